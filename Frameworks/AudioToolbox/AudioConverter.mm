@@ -15,102 +15,951 @@
 //******************************************************************************
 
 #import <AudioToolbox/AudioConverter.h>
-#import <StubReturn.h>
+#include "AudioConverterKernels.h"
+#include "LoggingNative.h"
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+static const wchar_t* TAG = L"AudioConverter";
+static const double c_pi = 3.14159265358979323846;
+
+namespace {
+
+enum SampleType { SampleUInt8, SampleInt8, SampleInt16, SampleInt24, SampleInt32, SampleFloat32, SampleFloat64 };
+
+// How one side of a converter lays out its linear PCM samples
+struct LPCMLayout {
+    SampleType type;
+    bool swap; // Not in host byte order
+    bool nonInterleaved;
+    UInt32 channels;
+    UInt32 bytesPerSample;
+    UInt32 bytesPerFrame; // Per buffer, so one sample when non-interleaved
+
+    bool init(const AudioStreamBasicDescription& desc) {
+        if (desc.mFormatID != kAudioFormatLinearPCM || desc.mChannelsPerFrame == 0 || desc.mFramesPerPacket > 1) {
+            return false;
+        }
+
+        channels = desc.mChannelsPerFrame;
+        nonInterleaved = (desc.mFormatFlags & kAudioFormatFlagIsNonInterleaved) != 0;
+        swap = (desc.mFormatFlags & kAudioFormatFlagIsBigEndian) != kAudioFormatFlagsNativeEndian;
+        bytesPerFrame = desc.mBytesPerFrame;
+
+        // Samples have to fill their containers; no 20-in-24 or aligned-high layouts
+        UInt32 samplesPerFrame = nonInterleaved ? 1 : channels;
+        if (bytesPerFrame == 0 || bytesPerFrame % samplesPerFrame != 0) {
+            return false;
+        }
+        bytesPerSample = bytesPerFrame / samplesPerFrame;
+        if (desc.mBitsPerChannel != bytesPerSample * 8) {
+            return false;
+        }
+
+        if (desc.mFormatFlags & kAudioFormatFlagIsFloat) {
+            switch (bytesPerSample) {
+                case 4:
+                    type = SampleFloat32;
+                    return true;
+                case 8:
+                    type = SampleFloat64;
+                    return true;
+            }
+            return false;
+        }
+
+        switch (bytesPerSample) {
+            case 1:
+                type = (desc.mFormatFlags & kAudioFormatFlagIsSignedInteger) ? SampleInt8 : SampleUInt8;
+                return true;
+            case 2:
+                type = SampleInt16;
+                return true;
+            case 3:
+                type = SampleInt24;
+                return true;
+            case 4:
+                type = SampleInt32;
+                return true;
+        }
+        return false;
+    }
+
+    bool isNative(SampleType sampleType) const {
+        return type == sampleType && !swap;
+    }
+
+    bool sameLayout(const LPCMLayout& other) const {
+        return type == other.type && swap == other.swap && nonInterleaved == other.nonInterleaved && channels == other.channels;
+    }
+
+    // Distance between consecutive samples of one channel, in samples
+    UInt32 stride() const {
+        return nonInterleaved ? 1 : channels;
+    }
+
+    UInt32 numberBuffers() const {
+        return nonInterleaved ? channels : 1;
+    }
+
+    // Frames that fit in every buffer of the list
+    UInt32 framesIn(const AudioBufferList* list) const {
+        if (list->mNumberBuffers < numberBuffers()) {
+            return 0;
+        }
+
+        UInt32 frames = 0xFFFFFFFF;
+        for (UInt32 i = 0; i < numberBuffers(); i++) {
+            if (!list->mBuffers[i].mData) {
+                return 0;
+            }
+            frames = std::min(frames, list->mBuffers[i].mDataByteSize / bytesPerFrame);
+        }
+        return frames;
+    }
+
+    // First sample of a channel, at the given frame
+    uint8_t* channelData(const AudioBufferList* list, UInt32 channel, UInt32 frame) const {
+        if (nonInterleaved) {
+            return (uint8_t*)list->mBuffers[channel].mData + frame * bytesPerFrame;
+        }
+        return (uint8_t*)list->mBuffers[0].mData + frame * bytesPerFrame + channel * bytesPerSample;
+    }
+};
+
+static void loadHostOrder(const uint8_t* in, uint8_t* out, UInt32 size, bool swap) {
+    for (UInt32 i = 0; i < size; i++) {
+        out[i] = swap ? in[size - 1 - i] : in[i];
+    }
+}
+
+static float readSample(const uint8_t* in, const LPCMLayout& layout) {
+    uint8_t bytes[8];
+    loadHostOrder(in, bytes, layout.bytesPerSample, layout.swap);
+
+    switch (layout.type) {
+        case SampleUInt8:
+            return ((int)bytes[0] - 128) * (1.0f / 128.0f);
+        case SampleInt8:
+            return (int8_t)bytes[0] * (1.0f / 128.0f);
+        case SampleInt16: {
+            int16_t value;
+            memcpy(&value, bytes, sizeof(value));
+            return value * (1.0f / 32768.0f);
+        }
+        case SampleInt24: {
+            int32_t value = bytes[0] | (bytes[1] << 8) | ((int8_t)bytes[2] << 16);
+            return value * (1.0f / 8388608.0f);
+        }
+        case SampleInt32: {
+            int32_t value;
+            memcpy(&value, bytes, sizeof(value));
+            return (float)(value * (1.0 / 2147483648.0));
+        }
+        case SampleFloat32: {
+            float value;
+            memcpy(&value, bytes, sizeof(value));
+            return value;
+        }
+        case SampleFloat64: {
+            double value;
+            memcpy(&value, bytes, sizeof(value));
+            return (float)value;
+        }
+    }
+    return 0.0f;
+}
+
+static int32_t quantize(float sample, double scale, double minimum, double maximum) {
+    double value = floor(sample * scale + 0.5);
+    return (int32_t)std::min(std::max(value, minimum), maximum);
+}
+
+static void writeSample(float sample, uint8_t* out, const LPCMLayout& layout) {
+    uint8_t bytes[8];
+
+    switch (layout.type) {
+        case SampleUInt8:
+            bytes[0] = (uint8_t)(quantize(sample, 128.0, -128.0, 127.0) + 128);
+            break;
+        case SampleInt8:
+            bytes[0] = (uint8_t)quantize(sample, 128.0, -128.0, 127.0);
+            break;
+        case SampleInt16: {
+            int16_t value = (int16_t)quantize(sample, 32768.0, -32768.0, 32767.0);
+            memcpy(bytes, &value, sizeof(value));
+            break;
+        }
+        case SampleInt24: {
+            int32_t value = quantize(sample, 8388608.0, -8388608.0, 8388607.0);
+            bytes[0] = (uint8_t)value;
+            bytes[1] = (uint8_t)(value >> 8);
+            bytes[2] = (uint8_t)(value >> 16);
+            break;
+        }
+        case SampleInt32: {
+            int32_t value = quantize(sample, 2147483648.0, -2147483648.0, 2147483647.0);
+            memcpy(bytes, &value, sizeof(value));
+            break;
+        }
+        case SampleFloat32:
+            memcpy(bytes, &sample, sizeof(sample));
+            break;
+        case SampleFloat64: {
+            double value = sample;
+            memcpy(bytes, &value, sizeof(value));
+            break;
+        }
+    }
+
+    loadHostOrder(bytes, out, layout.bytesPerSample, layout.swap);
+}
+
+static double besselI0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 50 && term > sum * 1e-12; k++) {
+        term *= (x / (2 * k)) * (x / (2 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+} // namespace
+
+// Linear PCM to linear PCM conversion. Input is decoded one channel at a time to
+// float, optionally resampled, then encoded into the output format. When nothing
+// but the sample format changes, samples are converted straight from the input
+// buffers to the output buffers.
+struct OpaqueAudioConverter {
+    AudioStreamBasicDescription _inputFormat;
+    AudioStreamBasicDescription _outputFormat;
+    LPCMLayout _input;
+    LPCMLayout _output;
+
+    // For each output channel, the input channel it comes from or -1 for silence.
+    // With no explicit map, a multichannel input going to mono is mixed down.
+    std::vector<SInt32> _channelMap;
+    bool _hasChannelMap;
+    bool _identityMap;
+
+    UInt32 _quality;
+    UInt32 _complexity;
+
+    // Sample rate conversion uses a windowed sinc filter, tabulated at _phases
+    // fractional offsets; rows are interpolated linearly between those offsets.
+    bool _resampling;
+    double _step; // Input frames per output frame
+    UInt32 _halfTaps;
+    UInt32 _phases;
+    std::vector<float> _filter; // _phases + 1 rows of 2 * _halfTaps taps
+
+    // Input frames, per output channel, that the filter still needs
+    std::vector<std::vector<float>> _history;
+    SInt64 _historyStart; // Input frame number of the first frame in _history
+    SInt64 _inputFrames;
+    UInt64 _outputFrames;
+    bool _endOfStream;
+
+    std::vector<float> _block; // kBlockFrames per output channel
+    std::vector<float> _mix;
+    std::vector<uint8_t> _inputList;
+
+    // Input the proc handed over beyond what a pull could use, copied out of its
+    // buffers and converted first on the next pull
+    std::vector<std::vector<uint8_t>> _surplus; // One per input buffer
+    std::vector<uint8_t> _surplusList;
+    UInt32 _surplusFrames;
+    UInt32 _surplusOffset;
+
+    enum { kBlockFrames = 1024, kMaxInputRequest = 4096 };
+
+    OpaqueAudioConverter(const AudioStreamBasicDescription& inputFormat,
+                         const AudioStreamBasicDescription& outputFormat,
+                         const LPCMLayout& input,
+                         const LPCMLayout& output)
+        : _inputFormat(inputFormat),
+          _outputFormat(outputFormat),
+          _input(input),
+          _output(output),
+          _hasChannelMap(false),
+          _quality(kAudioConverterQuality_Medium),
+          _complexity(kAudioConverterSampleRateConverterComplexity_Normal),
+          _block(kBlockFrames * output.channels),
+          _mix(kBlockFrames) {
+        for (UInt32 i = 0; i < _output.channels; i++) {
+            _channelMap.push_back(i < _input.channels ? i : (_input.channels == 1 ? 0 : -1));
+        }
+        updateIdentityMap();
+
+        _resampling = inputFormat.mSampleRate != outputFormat.mSampleRate;
+        _step = inputFormat.mSampleRate / outputFormat.mSampleRate;
+        _inputList.resize(offsetof(AudioBufferList, mBuffers) + _input.numberBuffers() * sizeof(AudioBuffer));
+        _surplusList.resize(_inputList.size());
+        _surplus.resize(_input.numberBuffers());
+
+        buildFilter();
+        reset();
+    }
+
+    void reset() {
+        // Start with _halfTaps frames of silence, so that the first output frame lines up with the first input frame
+        _history.assign(_output.channels, std::vector<float>(_resampling ? _halfTaps : 0, 0.0f));
+        _historyStart = -(SInt64)_history[0].size();
+        _inputFrames = 0;
+        _outputFrames = 0;
+        _endOfStream = false;
+        _surplusFrames = 0;
+        _surplusOffset = 0;
+    }
+
+    void buildFilter() {
+        if (!_resampling) {
+            return;
+        }
+
+        if (_complexity == kAudioConverterSampleRateConverterComplexity_Linear) {
+            // A triangle: plain linear interpolation between neighbouring frames
+            _halfTaps = 1;
+            _phases = 1;
+            _filter = { 1.0f, 0.0f, 0.0f, 1.0f };
+            return;
+        }
+
+        double beta;
+        if (_quality >= kAudioConverterQuality_High) {
+            _halfTaps = _quality >= kAudioConverterQuality_Max ? 32 : 24;
+            beta = 10.0;
+        } else if (_quality >= kAudioConverterQuality_Medium) {
+            _halfTaps = 16;
+            beta = 8.0;
+        } else {
+            _halfTaps = _quality >= kAudioConverterQuality_Low ? 12 : 8;
+            beta = 6.0;
+        }
+        _phases = 256;
+
+        // Cut off a little below the lower of the two Nyquist frequencies
+        double cutoff = std::min(1.0, 1.0 / _step) * (_halfTaps >= 16 ? 0.95 : 0.9);
+        UInt32 taps = 2 * _halfTaps;
+        _filter.resize((_phases + 1) * taps);
+
+        for (UInt32 phase = 0; phase <= _phases; phase++) {
+            float* row = &_filter[phase * taps];
+            double sum = 0.0;
+            for (UInt32 tap = 0; tap < taps; tap++) {
+                // Distance from the output position to the input frame under this tap
+                double distance = (double)tap - (_halfTaps - 1) - (double)phase / _phases;
+                double x = c_pi * cutoff * distance;
+                double sinc = x == 0.0 ? 1.0 : sin(x) / x;
+                double window = distance / _halfTaps;
+                window = besselI0(beta * sqrt(std::max(0.0, 1.0 - window * window))) / besselI0(beta);
+                row[tap] = (float)(sinc * window);
+                sum += row[tap];
+            }
+
+            // Unity gain at DC for every phase
+            for (UInt32 tap = 0; tap < taps; tap++) {
+                row[tap] = (float)(row[tap] / sum);
+            }
+        }
+    }
+
+    void setChannelMap(const SInt32* map) {
+        _channelMap.assign(map, map + _output.channels);
+        _hasChannelMap = true;
+        updateIdentityMap();
+    }
+
+    void updateIdentityMap() {
+        _identityMap = _input.channels == _output.channels && _input.nonInterleaved == _output.nonInterleaved;
+        for (UInt32 i = 0; i < _output.channels && _identityMap; i++) {
+            _identityMap = _channelMap[i] == (SInt32)i;
+        }
+    }
+
+    void decodeChannel(const AudioBufferList* list, UInt32 channel, UInt32 frame, UInt32 count, float* out) {
+        const uint8_t* in = _input.channelData(list, channel, frame);
+        if (_input.isNative(SampleInt16)) {
+            AudioKernelInt16ToFloat((const int16_t*)in, _input.stride(), out, 1, count);
+        } else if (_input.isNative(SampleFloat32)) {
+            AudioKernelCopyFloat((const float*)in, _input.stride(), out, 1, count);
+        } else {
+            UInt32 step = _input.stride() * _input.bytesPerSample;
+            for (UInt32 i = 0; i < count; i++) {
+                out[i] = readSample(in + i * step, _input);
+            }
+        }
+    }
+
+    // Fills count frames of one output channel, with the channel map applied
+    void decodeOutputChannel(const AudioBufferList* list, UInt32 channel, UInt32 frame, UInt32 count, float* out) {
+        if (!_hasChannelMap && _output.channels == 1 && _input.channels > 1) {
+            decodeChannel(list, 0, frame, count, out);
+            for (UInt32 source = 1; source < _input.channels; source++) {
+                float* mix = &_mix[0];
+                for (UInt32 done = 0; done < count; done += kBlockFrames) {
+                    UInt32 n = std::min<UInt32>(kBlockFrames, count - done);
+                    decodeChannel(list, source, frame + done, n, mix);
+                    for (UInt32 i = 0; i < n; i++) {
+                        out[done + i] += mix[i];
+                    }
+                }
+            }
+
+            float scale = 1.0f / _input.channels;
+            for (UInt32 i = 0; i < count; i++) {
+                out[i] *= scale;
+            }
+        } else if (_channelMap[channel] < 0) {
+            std::fill(out, out + count, 0.0f);
+        } else {
+            decodeChannel(list, _channelMap[channel], frame, count, out);
+        }
+    }
+
+    void encodeChannel(const float* in, UInt32 count, AudioBufferList* list, UInt32 channel, UInt32 frame) {
+        uint8_t* out = _output.channelData(list, channel, frame);
+        if (_output.isNative(SampleInt16)) {
+            AudioKernelFloatToInt16(in, 1, (int16_t*)out, _output.stride(), count);
+        } else if (_output.isNative(SampleFloat32)) {
+            AudioKernelCopyFloat(in, 1, (float*)out, _output.stride(), count);
+        } else {
+            UInt32 step = _output.stride() * _output.bytesPerSample;
+            for (UInt32 i = 0; i < count; i++) {
+                writeSample(in[i], out + i * step, _output);
+            }
+        }
+    }
+
+    // Converts frames without changing the sample rate
+    void convert(const AudioBufferList* in, UInt32 inFrame, AudioBufferList* out, UInt32 outFrame, UInt32 count) {
+        if (_identityMap) {
+            // The buffers line up sample for sample; convert each one as a single run
+            bool direct = _input.sameLayout(_output) || (_input.isNative(SampleInt16) && _output.isNative(SampleFloat32)) ||
+                          (_input.isNative(SampleFloat32) && _output.isNative(SampleInt16));
+            if (direct) {
+                UInt32 samples = count * _input.stride();
+                for (UInt32 i = 0; i < _input.numberBuffers(); i++) {
+                    const uint8_t* src = (const uint8_t*)in->mBuffers[i].mData + inFrame * _input.bytesPerFrame;
+                    uint8_t* dest = (uint8_t*)out->mBuffers[i].mData + outFrame * _output.bytesPerFrame;
+                    if (_input.sameLayout(_output)) {
+                        memcpy(dest, src, count * _input.bytesPerFrame);
+                    } else if (_input.isNative(SampleInt16)) {
+                        AudioKernelInt16ToFloat((const int16_t*)src, 1, (float*)dest, 1, samples);
+                    } else {
+                        AudioKernelFloatToInt16((const float*)src, 1, (int16_t*)dest, 1, samples);
+                    }
+                }
+                return;
+            }
+        }
+
+        for (UInt32 done = 0; done < count; done += kBlockFrames) {
+            UInt32 n = std::min<UInt32>(kBlockFrames, count - done);
+            for (UInt32 channel = 0; channel < _output.channels; channel++) {
+                decodeOutputChannel(in, channel, inFrame + done, n, &_block[0]);
+                encodeChannel(&_block[0], n, out, channel, outFrame + done);
+            }
+        }
+    }
+
+    void appendInput(const AudioBufferList* list, UInt32 count) {
+        for (UInt32 channel = 0; channel < _output.channels; channel++) {
+            std::vector<float>& history = _history[channel];
+            size_t end = history.size();
+            history.resize(end + count);
+            decodeOutputChannel(list, channel, 0, count, &history[end]);
+        }
+        _inputFrames += count;
+    }
+
+    void endStream() {
+        if (_endOfStream) {
+            return;
+        }
+
+        // Enough silence for the filter to reach the last input frame
+        for (auto& history : _history) {
+            history.resize(history.size() + _halfTaps, 0.0f);
+        }
+        _endOfStream = true;
+    }
+
+    // Output frames the input seen so far makes for, once the stream has ended
+    UInt64 totalOutputFrames() const {
+        return (UInt64)ceil(_inputFrames / _step - 1e-9);
+    }
+
+    // Input frames still needed to produce count more output frames
+    UInt32 inputFramesNeeded(UInt32 count) const {
+        double last = (_outputFrames + count - 1) * _step;
+        SInt64 needed = (SInt64)floor(last) + _halfTaps + 1 - (_historyStart + (SInt64)_history[0].size());
+        return (UInt32)std::min<SInt64>(std::max<SInt64>(needed, 1), kMaxInputRequest);
+    }
+
+    // Filters as many output frames as the buffered input allows
+    UInt32 resample(AudioBufferList* out, UInt32 outFrame, UInt32 count) {
+        UInt32 taps = 2 * _halfTaps;
+        SInt64 available = _history[0].size();
+        UInt32 produced = 0;
+
+        while (produced < count) {
+            UInt32 blockFrames = 0;
+            while (blockFrames < kBlockFrames && produced + blockFrames < count) {
+                if (_endOfStream && _outputFrames >= totalOutputFrames()) {
+                    break;
+                }
+
+                // Where this output frame falls between input frames. Working it out from the
+                // frame count, rather than accumulating _step, keeps long streams from drifting.
+                double position = _outputFrames * _step;
+                SInt64 whole = (SInt64)floor(position);
+                SInt64 first = whole - (_halfTaps - 1) - _historyStart;
+                if (first + taps > available) {
+                    break;
+                }
+
+                double phase = (position - whole) * _phases;
+                UInt32 row = std::min((UInt32)phase, _phases - 1);
+                float weight = (float)(phase - row);
+                const float* filter0 = &_filter[row * taps];
+                const float* filter1 = filter0 + taps;
+
+                for (UInt32 channel = 0; channel < _output.channels; channel++) {
+                    const float* frames = &_history[channel][(size_t)first];
+                    float sample0 = AudioKernelDotProduct(frames, filter0, taps);
+                    float sample1 = AudioKernelDotProduct(frames, filter1, taps);
+                    _block[channel * kBlockFrames + blockFrames] = sample0 + (sample1 - sample0) * weight;
+                }
+
+                _outputFrames++;
+                blockFrames++;
+            }
+
+            if (blockFrames == 0) {
+                break;
+            }
+
+            for (UInt32 channel = 0; channel < _output.channels; channel++) {
+                encodeChannel(&_block[channel * kBlockFrames], blockFrames, out, channel, outFrame + produced);
+            }
+            produced += blockFrames;
+        }
+
+        // Drop input the filter has moved past. When decimating with short filters the next output
+        // frame can start beyond everything buffered so far.
+        SInt64 keepFrom = (SInt64)floor(_outputFrames * _step) - (_halfTaps - 1) - _historyStart;
+        keepFrom = std::min(keepFrom, available);
+        if (keepFrom >= kBlockFrames) {
+            for (auto& history : _history) {
+                history.erase(history.begin(), history.begin() + (size_t)keepFrom);
+            }
+            _historyStart += keepFrom;
+        }
+
+        return produced;
+    }
+
+    void keepSurplus(const AudioBufferList* list, UInt32 inFrame, UInt32 count) {
+        AudioBufferList* surplusList = (AudioBufferList*)&_surplusList[0];
+        surplusList->mNumberBuffers = list->mNumberBuffers;
+        for (UInt32 i = 0; i < list->mNumberBuffers; i++) {
+            const uint8_t* src = (const uint8_t*)list->mBuffers[i].mData + inFrame * _input.bytesPerFrame;
+            _surplus[i].assign(src, src + count * _input.bytesPerFrame);
+            surplusList->mBuffers[i].mNumberChannels = list->mBuffers[i].mNumberChannels;
+            surplusList->mBuffers[i].mDataByteSize = (UInt32)_surplus[i].size();
+            surplusList->mBuffers[i].mData = _surplus[i].data();
+        }
+        _surplusFrames = count;
+        _surplusOffset = 0;
+    }
+
+    UInt32 convertSurplus(AudioBufferList* out, UInt32 outFrame, UInt32 count) {
+        count = std::min(count, _surplusFrames - _surplusOffset);
+        convert((const AudioBufferList*)&_surplusList[0], _surplusOffset, out, outFrame, count);
+        _surplusOffset += count;
+        if (_surplusOffset == _surplusFrames) {
+            _surplusFrames = 0;
+            _surplusOffset = 0;
+        }
+        return count;
+    }
+
+    OSStatus fillComplexBuffer(AudioConverterComplexInputDataProc inputProc, void* userData, UInt32* ioFrames, AudioBufferList* out) {
+        UInt32 wanted = std::min(*ioFrames, _output.framesIn(out));
+        UInt32 produced = 0;
+        OSStatus status = noErr;
+        AudioBufferList* inputList = (AudioBufferList*)&_inputList[0];
+
+        if (_surplusFrames > 0) {
+            produced += convertSurplus(out, 0, wanted);
+        }
+
+        while (produced < wanted) {
+            if (_resampling) {
+                produced += resample(out, produced, wanted - produced);
+            }
+            if (produced == wanted || _endOfStream) {
+                break;
+            }
+
+            // The input proc's buffers only stay valid until it is called again, so everything
+            // it hands over is consumed or copied before asking for more. It may hand over more
+            // than was requested; none of that is dropped.
+            UInt32 frames = _resampling ? inputFramesNeeded(wanted - produced) : wanted - produced;
+            AudioStreamPacketDescription* packetDescriptions = nullptr;
+
+            inputList->mNumberBuffers = _input.numberBuffers();
+            for (UInt32 i = 0; i < inputList->mNumberBuffers; i++) {
+                inputList->mBuffers[i].mNumberChannels = _input.nonInterleaved ? 1 : _input.channels;
+                inputList->mBuffers[i].mDataByteSize = 0;
+                inputList->mBuffers[i].mData = nullptr;
+            }
+
+            status = inputProc(this, &frames, inputList, &packetDescriptions, userData);
+            frames = std::min(frames, _input.framesIn(inputList));
+
+            if (frames == 0) {
+                if (status == noErr) {
+                    // No more input; let the filter drain, then stop
+                    if (_resampling) {
+                        endStream();
+                        continue;
+                    }
+                    _endOfStream = true;
+                }
+                break;
+            }
+
+            if (_resampling) {
+                appendInput(inputList, frames);
+            } else {
+                UInt32 count = std::min(frames, wanted - produced);
+                convert(inputList, 0, out, produced, count);
+                produced += count;
+                if (count < frames) {
+                    keepSurplus(inputList, count, frames - count);
+                }
+            }
+
+            if (status != noErr) {
+                break;
+            }
+        }
+
+        *ioFrames = produced;
+        for (UInt32 i = 0; i < _output.numberBuffers(); i++) {
+            out->mBuffers[i].mDataByteSize = produced * _output.bytesPerFrame;
+        }
+
+        return status;
+    }
+};
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 OSStatus AudioConverterDispose(AudioConverterRef inAudioConverter) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    delete inAudioConverter;
+    return noErr;
 }
 
 /**
- @Status Stub
+ @Status Caveat
+ @Notes Only conversions between linear PCM formats are supported
 */
 OSStatus AudioConverterNew(const AudioStreamBasicDescription* inSourceFormat,
                            const AudioStreamBasicDescription* inDestinationFormat,
-                           DWORD* outAudioConverter) {
-    // TODO: outAudioConverter ought to be made AudioConverterRef _Nullable * when this is unstubbed
-    UNIMPLEMENTED();
-    if (outAudioConverter) {
-        *outAudioConverter = 1234;
+                           AudioConverterRef _Nullable* outAudioConverter) {
+    if (!inSourceFormat || !inDestinationFormat || !outAudioConverter) {
+        return kAudio_ParamError;
+    }
+    *outAudioConverter = nullptr;
+
+    LPCMLayout input, output;
+    if (!input.init(*inSourceFormat) || !output.init(*inDestinationFormat)) {
+        TraceError(TAG,
+                   L"Unsupported conversion from format %08x (flags %x) to %08x (flags %x)",
+                   inSourceFormat->mFormatID,
+                   inSourceFormat->mFormatFlags,
+                   inDestinationFormat->mFormatID,
+                   inDestinationFormat->mFormatFlags);
+        return kAudioConverterErr_FormatNotSupported;
+    }
+
+    if (!(inSourceFormat->mSampleRate > 0)) {
+        return kAudioConverterErr_InputSampleRateOutOfRange;
     }
-    return StubReturn();
+    if (!(inDestinationFormat->mSampleRate > 0)) {
+        return kAudioConverterErr_OutputSampleRateOutOfRange;
+    }
+
+    *outAudioConverter = new OpaqueAudioConverter(*inSourceFormat, *inDestinationFormat, input, output);
+    return noErr;
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Caveat
+ @Notes Class descriptions are ignored; the built in linear PCM converter is always used
 */
 OSStatus AudioConverterNewSpecific(const AudioStreamBasicDescription* inSourceFormat,
                                    const AudioStreamBasicDescription* inDestinationFormat,
                                    UInt32 inNumberClassDescriptions,
                                    const AudioClassDescription* inClassDescriptions,
                                    AudioConverterRef _Nullable* outAudioConverter) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return AudioConverterNew(inSourceFormat, inDestinationFormat, outAudioConverter);
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 OSStatus AudioConverterReset(AudioConverterRef inAudioConverter) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    if (!inAudioConverter) {
+        return kAudio_ParamError;
+    }
+
+    inAudioConverter->reset();
+    return noErr;
+}
+
+static OSStatus _getPropertySize(AudioConverterRef converter, AudioConverterPropertyID propertyID, UInt32* size, Boolean* writable) {
+    *writable = false;
+
+    switch (propertyID) {
+        case kAudioConverterCurrentInputStreamDescription:
+        case kAudioConverterCurrentOutputStreamDescription:
+            *size = sizeof(AudioStreamBasicDescription);
+            return noErr;
+
+        case kAudioConverterSampleRateConverterQuality:
+        case kAudioConverterSampleRateConverterComplexity:
+            *writable = true;
+            *size = sizeof(UInt32);
+            return noErr;
+
+        case kAudioConverterChannelMap:
+            *writable = true;
+            *size = converter->_output.channels * sizeof(SInt32);
+            return noErr;
+
+        case kAudioConverterPrimeInfo:
+            *size = sizeof(AudioConverterPrimeInfo);
+            return noErr;
+
+        case kAudioConverterPropertyMinimumInputBufferSize:
+        case kAudioConverterPropertyMinimumOutputBufferSize:
+        case kAudioConverterPropertyMaximumInputPacketSize:
+        case kAudioConverterPropertyMaximumOutputPacketSize:
+        case kAudioConverterPropertyCalculateInputBufferSize:
+        case kAudioConverterPropertyCalculateOutputBufferSize:
+            *size = sizeof(UInt32);
+            return noErr;
+    }
+
+    return kAudioConverterErr_PropertyNotSupported;
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Caveat
+ @Notes Supports stream descriptions, sample rate converter quality and complexity, channel map, prime info and buffer sizes
 */
 OSStatus AudioConverterGetProperty(AudioConverterRef inAudioConverter,
                                    AudioConverterPropertyID inPropertyID,
                                    UInt32* ioPropertyDataSize,
                                    void* outPropertyData) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    if (!inAudioConverter || !ioPropertyDataSize || !outPropertyData) {
+        return kAudio_ParamError;
+    }
+
+    UInt32 size;
+    Boolean writable;
+    OSStatus status = _getPropertySize(inAudioConverter, inPropertyID, &size, &writable);
+    if (status != noErr) {
+        return status;
+    }
+
+    // Buffer size calculations take their argument in the same UInt32 they answer in
+    if (*ioPropertyDataSize < size) {
+        return kAudioConverterErr_BadPropertySizeError;
+    }
+    *ioPropertyDataSize = size;
+
+    OpaqueAudioConverter* converter = inAudioConverter;
+    switch (inPropertyID) {
+        case kAudioConverterCurrentInputStreamDescription:
+            memcpy(outPropertyData, &converter->_inputFormat, size);
+            break;
+
+        case kAudioConverterCurrentOutputStreamDescription:
+            memcpy(outPropertyData, &converter->_outputFormat, size);
+            break;
+
+        case kAudioConverterSampleRateConverterQuality:
+            *(UInt32*)outPropertyData = converter->_quality;
+            break;
+
+        case kAudioConverterSampleRateConverterComplexity:
+            *(UInt32*)outPropertyData = converter->_complexity;
+            break;
+
+        case kAudioConverterChannelMap:
+            memcpy(outPropertyData, &converter->_channelMap[0], size);
+            break;
+
+        case kAudioConverterPrimeInfo: {
+            // The filter is primed with silence internally, so output lines up with input
+            AudioConverterPrimeInfo* info = (AudioConverterPrimeInfo*)outPropertyData;
+            info->leadingFrames = 0;
+            info->trailingFrames = 0;
+            break;
+        }
+
+        case kAudioConverterPropertyMinimumInputBufferSize:
+        case kAudioConverterPropertyMaximumInputPacketSize:
+            *(UInt32*)outPropertyData = converter->_input.bytesPerFrame;
+            break;
+
+        case kAudioConverterPropertyMinimumOutputBufferSize:
+        case kAudioConverterPropertyMaximumOutputPacketSize:
+            *(UInt32*)outPropertyData = converter->_output.bytesPerFrame;
+            break;
+
+        case kAudioConverterPropertyCalculateInputBufferSize: {
+            double frames = ceil(*(UInt32*)outPropertyData / converter->_output.bytesPerFrame * converter->_step);
+            *(UInt32*)outPropertyData = (UInt32)frames * converter->_input.bytesPerFrame;
+            break;
+        }
+
+        case kAudioConverterPropertyCalculateOutputBufferSize: {
+            double frames = ceil(*(UInt32*)outPropertyData / converter->_input.bytesPerFrame / converter->_step);
+            *(UInt32*)outPropertyData = (UInt32)frames * converter->_output.bytesPerFrame;
+            break;
+        }
+    }
+
+    return noErr;
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 OSStatus AudioConverterGetPropertyInfo(AudioConverterRef inAudioConverter,
                                        AudioConverterPropertyID inPropertyID,
                                        UInt32* outSize,
                                        Boolean* outWritable) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    if (!inAudioConverter) {
+        return kAudio_ParamError;
+    }
+
+    UInt32 size;
+    Boolean writable;
+    OSStatus status = _getPropertySize(inAudioConverter, inPropertyID, &size, &writable);
+    if (status == noErr) {
+        if (outSize) {
+            *outSize = size;
+        }
+        if (outWritable) {
+            *outWritable = writable;
+        }
+    }
+
+    return status;
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Caveat
+ @Notes Supports sample rate converter quality and complexity, and the channel map
 */
 OSStatus AudioConverterSetProperty(AudioConverterRef inAudioConverter,
                                    AudioConverterPropertyID inPropertyID,
                                    UInt32 inPropertyDataSize,
                                    const void* inPropertyData) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    if (!inAudioConverter || !inPropertyData) {
+        return kAudio_ParamError;
+    }
+
+    UInt32 size;
+    Boolean writable;
+    OSStatus status = _getPropertySize(inAudioConverter, inPropertyID, &size, &writable);
+    if (status != noErr) {
+        return status;
+    }
+    if (!writable) {
+        return kAudioConverterErr_PropertyNotSupported;
+    }
+    if (inPropertyDataSize != size) {
+        return kAudioConverterErr_BadPropertySizeError;
+    }
+
+    OpaqueAudioConverter* converter = inAudioConverter;
+    switch (inPropertyID) {
+        case kAudioConverterSampleRateConverterQuality:
+            converter->_quality = std::min<UInt32>(*(const UInt32*)inPropertyData, kAudioConverterQuality_Max);
+            break;
+
+        case kAudioConverterSampleRateConverterComplexity:
+            converter->_complexity = *(const UInt32*)inPropertyData;
+            break;
+
+        case kAudioConverterChannelMap: {
+            const SInt32* map = (const SInt32*)inPropertyData;
+            for (UInt32 i = 0; i < converter->_output.channels; i++) {
+                if (map[i] >= (SInt32)converter->_input.channels) {
+                    return kAudio_ParamError;
+                }
+            }
+            converter->setChannelMap(map);
+            break;
+        }
+    }
+
+    // The filter length depends on the settings, and the buffered input on the filter length
+    if (inPropertyID != kAudioConverterChannelMap) {
+        converter->buildFilter();
+        converter->reset();
+    }
+
+    return noErr;
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Caveat
+ @Notes Sample rate conversion and non-interleaved multichannel formats need AudioConverterFillComplexBuffer
 */
 OSStatus AudioConverterConvertBuffer(
     AudioConverterRef inAudioConverter, UInt32 inInputDataSize, const void* inInputData, UInt32* ioOutputDataSize, void* outOutputData) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    if (!inAudioConverter || !inInputData || !ioOutputDataSize || !outOutputData) {
+        return kAudio_ParamError;
+    }
+
+    OpaqueAudioConverter* converter = inAudioConverter;
+    if (converter->_resampling) {
+        return kAudioConverterErr_OperationNotSupported;
+    }
+    if (converter->_input.numberBuffers() != 1 || converter->_output.numberBuffers() != 1) {
+        return kAudioConverterErr_FormatNotSupported;
+    }
+
+    UInt32 frames = inInputDataSize / converter->_input.bytesPerFrame;
+    if (frames * converter->_output.bytesPerFrame > *ioOutputDataSize) {
+        return kAudioConverterErr_InvalidOutputSize;
+    }
+
+    AudioBufferList input = { 1, { { converter->_input.channels, inInputDataSize, const_cast<void*>(inInputData) } } };
+    AudioBufferList output = { 1, { { converter->_output.channels, *ioOutputDataSize, outOutputData } } };
+    converter->convert(&input, 0, &output, 0, frames);
+
+    *ioOutputDataSize = frames * converter->_output.bytesPerFrame;
+    return noErr;
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Caveat
+ @Notes Only linear PCM formats are supported, so packet descriptions are never used
 */
 OSStatus AudioConverterFillComplexBuffer(AudioConverterRef inAudioConverter,
                                          AudioConverterComplexInputDataProc inInputDataProc,
@@ -118,18 +967,40 @@ OSStatus AudioConverterFillComplexBuffer(AudioConverterRef inAudioConverter,
                                          UInt32* ioOutputDataPacketSize,
                                          AudioBufferList* outOutputData,
                                          AudioStreamPacketDescription* outPacketDescription) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    if (!inAudioConverter || !inInputDataProc || !ioOutputDataPacketSize || !outOutputData) {
+        return kAudio_ParamError;
+    }
+
+    return inAudioConverter->fillComplexBuffer(inInputDataProc, inInputDataProcUserData, ioOutputDataPacketSize, outOutputData);
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Caveat
+ @Notes Sample rate conversion needs AudioConverterFillComplexBuffer
 */
 OSStatus AudioConverterConvertComplexBuffer(AudioConverterRef inAudioConverter,
                                             UInt32 inNumberPCMFrames,
                                             const AudioBufferList* inInputData,
                                             AudioBufferList* outOutputData) {
-    UNIMPLEMENTED();
-    return StubReturn();
-}
\ No newline at end of file
+    if (!inAudioConverter || !inInputData || !outOutputData) {
+        return kAudio_ParamError;
+    }
+
+    OpaqueAudioConverter* converter = inAudioConverter;
+    if (converter->_resampling) {
+        return kAudioConverterErr_OperationNotSupported;
+    }
+    if (converter->_input.framesIn(inInputData) < inNumberPCMFrames) {
+        return kAudioConverterErr_InvalidInputSize;
+    }
+    if (converter->_output.framesIn(outOutputData) < inNumberPCMFrames) {
+        return kAudioConverterErr_InvalidOutputSize;
+    }
+
+    converter->convert(inInputData, 0, outOutputData, 0, inNumberPCMFrames);
+    for (UInt32 i = 0; i < converter->_output.numberBuffers(); i++) {
+        outOutputData->mBuffers[i].mDataByteSize = inNumberPCMFrames * converter->_output.bytesPerFrame;
+    }
+
+    return noErr;
+}
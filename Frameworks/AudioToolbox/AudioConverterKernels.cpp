@@ -0,0 +1,121 @@
+//******************************************************************************
+//
+// Copyright (c) 2016 Microsoft Corporation. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+#include "AudioConverterKernels.h"
+
+#include <math.h>
+#include <string.h>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#define AUDIOKERNEL_SSE 1
+#include <emmintrin.h>
+#include <xmmintrin.h>
+#else
+#define AUDIOKERNEL_SSE 0
+#endif
+
+static const float c_int16Scale = 1.0f / 32768.0f;
+
+void AudioKernelInt16ToFloat(const int16_t* in, size_t inStride, float* out, size_t outStride, size_t count) {
+    size_t i = 0;
+
+#if (AUDIOKERNEL_SSE == 1)
+    if (inStride == 1 && outStride == 1) {
+        const __m128 vScale = _mm_set1_ps(c_int16Scale);
+        for (; i + 8 <= count; i += 8) {
+            __m128i vInt16 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&in[i]));
+
+            // Sign extend by putting each sample in the top half of a 32 bit lane, then shifting down
+            __m128i vLow = _mm_srai_epi32(_mm_unpacklo_epi16(vInt16, vInt16), 16);
+            __m128i vHigh = _mm_srai_epi32(_mm_unpackhi_epi16(vInt16, vInt16), 16);
+
+            _mm_storeu_ps(&out[i], _mm_mul_ps(_mm_cvtepi32_ps(vLow), vScale));
+            _mm_storeu_ps(&out[i + 4], _mm_mul_ps(_mm_cvtepi32_ps(vHigh), vScale));
+        }
+    }
+#endif
+
+    for (; i < count; i++) {
+        out[i * outStride] = in[i * inStride] * c_int16Scale;
+    }
+}
+
+void AudioKernelFloatToInt16(const float* in, size_t inStride, int16_t* out, size_t outStride, size_t count) {
+    size_t i = 0;
+
+#if (AUDIOKERNEL_SSE == 1)
+    if (inStride == 1 && outStride == 1) {
+        const __m128 vScale = _mm_set1_ps(32768.0f);
+        const __m128 vMin = _mm_set1_ps(-32768.0f);
+        const __m128 vMax = _mm_set1_ps(32767.0f);
+        for (; i + 8 <= count; i += 8) {
+            __m128 vLow = _mm_mul_ps(_mm_loadu_ps(&in[i]), vScale);
+            __m128 vHigh = _mm_mul_ps(_mm_loadu_ps(&in[i + 4]), vScale);
+            vLow = _mm_min_ps(_mm_max_ps(vLow, vMin), vMax);
+            vHigh = _mm_min_ps(_mm_max_ps(vHigh, vMin), vMax);
+
+            // cvtps rounds to nearest even, same as lrintf below
+            __m128i vInt16 = _mm_packs_epi32(_mm_cvtps_epi32(vLow), _mm_cvtps_epi32(vHigh));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(&out[i]), vInt16);
+        }
+    }
+#endif
+
+    for (; i < count; i++) {
+        float sample = in[i * inStride] * 32768.0f;
+        if (sample < -32768.0f) {
+            sample = -32768.0f;
+        } else if (sample > 32767.0f) {
+            sample = 32767.0f;
+        }
+        out[i * outStride] = (int16_t)lrintf(sample);
+    }
+}
+
+void AudioKernelCopyFloat(const float* in, size_t inStride, float* out, size_t outStride, size_t count) {
+    if (inStride == 1 && outStride == 1) {
+        memcpy(out, in, count * sizeof(float));
+        return;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        out[i * outStride] = in[i * inStride];
+    }
+}
+
+float AudioKernelDotProduct(const float* a, const float* b, size_t count) {
+    size_t i = 0;
+    float sum = 0.0f;
+
+#if (AUDIOKERNEL_SSE == 1)
+    __m128 vSum0 = _mm_setzero_ps();
+    __m128 vSum1 = _mm_setzero_ps();
+    for (; i + 8 <= count; i += 8) {
+        vSum0 = _mm_add_ps(vSum0, _mm_mul_ps(_mm_loadu_ps(&a[i]), _mm_loadu_ps(&b[i])));
+        vSum1 = _mm_add_ps(vSum1, _mm_mul_ps(_mm_loadu_ps(&a[i + 4]), _mm_loadu_ps(&b[i + 4])));
+    }
+
+    float lanes[4];
+    _mm_storeu_ps(lanes, _mm_add_ps(vSum0, vSum1));
+    sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+
+    for (; i < count; i++) {
+        sum += a[i] * b[i];
+    }
+
+    return sum;
+}
@@ -0,0 +1,28 @@
+//******************************************************************************
+//
+// Copyright (c) 2016 Microsoft Corporation. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Inner loops for AudioConverter. Unit stride runs use SSE2 on x86; strided runs
+// and other architectures fall back to plain loops. Integer samples map to [-1, 1)
+// floats; floats are clipped and rounded to nearest on the way back.
+void AudioKernelInt16ToFloat(const int16_t* in, size_t inStride, float* out, size_t outStride, size_t count);
+void AudioKernelFloatToInt16(const float* in, size_t inStride, int16_t* out, size_t outStride, size_t count);
+void AudioKernelCopyFloat(const float* in, size_t inStride, float* out, size_t outStride, size_t count);
+float AudioKernelDotProduct(const float* a, const float* b, size_t count);
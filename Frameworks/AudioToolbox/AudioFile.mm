@@ -71,11 +71,19 @@ public:
     }
 };
 
+// The compressed stream is kept in memory (stb_vorbis is built without stdio), but
+// it's only decoded as far as it is read, and reads at other offsets seek.
 class AudioFileOGG : public OpaqueAudioFileID {
     stb_vorbis* _handle;
     StrongId<NSData> _data;
+    int _channels;
 
-    AudioFileOGG(stb_vorbis* handle, NSData* data) : _handle(handle), _data(data) {
+    // Frame the decoder will produce next, and where read() carries on from
+    i64 _decodePosition;
+    i64 _readPosition;
+
+    AudioFileOGG(stb_vorbis* handle, NSData* data)
+        : _handle(handle), _data(data), _channels(stb_vorbis_get_info(handle).channels), _decodePosition(0), _readPosition(0) {
     }
 
 public:
@@ -110,31 +118,35 @@ public:
         }
 
         u32 numBytes = buffers->mBuffers[0].mDataByteSize;
-        int ret = readBytes(0, &numBytes, buffers->mBuffers[0].mData);
-        *outFrameCount = numBytes / 2;
+        int ret = readBytes(_readPosition, &numBytes, buffers->mBuffers[0].mData);
+        _readPosition += numBytes;
+        *outFrameCount = numBytes / (_channels * sizeof(short));
 
         return ret;
     }
 
     int readBytes(i64 start, u32* numBytes, void* buffer) {
-        int remainingShorts = *numBytes / 2;
-        short* data = (short*)buffer;
-        stb_vorbis_info info = stb_vorbis_get_info(_handle);
-
-        *numBytes = 0;
-        for (;;) {
-            int n = stb_vorbis_get_frame_short_interleaved(_handle, info.channels, data, remainingShorts);
+        u32 bytesPerFrame = _channels * sizeof(short);
+        if (start < 0 || (start % bytesPerFrame) != 0) {
+            TraceError(TAG, L"[OGG] Read offset %lld is not on a frame boundary", start);
+            *numBytes = 0;
+            return -1;
+        }
 
-            // Are we done?
-            if (n == 0) {
-                break;
+        i64 frame = start / bytesPerFrame;
+        if (frame != _decodePosition) {
+            if (!stb_vorbis_seek(_handle, (unsigned int)frame)) {
+                // Past the end of the stream
+                *numBytes = 0;
+                return 0;
             }
-
-            data += n * info.channels;
-            remainingShorts -= n * info.channels;
-            *numBytes += n * info.channels * 2;
+            _decodePosition = frame;
         }
 
+        int n = stb_vorbis_get_samples_short_interleaved(_handle, _channels, (short*)buffer, *numBytes / sizeof(short));
+        _decodePosition += n;
+        *numBytes = n * bytesPerFrame;
+
         return 0;
     }
 
@@ -381,12 +393,105 @@ public:
     }
 };
 
+// CAF audio is decoded on demand, a block of packets at a time. Every format we
+// support is constant bitrate, so a packet's location in the file is simple
+// arithmetic and reads at any offset only decode the blocks they touch. The last
+// few blocks are kept, since reads are mostly sequential or loop over a region.
 class AudioFileCAF : public OpaqueAudioFileID {
+    enum { kFramesPerBlock = 4096, kCachedBlocks = 4 };
+
+    struct Block {
+        i64 index;
+        u32 lastUse;
+        std::vector<i16> samples;
+
+        Block() : index(-1), lastUse(0) {
+        }
+    };
+
     CAFDecoder _decoder;
+    StrongId<NSFileHandle> _file;
+
+    u32 _channels;
+    u32 _packetsPerBlock;
+    i64 _numPackets;
+    i64 _numFrames;
+    i64 _primingFrames;
+
+    Block _blocks[kCachedBlocks];
+    u32 _useCount;
+    i64 _lastDecodedBlock;
+    i64 _readPosition;
+
+    AudioFileCAF() : _useCount(0), _lastDecodedBlock(-1), _readPosition(0) {
+    }
+
+    const Block* getBlock(i64 index) {
+        Block* block = &_blocks[0];
+        for (Block& cur : _blocks) {
+            if (cur.index == index) {
+                cur.lastUse = ++_useCount;
+                return &cur;
+            }
+            if (cur.lastUse < block->lastUse) {
+                block = &cur;
+            }
+        }
+
+        i64 firstPacket = index * _packetsPerBlock;
+        u32 numPackets = (u32)std::min<i64>(_packetsPerBlock, _numPackets - firstPacket);
+        if (numPackets == 0) {
+            return nullptr;
+        }
+
+        u32 bytesPerPacket = _decoder.BytesPerPacket();
+        [_file seekToFileOffset:_decoder.DataOffset() + firstPacket * bytesPerPacket];
+        NSData* packets = [_file readDataOfLength:numPackets * bytesPerPacket];
+        numPackets = std::min<u32>(numPackets, [packets length] / bytesPerPacket);
+        if (numPackets == 0) {
+            return nullptr;
+        }
+
+        // IMA4 predictor state carries over from one packet to the next
+        if (index != _lastDecodedBlock + 1) {
+            _decoder.ResetChannelStates();
+        }
+        _lastDecodedBlock = index;
 
-    // Storing this in here really sucks but we can't really know until
-    // we've read it all.. Refactor decoder?
-    std::vector<i16> _data;
+        block->index = index;
+        block->lastUse = ++_useCount;
+        block->samples.resize(numPackets * _decoder.FramesPerPacket() * _channels);
+        _decoder.DecodePackets((const Byte*)[packets bytes], numPackets, &block->samples[0]);
+
+        return block;
+    }
+
+    // Copies interleaved samples starting at the given sample, returning how many were copied
+    u32 copySamples(i64 sample, u32 count, i16* out) {
+        i64 totalSamples = _numFrames * _channels;
+        i64 samplesPerBlock = (i64)_packetsPerBlock * _decoder.FramesPerPacket() * _channels;
+        u32 copied = 0;
+
+        while (copied < count && sample < totalSamples) {
+            i64 rawSample = sample + _primingFrames * _channels;
+            const Block* block = getBlock(rawSample / samplesPerBlock);
+            if (!block) {
+                break;
+            }
+
+            u32 offset = (u32)(rawSample % samplesPerBlock);
+            if (offset >= block->samples.size()) {
+                break;
+            }
+
+            u32 n = (u32)std::min<i64>(std::min<i64>(count - copied, block->samples.size() - offset), totalSamples - sample);
+            memcpy(out + copied, &block->samples[offset], n * sizeof(i16));
+            copied += n;
+            sample += n;
+        }
+
+        return copied;
+    }
 
 public:
     static OpaqueAudioFileID* openURL(NSURL* url) {
@@ -399,22 +504,36 @@ public:
         }
 
         AudioFileCAF* self = new AudioFileCAF();
-        if (!self->_decoder.InitForRead(inStream)) {
+        bool parsed = self->_decoder.InitForRead(inStream);
+        [inStream close];
+
+        if (!parsed) {
             TraceError(TAG, L"CAF %hs has an unsupported format..", url);
+            delete self;
             return NULL;
         }
 
-        i16 buffer[1024];
-        while (true) {
-            uint numBytes = sizeof(buffer) / 2;
-            self->_decoder.ReadBuf(inStream, buffer, numBytes);
+        // The header only needed to be parsed once; the audio data is read at random
+        self->_file = [NSFileHandle fileHandleForReadingFromURL:url error:nil];
+        if (!self->_file) {
+            TraceError(TAG, L"CAF %hs couldn't be opened for reading..", url);
+            delete self;
+            return NULL;
+        }
 
-            if (numBytes == 0) {
-                // Done!
-                break;
-            }
+        i64 dataBytes = self->_decoder.DataByteCount();
+        if (dataBytes < 0) {
+            dataBytes = [self->_file seekToEndOfFile] - self->_decoder.DataOffset();
+        }
 
-            self->_data.insert(self->_data.end(), buffer, buffer + numBytes / 2);
+        u32 framesPerPacket = self->_decoder.FramesPerPacket();
+        self->_channels = self->_decoder.OutputFormat.mChannelsPerFrame;
+        self->_packetsPerBlock = std::max<u32>(1, kFramesPerBlock / framesPerPacket);
+        self->_numPackets = std::max<i64>(0, dataBytes) / self->_decoder.BytesPerPacket();
+        self->_primingFrames = self->_decoder.PrimingFrames();
+        self->_numFrames = std::max<i64>(0, self->_numPackets * framesPerPacket - self->_primingFrames);
+        if (self->_decoder.ValidFrames() >= 0) {
+            self->_numFrames = std::min(self->_numFrames, self->_decoder.ValidFrames());
         }
 
         return self;
@@ -428,7 +547,7 @@ public:
         switch (propID) {
             case kExtAudioFileProperty_FileLengthFrames: {
                 TraceVerbose(TAG, L"CAF getting filelengthframes");
-                *(i64*)out = _data.size() / outDesc.mChannelsPerFrame;
+                *(i64*)out = _numFrames;
                 break;
             }
 
@@ -452,7 +571,7 @@ public:
 
             case kAudioFilePropertyAudioDataByteCount: {
                 TraceVerbose(TAG, L"CAF getting byte count");
-                *(u64*)out = _data.size() * sizeof(short);
+                *(u64*)out = _numFrames * _channels * sizeof(short);
                 break;
             }
 
@@ -465,18 +584,25 @@ public:
     }
 
     int read(u32* outFrameCount, AudioBufferList* buffers) {
-        return 0;
+        assert(buffers->mNumberBuffers == 1);
+
+        u32 numBytes = buffers->mBuffers[0].mDataByteSize;
+        int ret = readBytes(_readPosition, &numBytes, buffers->mBuffers[0].mData);
+        _readPosition += numBytes;
+        *outFrameCount = numBytes / (_channels * sizeof(short));
+
+        return ret;
     }
 
     int readBytes(i64 start, u32* numBytes, void* buffer) {
-        if (start != 0) {
-            TraceError(TAG, L"Attempting to read CAF with non-zero offset, unsupported.");
+        if (start < 0 || (start % sizeof(i16)) != 0) {
+            TraceError(TAG, L"Attempting to read CAF at offset %lld, which isn't on a sample boundary.", start);
+            *numBytes = 0;
             return -1;
         }
 
-        int readSize = min(*numBytes, _data.size() * 2);
-        memcpy(buffer, &*_data.begin(), readSize);
-        *numBytes = readSize;
+        u32 copied = copySamples(start / sizeof(i16), *numBytes / sizeof(i16), (i16*)buffer);
+        *numBytes = copied * sizeof(i16);
 
         return 0;
     }
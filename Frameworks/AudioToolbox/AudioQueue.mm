@@ -15,65 +15,1171 @@
 //******************************************************************************
 
 #import <AudioToolbox/AudioQueue.h>
+#import <AudioToolbox/AudioFormat.h>
 #import <StubReturn.h>
+#include "AudioQueueInternal.h"
+#include "LoggingNative.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <vector>
+
+static const wchar_t* TAG = L"AudioQueue";
+
+namespace {
+
+enum { kMaxBuffers = 1024, kMaxBufferParameters = 8, kDefaultPeriodFrames = 512, kMaxPeriodFrames = 16384 };
+
+enum QueueState { kStateStopped, kStateRunning, kStatePaused };
+
+// What the render thread does once it leaves its loop
+enum ExitAction { kExitNone, kExitPause, kExitStop, kExitHalt, kExitDispose };
+
+// The public AudioQueueBuffer comes first, so AudioQueueBufferRefs can be cast back.
+// Each one is a single allocation: this header, the packet descriptions, then the audio.
+struct AudioQueueBufferImpl {
+    AudioQueueBuffer buffer;
+    AudioQueueRef owner;
+    std::atomic<bool> enqueued;
+    UInt32 trimStart;
+    UInt32 trimEnd;
+    UInt32 parameterCount;
+    AudioQueueParameterEvent parameters[kMaxBufferParameters];
+
+    AudioQueueBufferImpl(AudioQueueRef queue, UInt32 capacity, void* data, UInt32 descriptionCapacity, AudioStreamPacketDescription* descriptions)
+        : buffer{ capacity, data, 0, nullptr, descriptionCapacity, descriptions, 0 },
+          owner(queue),
+          enqueued(false),
+          trimStart(0),
+          trimEnd(0),
+          parameterCount(0) {
+    }
+
+    static AudioQueueBufferImpl* fromRef(AudioQueueBufferRef buffer) {
+        return reinterpret_cast<AudioQueueBufferImpl*>(buffer);
+    }
+};
+
+// Enqueued buffers, in play order. Producers are serialised by the queue's enqueue
+// lock; the consumer is the render thread, or a control call while no render thread
+// is running, and it never blocks.
+class BufferRing {
+public:
+    BufferRing() : _head(0), _tail(0) {
+    }
+
+    bool push(AudioQueueBufferImpl* buffer) {
+        UInt32 tail = _tail.load(std::memory_order_relaxed);
+        if (tail - _head.load(std::memory_order_acquire) == kMaxBuffers) {
+            return false;
+        }
+        _slots[tail % kMaxBuffers] = buffer;
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    AudioQueueBufferImpl* front() const {
+        UInt32 head = _head.load(std::memory_order_relaxed);
+        if (head == _tail.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        return _slots[head % kMaxBuffers];
+    }
+
+    void pop() {
+        _head.store(_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    bool empty() const {
+        return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire);
+    }
+
+private:
+    AudioQueueBufferImpl* _slots[kMaxBuffers];
+    std::atomic<UInt32> _head;
+    std::atomic<UInt32> _tail;
+};
+
+// A buffer's parameter value, due at a frame of the period being rendered
+struct PendingParameter {
+    UInt32 frame;
+    AudioQueueParameterID id;
+    AudioQueueParameterValue value;
+};
+
+struct PropertyListener {
+    AudioQueuePropertyID id;
+    AudioQueuePropertyListenerProc proc;
+    void* userData;
+};
+
+static AudioStreamBasicDescription floatFormat(double sampleRate, UInt32 channels, bool nonInterleaved) {
+    AudioStreamBasicDescription desc = {};
+    desc.mSampleRate = sampleRate;
+    desc.mFormatID = kAudioFormatLinearPCM;
+    desc.mFormatFlags = kAudioFormatFlagsNativeFloatPacked | (nonInterleaved ? kAudioFormatFlagIsNonInterleaved : 0);
+    desc.mChannelsPerFrame = channels;
+    desc.mBitsPerChannel = 32;
+    desc.mFramesPerPacket = 1;
+    desc.mBytesPerFrame = nonInterleaved ? sizeof(float) : sizeof(float) * channels;
+    desc.mBytesPerPacket = desc.mBytesPerFrame;
+    return desc;
+}
+
+} // namespace
+
+struct OpaqueAudioQueueTimeline {
+    UInt64 discontinuities;
+};
+
+struct OpaqueAudioQueueProcessingTap {
+    AudioQueueRef queue;
+    AudioQueueProcessingTapCallback callback;
+    void* clientData;
+    AudioQueueProcessingTapFlags flags;
+
+    // Non-interleaved Float32, one period per channel
+    std::vector<std::vector<float>> channels;
+    std::vector<uint8_t> list;
+    bool startOfStream;
+    bool pulled;
+
+    AudioBufferList* bufferList() {
+        return reinterpret_cast<AudioBufferList*>(&list[0]);
+    }
+};
+
+struct OpaqueAudioQueue {
+    AudioStreamBasicDescription _format;
+    AudioQueueOutputCallback _callback;
+    void* _userData;
+    AudioConverterRef _converter;
+    UInt32 _channels;
+    UInt32 _periodFrames;
+
+    std::unique_ptr<AudioQueueSink> _sink;
+    bool _sinkOpen;
+
+    // _controlLock serialises Start, Stop, Pause, Reset and Dispose from client threads.
+    // The render thread never takes it: control calls made from an output callback only
+    // leave a request for the render loop, since the caller may be waiting for that loop.
+    std::mutex _controlLock;
+    std::mutex _enqueueLock;
+    std::mutex _bufferLock;
+    std::mutex _listenerLock;
+
+    std::vector<AudioQueueBufferImpl*> _buffers;
+    std::vector<PropertyListener> _listeners;
+    BufferRing _ring;
+    std::atomic<SInt64> _queuedFrames;
+
+    pthread_t _thread;
+    std::atomic<bool> _threadStarted;
+    std::atomic<int> _state;
+    std::atomic<int> _exitAction;
+    std::atomic<bool> _stopWhenDrained;
+    std::atomic<bool> _resetRequested;
+    std::atomic<bool> _resetting;
+    std::atomic<bool> _disposing;
+
+    std::atomic<float> _volume;
+    std::atomic<float> _volumeRampTime;
+    std::atomic<float> _pan;
+    std::atomic<UInt32> _metering;
+    std::unique_ptr<std::atomic<float>[]> _levels; // Average and peak power per channel
+
+    OpaqueAudioQueueProcessingTap* _tap;
+
+    // Owned by whoever is consuming the ring
+    AudioQueueBufferImpl* _current;
+    UInt32 _currentFrame;
+    UInt32 _currentEnd;
+    std::vector<AudioQueueBufferImpl*> _finished;
+    std::vector<PendingParameter> _pendingParameters;
+    std::vector<float> _period;
+    UInt32 _sourceFrames; // Frames of the current period that came from buffers
+    bool _effectsApplied;
+    bool _playing; // Something has been played since the last start or reset
+    float _gain;
+    float _gainTarget;
+    float _gainStep;
+    UInt64 _sampleTime;
+
+    std::atomic<UInt64> _renderedFrames;
+    std::atomic<UInt32> _latencyFrames;
+    std::atomic<UInt64> _discontinuities;
+    std::atomic<UInt64> _statPeriods;
+    std::atomic<UInt64> _statUnderruns;
+    std::atomic<UInt64> _statUnderrunFrames;
+    std::atomic<UInt64> _statBuffersCompleted;
+
+    OpaqueAudioQueue(const AudioStreamBasicDescription& format,
+                     AudioQueueOutputCallback callback,
+                     void* userData,
+                     AudioConverterRef converter,
+                     std::unique_ptr<AudioQueueSink> sink)
+        : _format(format),
+          _callback(callback),
+          _userData(userData),
+          _converter(converter),
+          _channels(format.mChannelsPerFrame),
+          _periodFrames(kDefaultPeriodFrames),
+          _sink(std::move(sink)),
+          _sinkOpen(false),
+          _queuedFrames(0),
+          _threadStarted(false),
+          _state(kStateStopped),
+          _exitAction(kExitNone),
+          _stopWhenDrained(false),
+          _resetRequested(false),
+          _resetting(false),
+          _disposing(false),
+          _volume(1.0f),
+          _volumeRampTime(0.0f),
+          _pan(0.0f),
+          _metering(0),
+          _levels(new std::atomic<float>[2 * format.mChannelsPerFrame]),
+          _tap(nullptr),
+          _current(nullptr),
+          _renderedFrames(0),
+          _latencyFrames(0),
+          _discontinuities(0),
+          _statPeriods(0),
+          _statUnderruns(0),
+          _statUnderrunFrames(0),
+          _statBuffersCompleted(0) {
+        for (UInt32 i = 0; i < 2 * _channels; i++) {
+            _levels[i].store(0.0f);
+        }
+        _finished.reserve(kMaxBuffers);
+        _pendingParameters.reserve(4 * kMaxBufferParameters);
+        resetRenderState();
+    }
+
+    ~OpaqueAudioQueue() {
+        closeSink();
+        for (AudioQueueBufferImpl* buffer : _buffers) {
+            buffer->~AudioQueueBufferImpl();
+            free(buffer);
+        }
+        delete _tap;
+        AudioConverterDispose(_converter);
+    }
+
+    bool onRenderThread() const {
+        return _threadStarted.load() && pthread_equal(_thread, pthread_self());
+    }
+
+    // Buffers
+
+    OSStatus allocateBuffer(UInt32 byteSize, UInt32 descriptionCount, AudioQueueBufferRef* outBuffer) {
+        std::lock_guard<std::mutex> lock(_bufferLock);
+        if (_buffers.size() >= kMaxBuffers) {
+            return kAudioQueueErr_InvalidBuffer;
+        }
+
+        size_t headerSize = (sizeof(AudioQueueBufferImpl) + 15) & ~size_t(15);
+        size_t descriptionSize = ((descriptionCount * sizeof(AudioStreamPacketDescription)) + 15) & ~size_t(15);
+        uint8_t* memory = static_cast<uint8_t*>(calloc(1, headerSize + descriptionSize + byteSize));
+        if (!memory) {
+            return kAudio_MemFullError;
+        }
+
+        AudioStreamPacketDescription* descriptions =
+            descriptionCount ? reinterpret_cast<AudioStreamPacketDescription*>(memory + headerSize) : nullptr;
+        AudioQueueBufferImpl* buffer = new (memory)
+            AudioQueueBufferImpl(this, byteSize, memory + headerSize + descriptionSize, descriptionCount, descriptions);
+        _buffers.push_back(buffer);
+
+        *outBuffer = &buffer->buffer;
+        return noErr;
+    }
+
+    OSStatus freeBuffer(AudioQueueBufferRef bufferRef) {
+        std::lock_guard<std::mutex> lock(_bufferLock);
+        auto found = std::find(_buffers.begin(), _buffers.end(), AudioQueueBufferImpl::fromRef(bufferRef));
+        if (found == _buffers.end()) {
+            return kAudioQueueErr_InvalidBuffer;
+        }
+
+        AudioQueueBufferImpl* buffer = *found;
+        if (buffer->enqueued.load()) {
+            return kAudioQueueErr_BufferInQueue;
+        }
+
+        _buffers.erase(found);
+        buffer->~AudioQueueBufferImpl();
+        free(buffer);
+        return noErr;
+    }
+
+    OSStatus enqueue(AudioQueueBufferRef bufferRef,
+                     UInt32 trimStart,
+                     UInt32 trimEnd,
+                     UInt32 parameterCount,
+                     const AudioQueueParameterEvent* parameters,
+                     AudioTimeStamp* outStartTime) {
+        AudioQueueBufferImpl* buffer = AudioQueueBufferImpl::fromRef(bufferRef);
+        if (buffer->owner != this || buffer->buffer.mAudioDataByteSize > buffer->buffer.mAudioDataBytesCapacity) {
+            return kAudioQueueErr_InvalidBuffer;
+        }
+        if (buffer->buffer.mAudioDataByteSize == 0) {
+            return kAudioQueueErr_BufferEmpty;
+        }
+        if (parameterCount > kMaxBufferParameters) {
+            return kAudioQueueErr_InvalidParameter;
+        }
+        if (_disposing.load()) {
+            return kAudioQueueErr_DisposalPending;
+        }
+        if (_resetting.load()) {
+            return kAudioQueueErr_EnqueueDuringReset;
+        }
+
+        std::lock_guard<std::mutex> lock(_enqueueLock);
+        if (buffer->enqueued.load()) {
+            return kAudioQueueErr_BufferInQueue;
+        }
+
+        UInt32 frames = buffer->buffer.mAudioDataByteSize / _format.mBytesPerFrame;
+        buffer->trimStart = std::min(trimStart, frames);
+        buffer->trimEnd = std::min(trimEnd, frames - buffer->trimStart);
+        buffer->parameterCount = parameterCount;
+        std::copy(parameters, parameters + parameterCount, buffer->parameters);
+
+        if (outStartTime) {
+            memset(outStartTime, 0, sizeof(AudioTimeStamp));
+            outStartTime->mSampleTime = _renderedFrames.load() + std::max<SInt64>(_queuedFrames.load(), 0);
+            outStartTime->mFlags = kAudioTimeStampSampleTimeValid;
+        }
+
+        buffer->enqueued.store(true);
+        _queuedFrames += frames - buffer->trimStart - buffer->trimEnd;
+        _ring.push(buffer);
+        return noErr;
+    }
+
+    // Rendering; everything from here to the control calls belongs to the ring's consumer
+
+    void resetRenderState() {
+        _current = nullptr;
+        _finished.clear();
+        _pendingParameters.clear();
+        _sourceFrames = 0;
+        _playing = false;
+        _gain = _gainTarget = _volume.load();
+        _gainStep = 0.0f;
+        if (_tap) {
+            _tap->startOfStream = true;
+        }
+    }
+
+    void beginBuffer(AudioQueueBufferImpl* buffer, UInt32 periodFrame) {
+        for (UInt32 i = 0; i < buffer->parameterCount; i++) {
+            if (_pendingParameters.size() < _pendingParameters.capacity()) {
+                _pendingParameters.push_back({ periodFrame, buffer->parameters[i].mID, buffer->parameters[i].mValue });
+            } else {
+                setParameter(buffer->parameters[i].mID, buffer->parameters[i].mValue);
+            }
+        }
+
+        _current = buffer;
+        _currentFrame = buffer->trimStart;
+        _currentEnd = buffer->buffer.mAudioDataByteSize / _format.mBytesPerFrame - buffer->trimEnd;
+    }
+
+    void finishBuffer() {
+        _queuedFrames -= _currentEnd - _currentFrame;
+        _ring.pop();
+        _finished.push_back(_current);
+        _current = nullptr;
+    }
+
+    // Converts up to count frames of enqueued audio into out, as interleaved Float32,
+    // and pads the rest with silence. Returns the number of frames that were audio.
+    UInt32 pullSource(float* out, UInt32 count) {
+        UInt32 done = 0;
+        while (done < count) {
+            if (!_current) {
+                AudioQueueBufferImpl* next = _ring.front();
+                if (!next) {
+                    break;
+                }
+                beginBuffer(next, done);
+            }
+
+            UInt32 frames = std::min(count - done, _currentEnd - _currentFrame);
+            if (frames > 0) {
+                const uint8_t* in = static_cast<const uint8_t*>(_current->buffer.mAudioData) + _currentFrame * _format.mBytesPerFrame;
+                UInt32 outSize = frames * _channels * sizeof(float);
+                AudioConverterConvertBuffer(_converter, frames * _format.mBytesPerFrame, in, &outSize, out + done * _channels);
+                _queuedFrames -= frames;
+                _currentFrame += frames;
+                done += frames;
+            }
+
+            if (_currentFrame >= _currentEnd) {
+                finishBuffer();
+            }
+        }
+
+        std::fill(out + done * _channels, out + count * _channels, 0.0f);
+        if (done > 0) {
+            _playing = true;
+        }
+        return done;
+    }
+
+    void updateGainTarget() {
+        float target = _volume.load(std::memory_order_relaxed);
+        if (target != _gainTarget) {
+            float rampFrames = _volumeRampTime.load(std::memory_order_relaxed) * static_cast<float>(_format.mSampleRate);
+            _gainTarget = target;
+            _gainStep = rampFrames >= 1.0f ? (target - _gain) / rampFrames : target - _gain;
+        }
+    }
+
+    void applyPendingParameters() {
+        for (const PendingParameter& parameter : _pendingParameters) {
+            setParameter(parameter.id, parameter.value);
+        }
+        _pendingParameters.clear();
+    }
+
+    // Volume, with its ramp, then pan. Parameters that came with buffers change at the
+    // frame where their buffer starts.
+    void applyEffects(float* samples, UInt32 frames) {
+        size_t next = 0;
+        UInt32 frame = 0;
+        while (frame < frames) {
+            for (; next < _pendingParameters.size() && _pendingParameters[next].frame <= frame; next++) {
+                setParameter(_pendingParameters[next].id, _pendingParameters[next].value);
+            }
+            UInt32 end = next < _pendingParameters.size() ? std::min(frames, _pendingParameters[next].frame) : frames;
+
+            updateGainTarget();
+            float pan = _pan.load(std::memory_order_relaxed);
+            float left = _channels == 2 ? std::min(1.0f, 1.0f - pan) : 1.0f;
+            float right = _channels == 2 ? std::min(1.0f, 1.0f + pan) : 1.0f;
+
+            for (; frame < end; frame++) {
+                if (_gain != _gainTarget) {
+                    _gain += _gainStep;
+                    if ((_gainStep > 0.0f && _gain > _gainTarget) || (_gainStep < 0.0f && _gain < _gainTarget)) {
+                        _gain = _gainTarget;
+                    }
+                }
+
+                float* sample = samples + frame * _channels;
+                if (_channels == 2) {
+                    sample[0] *= _gain * left;
+                    sample[1] *= _gain * right;
+                } else {
+                    for (UInt32 channel = 0; channel < _channels; channel++) {
+                        sample[channel] *= _gain;
+                    }
+                }
+            }
+        }
+        applyPendingParameters();
+    }
+
+    void updateLevels(const float* samples, UInt32 frames) {
+        for (UInt32 channel = 0; channel < _channels; channel++) {
+            float sum = 0.0f;
+            float peak = 0.0f;
+            for (UInt32 frame = 0; frame < frames; frame++) {
+                float sample = samples[frame * _channels + channel];
+                sum += sample * sample;
+                peak = std::max(peak, fabsf(sample));
+            }
+            _levels[2 * channel].store(frames ? sqrtf(sum / frames) : 0.0f, std::memory_order_relaxed);
+            _levels[2 * channel + 1].store(peak, std::memory_order_relaxed);
+        }
+    }
+
+    // Called by the tap, from inside its callback
+    UInt32 tapGetSource(UInt32 frames, AudioBufferList* ioData) {
+        _sourceFrames = pullSource(&_period[0], frames);
+        if (_tap->flags & kAudioQueueProcessingTap_PostEffects) {
+            applyEffects(&_period[0], frames);
+            _effectsApplied = true;
+        }
+
+        for (UInt32 channel = 0; channel < _channels && channel < ioData->mNumberBuffers; channel++) {
+            float* out = static_cast<float*>(ioData->mBuffers[channel].mData);
+            for (UInt32 frame = 0; frame < frames; frame++) {
+                out[frame] = _period[frame * _channels + channel];
+            }
+            ioData->mBuffers[channel].mDataByteSize = frames * sizeof(float);
+        }
+
+        _tap->pulled = true;
+        return _sourceFrames;
+    }
+
+    void renderTap(UInt32 frames) {
+        OpaqueAudioQueueProcessingTap* tap = _tap;
+        AudioBufferList* list = tap->bufferList();
+        for (UInt32 channel = 0; channel < _channels; channel++) {
+            list->mBuffers[channel].mNumberChannels = 1;
+            list->mBuffers[channel].mDataByteSize = frames * sizeof(float);
+            list->mBuffers[channel].mData = &tap->channels[channel][0];
+        }
+
+        AudioTimeStamp timeStamp = {};
+        timeStamp.mSampleTime = static_cast<Float64>(_sampleTime);
+        timeStamp.mFlags = kAudioTimeStampSampleTimeValid;
+
+        AudioQueueProcessingTapFlags flags = tap->flags & ~kAudioQueueProcessingTap_Siphon;
+        if (tap->startOfStream) {
+            flags |= kAudioQueueProcessingTap_StartOfStream;
+            tap->startOfStream = false;
+        }
+
+        UInt32 outFrames = 0;
+        tap->pulled = false;
+        tap->callback(tap->clientData, tap, frames, &timeStamp, &flags, &outFrames, list);
+
+        if (!tap->pulled) {
+            // The tap generated its own audio; the source still has to be consumed
+            _sourceFrames = pullSource(&_period[0], frames);
+        }
+
+        if (!(tap->flags & kAudioQueueProcessingTap_Siphon)) {
+            outFrames = std::min(outFrames, frames);
+            for (UInt32 channel = 0; channel < _channels; channel++) {
+                const float* in = static_cast<const float*>(list->mBuffers[channel].mData);
+                for (UInt32 frame = 0; frame < outFrames; frame++) {
+                    _period[frame * _channels + channel] = in[frame];
+                }
+            }
+            std::fill(_period.begin() + outFrames * _channels, _period.begin() + frames * _channels, 0.0f);
+
+            // What the tap returned replaces the source, effects and all
+            if (tap->flags & kAudioQueueProcessingTap_PostEffects) {
+                _effectsApplied = true;
+            }
+        }
+    }
+
+    void renderPeriod(UInt32 frames) {
+        _effectsApplied = false;
+        if (_tap) {
+            renderTap(frames);
+        } else {
+            _sourceFrames = pullSource(&_period[0], frames);
+        }
+
+        if (!_effectsApplied) {
+            applyEffects(&_period[0], frames);
+        }
+        applyPendingParameters();
+        if (_metering.load(std::memory_order_relaxed)) {
+            updateLevels(&_period[0], frames);
+        }
+    }
+
+    void deliverFinished() {
+        // Output callbacks may enqueue, but only onto the ring, never onto _finished
+        for (size_t i = 0; i < _finished.size(); i++) {
+            _finished[i]->enqueued.store(false);
+            _statBuffersCompleted++;
+            _callback(_userData, this, &_finished[i]->buffer);
+        }
+        _finished.clear();
+    }
+
+    // Hands every enqueued buffer back to the client without playing it
+    void returnAllBuffers() {
+        _resetting.store(true);
+        if (_current) {
+            finishBuffer();
+        }
+        while (AudioQueueBufferImpl* buffer = _ring.front()) {
+            _ring.pop();
+            _finished.push_back(buffer);
+        }
+        _queuedFrames.store(0);
+
+        for (size_t i = 0; i < _finished.size(); i++) {
+            _finished[i]->enqueued.store(false);
+            _callback(_userData, this, &_finished[i]->buffer);
+        }
+        _finished.clear();
+        _resetting.store(false);
+    }
+
+    void renderLoop() {
+        while (_exitAction.load(std::memory_order_acquire) == kExitNone) {
+            UInt32 frames = _periodFrames;
+            renderPeriod(frames);
+
+            // Hand buffers back before blocking on the sink, so the client has the
+            // whole period to refill them. A callback may also ask to stop or reset.
+            deliverFinished();
+            if (_resetRequested.exchange(false)) {
+                returnAllBuffers();
+                resetRenderState();
+                _discontinuities++;
+            }
+
+            bool drained = _stopWhenDrained.load() && !_current && _ring.empty();
+            if (_sourceFrames < frames && _playing && !drained) {
+                _statUnderruns++;
+                _statUnderrunFrames += frames - _sourceFrames;
+                _discontinuities++;
+            }
+
+            UInt32 writeFrames = drained ? _sourceFrames : frames;
+            if (writeFrames > 0) {
+                OSStatus status = _sink->write(&_period[0], writeFrames);
+                if (status != noErr) {
+                    TraceError(TAG, L"Audio queue output failed with %d; stopping", status);
+                    int expected = kExitNone;
+                    _exitAction.compare_exchange_strong(expected, kExitStop);
+                }
+                _sampleTime += writeFrames;
+                _renderedFrames.store(_sampleTime);
+                _latencyFrames.store(_sink->latencyFrames());
+                _statPeriods++;
+            }
+
+            if (drained) {
+                int expected = kExitNone;
+                _exitAction.compare_exchange_strong(expected, kExitStop);
+            }
+        }
+    }
+
+    static void* renderThreadMain(void* param) {
+        OpaqueAudioQueue* queue = static_cast<OpaqueAudioQueue*>(param);
+        queue->renderLoop();
+
+        switch (queue->_exitAction.load()) {
+            case kExitPause:
+                queue->_state.store(kStatePaused);
+                break;
+            case kExitStop:
+                queue->stopped();
+                break;
+            case kExitDispose:
+                pthread_detach(pthread_self());
+                queue->_threadStarted.store(false);
+                delete queue;
+                break;
+        }
+        return nullptr;
+    }
+
+    bool startThread() {
+        // The highest priority maps to THREAD_PRIORITY_TIME_CRITICAL
+        struct sched_param param = { sched_get_priority_max(0) };
+
+        pthread_attr_t attrs;
+        pthread_attr_init(&attrs);
+        pthread_attr_setschedparam(&attrs, &param);
+        _exitAction.store(kExitNone);
+        int status = pthread_create(&_thread, &attrs, renderThreadMain, this);
+        pthread_attr_destroy(&attrs);
+
+        if (status != 0) {
+            TraceError(TAG, L"Unable to create the audio queue render thread. Error code : %d.", status);
+            return false;
+        }
+        _threadStarted.store(true);
+        return true;
+    }
+
+    // Asks the render thread to leave, unless it is already on its way out, and waits for it.
+    // Called with _controlLock held, never from the render thread.
+    void joinThread(ExitAction action) {
+        if (!_threadStarted.load()) {
+            return;
+        }
+        int expected = kExitNone;
+        _exitAction.compare_exchange_strong(expected, action);
+        pthread_join(_thread, nullptr);
+        _threadStarted.store(false);
+    }
+
+    // Reaps a render thread that stopped by itself
+    void reapThread() {
+        if (_threadStarted.load() && _exitAction.load() != kExitNone) {
+            joinThread(kExitHalt);
+        }
+    }
+
+    // Control
+
+    OSStatus openSink() {
+        _period.assign(_periodFrames * _channels, 0.0f);
+        if (_tap) {
+            for (auto& channel : _tap->channels) {
+                channel.assign(_periodFrames, 0.0f);
+            }
+        }
+
+        OSStatus status = _sink->open(_format.mSampleRate, _channels, _periodFrames);
+        _sinkOpen = status == noErr;
+        return status;
+    }
+
+    void closeSink() {
+        if (_sinkOpen) {
+            _sink->close();
+            _sinkOpen = false;
+        }
+    }
+
+    void notifyListeners(AudioQueuePropertyID id) {
+        std::vector<PropertyListener> listeners;
+        {
+            std::lock_guard<std::mutex> lock(_listenerLock);
+            listeners = _listeners;
+        }
+        for (const PropertyListener& listener : listeners) {
+            if (listener.id == id) {
+                listener.proc(listener.userData, this, id);
+            }
+        }
+    }
+
+    // Runs on whichever thread finished the queue off
+    void stopped() {
+        if (_state.load() == kStateStopped) {
+            return;
+        }
+        returnAllBuffers();
+        closeSink();
+        _stopWhenDrained.store(false);
+        _latencyFrames.store(0);
+        _state.store(kStateStopped);
+        notifyListeners(kAudioQueueProperty_IsRunning);
+    }
+
+    OSStatus start() {
+        if (onRenderThread()) {
+            if (_state.load() != kStateRunning) {
+                return kAudioQueueErr_InvalidRunState;
+            }
+            // Cancels a pending asynchronous stop; this thread is the one that would act on it
+            _stopWhenDrained.store(false);
+            return noErr;
+        }
+
+        std::lock_guard<std::mutex> lock(_controlLock);
+        reapThread();
+        if (_disposing.load()) {
+            return kAudioQueueErr_DisposalPending;
+        }
+        if (_threadStarted.load()) {
+            if (!_stopWhenDrained.load()) {
+                return noErr;
+            }
+
+            // An asynchronous stop is pending, and the render thread may already have committed to it.
+            // Take the thread down and start a fresh one below, restarting the queue if it did stop.
+            joinThread(kExitHalt);
+        }
+
+        bool wasStopped = _state.load() == kStateStopped;
+        if (wasStopped) {
+            if (openSink() != noErr) {
+                return kAudioQueueErr_CannotStart;
+            }
+            resetRenderState();
+            _sampleTime = 0;
+            _renderedFrames.store(0);
+        }
+
+        _stopWhenDrained.store(false);
+        _state.store(kStateRunning);
+        if (!startThread()) {
+            if (wasStopped) {
+                closeSink();
+                _state.store(kStateStopped);
+            } else {
+                _state.store(kStatePaused);
+            }
+            return kAudioQueueErr_CannotStart;
+        }
+
+        if (wasStopped) {
+            notifyListeners(kAudioQueueProperty_IsRunning);
+        }
+        return noErr;
+    }
+
+    OSStatus stop(bool immediate) {
+        if (onRenderThread()) {
+            if (immediate) {
+                int expected = kExitNone;
+                _exitAction.compare_exchange_strong(expected, kExitStop);
+            } else {
+                _stopWhenDrained.store(true);
+            }
+            return noErr;
+        }
+
+        std::lock_guard<std::mutex> lock(_controlLock);
+        reapThread();
+        if (_threadStarted.load()) {
+            if (!immediate) {
+                // Asynchronous; the render thread stops once it has played everything
+                _stopWhenDrained.store(true);
+                return noErr;
+            }
+            joinThread(kExitStop);
+        }
+
+        stopped();
+        return noErr;
+    }
+
+    OSStatus pause() {
+        if (onRenderThread()) {
+            int expected = kExitNone;
+            _exitAction.compare_exchange_strong(expected, kExitPause);
+            return noErr;
+        }
+
+        std::lock_guard<std::mutex> lock(_controlLock);
+        joinThread(kExitPause);
+        return noErr;
+    }
+
+    OSStatus reset() {
+        if (onRenderThread()) {
+            _resetRequested.store(true);
+            return noErr;
+        }
+
+        std::lock_guard<std::mutex> lock(_controlLock);
+        reapThread();
+        bool running = _threadStarted.load();
+        if (running) {
+            joinThread(kExitHalt);
+        }
+
+        returnAllBuffers();
+        resetRenderState();
+        _discontinuities++;
+
+        if (running && !startThread()) {
+            _state.store(kStatePaused);
+            return kAudioQueueErr_CannotStart;
+        }
+        return noErr;
+    }
+
+    OSStatus dispose(bool immediate) {
+        _disposing.store(true);
+        if (onRenderThread()) {
+            _exitAction.store(kExitDispose);
+            return noErr;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_controlLock);
+            if (_threadStarted.load() && !immediate && _exitAction.load() == kExitNone && _state.load() == kStateRunning) {
+                // Play out what is already enqueued first
+                _stopWhenDrained.store(true);
+                pthread_join(_thread, nullptr);
+                _threadStarted.store(false);
+            }
+            joinThread(kExitHalt);
+        }
+
+        delete this;
+        return noErr;
+    }
+
+    // Parameters and properties
+
+    OSStatus setParameter(AudioQueueParameterID id, AudioQueueParameterValue value) {
+        switch (id) {
+            case kAudioQueueParam_Volume:
+                _volume.store(std::max(0.0f, std::min(1.0f, value)));
+                return noErr;
+            case kAudioQueueParam_VolumeRampTime:
+                _volumeRampTime.store(std::max(0.0f, value));
+                return noErr;
+            case kAudioQueueParam_Pan:
+                _pan.store(std::max(-1.0f, std::min(1.0f, value)));
+                return noErr;
+        }
+        return kAudioQueueErr_InvalidParameter;
+    }
+
+    OSStatus getParameter(AudioQueueParameterID id, AudioQueueParameterValue* value) {
+        switch (id) {
+            case kAudioQueueParam_Volume:
+                *value = _volume.load();
+                return noErr;
+            case kAudioQueueParam_VolumeRampTime:
+                *value = _volumeRampTime.load();
+                return noErr;
+            case kAudioQueueParam_Pan:
+                *value = _pan.load();
+                return noErr;
+        }
+        return kAudioQueueErr_InvalidParameter;
+    }
+
+    OSStatus getPropertySize(AudioQueuePropertyID id, UInt32* size) {
+        switch (id) {
+            case kAudioQueueProperty_IsRunning:
+            case kAudioQueueDeviceProperty_NumberChannels:
+            case kAudioQueueProperty_MaximumOutputPacketSize:
+            case kAudioQueueProperty_EnableLevelMetering:
+            case kAudioQueueProperty_DecodeBufferSizeFrames:
+            case kAudioQueueProperty_ConverterError:
+                *size = sizeof(UInt32);
+                return noErr;
+            case kAudioQueueDeviceProperty_SampleRate:
+                *size = sizeof(Float64);
+                return noErr;
+            case kAudioQueueProperty_StreamDescription:
+                *size = sizeof(AudioStreamBasicDescription);
+                return noErr;
+            case kAudioQueueProperty_CurrentLevelMeter:
+            case kAudioQueueProperty_CurrentLevelMeterDB:
+                *size = _channels * sizeof(AudioQueueLevelMeterState);
+                return noErr;
+        }
+        return kAudioQueueErr_InvalidProperty;
+    }
+
+    OSStatus getProperty(AudioQueuePropertyID id, void* data, UInt32* size) {
+        UInt32 required;
+        OSStatus status = getPropertySize(id, &required);
+        if (status != noErr) {
+            return status;
+        }
+
+        UInt32 value = 0;
+        switch (id) {
+            case kAudioQueueProperty_IsRunning:
+                value = _state.load() != kStateStopped;
+                break;
+            case kAudioQueueDeviceProperty_NumberChannels:
+                value = _channels;
+                break;
+            case kAudioQueueProperty_MaximumOutputPacketSize:
+                value = _format.mBytesPerPacket;
+                break;
+            case kAudioQueueProperty_EnableLevelMetering:
+                value = _metering.load();
+                break;
+            case kAudioQueueProperty_DecodeBufferSizeFrames:
+                value = _periodFrames;
+                break;
+            case kAudioQueueProperty_ConverterError:
+                value = noErr;
+                break;
+            case kAudioQueueDeviceProperty_SampleRate:
+                if (*size < sizeof(Float64)) {
+                    return kAudioQueueErr_InvalidPropertySize;
+                }
+                *static_cast<Float64*>(data) = _format.mSampleRate;
+                *size = sizeof(Float64);
+                return noErr;
+            case kAudioQueueProperty_StreamDescription:
+                if (*size < sizeof(AudioStreamBasicDescription)) {
+                    return kAudioQueueErr_InvalidPropertySize;
+                }
+                *static_cast<AudioStreamBasicDescription*>(data) = _format;
+                *size = sizeof(AudioStreamBasicDescription);
+                return noErr;
+            case kAudioQueueProperty_CurrentLevelMeter:
+            case kAudioQueueProperty_CurrentLevelMeterDB: {
+                if (!_metering.load()) {
+                    return kAudioQueueErr_InvalidPropertyValue;
+                }
+
+                // Fewer channels than the queue has may be asked for
+                UInt32 channels = std::min<UInt32>(_channels, *size / sizeof(AudioQueueLevelMeterState));
+                AudioQueueLevelMeterState* levels = static_cast<AudioQueueLevelMeterState*>(data);
+                for (UInt32 channel = 0; channel < channels; channel++) {
+                    levels[channel].mAveragePower = _levels[2 * channel].load(std::memory_order_relaxed);
+                    levels[channel].mPeakPower = _levels[2 * channel + 1].load(std::memory_order_relaxed);
+                    if (id == kAudioQueueProperty_CurrentLevelMeterDB) {
+                        levels[channel].mAveragePower = 20.0f * log10f(std::max(levels[channel].mAveragePower, 1e-6f));
+                        levels[channel].mPeakPower = 20.0f * log10f(std::max(levels[channel].mPeakPower, 1e-6f));
+                    }
+                }
+                *size = channels * sizeof(AudioQueueLevelMeterState);
+                return noErr;
+            }
+        }
+
+        if (*size < sizeof(UInt32)) {
+            return kAudioQueueErr_InvalidPropertySize;
+        }
+        *static_cast<UInt32*>(data) = value;
+        *size = sizeof(UInt32);
+        return noErr;
+    }
+
+    OSStatus setProperty(AudioQueuePropertyID id, const void* data, UInt32 size) {
+        switch (id) {
+            case kAudioQueueProperty_EnableLevelMetering:
+                if (size != sizeof(UInt32)) {
+                    return kAudioQueueErr_InvalidPropertySize;
+                }
+                _metering.store(*static_cast<const UInt32*>(data) != 0);
+                return noErr;
+            case kAudioQueueProperty_DecodeBufferSizeFrames: {
+                if (size != sizeof(UInt32)) {
+                    return kAudioQueueErr_InvalidPropertySize;
+                }
+                UInt32 frames = *static_cast<const UInt32*>(data);
+                if (frames == 0 || frames > kMaxPeriodFrames) {
+                    return kAudioQueueErr_InvalidPropertyValue;
+                }
+
+                std::lock_guard<std::mutex> lock(_controlLock);
+                if (_state.load() != kStateStopped) {
+                    return kAudioQueueErr_InvalidRunState;
+                }
+                _periodFrames = frames;
+                return noErr;
+            }
+        }
+
+        UInt32 ignored;
+        return getPropertySize(id, &ignored) == noErr ? kAudioQueueErr_InvalidPropertyValue : kAudioQueueErr_InvalidProperty;
+    }
+
+    void addListener(AudioQueuePropertyID id, AudioQueuePropertyListenerProc proc, void* userData) {
+        std::lock_guard<std::mutex> lock(_listenerLock);
+        _listeners.push_back({ id, proc, userData });
+    }
+
+    void removeListener(AudioQueuePropertyID id, AudioQueuePropertyListenerProc proc, void* userData) {
+        std::lock_guard<std::mutex> lock(_listenerLock);
+        _listeners.erase(std::remove_if(_listeners.begin(),
+                                        _listeners.end(),
+                                        [&](const PropertyListener& listener) {
+                                            return listener.id == id && listener.proc == proc && listener.userData == userData;
+                                        }),
+                         _listeners.end());
+    }
+
+    // The sample time being heard, counted from the last start
+    Float64 currentSampleTime() {
+        UInt64 rendered = _renderedFrames.load();
+        UInt32 latency = _latencyFrames.load();
+        return static_cast<Float64>(rendered > latency ? rendered - latency : 0);
+    }
+};
+
+OSStatus AudioQueueSetSink(AudioQueueRef queue, std::unique_ptr<AudioQueueSink> sink) {
+    if (!queue || !sink) {
+        return kAudio_ParamError;
+    }
+
+    std::lock_guard<std::mutex> lock(queue->_controlLock);
+    if (queue->_state.load() != kStateStopped) {
+        return kAudioQueueErr_InvalidRunState;
+    }
+    queue->_sink = std::move(sink);
+    return noErr;
+}
+
+OSStatus AudioQueueGetRenderStatistics(AudioQueueRef queue, AudioQueueRenderStatistics* statistics) {
+    if (!queue || !statistics) {
+        return kAudio_ParamError;
+    }
+
+    statistics->periods = queue->_statPeriods.load();
+    statistics->frames = queue->_renderedFrames.load();
+    statistics->underruns = queue->_statUnderruns.load();
+    statistics->underrunFrames = queue->_statUnderrunFrames.load();
+    statistics->buffersCompleted = queue->_statBuffersCompleted.load();
+    return noErr;
+}
 
 /**
- @Status Stub
- @Notes
+ @Status Caveat
+ @Notes inStartTime is ignored; playback starts as soon as possible
 */
 OSStatus AudioQueueStart(AudioQueueRef inAQ, const AudioTimeStamp* inStartTime) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    if (!inAQ) {
+        return kAudio_ParamError;
+    }
+    return inAQ->start();
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Caveat
+ @Notes Linear PCM needs no decoding, so this only reports how many frames are enqueued
 */
 OSStatus AudioQueuePrime(AudioQueueRef inAQ, UInt32 inNumberOfFramesToPrepare, UInt32* outNumberOfFramesPrepared) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    if (!inAQ) {
+        return kAudio_ParamError;
+    }
+
+    if (outNumberOfFramesPrepared) {
+        UInt32 queued = static_cast<UInt32>(std::max<SInt64>(inAQ->_queuedFrames.load(), 0));
+        *outNumberOfFramesPrepared = inNumberOfFramesToPrepare ? std::min(queued, inNumberOfFramesToPrepare) : queued;
+    }
+    return noErr;
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
+ @Notes Linear PCM has no decoder state to flush, so every enqueued frame is always played
 */
 OSStatus AudioQueueFlush(AudioQueueRef inAQ) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    if (!inAQ) {
+        return kAudio_ParamError;
+    }
+    return noErr;
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 OSStatus AudioQueueStop(AudioQueueRef inAQ, Boolean inImmediate) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    if (!inAQ) {
+        return kAudio_ParamError;
+    }
+    return inAQ->stop(inImmediate);
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 OSStatus AudioQueuePause(AudioQueueRef inAQ) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    if (!inAQ) {
+        return kAudio_ParamError;
+    }
+    return inAQ->pause();
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 OSStatus AudioQueueReset(AudioQueueRef inAQ) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    if (!inAQ) {
+        return kAudio_ParamError;
+    }
+    return inAQ->reset();
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Caveat
+ @Notes Only interleaved linear PCM is supported. Callbacks are always made on the queue's own render thread,
+        so inCallbackRunLoop and inCallbackRunLoopMode are ignored.
 */
 OSStatus AudioQueueNewOutput(const AudioStreamBasicDescription* inFormat,
                              AudioQueueOutputCallback inCallbackProc,
@@ -82,8 +1188,27 @@ OSStatus AudioQueueNewOutput(const AudioStreamBasicDescription* inFormat,
                              CFStringRef inCallbackRunLoopMode,
                              UInt32 inFlags,
                              AudioQueueRef _Nullable* outAQ) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    if (!inFormat || !inCallbackProc || !outAQ) {
+        return kAudio_ParamError;
+    }
+    *outAQ = nullptr;
+
+    if (inFormat->mFormatID != kAudioFormatLinearPCM) {
+        return kAudioQueueErr_CodecNotFound;
+    }
+    if ((inFormat->mFormatFlags & kAudioFormatFlagIsNonInterleaved) || inFormat->mSampleRate <= 0.0) {
+        return kAudioFormatUnsupportedDataFormatError;
+    }
+
+    AudioStreamBasicDescription output = floatFormat(inFormat->mSampleRate, inFormat->mChannelsPerFrame, false);
+    AudioConverterRef converter;
+    if (AudioConverterNew(inFormat, &output, &converter) != noErr) {
+        return kAudioFormatUnsupportedDataFormatError;
+    }
+
+    std::unique_ptr<AudioQueueSink> sink = AudioQueueCreateDefaultSink();
+    *outAQ = new OpaqueAudioQueue(*inFormat, inCallbackProc, inUserData, converter, std::move(sink));
+    return noErr;
 }
 
 /**
@@ -102,59 +1227,64 @@ OSStatus AudioQueueNewInput(const AudioStreamBasicDescription* inFormat,
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 OSStatus AudioQueueDispose(AudioQueueRef inAQ, Boolean inImmediate) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    if (!inAQ) {
+        return kAudio_ParamError;
+    }
+    return inAQ->dispose(inImmediate);
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 OSStatus AudioQueueAllocateBuffer(AudioQueueRef inAQ, UInt32 inBufferByteSize, AudioQueueBufferRef _Nullable* outBuffer) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    return AudioQueueAllocateBufferWithPacketDescriptions(inAQ, inBufferByteSize, 0, outBuffer);
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Caveat
+ @Notes Packet descriptions are never needed for linear PCM, and are ignored
 */
 OSStatus AudioQueueAllocateBufferWithPacketDescriptions(AudioQueueRef inAQ,
                                                         UInt32 inBufferByteSize,
                                                         UInt32 inNumberPacketDescriptions,
                                                         AudioQueueBufferRef _Nullable* outBuffer) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    if (!inAQ || !outBuffer || inBufferByteSize == 0) {
+        return kAudio_ParamError;
+    }
+    return inAQ->allocateBuffer(inBufferByteSize, inNumberPacketDescriptions, outBuffer);
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 OSStatus AudioQueueFreeBuffer(AudioQueueRef inAQ, AudioQueueBufferRef inBuffer) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    if (!inAQ || !inBuffer) {
+        return kAudio_ParamError;
+    }
+    return inAQ->freeBuffer(inBuffer);
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Caveat
+ @Notes Packet descriptions are ignored, since only linear PCM is supported
 */
 OSStatus AudioQueueEnqueueBuffer(AudioQueueRef inAQ,
                                  AudioQueueBufferRef inBuffer,
                                  UInt32 inNumPacketDescs,
                                  const AudioStreamPacketDescription* inPacketDescs) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    if (!inAQ || !inBuffer) {
+        return kAudio_ParamError;
+    }
+    return inAQ->enqueue(inBuffer, 0, 0, 0, nullptr, nullptr);
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Caveat
+ @Notes inStartTime is ignored and buffers play back to back. Parameter values take effect when the
+        buffer starts playing; at most 8 may be given.
 */
 OSStatus AudioQueueEnqueueBufferWithParameters(AudioQueueRef inAQ,
                                                AudioQueueBufferRef inBuffer,
@@ -166,104 +1296,135 @@ OSStatus AudioQueueEnqueueBufferWithParameters(AudioQueueRef inAQ,
                                                const AudioQueueParameterEvent* inParamValues,
                                                const AudioTimeStamp* inStartTime,
                                                AudioTimeStamp* outActualStartTime) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    if (!inAQ || !inBuffer || (inNumParamValues && !inParamValues)) {
+        return kAudio_ParamError;
+    }
+    return inAQ->enqueue(inBuffer, inTrimFramesAtStart, inTrimFramesAtEnd, inNumParamValues, inParamValues, outActualStartTime);
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Caveat
+ @Notes Only kAudioQueueParam_Volume, kAudioQueueParam_VolumeRampTime and kAudioQueueParam_Pan are supported
 */
 OSStatus AudioQueueGetParameter(AudioQueueRef inAQ, AudioQueueParameterID inParamID, AudioQueueParameterValue* outValue) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    if (!inAQ || !outValue) {
+        return kAudio_ParamError;
+    }
+    return inAQ->getParameter(inParamID, outValue);
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Caveat
+ @Notes Only kAudioQueueParam_Volume, kAudioQueueParam_VolumeRampTime and kAudioQueueParam_Pan are supported
 */
 OSStatus AudioQueueSetParameter(AudioQueueRef inAQ, AudioQueueParameterID inParamID, AudioQueueParameterValue inValue) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    if (!inAQ) {
+        return kAudio_ParamError;
+    }
+    return inAQ->setParameter(inParamID, inValue);
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Caveat
+ @Notes kAudioQueueProperty_CurrentDevice, kAudioQueueProperty_MagicCookie, kAudioQueueProperty_ChannelLayout and
+        kAudioQueueProperty_HardwareCodecPolicy are not supported
 */
 OSStatus AudioQueueGetProperty(AudioQueueRef inAQ, AudioQueuePropertyID inID, void* outData, UInt32* ioDataSize) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    if (!inAQ || !outData || !ioDataSize) {
+        return kAudio_ParamError;
+    }
+    return inAQ->getProperty(inID, outData, ioDataSize);
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Caveat
+ @Notes Only kAudioQueueProperty_EnableLevelMetering and kAudioQueueProperty_DecodeBufferSizeFrames can be set
 */
 OSStatus AudioQueueSetProperty(AudioQueueRef inAQ, AudioQueuePropertyID inID, const void* inData, UInt32 inDataSize) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    if (!inAQ || !inData) {
+        return kAudio_ParamError;
+    }
+    return inAQ->setProperty(inID, inData, inDataSize);
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Caveat
+ @Notes See AudioQueueGetProperty
 */
 OSStatus AudioQueueGetPropertySize(AudioQueueRef inAQ, AudioQueuePropertyID inID, UInt32* outDataSize) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    if (!inAQ || !outDataSize) {
+        return kAudio_ParamError;
+    }
+    return inAQ->getPropertySize(inID, outDataSize);
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Caveat
+ @Notes Only kAudioQueueProperty_IsRunning ever changes, so no other listener is called
 */
 OSStatus AudioQueueAddPropertyListener(AudioQueueRef inAQ,
                                        AudioQueuePropertyID inID,
                                        AudioQueuePropertyListenerProc inProc,
                                        void* inUserData) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    if (!inAQ || !inProc) {
+        return kAudio_ParamError;
+    }
+    inAQ->addListener(inID, inProc, inUserData);
+    return noErr;
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 OSStatus AudioQueueRemovePropertyListener(AudioQueueRef inAQ,
                                           AudioQueuePropertyID inID,
                                           AudioQueuePropertyListenerProc inProc,
                                           void* inUserData) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    if (!inAQ || !inProc) {
+        return kAudio_ParamError;
+    }
+    inAQ->removeListener(inID, inProc, inUserData);
+    return noErr;
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 OSStatus AudioQueueCreateTimeline(AudioQueueRef inAQ, AudioQueueTimelineRef _Nullable* outTimeline) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    if (!inAQ || !outTimeline) {
+        return kAudio_ParamError;
+    }
+    *outTimeline = new OpaqueAudioQueueTimeline{ inAQ->_discontinuities.load() };
+    return noErr;
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Interoperable
 */
 OSStatus AudioQueueDisposeTimeline(AudioQueueRef inAQ, AudioQueueTimelineRef inTimeline) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    if (!inAQ || !inTimeline) {
+        return kAudio_ParamError;
+    }
+    delete inTimeline;
+    return noErr;
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Caveat
+ @Notes Only the sample time is valid
 */
 OSStatus AudioQueueDeviceGetCurrentTime(AudioQueueRef inAQ, AudioTimeStamp* outTimeStamp) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    if (!inAQ || !outTimeStamp) {
+        return kAudio_ParamError;
+    }
+    if (inAQ->_state.load() == kStateStopped) {
+        return kAudioQueueErr_InvalidRunState;
+    }
+
+    memset(outTimeStamp, 0, sizeof(AudioTimeStamp));
+    outTimeStamp->mSampleTime = inAQ->currentSampleTime();
+    outTimeStamp->mFlags = kAudioTimeStampSampleTimeValid;
+    return noErr;
 }
 
 /**
@@ -285,15 +1446,36 @@ OSStatus AudioQueueDeviceTranslateTime(AudioQueueRef inAQ, const AudioTimeStamp*
 }
 
 /**
- @Status Stub
- @Notes
+ @Status Caveat
+ @Notes Only the sample time is valid. Underruns and resets count as timeline discontinuities.
 */
 OSStatus AudioQueueGetCurrentTime(AudioQueueRef inAQ,
                                   AudioQueueTimelineRef inTimeline,
                                   AudioTimeStamp* outTimeStamp,
                                   Boolean* outTimelineDiscontinuity) {
-    UNIMPLEMENTED();
-    return StubReturn();
+    if (!inAQ) {
+        return kAudio_ParamError;
+    }
+    if (inAQ->_state.load() == kStateStopped) {
+        return kAudioQueueErr_InvalidRunState;
+    }
+
+    if (outTimeStamp) {
+        memset(outTimeStamp, 0, sizeof(AudioTimeStamp));
+        outTimeStamp->mSampleTime = inAQ->currentSampleTime();
+        outTimeStamp->mFlags = kAudioTimeStampSampleTimeValid;
+    }
+
+    if (inTimeline) {
+        UInt64 discontinuities = inAQ->_discontinuities.load();
+        if (outTimelineDiscontinuity) {
+            *outTimelineDiscontinuity = discontinuities != inTimeline->discontinuities;
+        }
+        inTimeline->discontinuities = discontinuities;
+    } else if (outTimelineDiscontinuity) {
+        *outTimelineDiscontinuity = false;
+    }
+    return noErr;
 }
 
 /**
@@ -317,4 +1499,120 @@ OSStatus AudioQueueOfflineRender(AudioQueueRef inAQ,
                                  UInt32 inNumberFrames) {
     UNIMPLEMENTED();
     return StubReturn();
-}
\ No newline at end of file
+}
+
+/**
+ @Status Caveat
+ @Notes The processing format is non-interleaved Float32 at the queue's sample rate and channel count.
+        Taps can only be added or removed while the queue is stopped.
+*/
+OSStatus AudioQueueProcessingTapNew(AudioQueueRef inAQ,
+                                    AudioQueueProcessingTapCallback inCallback,
+                                    void* inClientData,
+                                    AudioQueueProcessingTapFlags inFlags,
+                                    UInt32* outMaxFrames,
+                                    AudioStreamBasicDescription* outProcessingFormat,
+                                    AudioQueueProcessingTapRef _Nullable* outAQTap) {
+    if (!inAQ || !inCallback || !outMaxFrames || !outProcessingFormat || !outAQTap) {
+        return kAudio_ParamError;
+    }
+    if ((inFlags & kAudioQueueProcessingTap_PreEffects) == (inFlags & kAudioQueueProcessingTap_PostEffects)) {
+        // Exactly one of the two is required
+        return kAudio_ParamError;
+    }
+
+    std::lock_guard<std::mutex> lock(inAQ->_controlLock);
+    if (inAQ->_state.load() != kStateStopped) {
+        return kAudioQueueErr_InvalidRunState;
+    }
+    if (inAQ->_tap) {
+        return kAudioQueueErr_InvalidQueueType;
+    }
+
+    OpaqueAudioQueueProcessingTap* tap = new OpaqueAudioQueueProcessingTap();
+    tap->queue = inAQ;
+    tap->callback = inCallback;
+    tap->clientData = inClientData;
+    tap->flags = inFlags & (kAudioQueueProcessingTap_PreEffects | kAudioQueueProcessingTap_PostEffects | kAudioQueueProcessingTap_Siphon);
+    tap->channels.resize(inAQ->_channels);
+    tap->list.resize(offsetof(AudioBufferList, mBuffers) + inAQ->_channels * sizeof(AudioBuffer));
+    tap->bufferList()->mNumberBuffers = inAQ->_channels;
+    tap->startOfStream = true;
+    inAQ->_tap = tap;
+
+    *outMaxFrames = inAQ->_periodFrames;
+    *outProcessingFormat = floatFormat(inAQ->_format.mSampleRate, inAQ->_channels, true);
+    *outAQTap = tap;
+    return noErr;
+}
+
+/**
+ @Status Caveat
+ @Notes The queue has to be stopped
+*/
+OSStatus AudioQueueProcessingTapDispose(AudioQueueProcessingTapRef inAQTap) {
+    if (!inAQTap) {
+        return kAudio_ParamError;
+    }
+
+    AudioQueueRef queue = inAQTap->queue;
+    std::lock_guard<std::mutex> lock(queue->_controlLock);
+    if (queue->_state.load() != kStateStopped) {
+        return kAudioQueueErr_InvalidRunState;
+    }
+
+    queue->_tap = nullptr;
+    delete inAQTap;
+    return noErr;
+}
+
+/**
+ @Status Interoperable
+ @Notes Only valid from inside the tap's callback
+*/
+OSStatus AudioQueueProcessingTapGetSourceAudio(AudioQueueProcessingTapRef inAQTap,
+                                               UInt32 inNumberFrames,
+                                               AudioTimeStamp* ioTimeStamp,
+                                               AudioQueueProcessingTapFlags* outFlags,
+                                               UInt32* outNumberFrames,
+                                               AudioBufferList* ioData) {
+    if (!inAQTap || !ioData || !outNumberFrames) {
+        return kAudio_ParamError;
+    }
+
+    AudioQueueRef queue = inAQTap->queue;
+    if (!queue->onRenderThread() || inAQTap->pulled) {
+        return kAudioQueueErr_InvalidRunState;
+    }
+    if (inNumberFrames > queue->_periodFrames || ioData->mNumberBuffers < queue->_channels) {
+        return kAudio_ParamError;
+    }
+
+    UInt32 frames = queue->tapGetSource(inNumberFrames, ioData);
+    *outNumberFrames = inNumberFrames;
+    if (outFlags) {
+        *outFlags = 0;
+        if (frames < inNumberFrames && queue->_stopWhenDrained.load()) {
+            *outFlags |= kAudioQueueProcessingTap_EndOfStream;
+        }
+    }
+    if (ioTimeStamp) {
+        ioTimeStamp->mSampleTime = static_cast<Float64>(queue->_sampleTime);
+        ioTimeStamp->mFlags = kAudioTimeStampSampleTimeValid;
+    }
+    return noErr;
+}
+
+/**
+ @Status Interoperable
+*/
+OSStatus AudioQueueProcessingTapGetQueueTime(AudioQueueProcessingTapRef inAQTap, Float64* outQueueSampleTime, UInt32* outQueueFrameCount) {
+    if (!inAQTap || !outQueueSampleTime || !outQueueFrameCount) {
+        return kAudio_ParamError;
+    }
+
+    AudioQueueRef queue = inAQTap->queue;
+    *outQueueSampleTime = static_cast<Float64>(queue->_sampleTime);
+    *outQueueFrameCount = queue->_periodFrames;
+    return noErr;
+}
@@ -0,0 +1,240 @@
+//******************************************************************************
+//
+// Copyright (c) 2016 Microsoft Corporation. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+#include "AudioQueueInternal.h"
+#include "AudioConverterKernels.h"
+#include "LoggingNative.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const wchar_t* TAG = L"AudioQueueSink";
+
+namespace {
+
+// Stands in for a device clock: frames are played at the sample rate, and up to
+// _capacity of them can be waiting to be played.
+class RealTimeClock {
+public:
+    void start(double sampleRate, UInt32 capacity) {
+        _sampleRate = sampleRate;
+        _capacity = capacity;
+        _written = 0;
+        _started = false;
+    }
+
+    // Records a write and waits until there is room for another one
+    void wrote(UInt32 frames) {
+        Clock::time_point now = Clock::now();
+        if (!_started) {
+            _origin = now;
+            _started = true;
+        } else if (played(now) > _written) {
+            // The device ran dry; it starts again from whatever arrives now
+            _origin = now - toDuration(_written);
+        }
+
+        _written += frames;
+        if (_written > _capacity) {
+            std::this_thread::sleep_until(_origin + toDuration(_written - _capacity));
+        }
+    }
+
+    UInt32 pending() const {
+        if (!_started) {
+            return static_cast<UInt32>(_written);
+        }
+        double played = this->played(Clock::now());
+        return played < _written ? static_cast<UInt32>(_written - played) : 0;
+    }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    Clock::duration toDuration(UInt64 frames) const {
+        return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(frames / _sampleRate));
+    }
+
+    double played(Clock::time_point now) const {
+        return std::chrono::duration<double>(now - _origin).count() * _sampleRate;
+    }
+
+    double _sampleRate;
+    UInt32 _capacity;
+    UInt64 _written;
+    bool _started;
+    Clock::time_point _origin;
+};
+
+class NullSink : public AudioQueueSink {
+public:
+    explicit NullSink(bool realTime) : _realTime(realTime) {
+    }
+
+    OSStatus open(double sampleRate, UInt32 channels, UInt32 periodFrames) override {
+        _clock.start(sampleRate, 2 * periodFrames);
+        return noErr;
+    }
+
+    OSStatus write(const float* samples, UInt32 frames) override {
+        if (_realTime) {
+            _clock.wrote(frames);
+        }
+        return noErr;
+    }
+
+    void close() override {
+    }
+
+    UInt32 latencyFrames() override {
+        return _realTime ? _clock.pending() : 0;
+    }
+
+private:
+    bool _realTime;
+    RealTimeClock _clock;
+};
+
+static void putLE(uint8_t* out, uint32_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        out[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+class WAVSink : public AudioQueueSink {
+public:
+    WAVSink(const char* path, bool realTime) : _path(path), _realTime(realTime), _file(nullptr) {
+    }
+
+    ~WAVSink() {
+        close();
+    }
+
+    OSStatus open(double sampleRate, UInt32 channels, UInt32 periodFrames) override {
+        close();
+
+        _file = fopen(_path.c_str(), "wb");
+        if (!_file) {
+            TraceError(TAG, L"Unable to create %hs", _path.c_str());
+            return kAudioQueueErr_InvalidDevice;
+        }
+
+        _sampleRate = static_cast<UInt32>(sampleRate + 0.5);
+        _channels = channels;
+        _dataBytes = 0;
+        _samples.resize(periodFrames * channels);
+        _clock.start(sampleRate, 2 * periodFrames);
+
+        // Sizes are filled in by close()
+        writeHeader();
+        return noErr;
+    }
+
+    OSStatus write(const float* samples, UInt32 frames) override {
+        UInt32 count = frames * _channels;
+        if (count > _samples.size()) {
+            _samples.resize(count);
+        }
+
+        AudioKernelFloatToInt16(samples, 1, &_samples[0], 1, count);
+        if (fwrite(&_samples[0], sizeof(int16_t), count, _file) != count) {
+            TraceError(TAG, L"Unable to write to %hs", _path.c_str());
+            return kAudioQueueErr_InvalidDevice;
+        }
+        _dataBytes += count * sizeof(int16_t);
+
+        if (_realTime) {
+            _clock.wrote(frames);
+        }
+        return noErr;
+    }
+
+    void close() override {
+        if (_file) {
+            fseek(_file, 0, SEEK_SET);
+            writeHeader();
+            fclose(_file);
+            _file = nullptr;
+        }
+    }
+
+    UInt32 latencyFrames() override {
+        return _realTime ? _clock.pending() : 0;
+    }
+
+private:
+    void writeHeader() {
+        uint8_t header[44];
+        memcpy(header, "RIFF", 4);
+        putLE(header + 4, 36 + _dataBytes, 4);
+        memcpy(header + 8, "WAVEfmt ", 8);
+        putLE(header + 16, 16, 4);
+        putLE(header + 20, 1, 2); // PCM
+        putLE(header + 22, _channels, 2);
+        putLE(header + 24, _sampleRate, 4);
+        putLE(header + 28, _sampleRate * _channels * sizeof(int16_t), 4);
+        putLE(header + 32, _channels * sizeof(int16_t), 2);
+        putLE(header + 34, 16, 2);
+        memcpy(header + 36, "data", 4);
+        putLE(header + 40, _dataBytes, 4);
+        fwrite(header, 1, sizeof(header), _file);
+    }
+
+    std::string _path;
+    bool _realTime;
+    FILE* _file;
+    UInt32 _sampleRate;
+    UInt32 _channels;
+    UInt32 _dataBytes;
+    std::vector<int16_t> _samples;
+    RealTimeClock _clock;
+};
+
+std::mutex s_factoryLock;
+AudioQueueSinkFactory s_factory;
+
+} // namespace
+
+std::unique_ptr<AudioQueueSink> AudioQueueCreateNullSink(bool realTime) {
+    return std::unique_ptr<AudioQueueSink>(new NullSink(realTime));
+}
+
+std::unique_ptr<AudioQueueSink> AudioQueueCreateWAVSink(const char* path, bool realTime) {
+    return std::unique_ptr<AudioQueueSink>(new WAVSink(path, realTime));
+}
+
+void AudioQueueSetDefaultSinkFactory(AudioQueueSinkFactory factory) {
+    std::lock_guard<std::mutex> lock(s_factoryLock);
+    s_factory = std::move(factory);
+}
+
+std::unique_ptr<AudioQueueSink> AudioQueueCreateDefaultSink() {
+    {
+        std::lock_guard<std::mutex> lock(s_factoryLock);
+        if (s_factory) {
+            return s_factory();
+        }
+    }
+
+    static std::once_flag warned;
+    std::call_once(warned, []() { TraceWarning(TAG, L"No audio output device is available; audio queue output will be discarded"); });
+    return AudioQueueCreateNullSink(true);
+}
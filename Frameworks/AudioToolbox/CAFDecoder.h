@@ -83,6 +83,9 @@ private:
         CAF_FreeTableChunkID = 'free'
     };
 
+    // CAF linear PCM format flags; unlike the Core Audio ones, CAF defaults to big endian
+    enum { kCAFLinearPCMFormatFlagIsFloat = (1L << 0), kCAFLinearPCMFormatFlagIsLittleEndian = (1L << 1) };
+
 #pragma pack(push)
 #pragma pack(1)
     struct CAFFileHeader {
@@ -141,8 +144,12 @@ private:
                               CAFAudioDescription& mInputFormat);
     CAFAudioDescription cafDesc;
     CAFPacketTableHeader cafPacketTbl;
+    bool hasPacketTbl;
+    bool isBigEndian;
+
+    int64_t dataOffset;
+    int64_t dataByteCount;
 
-    
     ChannelStateList channelStates;
 
 public:
@@ -150,4 +157,33 @@ public:
 
     bool InitForRead(NSInputStream* stream);
     int ReadBuf(NSInputStream* stream, int16_t* samplesOut, uint32_t& ioOutputDataByteSize);
+
+    // Layout of the audio data chunk, for callers that fetch packets themselves.
+    // Every supported format is constant bitrate, so packet N lives at
+    // DataOffset() + N * BytesPerPacket().
+    int64_t DataOffset() const {
+        return dataOffset;
+    }
+    // -1 if the data chunk runs to the end of the file
+    int64_t DataByteCount() const {
+        return dataByteCount;
+    }
+    UInt32 BytesPerPacket() const {
+        return cafDesc.mBytesPerPacket;
+    }
+    UInt32 FramesPerPacket() const {
+        return cafDesc.mFramesPerPacket;
+    }
+    // Frames to drop from the front, and the playable frame count (-1 if unknown), from the packet table
+    int64_t PrimingFrames() const {
+        return hasPacketTbl ? cafPacketTbl.mPrimingFrames : 0;
+    }
+    int64_t ValidFrames() const {
+        return hasPacketTbl ? cafPacketTbl.mNumberValidFrames : -1;
+    }
+
+    // Decodes whole packets into interleaved 16 bit samples. Decoding carries on
+    // from the previous call; call ResetChannelStates() first when jumping elsewhere.
+    void DecodePackets(const Byte* inInputData, UInt32 inNumberPackets, int16_t* outOutputData);
+    void ResetChannelStates();
 };
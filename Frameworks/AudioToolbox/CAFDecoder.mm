@@ -200,7 +200,7 @@ void CAFDecoder::ProduceOutputPackets(NSInputStream* stream,
 
     if (isPcm) {
         NSInteger result =
-            [stream read:(uint8_t*)&outOutputData maxLength:(cafDesc.mBytesPerPacket * (ioOutputDataByteSize / cafDesc.mBytesPerPacket))];
+            [stream read:(uint8_t*)outOutputData maxLength:(cafDesc.mBytesPerPacket * (ioOutputDataByteSize / cafDesc.mBytesPerPacket))];
         ioNumberPackets = (result / cafDesc.mBytesPerPacket);
         ioOutputDataByteSize = result;
         return;
@@ -265,12 +265,17 @@ bool CAFDecoder::InitForRead(NSInputStream* inStream) {
     [inStream read:(uint8_t*)&header maxLength:sizeof(CAFFileHeader)];
     bool stop = false;
     isPcm = false;
+    isBigEndian = true;
+    hasPacketTbl = false;
+    dataOffset = sizeof(CAFFileHeader);
+    dataByteCount = -1;
 
     while ([inStream hasBytesAvailable] && !stop) {
         CAFChunkHeader chunkHeader;
         [inStream read:(uint8_t*)&chunkHeader maxLength:sizeof(CAFChunkHeader)];
         chunkHeader.mChunkType = int32Swap(chunkHeader.mChunkType);
         chunkHeader.mChunkSize = int64Swap(chunkHeader.mChunkSize);
+        dataOffset += sizeof(CAFChunkHeader);
 
         int64_t bytesLeftUntilChunkEnd = chunkHeader.mChunkSize;
         std::vector<uint8_t> bytesToSkip;
@@ -303,10 +308,27 @@ bool CAFDecoder::InitForRead(NSInputStream* inStream) {
                 cafDesc.mFramesPerPacket = int32Swap(cafDesc.mFramesPerPacket);
                 cafDesc.mChannelsPerFrame = int32Swap(cafDesc.mChannelsPerFrame);
                 cafDesc.mBitsPerChannel = int32Swap(cafDesc.mBitsPerChannel);
+
+                // We only hand out 16 bit samples, and the IMA4 decoder assumes the standard packet layout
+                if (isPcm) {
+                    if ((cafDesc.mFormatFlags & kCAFLinearPCMFormatFlagIsFloat) || cafDesc.mBitsPerChannel != 16 ||
+                        cafDesc.mBytesPerPacket != 2 * cafDesc.mChannelsPerFrame || cafDesc.mFramesPerPacket != 1) {
+                        TraceError(TAG, L"Unsupported CAF linear PCM format (%d bits)", cafDesc.mBitsPerChannel);
+                        return false;
+                    }
+                    isBigEndian = (cafDesc.mFormatFlags & kCAFLinearPCMFormatFlagIsLittleEndian) == 0;
+                } else if (cafDesc.mFramesPerPacket != kIMAFramesPerPacket ||
+                           cafDesc.mBytesPerPacket != kIMA4PacketBytes * cafDesc.mChannelsPerFrame) {
+                    TraceError(TAG, L"Unsupported CAF IMA4 packet layout");
+                    return false;
+                }
                 break;
 
             case CAF_PacketTableChunkID:
-                bytesLeftUntilChunkEnd -= [inStream read:(uint8_t*)&cafPacketTbl maxLength:sizeof(cafPacketTbl)];
+                // Only the fixed part; CBR formats don't have any packet descriptions
+                bytesLeftUntilChunkEnd -=
+                    [inStream read:(uint8_t*)&cafPacketTbl maxLength:offsetof(CAFPacketTableHeader, mPacketDescriptions)];
+                hasPacketTbl = true;
 
                 cafPacketTbl.mNumberPackets = int64Swap(cafPacketTbl.mNumberPackets);
                 cafPacketTbl.mNumberValidFrames = int64Swap(cafPacketTbl.mNumberValidFrames);
@@ -319,6 +341,11 @@ bool CAFDecoder::InitForRead(NSInputStream* inStream) {
                 bytesLeftUntilChunkEnd -= [inStream read:(uint8_t*)editCount maxLength:_countof(editCount)];
                 stop = true;
 
+                dataOffset += _countof(editCount);
+                if (chunkHeader.mChunkSize >= _countof(editCount)) {
+                    dataByteCount = chunkHeader.mChunkSize - _countof(editCount);
+                }
+
                 OutputFormat.mBytesPerFrame = 2 * cafDesc.mChannelsPerFrame;
                 OutputFormat.mChannelsPerFrame = cafDesc.mChannelsPerFrame;
                 OutputFormat.mSampleRate = cafDesc.mSampleRate;
@@ -331,22 +358,55 @@ bool CAFDecoder::InitForRead(NSInputStream* inStream) {
                 break;
 
             default:
-                bytesToSkip.reserve(chunkHeader.mChunkSize);
-                bytesLeftUntilChunkEnd -= [inStream read:(uint8_t*)&bytesToSkip[0] maxLength:chunkHeader.mChunkSize];
                 break;
         }
 
         if (!stop) {
+            dataOffset += chunkHeader.mChunkSize;
             if (bytesLeftUntilChunkEnd > 0) {
+                bytesToSkip.resize(bytesLeftUntilChunkEnd);
                 [inStream read:(uint8_t*)&bytesToSkip[0] maxLength:bytesLeftUntilChunkEnd];
             }
         }
     }
 
+    if (!stop) {
+        TraceError(TAG, L"CAF file has no audio data chunk");
+        return false;
+    }
+
     return true;
 }
 
 int CAFDecoder::ReadBuf(NSInputStream* inputStream, int16_t* out, uint32_t& ioOutputDataByteSize) {
     ProduceOutputPackets(inputStream, channelStates, out, ioOutputDataByteSize, OutputFormat, cafDesc);
     return ioOutputDataByteSize;
-}
\ No newline at end of file
+}
+
+void CAFDecoder::ResetChannelStates() {
+    for (auto& state : channelStates) {
+        state.Reset();
+    }
+}
+
+void CAFDecoder::DecodePackets(const Byte* inInputData, UInt32 inNumberPackets, int16_t* outOutputData) {
+    if (isPcm) {
+        UInt32 numSamples = inNumberPackets * cafDesc.mChannelsPerFrame;
+        memcpy(outOutputData, inInputData, numSamples * sizeof(int16_t));
+        if (isBigEndian) {
+            for (UInt32 i = 0; i < numSamples; i++) {
+                outOutputData[i] = CFSwapInt16BigToHost(outOutputData[i]);
+            }
+        }
+        return;
+    }
+
+    for (int theChannelIndex = 0; theChannelIndex < OutputFormat.mChannelsPerFrame; ++theChannelIndex) {
+        DecodeChannelSInt16(channelStates[theChannelIndex],
+                            OutputFormat.mChannelsPerFrame,
+                            theChannelIndex,
+                            inNumberPackets,
+                            inInputData,
+                            outOutputData);
+    }
+}
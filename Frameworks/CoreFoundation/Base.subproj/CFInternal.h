@@ -337,6 +337,10 @@ CF_PRIVATE dispatch_time_t __CFTSRToDispatchTime(uint64_t tsr);
 #endif
 CF_PRIVATE uint64_t __CFTSRToNanoseconds(uint64_t tsr);
 
+// The UTC offset, in milliseconds, that tz's transition table gives for date (an ICU UDate, in
+// milliseconds since 1970); false when the table can't answer and ICU has to be asked instead
+CF_PRIVATE Boolean __CFTimeZoneGetTableOffset(CFTimeZoneRef tz, double date, Boolean local, int32_t *offset);
+
 extern CFStringRef __CFCopyFormattingDescription(CFTypeRef cf, CFDictionaryRef formatOptions);
 
 /* Enhanced string formatting support
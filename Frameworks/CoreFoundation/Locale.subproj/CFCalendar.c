@@ -889,9 +889,178 @@ CFIndex CFCalendarGetOrdinalityOfUnit(CFCalendarRef calendar, CFCalendarUnit sma
     return result;
 }
 
+/* Gregorian fast path. Between 1601 and 9999 the Gregorian calendar is plain arithmetic on day
+ * numbers, so composing and decomposing don't need the shared UCalendar, or the lock its callers
+ * hold, as long as the time zone's offsets come from its transition table. Anything else (other
+ * calendars, a moved Gregorian change, fields that need ICU's resolution rules, dates outside
+ * the range or the table) returns false and goes through ICU as before.
+ */
+
+#define __kCFCalendarMillisPerDay (86400000LL)
+#define __kCFCalendarFastPathFirstDay (-134774LL)          // 1601-01-01, in days since 1970
+#define __kCFCalendarFastPathLastDay (2932897LL)           // 10000-01-01
+#define __kCFCalendarDefaultGregorianChange (-12219292800000.0) // ICU's default, 1582-10-15
+#define __kCFCalendarEpochJulianDay (2440588)
+
+CF_INLINE int64_t __CFCalendarFloorDivide(int64_t numerator, int64_t denominator) {
+    return (numerator >= 0) ? numerator / denominator : -((denominator - 1 - numerator) / denominator);
+}
+
+// Days since 1970-01-01 of a proleptic Gregorian date, month 1-12
+CF_INLINE int64_t __CFCalendarDaysFromCivil(int64_t year, int64_t month, int64_t day) {
+    year -= (month <= 2);
+    int64_t era = __CFCalendarFloorDivide(year, 400);
+    int64_t yearOfEra = year - era * 400;
+    int64_t dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1; // From March 1
+    int64_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+CF_INLINE void __CFCalendarCivilFromDays(int64_t days, int32_t *year, int32_t *month, int32_t *day) {
+    days += 719468;
+    int64_t era = __CFCalendarFloorDivide(days, 146097);
+    int64_t dayOfEra = days - era * 146097;
+    int64_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    int64_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100); // From March 1
+    int64_t monthIndex = (5 * dayOfYear + 2) / 153;
+    *day = (int32_t)(dayOfYear - (153 * monthIndex + 2) / 5 + 1);
+    *month = (int32_t)(monthIndex < 10 ? monthIndex + 3 : monthIndex - 9);
+    *year = (int32_t)(yearOfEra + era * 400 + (*month <= 2));
+}
+
+CF_INLINE int32_t __CFCalendarYearLength(int32_t year) {
+    return ((year % 4 == 0) && ((year % 100 != 0) || (year % 400 == 0))) ? 366 : 365;
+}
+
+// ICU's Calendar::weekNumber: the week of a period that dayOfPeriod, a dayOfWeek, is in
+CF_INLINE int32_t __CFCalendarWeekNumber(int32_t dayOfPeriod, int32_t dayOfWeek, int32_t firstDayOfWeek, int32_t minimalDays) {
+    int32_t periodStartDayOfWeek = (dayOfWeek - firstDayOfWeek - dayOfPeriod + 1) % 7;
+    if (periodStartDayOfWeek < 0) periodStartDayOfWeek += 7;
+    int32_t week = (dayOfPeriod + periodStartDayOfWeek - 1) / 7;
+    if ((7 - periodStartDayOfWeek) >= minimalDays) week++;
+    return week;
+}
+
+static Boolean __CFCalendarCanUseGregorianFastPath(CFCalendarRef calendar) {
+    if (calendar->_identifier != kCFCalendarIdentifierGregorian) return false;
+    // The offsets have to be the ones the UCalendar's own zone would use
+    if (CF_IS_OBJC(CFTimeZoneGetTypeID(), calendar->_tz)) return false;
+    UErrorCode status = U_ZERO_ERROR;
+    UDate change = ucal_getGregorianChange(calendar->_cal, &status);
+    return U_SUCCESS(status) && (change <= __kCFCalendarDefaultGregorianChange);
+}
+
+static Boolean __CFCalendarComposeGregorian(CFCalendarRef calendar, CFAbsoluteTime *atp, const char *componentDesc, const int *vector) {
+    if (!__CFCalendarCanUseGregorianFastPath(calendar)) return false;
+
+    // Same defaults as the ICU path; ICU is lenient, so out of range values carry into the next unit
+    int64_t year = 1, month = 1, day = 1, hour = 0, minute = 0, second = 0, millisecond = 0;
+    for (const char *desc = componentDesc; *desc; desc++, vector++) {
+        switch (*desc) {
+        case 'G': if (*vector != 1) return false; break;
+        case 'y': year = *vector; break;
+        case 'M': month = *vector; break;
+        case 'd': day = *vector; break;
+        case 'H': hour = *vector; break;
+        case 'm': minute = *vector; break;
+        case 's': second = *vector; break;
+        case 'S': millisecond = *vector; break;
+        default: return false; // Week based, 12 hour and the rest are left to ICU's field resolution
+        }
+    }
+
+    year += __CFCalendarFloorDivide(month - 1, 12);
+    month -= 12 * __CFCalendarFloorDivide(month - 1, 12);
+    if (year < 1600 || 10000 < year) return false;
+    int64_t wall = (__CFCalendarDaysFromCivil(year, month, 1) + day - 1) * __kCFCalendarMillisPerDay;
+    wall += ((hour * 60 + minute) * 60 + second) * 1000 + millisecond;
+    if (!((__kCFCalendarFastPathFirstDay * __kCFCalendarMillisPerDay <= wall) && (wall < __kCFCalendarFastPathLastDay * __kCFCalendarMillisPerDay))) return false;
+
+    int32_t offset;
+    if (!__CFTimeZoneGetTableOffset(calendar->_tz, (UDate)wall, true, &offset)) return false;
+    UDate udate = (UDate)(wall - offset);
+    if (atp) *atp = (udate / 1000.0) - kCFAbsoluteTimeIntervalSince1970;
+    return true;
+}
+
+static Boolean __CFCalendarDecomposeGregorian(CFCalendarRef calendar, CFAbsoluteTime at, const char *componentDesc, int **vector) {
+    for (const char *desc = componentDesc; *desc; desc++) {
+        if ((UCalendarDateFields)-1 == __CFCalendarGetICUFieldCodeFromChar(*desc)) return false; // Let ICU report it
+    }
+    if (!__CFCalendarCanUseGregorianFastPath(calendar)) return false;
+
+    UDate udate = floor((at + kCFAbsoluteTimeIntervalSince1970) * 1000.0);
+    int32_t offset;
+    if (!__CFTimeZoneGetTableOffset(calendar->_tz, udate, false, &offset)) return false;
+    UDate local = udate + offset;
+    if (!((__kCFCalendarFastPathFirstDay * __kCFCalendarMillisPerDay <= local) && (local < __kCFCalendarFastPathLastDay * __kCFCalendarMillisPerDay))) return false;
+
+    int64_t days = __CFCalendarFloorDivide((int64_t)local, __kCFCalendarMillisPerDay);
+    int32_t millisInDay = (int32_t)((int64_t)local - days * __kCFCalendarMillisPerDay);
+    int32_t year, month, day;
+    __CFCalendarCivilFromDays(days, &year, &month, &day);
+    int32_t dayOfYear = (int32_t)(days - __CFCalendarDaysFromCivil(year, 1, 1)) + 1;
+    int32_t dayOfWeek = (int32_t)(days + 4 - 7 * __CFCalendarFloorDivide(days + 4, 7)) + 1; // 1970-01-01 was a Thursday
+    int32_t hour = millisInDay / 3600000;
+
+    // Week numbering follows ICU's Calendar::computeWeekFields, with the calendar's own settings
+    int32_t firstDayOfWeek = 1, minimalDays = 1, weekOfYear = 0, yearForWeekOfYear = year;
+    for (const char *desc = componentDesc; *desc; desc++) {
+        if ('w' == *desc || 'W' == *desc || 'Y' == *desc) {
+            firstDayOfWeek = ucal_getAttribute(calendar->_cal, UCAL_FIRST_DAY_OF_WEEK);
+            minimalDays = ucal_getAttribute(calendar->_cal, UCAL_MINIMAL_DAYS_IN_FIRST_WEEK);
+            int32_t relativeDayOfWeek = (dayOfWeek + 7 - firstDayOfWeek) % 7;
+            int32_t relativeDayOfWeekJan1 = (dayOfWeek - dayOfYear + 7001 - firstDayOfWeek) % 7;
+            weekOfYear = (dayOfYear - 1 + relativeDayOfWeekJan1) / 7;
+            if ((7 - relativeDayOfWeekJan1) >= minimalDays) weekOfYear++;
+            if (0 == weekOfYear) {
+                weekOfYear = __CFCalendarWeekNumber(dayOfYear + __CFCalendarYearLength(year - 1), dayOfWeek, firstDayOfWeek, minimalDays);
+                yearForWeekOfYear--;
+            } else {
+                int32_t lastDayOfYear = __CFCalendarYearLength(year);
+                if (dayOfYear >= lastDayOfYear - 5) {
+                    int32_t lastRelativeDayOfWeek = (relativeDayOfWeek + lastDayOfYear - dayOfYear) % 7;
+                    if (((6 - lastRelativeDayOfWeek) >= minimalDays) && ((dayOfYear + 7 - relativeDayOfWeek) > lastDayOfYear)) {
+                        weekOfYear = 1;
+                        yearForWeekOfYear++;
+                    }
+                }
+            }
+            break;
+        }
+    }
+
+    for (const char *desc = componentDesc; *desc; desc++, vector++) {
+        int value = 0;
+        switch (*desc) {
+        case 'G': value = 1; break;
+        case 'y': value = year; break;
+        case 'M': value = month; break;
+        case 'l': value = 0; break;
+        case 'd': value = day; break;
+        case 'h': value = hour % 12; break;
+        case 'H': value = hour; break;
+        case 'm': value = (millisInDay / 60000) % 60; break;
+        case 's': value = (millisInDay / 1000) % 60; break;
+        case 'S': value = millisInDay % 1000; break;
+        case 'w': value = weekOfYear; break;
+        case 'W': value = __CFCalendarWeekNumber(day, dayOfWeek, firstDayOfWeek, minimalDays); break;
+        case 'Y': value = yearForWeekOfYear; break;
+        case 'E': value = dayOfWeek; break;
+        case 'D': value = dayOfYear; break;
+        case 'F': value = (day - 1) / 7 + 1; break;
+        case 'a': value = (hour >= 12) ? 1 : 0; break;
+        case 'g': value = (int)(days + __kCFCalendarEpochJulianDay); break;
+        }
+        *(*vector) = value;
+    }
+    return true;
+}
+
 Boolean _CFCalendarComposeAbsoluteTimeV(CFCalendarRef calendar, /* out */ CFAbsoluteTime *atp, const char *componentDesc, int *vector, int count) {
     if (!calendar->_cal) __CFCalendarSetupCal(calendar);
     if (calendar->_cal) {
+    if (__CFCalendarComposeGregorian(calendar, atp, componentDesc, vector)) return true;
     UErrorCode status = U_ZERO_ERROR;
     ucal_clear(calendar->_cal);
     ucal_set(calendar->_cal, UCAL_YEAR, 1);
@@ -934,6 +1103,7 @@ Boolean _CFCalendarComposeAbsoluteTimeV(CFCalendarRef calendar, /* out */ CFAbso
 Boolean _CFCalendarDecomposeAbsoluteTimeV(CFCalendarRef calendar, CFAbsoluteTime at, const char *componentDesc, int **vector, int count) {
     if (!calendar->_cal) __CFCalendarSetupCal(calendar);
     if (calendar->_cal) {
+    if (__CFCalendarDecomposeGregorian(calendar, at, componentDesc, vector)) return true;
     UErrorCode status = U_ZERO_ERROR;
     ucal_clear(calendar->_cal);
     UDate udate = floor((at + kCFAbsoluteTimeIntervalSince1970) * 1000.0);
@@ -213,11 +213,33 @@ static CFStringRef __UnicodeStringToCFStringRef(UnicodeString str) {
         CFSTR("");
 }
 
+/* The offsets a zone uses from 1900 to 2100, one period per ICU transition, so that offset
+ * queries are a binary search rather than a walk through ICU's rules. Built the first time
+ * it's needed and immutable after that, apart from the lookup cache; anything outside the
+ * table still goes to ICU.
+ */
+typedef struct {
+    UDate start;       // When the period begins, in milliseconds since 1970
+    int32_t rawOffset; // In milliseconds, as ICU reports them
+    int32_t dstOffset;
+} __CFTimeZonePeriod;
+
+typedef struct {
+    UDate end; // Where the last period ends
+    CFIndex count;
+    volatile CFIndex lastPeriod; // The period last looked up; consecutive queries usually land in the same one
+    __CFTimeZonePeriod periods[1];
+} __CFTimeZoneTransitions;
+
+#define __kCFTimeZoneTransitionsStart (-2208988800000.0) // 1900-01-01 00:00 GMT
+#define __kCFTimeZoneTransitionsEnd (4102444800000.0)    // 2100-01-01 00:00 GMT
+
 struct __CFTimeZone {
     CFRuntimeBase _base;
     icu::LocalPointer<icu::BasicTimeZone> _timeZone;
     CFStringRef _name; /* immutable */
     CFDataRef _data;   /* immutable */
+    __CFTimeZoneTransitions *_transitions;
 };
 
 static CFTimeZoneRef __CFTimeZoneInitWithICU(CFTimeZoneRef ret, CFStringRef name, CFDataRef data) {
@@ -243,6 +265,132 @@ CF_INLINE CFAbsoluteTime __UDateToCFAbsoluteTime(UDate time) {
     return time/1000 - kCFAbsoluteTimeIntervalSince1970;
 }
 
+static __CFTimeZoneTransitions *__CFTimeZoneCreateTransitions(icu::BasicTimeZone *timeZone) {
+    UErrorCode status = U_ZERO_ERROR;
+    int32_t rawOffset, dstOffset;
+    timeZone->getOffset(__kCFTimeZoneTransitionsStart, false, rawOffset, dstOffset, status);
+    if (U_FAILURE(status)) return NULL;
+
+    CFIndex capacity = 64;
+    __CFTimeZoneTransitions *table = (__CFTimeZoneTransitions *)CFAllocatorAllocate(kCFAllocatorSystemDefault, sizeof(__CFTimeZoneTransitions) + (capacity - 1) * sizeof(__CFTimeZonePeriod), 0);
+    if (!table) return NULL;
+    table->end = __kCFTimeZoneTransitionsEnd;
+    table->count = 1;
+    table->lastPeriod = 0;
+    table->periods[0].start = __kCFTimeZoneTransitionsStart;
+    table->periods[0].rawOffset = rawOffset;
+    table->periods[0].dstOffset = dstOffset;
+
+    // Every transition is kept, even ones that don't change the offsets, so that the next one is always the next period
+    icu::TimeZoneTransition transition;
+    UDate date = __kCFTimeZoneTransitionsStart;
+    while (timeZone->getNextTransition(date, false, transition) && (transition.getTime() < __kCFTimeZoneTransitionsEnd)) {
+        date = transition.getTime();
+        timeZone->getOffset(date, false, rawOffset, dstOffset, status);
+        if (U_FAILURE(status)) {
+            CFAllocatorDeallocate(kCFAllocatorSystemDefault, table);
+            return NULL;
+        }
+
+        if (table->count == capacity) {
+            capacity *= 2;
+            __CFTimeZoneTransitions *grown = (__CFTimeZoneTransitions *)CFAllocatorReallocate(kCFAllocatorSystemDefault, table, sizeof(__CFTimeZoneTransitions) + (capacity - 1) * sizeof(__CFTimeZonePeriod), 0);
+            if (!grown) {
+                CFAllocatorDeallocate(kCFAllocatorSystemDefault, table);
+                return NULL;
+            }
+            table = grown;
+        }
+        table->periods[table->count].start = date;
+        table->periods[table->count].rawOffset = rawOffset;
+        table->periods[table->count].dstOffset = dstOffset;
+        table->count++;
+    }
+
+    return table;
+}
+
+static __CFTimeZoneTransitions *__CFTimeZoneGetTransitions(CFTimeZoneRef tz) {
+    __CFTimeZoneTransitions *table = tz->_transitions;
+    if (!table) {
+        table = __CFTimeZoneCreateTransitions(tz->_timeZone.getAlias());
+        if (!table) return NULL;
+        if (!OSAtomicCompareAndSwapPtrBarrier(NULL, table, (void * volatile *)&((struct __CFTimeZone *)tz)->_transitions)) {
+            // Another thread got there first
+            CFAllocatorDeallocate(kCFAllocatorSystemDefault, table);
+            table = tz->_transitions;
+        }
+    }
+    return table;
+}
+
+// Returns the index of the period that date falls in, or kCFNotFound if it's outside the table
+static CFIndex __CFTimeZoneFindPeriod(CFTimeZoneRef tz, UDate date, const __CFTimeZoneTransitions **tableOut) {
+    __CFTimeZoneTransitions *table = __CFTimeZoneGetTransitions(tz);
+    if (!table || !((date >= table->periods[0].start) && (date < table->end))) return kCFNotFound; // Also catches NaN
+
+    const __CFTimeZonePeriod *periods = table->periods;
+    CFIndex idx = table->lastPeriod;
+    if (!((date >= periods[idx].start) && ((idx + 1 == table->count) || (date < periods[idx + 1].start)))) {
+        CFIndex low = 0, high = table->count - 1;
+        while (low < high) {
+            CFIndex mid = low + (high - low + 1) / 2;
+            if (periods[mid].start <= date) {
+                low = mid;
+            } else {
+                high = mid - 1;
+            }
+        }
+        idx = low;
+        table->lastPeriod = idx;
+    }
+
+    *tableOut = table;
+    return idx;
+}
+
+// Wall clock times this close to either end of the table could belong to a transition just outside it
+#define __kCFTimeZoneLocalMargin (2 * 86400000.0)
+
+/* The offset, in milliseconds, in effect at date; or, when local is set, the offset that turns the
+ * wall clock time date back into a moment the way ICU's calendars do it. A wall time skipped by a
+ * transition takes the offset from before it, and a repeated one the offset from after it. Returns
+ * false when the answer isn't in the table, in which case the caller has to ask ICU.
+ */
+CF_PRIVATE Boolean __CFTimeZoneGetTableOffset(CFTimeZoneRef tz, UDate date, Boolean local, int32_t *offset) {
+    const __CFTimeZoneTransitions *table;
+    CFIndex idx;
+    if (!local) {
+        idx = __CFTimeZoneFindPeriod(tz, date, &table);
+        if (kCFNotFound == idx) return false;
+    } else {
+        table = __CFTimeZoneGetTransitions(tz);
+        if (!table) return false;
+        const __CFTimeZonePeriod *periods = table->periods;
+        const __CFTimeZonePeriod *last = &periods[table->count - 1];
+        if (!((date >= periods[0].start + periods[0].rawOffset + periods[0].dstOffset + __kCFTimeZoneLocalMargin) &&
+              (date < table->end + last->rawOffset + last->dstOffset - __kCFTimeZoneLocalMargin))) {
+            return false;
+        }
+
+        // The last period whose first wall time is at or before date. A skipped time falls in the
+        // gap before the next period starts, and a repeated one is already past its start.
+        CFIndex low = 0, high = table->count - 1;
+        while (low < high) {
+            CFIndex mid = low + (high - low + 1) / 2;
+            if (periods[mid].start + periods[mid].rawOffset + periods[mid].dstOffset <= date) {
+                low = mid;
+            } else {
+                high = mid - 1;
+            }
+        }
+        idx = low;
+    }
+
+    *offset = table->periods[idx].rawOffset + table->periods[idx].dstOffset;
+    return true;
+}
+
 static Boolean __CFTimeZoneEqual(CFTypeRef cf1, CFTypeRef cf2) {
     CFTimeZoneRef tz1 = (CFTimeZoneRef)cf1;
     CFTimeZoneRef tz2 = (CFTimeZoneRef)cf2;
@@ -273,6 +421,7 @@ static void __CFTimeZoneDeallocate(CFTypeRef cf) {
     CFIndex idx;
     if (tz->_name) CFRelease(tz->_name);
     if (tz->_data) CFRelease(tz->_data);
+    if (tz->_transitions) CFAllocatorDeallocate(kCFAllocatorSystemDefault, tz->_transitions);
 }
 
 static CFTypeID __kCFTimeZoneTypeID = _kCFRuntimeNotATypeID;
@@ -1203,6 +1352,12 @@ CFTimeInterval CFTimeZoneGetSecondsFromGMT(CFTimeZoneRef tz, CFAbsoluteTime at)
     CFIndex idx;
     __CFGenericValidateType(tz, CFTimeZoneGetTypeID());
 
+    const __CFTimeZoneTransitions *table;
+    CFIndex period = __CFTimeZoneFindPeriod(tz, __CFAbsoluteTimeToUDate(at), &table);
+    if (period != kCFNotFound) {
+        return (table->periods[period].rawOffset + table->periods[period].dstOffset) / 1000;
+    }
+
     int32_t rawOffset;
     int32_t dstOffset;
     UErrorCode status = U_ZERO_ERROR;
@@ -1226,6 +1381,12 @@ CFStringRef CFTimeZoneCopyAbbreviation(CFTimeZoneRef tz, CFAbsoluteTime at) {
 Boolean CFTimeZoneIsDaylightSavingTime(CFTimeZoneRef tz, CFAbsoluteTime at) {
     __CFGenericValidateType(tz, CFTimeZoneGetTypeID());
 
+    const __CFTimeZoneTransitions *table;
+    CFIndex period = __CFTimeZoneFindPeriod(tz, __CFAbsoluteTimeToUDate(at), &table);
+    if (period != kCFNotFound) {
+        return table->periods[period].dstOffset != 0;
+    }
+
     UErrorCode status = U_ZERO_ERROR;
     UBool daylight = tz->_timeZone->inDaylightTime(__CFAbsoluteTimeToUDate(at), status);
 
@@ -1243,6 +1404,12 @@ CFTimeInterval CFTimeZoneGetDaylightSavingTimeOffset(CFTimeZoneRef tz, CFAbsolut
     CF_OBJC_FUNCDISPATCHV(CFTimeZoneGetTypeID(), CFTimeInterval, (NSTimeZone *)tz, daylightSavingTimeOffsetForDate:(NSDate*)CFDateCreate(nullptr, at));
     __CFGenericValidateType(tz, CFTimeZoneGetTypeID());
 
+    const __CFTimeZoneTransitions *table;
+    CFIndex period = __CFTimeZoneFindPeriod(tz, __CFAbsoluteTimeToUDate(at), &table);
+    if (period != kCFNotFound) {
+        return table->periods[period].dstOffset / 1000;
+    }
+
     int32_t rawOffset;
     int32_t dstOffset;
     UErrorCode status = U_ZERO_ERROR;
@@ -1265,6 +1432,13 @@ CFAbsoluteTime CFTimeZoneGetNextDaylightSavingTimeTransition(CFTimeZoneRef tz, C
     }
     
     __CFGenericValidateType(tz, CFTimeZoneGetTypeID());
+
+    const __CFTimeZoneTransitions *table;
+    CFIndex period = __CFTimeZoneFindPeriod(tz, __CFAbsoluteTimeToUDate(at), &table);
+    if ((period != kCFNotFound) && (period + 1 < table->count)) {
+        return __UDateToCFAbsoluteTime(table->periods[period + 1].start);
+    }
+
     icu::TimeZoneTransition transition;
     tz->_timeZone->getNextTransition(__CFAbsoluteTimeToUDate(at), false, transition);
     return __UDateToCFAbsoluteTime(transition.getTime());
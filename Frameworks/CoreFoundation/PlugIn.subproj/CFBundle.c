@@ -836,6 +836,7 @@ static void __CFBundleDeallocate(CFTypeRef cf) {
     
     if (bundle->_bundleBasePath) CFRelease(bundle->_bundleBasePath);
     if (bundle->_queryTable) CFRelease(bundle->_queryTable);
+    _CFBundleDeallocateResourceIndex(bundle);
     
     if (bundle->_localizations) CFRelease(bundle->_localizations);
     if (bundle->_resourceDirectoryContents) CFRelease(bundle->_resourceDirectoryContents);
@@ -1004,6 +1005,8 @@ static CFBundleRef _CFBundleCreate(CFAllocatorRef allocator, CFURLRef bundleURL,
     
     bundle->_queryLock = CFLockInit;
     bundle->_queryTable = NULL;
+    bundle->_resourceIndex = NULL;
+    bundle->_lookedForResourceIndex = false;
     CFURLRef absoURL = CFURLCopyAbsoluteURL(bundle->_url);
     bundle->_bundleBasePath = CFURLCopyFileSystemPath(absoURL, PLATFORM_PATH_STYLE);
     CFRelease(absoURL);
@@ -67,6 +67,8 @@ typedef struct __CFPlugInData {
     CFMutableArrayRef _factories;
 } _CFPlugInData;
 
+struct __CFBundleResourceIndex;
+
 struct __CFBundle {
     CFRuntimeBase _base;
     
@@ -122,6 +124,8 @@ struct __CFBundle {
     CFLock_t _queryLock;
     CFMutableDictionaryRef _queryTable;
     CFStringRef _bundleBasePath;
+    struct __CFBundleResourceIndex *_resourceIndex; // Guarded by _queryLock
+    Boolean _lookedForResourceIndex;
     
     CFLock_t _additionalResourceLock;
     CFMutableDictionaryRef _additionalResourceBundles;
@@ -149,6 +153,7 @@ CF_EXPORT CFStringRef _CFGetPlatformName(void);
 CF_EXPORT CFStringRef _CFGetAlternatePlatformName(void);
 
 CF_PRIVATE void _CFBundleFlushQueryTableCache(CFBundleRef bundle);
+CF_PRIVATE void _CFBundleDeallocateResourceIndex(CFBundleRef bundle);
 
 CF_PRIVATE SInt32 _CFBundleCurrentArchitecture(void);
 CF_PRIVATE Boolean _CFBundleGetObjCImageInfo(CFBundleRef bundle, uint32_t *objcVersion, uint32_t *objcFlags);
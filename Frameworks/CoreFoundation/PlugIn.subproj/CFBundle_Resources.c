@@ -37,6 +37,7 @@
 #include <unistd.h>
 #include <sys/sysctl.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <dirent.h>
 #endif
 
@@ -72,18 +73,558 @@
 
 #endif
 
+#pragma mark -
+#pragma mark Resource Index
+
+// Building a query table reads the resources directory, Base.lproj and an lproj for each language in the search
+// list, once for every subdirectory that is asked about. The resource index records the names in every directory of
+// a bundle so that those reads come from memory instead. It is built the first time a bundle object needs a query
+// table, saved in a per-user cache and mapped by later launches for as long as the modification date of the bundle
+// directory stays the same. Changes further down do not move that date, so anything that edits a bundle in place
+// should call _CFBundleFlushCachesForURL or _CFBundleFlushBundleCaches afterwards.
+//
+// The file is a header, an open addressed table of directory numbers (plus one, so that zero is empty) hashed by
+// relative path, the directories, their entries in the order the file system gave them, and the NUL terminated paths
+// and UTF-8 names those refer to.
+
+#define __kCFBundleResourceIndexMagic 0x58444952 // 'RIDX'
+#define __kCFBundleResourceIndexVersion 1
+#define __kCFBundleResourceIndexMaxEntries (1 << 18)
+#define __kCFBundleResourceIndexMaxDepth 16
+// File dates here only have a resolution of a second, so an index taken too soon after a change can't tell it from the next one
+#define __kCFBundleResourceIndexSettleTime 2.0
+
+#define __kCFBundleResourceIndexEntryIsDirectory 1
+#define __kCFBundleResourceIndexEntryIsLink 2
+
+typedef struct {
+    uint32_t _magic;
+    uint32_t _version;
+    CFAbsoluteTime _modTime;
+    uint32_t _length;
+    uint32_t _slotCount;
+    uint32_t _directoryCount;
+    uint32_t _entryCount;
+    uint32_t _stringsLength;
+    uint32_t _bundlePath;
+    uint32_t _bundlePathLength;
+    uint32_t _reserved;
+} __CFBundleResourceIndexHeader;
+
+typedef struct {
+    uint32_t _path;
+    uint32_t _pathLength;
+    uint32_t _firstEntry;
+    uint32_t _entryCount;
+} __CFBundleResourceIndexDirectory;
+
+typedef struct {
+    uint32_t _name;
+    uint32_t _nameLength;
+    uint32_t _flags;
+} __CFBundleResourceIndexEntry;
+
+struct __CFBundleResourceIndex {
+    uint8_t *_bytes;
+    CFIndex _length;
+    Boolean _mapped;
+};
+
+#if DEPLOYMENT_TARGET_WINDOWS
+#define CSIDL_APPDATA 0x001a
+#endif
+
+// from CFUtilities.c
+CF_PRIVATE Boolean _CFReadMappedFromFile(CFStringRef path, Boolean map, Boolean uncached, void **outBytes, CFIndex *outLength, CFErrorRef *errorPtr);
+
+CF_INLINE const __CFBundleResourceIndexHeader *__CFBundleResourceIndexGetHeader(const struct __CFBundleResourceIndex *index) {
+    return (const __CFBundleResourceIndexHeader *)index->_bytes;
+}
+
+CF_INLINE const uint32_t *__CFBundleResourceIndexGetSlots(const struct __CFBundleResourceIndex *index) {
+    return (const uint32_t *)(index->_bytes + sizeof(__CFBundleResourceIndexHeader));
+}
+
+CF_INLINE const __CFBundleResourceIndexDirectory *__CFBundleResourceIndexGetDirectories(const struct __CFBundleResourceIndex *index) {
+    return (const __CFBundleResourceIndexDirectory *)(__CFBundleResourceIndexGetSlots(index) + __CFBundleResourceIndexGetHeader(index)->_slotCount);
+}
+
+CF_INLINE const __CFBundleResourceIndexEntry *__CFBundleResourceIndexGetEntries(const struct __CFBundleResourceIndex *index) {
+    return (const __CFBundleResourceIndexEntry *)(__CFBundleResourceIndexGetDirectories(index) + __CFBundleResourceIndexGetHeader(index)->_directoryCount);
+}
+
+CF_INLINE const char *__CFBundleResourceIndexGetStrings(const struct __CFBundleResourceIndex *index) {
+    return (const char *)(__CFBundleResourceIndexGetEntries(index) + __CFBundleResourceIndexGetHeader(index)->_entryCount);
+}
+
+CF_INLINE Boolean __CFBundleResourceIndexIsSlash(char c) {
+#if DEPLOYMENT_TARGET_WINDOWS
+    return c == '/' || c == '\\';
+#else
+    return c == '/';
+#endif
+}
+
+// Windows file names are matched without regard to case, as far as ASCII goes
+CF_INLINE char __CFBundleResourceIndexFoldCase(char c) {
+#if DEPLOYMENT_TARGET_WINDOWS
+    return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+#else
+    return c;
+#endif
+}
+
+static uint32_t __CFBundleResourceIndexHash(const char *key, CFIndex length) {
+    uint32_t hash = 2166136261U;
+    for (CFIndex i = 0; i < length; i++) {
+        hash = (hash ^ (uint8_t)__CFBundleResourceIndexFoldCase(key[i])) * 16777619U;
+    }
+    return hash;
+}
+
+static Boolean __CFBundleResourceIndexNamesAreEqual(const char *name1, const char *name2, CFIndex length) {
+    for (CFIndex i = 0; i < length; i++) {
+        if (__CFBundleResourceIndexFoldCase(name1[i]) != __CFBundleResourceIndexFoldCase(name2[i])) return false;
+    }
+    return true;
+}
+
+// Directories are keyed by their path relative to the bundle, which starts at relativeStart in path, in file system
+// representation with single slashes between components and none at either end. Paths that step through . or .. are
+// left to the file system.
+static Boolean __CFBundleResourceIndexGetKey(CFStringRef path, CFIndex relativeStart, char *key, CFIndex *keyLength) {
+    if (relativeStart >= CFStringGetLength(path)) {
+        key[0] = 0;
+        *keyLength = 0;
+        return true;
+    }
+    
+    char buffer[CFMaxPathSize];
+    CFStringRef relativePath = CFStringCreateWithSubstring(kCFAllocatorSystemDefault, path, CFRangeMake(relativeStart, CFStringGetLength(path) - relativeStart));
+    Boolean success = CFStringGetFileSystemRepresentation(relativePath, buffer, CFMaxPathSize);
+    CFRelease(relativePath);
+    if (!success) return false;
+    
+    CFIndex length = 0, componentStart = 0;
+    for (CFIndex i = 0; ; i++) {
+        char c = buffer[i];
+        if (c && !__CFBundleResourceIndexIsSlash(c)) {
+            key[length++] = c;
+            continue;
+        }
+        CFIndex componentLength = length - componentStart;
+        if (componentLength > 0 && key[componentStart] == '.' && (componentLength == 1 || (componentLength == 2 && key[componentStart + 1] == '.'))) return false;
+        if (!c) break;
+        if (componentLength > 0) {
+            key[length++] = '/';
+            componentStart = length;
+        }
+    }
+    if (length > 0 && key[length - 1] == '/') length--;
+    key[length] = 0;
+    *keyLength = length;
+    return true;
+}
+
+static const __CFBundleResourceIndexDirectory *__CFBundleResourceIndexFindDirectory(const struct __CFBundleResourceIndex *index, const char *key, CFIndex keyLength) {
+    const __CFBundleResourceIndexHeader *header = __CFBundleResourceIndexGetHeader(index);
+    const uint32_t *slots = __CFBundleResourceIndexGetSlots(index);
+    const __CFBundleResourceIndexDirectory *directories = __CFBundleResourceIndexGetDirectories(index);
+    const char *strings = __CFBundleResourceIndexGetStrings(index);
+    uint32_t mask = header->_slotCount - 1;
+    for (uint32_t slot = __CFBundleResourceIndexHash(key, keyLength) & mask; slots[slot]; slot = (slot + 1) & mask) {
+        const __CFBundleResourceIndexDirectory *directory = &directories[slots[slot] - 1];
+        if (directory->_pathLength == keyLength && __CFBundleResourceIndexNamesAreEqual(strings + directory->_path, key, keyLength)) return directory;
+    }
+    return NULL;
+}
+
+// A path that isn't in the index doesn't exist, unless it goes through a symbolic link, which the index records but doesn't follow
+static Boolean __CFBundleResourceIndexPathGoesThroughLink(const struct __CFBundleResourceIndex *index, const char *key, CFIndex keyLength) {
+    const __CFBundleResourceIndexEntry *entries = __CFBundleResourceIndexGetEntries(index);
+    const char *strings = __CFBundleResourceIndexGetStrings(index);
+    CFIndex end = keyLength;
+    while (end > 0) {
+        CFIndex nameStart = end;
+        while (nameStart > 0 && key[nameStart - 1] != '/') nameStart--;
+        CFIndex parentLength = nameStart > 0 ? nameStart - 1 : 0;
+        const __CFBundleResourceIndexDirectory *parent = __CFBundleResourceIndexFindDirectory(index, key, parentLength);
+        if (parent) {
+            for (uint32_t i = parent->_firstEntry; i < parent->_firstEntry + parent->_entryCount; i++) {
+                if (entries[i]._nameLength == end - nameStart && __CFBundleResourceIndexNamesAreEqual(strings + entries[i]._name, key + nameStart, end - nameStart)) {
+                    return (entries[i]._flags & __kCFBundleResourceIndexEntryIsLink) != 0;
+                }
+            }
+            return false;
+        }
+        end = parentLength;
+    }
+    return false;
+}
+
+// Calls fileHandler with what _CFIterateDirectory would for the directory at path, whose part inside the bundle
+// starts at relativeStart. Returns false if the index can't answer for that directory.
+static Boolean __CFBundleResourceIndexIterateDirectory(const struct __CFBundleResourceIndex *index, CFStringRef path, CFIndex relativeStart, CFArrayRef stuffToPrefix, Boolean (^fileHandler)(CFStringRef fileName, CFStringRef fileNameWithPrefix, uint8_t fileType)) {
+    char key[CFMaxPathSize];
+    CFIndex keyLength;
+    if (!__CFBundleResourceIndexGetKey(path, relativeStart, key, &keyLength)) return false;
+    
+    const __CFBundleResourceIndexDirectory *directory = __CFBundleResourceIndexFindDirectory(index, key, keyLength);
+    if (!directory) return !__CFBundleResourceIndexPathGoesThroughLink(index, key, keyLength);
+    
+    CFMutableStringRef prefix = CFStringCreateMutable(kCFAllocatorSystemDefault, 0);
+    if (stuffToPrefix) {
+        for (CFIndex i = 0; i < CFArrayGetCount(stuffToPrefix); i++) {
+            CFStringRef onePrefix = (CFStringRef)CFArrayGetValueAtIndex(stuffToPrefix, i);
+            if (CFStringGetLength(onePrefix) > 0) {
+                CFStringAppend(prefix, onePrefix);
+                if (!CFStringHasSuffix(prefix, _CFGetSlashStr())) {
+                    CFStringAppend(prefix, _CFGetSlashStr());
+                }
+            }
+        }
+    }
+    
+    const __CFBundleResourceIndexEntry *entries = __CFBundleResourceIndexGetEntries(index);
+    const char *strings = __CFBundleResourceIndexGetStrings(index);
+    for (uint32_t i = directory->_firstEntry; i < directory->_firstEntry + directory->_entryCount; i++) {
+        CFStringRef fileName = CFStringCreateWithCString(kCFAllocatorSystemDefault, strings + entries[i]._name, kCFStringEncodingUTF8);
+        if (!fileName) continue;
+        
+        Boolean isDirectory = (entries[i]._flags & __kCFBundleResourceIndexEntryIsDirectory) != 0;
+        CFStringRef fileNameWithPrefix = NULL;
+        if (isDirectory || CFStringGetLength(prefix) > 0) {
+            CFMutableStringRef fullPathToFile = CFStringCreateMutableCopy(kCFAllocatorSystemDefault, 0, prefix);
+            CFStringAppend(fullPathToFile, fileName);
+            if (isDirectory) CFStringAppend(fullPathToFile, _CFGetSlashStr());
+            fileNameWithPrefix = fullPathToFile;
+        } else {
+            fileNameWithPrefix = (CFStringRef)CFRetain(fileName);
+        }
+        
+        // File types aren't recorded; directories are told apart by the trailing slash
+        Boolean result = fileHandler(fileName, fileNameWithPrefix, 0);
+        CFRelease(fileName);
+        CFRelease(fileNameWithPrefix);
+        if (!result) break;
+    }
+    
+    CFRelease(prefix);
+    return true;
+}
+
+static uint32_t __CFBundleResourceIndexAppendString(CFMutableDataRef strings, const char *string, CFIndex length) {
+    uint32_t offset = (uint32_t)CFDataGetLength(strings);
+    CFDataAppendBytes(strings, (const UInt8 *)string, length);
+    CFDataAppendBytes(strings, (const UInt8 *)"", 1);
+    return offset;
+}
+
+static Boolean __CFBundleResourceIndexIsValid(const struct __CFBundleResourceIndex *index, const char *bundlePath, CFAbsoluteTime modTime) {
+    if (index->_length < (CFIndex)sizeof(__CFBundleResourceIndexHeader)) return false;
+    const __CFBundleResourceIndexHeader *header = __CFBundleResourceIndexGetHeader(index);
+    if (header->_magic != __kCFBundleResourceIndexMagic || header->_version != __kCFBundleResourceIndexVersion || header->_modTime != modTime || header->_length != index->_length) return false;
+    
+    uint64_t length = sizeof(__CFBundleResourceIndexHeader) + (uint64_t)header->_slotCount * sizeof(uint32_t) + (uint64_t)header->_directoryCount * sizeof(__CFBundleResourceIndexDirectory) + (uint64_t)header->_entryCount * sizeof(__CFBundleResourceIndexEntry) + header->_stringsLength;
+    if (length != (uint64_t)index->_length) return false;
+    if (header->_directoryCount == 0 || header->_slotCount <= header->_directoryCount || (header->_slotCount & (header->_slotCount - 1)) != 0) return false;
+    
+    // Everything has to point inside the file, at strings that end where they should, so that lookups don't need to check
+    const char *strings = __CFBundleResourceIndexGetStrings(index);
+    if (header->_stringsLength == 0 || strings[header->_stringsLength - 1] != 0) return false;
+#define __CFBundleResourceIndexIsString(offset, length) ((uint64_t)(offset) + (length) < header->_stringsLength && strlen(strings + (offset)) == (length))
+    if (!__CFBundleResourceIndexIsString(header->_bundlePath, header->_bundlePathLength) || strcmp(strings + header->_bundlePath, bundlePath) != 0) return false;
+    
+    const uint32_t *slots = __CFBundleResourceIndexGetSlots(index);
+    for (uint32_t i = 0; i < header->_slotCount; i++) {
+        if (slots[i] > header->_directoryCount) return false;
+    }
+    const __CFBundleResourceIndexDirectory *directories = __CFBundleResourceIndexGetDirectories(index);
+    for (uint32_t i = 0; i < header->_directoryCount; i++) {
+        if (!__CFBundleResourceIndexIsString(directories[i]._path, directories[i]._pathLength)) return false;
+        if ((uint64_t)directories[i]._firstEntry + directories[i]._entryCount > header->_entryCount) return false;
+    }
+    const __CFBundleResourceIndexEntry *entries = __CFBundleResourceIndexGetEntries(index);
+    for (uint32_t i = 0; i < header->_entryCount; i++) {
+        if (!__CFBundleResourceIndexIsString(entries[i]._name, entries[i]._nameLength)) return false;
+    }
+#undef __CFBundleResourceIndexIsString
+    return true;
+}
+
+static void __CFBundleResourceIndexDeallocate(struct __CFBundleResourceIndex *index) {
+    if (index->_mapped) {
+#if !DEPLOYMENT_TARGET_WINDOWS
+        munmap(index->_bytes, index->_length);
+#endif
+    } else {
+        free(index->_bytes);
+    }
+    free(index);
+}
+
+// Walks the bundle a directory at a time. Bundles too big or too deep (which is what a symbolic link loop looks like
+// on Windows, where links to directories are followed) don't get an index.
+static struct __CFBundleResourceIndex *__CFBundleResourceIndexCreate(CFStringRef bundlePath, const char *bundlePathBuffer, CFAbsoluteTime modTime) {
+    CFMutableDataRef directories = CFDataCreateMutable(kCFAllocatorSystemDefault, 0);
+    CFMutableDataRef entries = CFDataCreateMutable(kCFAllocatorSystemDefault, 0);
+    CFMutableDataRef strings = CFDataCreateMutable(kCFAllocatorSystemDefault, 0);
+    CFMutableArrayRef queue = CFArrayCreateMutable(kCFAllocatorSystemDefault, 0, &kCFTypeArrayCallBacks);
+    CFIndex bundlePathLength = CFStringGetLength(bundlePath);
+    __block uint32_t entryCount = 0;
+    __block Boolean abandoned = false;
+    
+    uint32_t bundlePathOffset = __CFBundleResourceIndexAppendString(strings, bundlePathBuffer, strlen(bundlePathBuffer));
+    CFArrayAppendValue(queue, bundlePath);
+    for (CFIndex next = 0; next < CFArrayGetCount(queue) && !abandoned; next++) {
+        CFStringRef path = (CFStringRef)CFArrayGetValueAtIndex(queue, next);
+        char key[CFMaxPathSize];
+        CFIndex keyLength;
+        if (!__CFBundleResourceIndexGetKey(path, bundlePathLength, key, &keyLength)) {
+            abandoned = true;
+            break;
+        }
+        CFIndex depth = keyLength > 0 ? 1 : 0;
+        for (CFIndex i = 0; i < keyLength; i++) {
+            if (key[i] == '/') depth++;
+        }
+        
+        __CFBundleResourceIndexDirectory directory;
+        directory._pathLength = (uint32_t)keyLength;
+        directory._path = __CFBundleResourceIndexAppendString(strings, key, keyLength);
+        directory._firstEntry = entryCount;
+        _CFIterateDirectory(path, true, NULL, ^Boolean(CFStringRef fileName, CFStringRef fileNameWithPrefix, uint8_t fileType) {
+            char name[CFMaxPathSize];
+            if (!CFStringGetCString(fileName, name, CFMaxPathSize, kCFStringEncodingUTF8)) return true;
+            
+            __CFBundleResourceIndexEntry entry;
+            entry._nameLength = (uint32_t)strlen(name);
+            entry._name = __CFBundleResourceIndexAppendString(strings, name, entry._nameLength);
+            entry._flags = 0;
+            if (CFStringHasSuffix(fileNameWithPrefix, _CFGetSlashStr())) {
+                entry._flags |= __kCFBundleResourceIndexEntryIsDirectory;
+                if (depth >= __kCFBundleResourceIndexMaxDepth) {
+                    abandoned = true;
+                    return false;
+                }
+                CFMutableStringRef subdirectoryPath = CFStringCreateMutableCopy(kCFAllocatorSystemDefault, 0, path);
+                _CFAppendPathComponent2(subdirectoryPath, fileName);
+                CFArrayAppendValue(queue, subdirectoryPath);
+                CFRelease(subdirectoryPath);
+            }
+#if !DEPLOYMENT_TARGET_WINDOWS
+            else if (fileType == DT_LNK) {
+                entry._flags |= __kCFBundleResourceIndexEntryIsLink;
+            }
+#endif
+            CFDataAppendBytes(entries, (const UInt8 *)&entry, sizeof(entry));
+            if (++entryCount > __kCFBundleResourceIndexMaxEntries) {
+                abandoned = true;
+                return false;
+            }
+            return true;
+        });
+        directory._entryCount = entryCount - directory._firstEntry;
+        CFDataAppendBytes(directories, (const UInt8 *)&directory, sizeof(directory));
+    }
+    CFRelease(queue);
+    
+    struct __CFBundleResourceIndex *index = NULL;
+    uint32_t directoryCount = (uint32_t)(CFDataGetLength(directories) / sizeof(__CFBundleResourceIndexDirectory));
+    uint32_t slotCount = 2;
+    while (slotCount < 2 * directoryCount) slotCount <<= 1;
+    uint64_t length = sizeof(__CFBundleResourceIndexHeader) + (uint64_t)slotCount * sizeof(uint32_t) + CFDataGetLength(directories) + CFDataGetLength(entries) + CFDataGetLength(strings);
+    if (!abandoned && length <= UINT32_MAX) {
+        index = (struct __CFBundleResourceIndex *)malloc(sizeof(struct __CFBundleResourceIndex));
+        index->_bytes = (uint8_t *)calloc(1, (size_t)length);
+        index->_length = (CFIndex)length;
+        index->_mapped = false;
+        
+        __CFBundleResourceIndexHeader *header = (__CFBundleResourceIndexHeader *)index->_bytes;
+        header->_magic = __kCFBundleResourceIndexMagic;
+        header->_version = __kCFBundleResourceIndexVersion;
+        header->_modTime = modTime;
+        header->_length = (uint32_t)length;
+        header->_slotCount = slotCount;
+        header->_directoryCount = directoryCount;
+        header->_entryCount = entryCount;
+        header->_stringsLength = (uint32_t)CFDataGetLength(strings);
+        header->_bundlePath = bundlePathOffset;
+        header->_bundlePathLength = (uint32_t)strlen(bundlePathBuffer);
+        memmove((void *)__CFBundleResourceIndexGetDirectories(index), CFDataGetBytePtr(directories), CFDataGetLength(directories));
+        memmove((void *)__CFBundleResourceIndexGetEntries(index), CFDataGetBytePtr(entries), CFDataGetLength(entries));
+        memmove((void *)__CFBundleResourceIndexGetStrings(index), CFDataGetBytePtr(strings), CFDataGetLength(strings));
+        
+        uint32_t *slots = (uint32_t *)__CFBundleResourceIndexGetSlots(index);
+        const __CFBundleResourceIndexDirectory *indexDirectories = __CFBundleResourceIndexGetDirectories(index);
+        const char *indexStrings = __CFBundleResourceIndexGetStrings(index);
+        for (uint32_t i = 0; i < directoryCount; i++) {
+            uint32_t slot = __CFBundleResourceIndexHash(indexStrings + indexDirectories[i]._path, indexDirectories[i]._pathLength) & (slotCount - 1);
+            while (slots[slot]) slot = (slot + 1) & (slotCount - 1);
+            slots[slot] = i + 1;
+        }
+    }
+    
+    CFRelease(directories);
+    CFRelease(entries);
+    CFRelease(strings);
+    return index;
+}
+
+// The cache directory, or the index file in it for the bundle at bundlePath
+static CFStringRef __CFBundleCopyResourceIndexPath(const char *bundlePath, Boolean createDirectory) {
+    CFMutableStringRef path = NULL;
+#if DEPLOYMENT_TARGET_WINDOWS
+    path = _CFCreateApplicationRepositoryPath(kCFAllocatorSystemDefault, CSIDL_APPDATA);
+    if (!path) return NULL;
+    CFStringRef components[] = { CFSTR("CFBundleResourceIndex") };
+#else
+    CFURLRef homeURL = CFCopyHomeDirectoryURL();
+    if (!homeURL) return NULL;
+    CFURLRef absoluteURL = CFURLCopyAbsoluteURL(homeURL);
+    CFStringRef homePath = CFURLCopyFileSystemPath(absoluteURL, kCFURLPOSIXPathStyle);
+    CFRelease(absoluteURL);
+    CFRelease(homeURL);
+    if (!homePath) return NULL;
+    path = CFStringCreateMutableCopy(kCFAllocatorSystemDefault, 0, homePath);
+    CFRelease(homePath);
+    CFStringRef components[] = { CFSTR("Library"), CFSTR("Caches"), CFSTR("CFBundleResourceIndex") };
+#endif
+    for (CFIndex i = 0; i < (CFIndex)(sizeof(components) / sizeof(components[0])); i++) {
+        _CFAppendPathComponent2(path, components[i]);
+        char buffer[CFMaxPathSize];
+        if (createDirectory && CFStringGetFileSystemRepresentation(path, buffer, CFMaxPathSize)) {
+            _CFCreateDirectory(buffer);
+        }
+    }
+    
+    if (bundlePath) {
+        // Named for the bundle path, less any trailing slashes
+        CFIndex length = strlen(bundlePath);
+        while (length > 1 && __CFBundleResourceIndexIsSlash(bundlePath[length - 1])) length--;
+        uint64_t hash = 14695981039346656037ULL;
+        for (CFIndex i = 0; i < length; i++) {
+            hash = (hash ^ (uint8_t)__CFBundleResourceIndexFoldCase(bundlePath[i])) * 1099511628211ULL;
+        }
+        CFStringRef fileName = CFStringCreateWithFormat(kCFAllocatorSystemDefault, NULL, CFSTR("%016llx"), (unsigned long long)hash);
+        _CFAppendPathComponent2(path, fileName);
+        CFRelease(fileName);
+    }
+    return path;
+}
+
+static void __CFBundleDeleteResourceIndexFile(CFStringRef bundlePath) {
+    char bundlePathBuffer[CFMaxPathSize], indexPathBuffer[CFMaxPathSize];
+    if (!CFStringGetFileSystemRepresentation(bundlePath, bundlePathBuffer, CFMaxPathSize)) return;
+    CFStringRef indexPath = __CFBundleCopyResourceIndexPath(bundlePathBuffer, false);
+    if (indexPath) {
+        if (CFStringGetFileSystemRepresentation(indexPath, indexPathBuffer, CFMaxPathSize)) _CFDeleteFile(indexPathBuffer);
+        CFRelease(indexPath);
+    }
+}
+
+// Maps the saved index for the bundle, or makes a new one. Returns NULL if the bundle has to be read from the file system.
+static struct __CFBundleResourceIndex *__CFBundleCopyResourceIndex(CFStringRef bundlePath) {
+    if (__CFgetenv("CFBundleDisableResourceIndex")) return NULL;
+    
+    char bundlePathBuffer[CFMaxPathSize];
+    if (!CFStringGetFileSystemRepresentation(bundlePath, bundlePathBuffer, CFMaxPathSize)) return NULL;
+    Boolean exists = false;
+    SInt32 mode = 0;
+    CFDateRef modDate = NULL;
+    if (_CFGetPathProperties(kCFAllocatorSystemDefault, bundlePathBuffer, &exists, &mode, NULL, &modDate, NULL, NULL) != 0 || !exists || (mode & S_IFMT) != S_IFDIR || !modDate) {
+        if (modDate) CFRelease(modDate);
+        return NULL;
+    }
+    CFAbsoluteTime modTime = CFDateGetAbsoluteTime(modDate);
+    CFRelease(modDate);
+    
+    struct __CFBundleResourceIndex *index = NULL;
+    CFStringRef indexPath = __CFBundleCopyResourceIndexPath(bundlePathBuffer, false);
+    if (indexPath) {
+        void *bytes = NULL;
+        CFIndex length = 0;
+#if DEPLOYMENT_TARGET_MACOSX || DEPLOYMENT_TARGET_EMBEDDED || DEPLOYMENT_TARGET_EMBEDDED_MINI || DEPLOYMENT_TARGET_LINUX || DEPLOYMENT_TARGET_FREEBSD
+        Boolean map = true;
+#else
+        Boolean map = false; // Read in one go instead
+#endif
+        if (_CFReadMappedFromFile(indexPath, map, false, &bytes, &length, NULL)) {
+            index = (struct __CFBundleResourceIndex *)malloc(sizeof(struct __CFBundleResourceIndex));
+            index->_bytes = (uint8_t *)bytes;
+            index->_length = length;
+            index->_mapped = map && length > 0;
+            if (!__CFBundleResourceIndexIsValid(index, bundlePathBuffer, modTime)) {
+                __CFBundleResourceIndexDeallocate(index);
+                index = NULL;
+            }
+        }
+    }
+    
+    if (!index) {
+        index = __CFBundleResourceIndexCreate(bundlePath, bundlePathBuffer, modTime);
+        if (index && indexPath && CFAbsoluteTimeGetCurrent() - modTime >= __kCFBundleResourceIndexSettleTime) {
+            CFStringRef directoryPath = __CFBundleCopyResourceIndexPath(NULL, true);
+            if (directoryPath) CFRelease(directoryPath);
+            CFURLRef indexURL = CFURLCreateWithFileSystemPath(kCFAllocatorSystemDefault, indexPath, PLATFORM_PATH_STYLE, false);
+            if (indexURL) {
+                _CFWriteBytesToFile(indexURL, index->_bytes, index->_length);
+                CFRelease(indexURL);
+            }
+        }
+    }
+    
+    if (indexPath) CFRelease(indexPath);
+    return index;
+}
+
+CF_PRIVATE void _CFBundleDeallocateResourceIndex(CFBundleRef bundle) {
+    if (bundle->_resourceIndex) {
+        __CFBundleResourceIndexDeallocate(bundle->_resourceIndex);
+        bundle->_resourceIndex = NULL;
+    }
+    bundle->_lookedForResourceIndex = false;
+}
+
 #pragma mark -
 #pragma mark Directory Contents and Caches
 
-// These are here for compatibility, but they do nothing anymore
-CF_EXPORT void _CFBundleFlushCachesForURL(CFURLRef url) { }
-CF_EXPORT void _CFBundleFlushCaches(void) { }
+// Query tables live in the bundle objects; these throw away the saved resource indexes behind them, so that the next
+// bundle object made for the directory reads it afresh
+CF_EXPORT void _CFBundleFlushCachesForURL(CFURLRef url) {
+    CFURLRef absoluteURL = CFURLCopyAbsoluteURL(url);
+    CFStringRef bundlePath = CFURLCopyFileSystemPath(absoluteURL, PLATFORM_PATH_STYLE);
+    CFRelease(absoluteURL);
+    if (bundlePath) {
+        __CFBundleDeleteResourceIndexFile(bundlePath);
+        CFRelease(bundlePath);
+    }
+}
+
+CF_EXPORT void _CFBundleFlushCaches(void) {
+    CFStringRef directoryPath = __CFBundleCopyResourceIndexPath(NULL, false);
+    if (directoryPath) {
+        _CFIterateDirectory(directoryPath, false, NULL, ^Boolean(CFStringRef fileName, CFStringRef fileNameWithPrefix, uint8_t fileType) {
+            CFMutableStringRef path = CFStringCreateMutableCopy(kCFAllocatorSystemDefault, 0, directoryPath);
+            _CFAppendPathComponent2(path, fileName);
+            char buffer[CFMaxPathSize];
+            if (CFStringGetFileSystemRepresentation(path, buffer, CFMaxPathSize)) _CFDeleteFile(buffer);
+            CFRelease(path);
+            return true;
+        });
+        CFRelease(directoryPath);
+    }
+}
 
 CF_PRIVATE void _CFBundleFlushQueryTableCache(CFBundleRef bundle) {
     __CFLock(&bundle->_queryLock);
     if (bundle->_queryTable) {
         CFDictionaryRemoveAllValues(bundle->_queryTable);
     }
+    if (bundle->_lookedForResourceIndex) {
+        _CFBundleDeallocateResourceIndex(bundle);
+        __CFBundleDeleteResourceIndexFile(bundle->_bundleBasePath);
+    }
     __CFUnlock(&bundle->_queryLock);
 }
 
@@ -608,7 +1149,7 @@ static void _CFBundleSplitFileName(CFStringRef fileName, CFStringRef *noProductO
     }    
 }
 
-static Boolean _CFBundleReadDirectory(CFStringRef pathOfDir, CFStringRef subdirectory, CFMutableArrayRef allFiles, Boolean hasFileAdded, CFMutableDictionaryRef queryTable, CFMutableDictionaryRef typeDir, CFMutableDictionaryRef addedTypes, Boolean firstLproj, CFStringRef product, CFStringRef platform, CFStringRef lprojName) {
+static Boolean _CFBundleReadDirectory(const struct __CFBundleResourceIndex *resourceIndex, CFIndex relativeStart, CFStringRef pathOfDir, CFStringRef subdirectory, CFMutableArrayRef allFiles, Boolean hasFileAdded, CFMutableDictionaryRef queryTable, CFMutableDictionaryRef typeDir, CFMutableDictionaryRef addedTypes, Boolean firstLproj, CFStringRef product, CFStringRef platform, CFStringRef lprojName) {
     
     CFArrayRef stuffToPrefix = NULL;
     if (lprojName && subdirectory) {
@@ -621,7 +1162,7 @@ static Boolean _CFBundleReadDirectory(CFStringRef pathOfDir, CFStringRef subdire
     }
     
     // If this file is a directory, the path needs to include a trailing slash so we can later create the right kind of CFURL object
-    _CFIterateDirectory(pathOfDir, true, stuffToPrefix, ^Boolean(CFStringRef fileName, CFStringRef pathToFile, uint8_t fileType) {
+    Boolean (^addFile)(CFStringRef, CFStringRef, uint8_t) = ^Boolean(CFStringRef fileName, CFStringRef pathToFile, uint8_t fileType) {
         CFStringRef startType = NULL, endType = NULL, noProductOrPlatform = NULL;
         _CFBundleFileVersion fileVersion;
         _CFBundleSplitFileName(fileName, &noProductOrPlatform, &endType, &startType, product, platform, &fileVersion);
@@ -693,7 +1234,11 @@ static Boolean _CFBundleReadDirectory(CFStringRef pathOfDir, CFStringRef subdire
         if (noProductOrPlatform) CFRelease(noProductOrPlatform);
         
         return true;
-    });
+    };
+    
+    if (!resourceIndex || !__CFBundleResourceIndexIterateDirectory(resourceIndex, pathOfDir, relativeStart, stuffToPrefix, addFile)) {
+        _CFIterateDirectory(pathOfDir, true, stuffToPrefix, addFile);
+    }
     
     if (stuffToPrefix) CFRelease(stuffToPrefix);
     
@@ -701,7 +1246,7 @@ static Boolean _CFBundleReadDirectory(CFStringRef pathOfDir, CFStringRef subdire
 }
 
 
-static CFDictionaryRef _createQueryTableAtPath(CFStringRef inPath, CFArrayRef languages, CFStringRef resourcesDirectory, CFStringRef subdirectory)
+static CFDictionaryRef _createQueryTableAtPath(CFStringRef inPath, const struct __CFBundleResourceIndex *resourceIndex, CFArrayRef languages, CFStringRef resourcesDirectory, CFStringRef subdirectory)
 {
     
     CFMutableDictionaryRef queryTable = CFDictionaryCreateMutable(kCFAllocatorSystemDefault, 0, &kCFCopyStringDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
@@ -717,6 +1262,7 @@ static CFDictionaryRef _createQueryTableAtPath(CFStringRef inPath, CFArrayRef la
     CFStringRef platform = CFStringCreateWithFormat(kCFAllocatorSystemDefault, NULL, CFSTR("-%@"), platformName);
     
     CFMutableStringRef path = CFStringCreateMutableCopy(kCFAllocatorSystemDefault, 0, inPath);
+    CFIndex inPathLen = CFStringGetLength(inPath);
     
     if (resourcesDirectory) {
         _CFAppendPathComponent2(path, resourcesDirectory);
@@ -729,7 +1275,7 @@ static CFDictionaryRef _createQueryTableAtPath(CFStringRef inPath, CFArrayRef la
         _CFAppendPathComponent2(path, subdirectory);
     }
     // read the content in sub dir and put them into query table
-    _CFBundleReadDirectory(path, subdirectory, allFiles, false, queryTable, typeDir, NULL, false, product, platform, NULL);
+    _CFBundleReadDirectory(resourceIndex, inPathLen, path, subdirectory, allFiles, false, queryTable, typeDir, NULL, false, product, platform, NULL);
     CFStringDelete(path, CFRangeMake(basePathLen, CFStringGetLength(path) - basePathLen));    // Strip the string back to the base path
     
     CFIndex numOfAllFiles = CFArrayGetCount(allFiles);
@@ -750,7 +1296,7 @@ static CFDictionaryRef _createQueryTableAtPath(CFStringRef inPath, CFArrayRef la
         if (subdirectory) {
             _CFAppendPathComponent2(path, subdirectory);
         }
-        _CFBundleReadDirectory(path, subdirectory, allFiles, hasFileAdded, queryTable, typeDir, addedTypes, firstLproj, product, platform, lprojTargetWithLproj);
+        _CFBundleReadDirectory(resourceIndex, inPathLen, path, subdirectory, allFiles, hasFileAdded, queryTable, typeDir, addedTypes, firstLproj, product, platform, lprojTargetWithLproj);
         CFRelease(lprojTargetWithLproj);
         CFStringDelete(path, CFRangeMake(basePathLen, CFStringGetLength(path) - basePathLen));         // Strip the string back to the base path
         
@@ -766,7 +1312,7 @@ static CFDictionaryRef _createQueryTableAtPath(CFStringRef inPath, CFArrayRef la
     if (subdirectory) {
         _CFAppendPathComponent2(path, subdirectory);
     }
-    _CFBundleReadDirectory(path, subdirectory, allFiles, hasFileAdded, queryTable, typeDir, addedTypes, YES, product, platform, _CFBundleBaseDirectoryWithLproj);
+    _CFBundleReadDirectory(resourceIndex, inPathLen, path, subdirectory, allFiles, hasFileAdded, queryTable, typeDir, addedTypes, YES, product, platform, _CFBundleBaseDirectoryWithLproj);
     CFStringDelete(path, CFRangeMake(basePathLen, CFStringGetLength(path) - basePathLen));    // Strip the string back to the base path
     
     if (!hasFileAdded && numOfAllFiles < CFArrayGetCount(allFiles)) {
@@ -785,7 +1331,7 @@ static CFDictionaryRef _createQueryTableAtPath(CFStringRef inPath, CFArrayRef la
             if (subdirectory) {
                 _CFAppendPathComponent2(path, subdirectory);
             }
-            _CFBundleReadDirectory(path, subdirectory, allFiles, hasFileAdded, queryTable, typeDir, addedTypes, false, product, platform, lprojTargetWithLproj);
+            _CFBundleReadDirectory(resourceIndex, inPathLen, path, subdirectory, allFiles, hasFileAdded, queryTable, typeDir, addedTypes, false, product, platform, lprojTargetWithLproj);
             CFRelease(lprojTargetWithLproj);
             CFStringDelete(path, CFRangeMake(basePathLen, CFStringGetLength(path) - basePathLen));         // Strip the string back to the base path
 
@@ -841,8 +1387,14 @@ static CFDictionaryRef _copyQueryTable(CFBundleRef bundle, CFURLRef bundleURL, C
         }
         
         if (!subTable) {
+            // The resource index is only looked for once there is a directory to read
+            if (!bundle->_lookedForResourceIndex) {
+                bundle->_resourceIndex = __CFBundleCopyResourceIndex(bundle->_bundleBasePath);
+                bundle->_lookedForResourceIndex = true;
+            }
+            
             // create the query table for the given sub dir
-            subTable = _createQueryTableAtPath(bundle->_bundleBasePath, languages, resourcesDirectory, subdirectory);
+            subTable = _createQueryTableAtPath(bundle->_bundleBasePath, bundle->_resourceIndex, languages, resourcesDirectory, subdirectory);
             
             CFDictionarySetValue(bundle->_queryTable, argDirStr, subTable);
         } else {
@@ -854,7 +1406,7 @@ static CFDictionaryRef _copyQueryTable(CFBundleRef bundle, CFURLRef bundleURL, C
         CFURLRef url = CFURLCopyAbsoluteURL(bundleURL);
         CFStringRef bundlePath = CFURLCopyFileSystemPath(url, PLATFORM_PATH_STYLE);
         CFRelease(url);
-        subTable = _createQueryTableAtPath(bundlePath, languages, resourcesDirectory, subdirectory);
+        subTable = _createQueryTableAtPath(bundlePath, NULL, languages, resourcesDirectory, subdirectory);
         CFRelease(bundlePath);
     }
     
@@ -989,6 +989,14 @@ typedef int socklen_t;
 #include <CoreFoundation/CFString.h>
 #include <CoreFoundation/CFPropertyList.h>
 #include "CFInternal.h"
+#if DEPLOYMENT_TARGET_LINUX
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+#if !DEPLOYMENT_TARGET_WINDOWS
+#include <poll.h>
+#endif
 
 #ifndef NBBY
 #define NBBY 8
@@ -1002,9 +1010,6 @@ typedef int socklen_t;
 #undef EBADF
 #define EBADF WSAENOTSOCK
 
-#define NFDBITS (sizeof(int32_t) * NBBY)
-
-typedef int32_t fd_mask;
 typedef int socklen_t;
 
 #define gettimeofday _NS_gettimeofday
@@ -1026,7 +1031,38 @@ if ((vvp)->tv_usec < 0) {               \
 
 
 // On Mach we use a v0 RunLoopSource to make client callbacks.  That source is signalled by a
-// separate SocketManager thread who uses select() to watch the sockets' fds.
+// separate SocketManager thread who watches the sockets' fds.
+//
+// Sockets are added to and removed from the manager's poll set one at a time as their callbacks
+// are enabled and disabled, rather than the manager rebuilding fd_sets from every scheduled
+// socket on each pass, so a pass costs about as much as the number of sockets that are ready.
+// On Linux the poll set is an epoll instance woken by an eventfd; elsewhere it is an array of
+// pollfds for poll() (WSAPoll() on Windows) woken by the wakeup socket pair.  Either way a socket
+// is reported once per arming: the manager disarms it and signals its source, and it is armed
+// again when its callbacks are re-enabled, just as it used to be cleared from and set back into
+// the fd_sets.  Run loops are woken once per batch of ready sockets rather than once per socket.
+
+#if DEPLOYMENT_TARGET_LINUX
+#define USE_EPOLL 1
+#else
+#define USE_EPOLL 0
+#endif
+
+#if DEPLOYMENT_TARGET_WINDOWS
+typedef WSAPOLLFD __CFSocketPollFd;
+#define __CFSocketPoll(fds, count, timeout) WSAPoll((fds), (ULONG)(count), (timeout))
+#else
+typedef struct pollfd __CFSocketPollFd;
+#define __CFSocketPoll(fds, count, timeout) poll((fds), (nfds_t)(count), (timeout))
+#endif
+
+/* Most ready sockets the manager handles before it wakes the run loops they signalled */
+#define MAX_MANAGER_EVENTS 256
+
+enum {
+    __kCFSocketManagerRead = 1,
+    __kCFSocketManagerWrite = 2
+};
 
 //#define LOG_CFSOCKET
 
@@ -1044,36 +1080,10 @@ CF_INLINE int __CFSocketLastError(void) {
 #endif
 }
 
-CF_INLINE CFIndex __CFSocketFdGetSize(CFDataRef fdSet) {
-    return NBBY * CFDataGetLength(fdSet);
-}
-
 // WINOBJC: ignore -Wtautological-compare as sock is unsigned but we have INVALID_SOCKET checks
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wtautological-compare"
 
-CF_INLINE Boolean __CFSocketFdSet(CFSocketNativeHandle sock, CFMutableDataRef fdSet) {
-    /* returns true if a change occurred, false otherwise */
-    Boolean retval = false;
-    if (INVALID_SOCKET != sock && 0 <= sock) {
-        CFIndex numFds = NBBY * CFDataGetLength(fdSet);
-        fd_mask *fds_bits;
-        if (sock >= numFds) {
-            CFIndex oldSize = numFds / NFDBITS, newSize = (sock + NFDBITS) / NFDBITS, changeInBytes = (newSize - oldSize) * sizeof(fd_mask);
-            CFDataIncreaseLength(fdSet, changeInBytes);
-            fds_bits = (fd_mask *)CFDataGetMutableBytePtr(fdSet);
-            memset(fds_bits + oldSize, 0, changeInBytes);
-        } else {
-            fds_bits = (fd_mask *)CFDataGetMutableBytePtr(fdSet);
-        }
-        if (!FD_ISSET(sock, (fd_set *)fds_bits)) {
-            retval = true;
-            FD_SET(sock, (fd_set *)fds_bits);
-        }
-    }
-    return retval;
-}
-
 
 #define MAX_SOCKADDR_LEN 256
 #define MAX_DATA_SIZE 65535
@@ -1086,16 +1096,25 @@ CF_INLINE Boolean __CFSocketFdSet(CFSocketNativeHandle sock, CFMutableDataRef fd
  */
 static CFLock_t __CFAllSocketsLock = CFLockInit; /* controls __CFAllSockets */
 static CFMutableDictionaryRef __CFAllSockets = NULL;
-static CFLock_t __CFActiveSocketsLock = CFLockInit; /* controls __CFRead/WriteSockets, __CFRead/WriteSocketsFds, __CFSocketManagerThread, and __CFSocketManagerIteration */
+static CFLock_t __CFActiveSocketsLock = CFLockInit; /* controls __CFRead/WriteSockets, the poll set, __CFSocketManagerThread, and __CFSocketManagerIteration */
 static volatile UInt32 __CFSocketManagerIteration = 0;
-static CFMutableArrayRef __CFWriteSockets = NULL;
-static CFMutableArrayRef __CFReadSockets = NULL;
-static CFMutableDataRef __CFWriteSocketsFds = NULL;
-static CFMutableDataRef __CFReadSocketsFds = NULL;
+static CFMutableSetRef __CFWriteSockets = NULL;
+static CFMutableSetRef __CFReadSockets = NULL;
+static CFMutableDictionaryRef __CFArmedSockets = NULL;  /* native socket -> CFSocket, for every socket armed in the poll set */
+static CFMutableArrayRef __CFBadSockets = NULL;  /* sockets the poll set refused, for the manager to invalidate */
 static CFDataRef zeroLengthData = NULL;
-static Boolean __CFReadSocketsTimeoutInvalid = true;  /* rebuild the timeout value before calling select */
+static Boolean __CFReadSocketsTimeoutInvalid = true;  /* rebuild the timeout value before waiting */
+static Boolean __CFReadSocketsHaveTimeout = false;  /* the manager is waiting with a timeout */
+static Boolean __CFSocketManagerWakeUpPending = false;
 
+#if USE_EPOLL
+static int __CFSocketManagerEpoll = -1;
+static int __CFSocketManagerEvent = -1;
+#else
+static CFMutableDataRef __CFSocketPollFds = NULL;  /* __CFSocketPollFd for each armed socket, after the wakeup socket */
+static Boolean __CFSocketPollFdsChanged = true;
 static CFSocketNativeHandle __CFWakeupSocketPair[2] = {INVALID_SOCKET, INVALID_SOCKET};
+#endif
 static void *__CFSocketManagerThread = NULL;
 
 static void __CFSocketDoCallback(CFSocketRef s, CFDataRef data, CFDataRef address, CFSocketNativeHandle sock);
@@ -1141,6 +1160,11 @@ struct __CFSocket {
     // We need to notify any waiting buffered read clients if there is data available without relying on select timing out.
     struct timeval _readBufferTimeoutNotificationTime;
     Boolean _hitTheTimeout;
+
+    // The events armed in the socket manager's poll set, and where; protected by __CFActiveSocketsLock
+    uint8_t _armedEvents;
+    Boolean _registered;            /* epoll has an entry for _socket, armed or not */
+    CFIndex _pollIndex;             /* index of the pollfd for _socket, or kCFNotFound */
 };
 
 /* Bit 6 in the base reserved bits is used for write-signalled state (mutable) */
@@ -1242,23 +1266,7 @@ static Boolean __CFNativeSocketIsValid(CFSocketNativeHandle sock) {
 #endif
 }
 
-CF_INLINE Boolean __CFSocketFdClr(CFSocketNativeHandle sock, CFMutableDataRef fdSet) {
-    /* returns true if a change occurred, false otherwise */
-    Boolean retval = false;
-    if (INVALID_SOCKET != sock && 0 <= sock) {
-        CFIndex numFds = NBBY * CFDataGetLength(fdSet);
-        fd_mask *fds_bits;
-        if (sock < numFds) {
-            fds_bits = (fd_mask *)CFDataGetMutableBytePtr(fdSet);
-            if (FD_ISSET(sock, (fd_set *)fds_bits)) {
-                retval = true;
-                FD_CLR(sock, (fd_set *)fds_bits);
-            }
-        }
-    }
-    return retval;
-}
-
+#if !USE_EPOLL
 static SInt32 __CFSocketCreateWakeupSocketPair(void) {
 #if DEPLOYMENT_TARGET_MACOSX || DEPLOYMENT_TARGET_EMBEDDED || DEPLOYMENT_TARGET_EMBEDDED_MINI
     SInt32 error;
@@ -1300,48 +1308,157 @@ static SInt32 __CFSocketCreateWakeupSocketPair(void) {
 #endif
     return error;
 }
+#endif
 
-
-// Version 0 RunLoopSources set a mask in an FD set to control what socket activity we hear about.
-// Changes to the master fs_sets occur via these 4 functions.
-CF_INLINE Boolean __CFSocketSetFDForRead(CFSocketRef s) {
-    __CFReadSocketsTimeoutInvalid = true;
-    Boolean b = __CFSocketFdSet(s->_socket, __CFReadSocketsFds);
-    if (b && INVALID_SOCKET != __CFWakeupSocketPair[0]) {
-        uint8_t c = 'r';
+// Called with __CFActiveSocketsLock held.  Wakeups coalesce until the manager starts its next pass.
+static void __CFSocketManagerWakeUp(void) {
+    if (__CFSocketManagerWakeUpPending) return;
+    __CFSocketManagerWakeUpPending = true;
+#if USE_EPOLL
+    if (0 <= __CFSocketManagerEvent) {
+        uint64_t one = 1;
+        write(__CFSocketManagerEvent, &one, sizeof(one));
+    }
+#else
+    if (INVALID_SOCKET != __CFWakeupSocketPair[0]) {
+        uint8_t c = 'u';
         send(__CFWakeupSocketPair[0], (const char *)&c, sizeof(c), 0);
     }
-    return b;
+#endif
 }
 
-CF_INLINE Boolean __CFSocketClearFDForRead(CFSocketRef s) {
-    __CFReadSocketsTimeoutInvalid = true;
-    Boolean b = __CFSocketFdClr(s->_socket, __CFReadSocketsFds);
-    if (b && INVALID_SOCKET != __CFWakeupSocketPair[0]) {
-        uint8_t c = 's';
-        send(__CFWakeupSocketPair[0], (const char *)&c, sizeof(c), 0);
+#if !USE_EPOLL
+CF_INLINE __CFSocketPollFd *__CFSocketGetPollFds(CFMutableDataRef pollFds) {
+    return (__CFSocketPollFd *)CFDataGetMutableBytePtr(pollFds);
+}
+
+CF_INLINE CFIndex __CFSocketGetPollFdCount(CFDataRef pollFds) {
+    return CFDataGetLength(pollFds) / sizeof(__CFSocketPollFd);
+}
+#endif
+
+/* Brings the poll set into line with s->_armedEvents; returns false if the socket can't be watched */
+static Boolean __CFSocketRegister(CFSocketRef s) {
+    CFSocketNativeHandle sock = s->_socket;
+#if USE_EPOLL
+    if (0 == s->_armedEvents) {
+        if (s->_registered) {
+            epoll_ctl(__CFSocketManagerEpoll, EPOLL_CTL_DEL, sock, NULL);
+            s->_registered = false;
+        }
+        return true;
+    }
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLONESHOT;
+    if (0 != (s->_armedEvents & __kCFSocketManagerRead)) event.events |= EPOLLIN;
+    if (0 != (s->_armedEvents & __kCFSocketManagerWrite)) event.events |= EPOLLOUT;
+    event.data.fd = sock;
+    int result = epoll_ctl(__CFSocketManagerEpoll, s->_registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, sock, &event);
+    /* an earlier CFSocket for this fd may have left it registered, or closing a dup may have dropped it */
+    if (0 > result && EEXIST == errno) {
+        result = epoll_ctl(__CFSocketManagerEpoll, EPOLL_CTL_MOD, sock, &event);
+    } else if (0 > result && ENOENT == errno) {
+        result = epoll_ctl(__CFSocketManagerEpoll, EPOLL_CTL_ADD, sock, &event);
+    }
+    s->_registered = (0 <= result);
+    return s->_registered;
+#else
+    CFIndex idx = s->_pollIndex;
+    if (0 == s->_armedEvents) {
+        if (kCFNotFound != idx) {
+            /* fill the hole with the last pollfd */
+            __CFSocketPollFd *fds = __CFSocketGetPollFds(__CFSocketPollFds);
+            CFIndex last = __CFSocketGetPollFdCount(__CFSocketPollFds) - 1;
+            if (idx != last) {
+                fds[idx] = fds[last];
+                CFSocketRef moved = (CFSocketRef)CFDictionaryGetValue(__CFArmedSockets, (void *)(uintptr_t)fds[idx].fd);
+                if (NULL != moved) moved->_pollIndex = idx;
+            }
+            CFDataSetLength(__CFSocketPollFds, last * sizeof(__CFSocketPollFd));
+            s->_pollIndex = kCFNotFound;
+            __CFSocketPollFdsChanged = true;
+        }
+        return true;
+    }
+    short events = 0;
+    if (0 != (s->_armedEvents & __kCFSocketManagerRead)) events |= POLLIN;
+    if (0 != (s->_armedEvents & __kCFSocketManagerWrite)) events |= POLLOUT;
+    if (kCFNotFound == idx) {
+        __CFSocketPollFd fd;
+        memset(&fd, 0, sizeof(fd));
+        fd.fd = sock;
+        fd.events = events;
+        CFDataAppendBytes(__CFSocketPollFds, (const UInt8 *)&fd, sizeof(fd));
+        s->_pollIndex = __CFSocketGetPollFdCount(__CFSocketPollFds) - 1;
+    } else {
+        __CFSocketGetPollFds(__CFSocketPollFds)[idx].events = events;
+    }
+    __CFSocketPollFdsChanged = true;
+    return true;
+#endif
+}
+
+/* Arms exactly these events for the socket; returns true if a change occurred, false otherwise */
+static Boolean __CFSocketSetArmedEvents(CFSocketRef s, uint8_t events) {
+    CFSocketNativeHandle sock = s->_socket;
+    uint8_t previous = s->_armedEvents;
+    if (INVALID_SOCKET == sock || events == previous) return false;
+    s->_armedEvents = events;
+    if (0 == previous) {
+        CFDictionarySetValue(__CFArmedSockets, (void *)(uintptr_t)sock, s);
+    } else if (0 == events && s == CFDictionaryGetValue(__CFArmedSockets, (void *)(uintptr_t)sock)) {
+        CFDictionaryRemoveValue(__CFArmedSockets, (void *)(uintptr_t)sock);
     }
+    if (!__CFSocketRegister(s)) {
+        /* this is where select() would have failed with EBADF; the manager invalidates the socket */
+#if defined(LOG_CFSOCKET)
+        fprintf(stdout, "socket manager could not watch socket %d, error %d\n", sock, __CFSocketLastError());
+#endif
+        s->_armedEvents = 0;
+        CFDictionaryRemoveValue(__CFArmedSockets, (void *)(uintptr_t)sock);
+        CFArrayAppendValue(__CFBadSockets, s);
+        __CFSocketManagerWakeUp();
+        return false;
+    }
+#if !USE_EPOLL
+    /* the manager polls a copy of the pollfds, so it has to pick up new events; it can ignore old ones */
+    if (0 != (events & ~previous)) __CFSocketManagerWakeUp();
+#endif
+    return true;
+}
+
+/* Returns true if the manager should work out its timeout again */
+CF_INLINE Boolean __CFSocketInvalidateReadTimeout(CFSocketRef s) {
+    if (__CFReadSocketsHaveTimeout || timerisset(&s->_readBufferTimeout) || NULL != s->_leftoverBytes) {
+        __CFReadSocketsTimeoutInvalid = true;
+        return true;
+    }
+    return false;
+}
+
+// Version 0 RunLoopSources arm events in the poll set to control what socket activity we hear about.
+// Changes to the poll set occur via these 4 functions.
+CF_INLINE Boolean __CFSocketSetFDForRead(CFSocketRef s) {
+    Boolean timeoutInvalid = __CFSocketInvalidateReadTimeout(s);
+    Boolean b = __CFSocketSetArmedEvents(s, s->_armedEvents | __kCFSocketManagerRead);
+    if (b && timeoutInvalid) __CFSocketManagerWakeUp();
     return b;
 }
 
+CF_INLINE Boolean __CFSocketClearFDForRead(CFSocketRef s) {
+    __CFSocketInvalidateReadTimeout(s);
+    return __CFSocketSetArmedEvents(s, s->_armedEvents & ~__kCFSocketManagerRead);
+}
+
 CF_INLINE Boolean __CFSocketSetFDForWrite(CFSocketRef s) {
     // CFLog(5, CFSTR("__CFSocketSetFDForWrite(%p)"), s);
-    Boolean b = __CFSocketFdSet(s->_socket, __CFWriteSocketsFds);
-    if (b && INVALID_SOCKET != __CFWakeupSocketPair[0]) {
-        uint8_t c = 'w';
-        send(__CFWakeupSocketPair[0], (const char *)&c, sizeof(c), 0);
-    }
-    return b;
+    return __CFSocketSetArmedEvents(s, s->_armedEvents | __kCFSocketManagerWrite);
 }
 
 CF_INLINE Boolean __CFSocketClearFDForWrite(CFSocketRef s) {
     // CFLog(5, CFSTR("__CFSocketClearFDForWrite(%p)"), s);
-    Boolean b = __CFSocketFdClr(s->_socket, __CFWriteSocketsFds);
-    if (b && INVALID_SOCKET != __CFWakeupSocketPair[0]) {
-        uint8_t c = 'x';
-        send(__CFWakeupSocketPair[0], (const char *)&c, sizeof(c), 0);
-    }
-    return b;
+    return __CFSocketSetArmedEvents(s, s->_armedEvents & ~__kCFSocketManagerWrite);
 }
 
 #if DEPLOYMENT_TARGET_WINDOWS
@@ -1385,23 +1502,40 @@ CF_PRIVATE void __CFSocketCleanup(void) {
 
 // CFNetwork needs to call this, especially for Win32 to get WSAStartup
 static void __CFSocketInitializeSockets(void) {
-    __CFWriteSockets = CFArrayCreateMutable(kCFAllocatorSystemDefault, 0, NULL);
-    __CFReadSockets = CFArrayCreateMutable(kCFAllocatorSystemDefault, 0, NULL);
-    __CFWriteSocketsFds = CFDataCreateMutable(kCFAllocatorSystemDefault, 0);
-    __CFReadSocketsFds = CFDataCreateMutable(kCFAllocatorSystemDefault, 0);
+    __CFWriteSockets = CFSetCreateMutable(kCFAllocatorSystemDefault, 0, NULL);
+    __CFReadSockets = CFSetCreateMutable(kCFAllocatorSystemDefault, 0, NULL);
+    __CFArmedSockets = CFDictionaryCreateMutable(kCFAllocatorSystemDefault, 0, NULL, NULL);
+    __CFBadSockets = CFArrayCreateMutable(kCFAllocatorSystemDefault, 0, &kCFTypeArrayCallBacks);
     zeroLengthData = CFDataCreateMutable(kCFAllocatorSystemDefault, 0);
 #if DEPLOYMENT_TARGET_WINDOWS
     __CFSocketInitializeWinSock_Guts();
 #endif
+#if USE_EPOLL
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    __CFSocketManagerEpoll = epoll_create1(EPOLL_CLOEXEC);
+    __CFSocketManagerEvent = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    event.events = EPOLLIN;
+    event.data.fd = __CFSocketManagerEvent;
+    if (0 > __CFSocketManagerEpoll || 0 > __CFSocketManagerEvent || 0 > epoll_ctl(__CFSocketManagerEpoll, EPOLL_CTL_ADD, __CFSocketManagerEvent, &event)) {
+        CFLog(kCFLogLevelWarning, CFSTR("*** Could not create epoll instance for CFSocket!!!"));
+    }
+#else
+    __CFSocketPollFds = CFDataCreateMutable(kCFAllocatorSystemDefault, 0);
     if (0 > __CFSocketCreateWakeupSocketPair()) {
         CFLog(kCFLogLevelWarning, CFSTR("*** Could not create wakeup socket pair for CFSocket!!!"));
     } else {
         UInt32 yes = 1;
+        __CFSocketPollFd wakeup;
         /* wakeup sockets must be non-blocking */
         ioctlsocket(__CFWakeupSocketPair[0], FIONBIO, (u_long *)&yes);
         ioctlsocket(__CFWakeupSocketPair[1], FIONBIO, (u_long *)&yes);
-        __CFSocketFdSet(__CFWakeupSocketPair[1], __CFReadSocketsFds);
+        memset(&wakeup, 0, sizeof(wakeup));
+        wakeup.fd = __CFWakeupSocketPair[1];
+        wakeup.events = POLLIN;
+        CFDataAppendBytes(__CFSocketPollFds, (const UInt8 *)&wakeup, sizeof(wakeup));
     }
+#endif
 }
 
 static CFRunLoopRef __CFSocketCopyRunLoopToWakeUp(CFRunLoopSourceRef src, CFMutableArrayRef runLoops) {
@@ -1450,9 +1584,43 @@ static CFRunLoopRef __CFSocketCopyRunLoopToWakeUp(CFRunLoopSourceRef src, CFMuta
     return rl;
 }
 
+// Signals the socket's v0 RunLoopSource and wakes a run loop to perform it, or adds that run loop to
+// runLoopsToWakeUp so the caller can wake each run loop once for a whole batch of sockets.
+// Called with the socket lock held, returns with it released.
+static void __CFSocketSignalSource(CFSocketRef s, CFMutableArrayRef runLoopsToWakeUp) {
+    CFRunLoopSourceSignal(s->_source0);
+    CFMutableArrayRef runLoopsOrig = (CFMutableArrayRef)CFRetain(s->_runLoops);
+    CFMutableArrayRef runLoopsCopy = CFArrayCreateMutableCopy(kCFAllocatorSystemDefault, 0, s->_runLoops);
+    CFRunLoopSourceRef source0 = s->_source0;
+    if (NULL != source0 && !CFRunLoopSourceIsValid(source0)) {
+        source0 = NULL;
+    }
+    if (source0) CFRetain(source0);
+    __CFSocketUnlock(s);
+    CFRunLoopRef rl = __CFSocketCopyRunLoopToWakeUp(source0, runLoopsCopy);
+    if (source0) CFRelease(source0);
+    if (NULL != rl) {
+        if (NULL == runLoopsToWakeUp) {
+            CFRunLoopWakeUp(rl);
+        } else if (!CFArrayContainsValue(runLoopsToWakeUp, CFRangeMake(0, CFArrayGetCount(runLoopsToWakeUp)), rl)) {
+            CFArrayAppendValue(runLoopsToWakeUp, rl);
+        }
+        CFRelease(rl);
+    }
+    __CFSocketLock(s);
+    if (runLoopsOrig == s->_runLoops) {
+        s->_runLoops = runLoopsCopy;
+        runLoopsCopy = NULL;
+        CFRelease(runLoopsOrig);
+    }
+    __CFSocketUnlock(s);
+    CFRelease(runLoopsOrig);
+    if (runLoopsCopy) CFRelease(runLoopsCopy);
+}
+
 // If callBackNow, we immediately do client callbacks, else we have to signal a v0 RunLoopSource so the
 // callbacks can happen in another thread.
-static void __CFSocketHandleWrite(CFSocketRef s, Boolean callBackNow) {
+static void __CFSocketHandleWrite(CFSocketRef s, Boolean callBackNow, CFMutableArrayRef runLoopsToWakeUp) {
     SInt32 errorCode = 0;
     int errorSize = sizeof(errorCode);
     CFOptionFlags writeCallBacksAvailable;
@@ -1479,30 +1647,7 @@ static void __CFSocketHandleWrite(CFSocketRef s, Boolean callBackNow) {
     if (callBackNow) {
         __CFSocketDoCallback(s, NULL, NULL, 0);
     } else {
-        CFRunLoopSourceSignal(s->_source0);
-        CFMutableArrayRef runLoopsOrig = (CFMutableArrayRef)CFRetain(s->_runLoops);
-        CFMutableArrayRef runLoopsCopy = CFArrayCreateMutableCopy(kCFAllocatorSystemDefault, 0, s->_runLoops);
-        CFRunLoopSourceRef source0 = s->_source0;
-        if (NULL != source0 && !CFRunLoopSourceIsValid(source0)) {
-            source0 = NULL;
-        }
-        if (source0) CFRetain(source0);
-        __CFSocketUnlock(s);
-        CFRunLoopRef rl = __CFSocketCopyRunLoopToWakeUp(source0, runLoopsCopy);
-        if (source0) CFRelease(source0);
-        if (NULL != rl) {
-            CFRunLoopWakeUp(rl);
-            CFRelease(rl);
-        }
-        __CFSocketLock(s);
-        if (runLoopsOrig == s->_runLoops) {
-            s->_runLoops = runLoopsCopy;
-            runLoopsCopy = NULL;
-            CFRelease(runLoopsOrig);
-        }
-        __CFSocketUnlock(s);
-        CFRelease(runLoopsOrig);
-        if (runLoopsCopy) CFRelease(runLoopsCopy);
+        __CFSocketSignalSource(s, runLoopsToWakeUp);
     }
 }
 
@@ -1562,7 +1707,7 @@ CFStringRef copyLocalAddress(CFAllocatorRef alloc, CFSocketNativeHandle s)
 
 #endif
 
-static void __CFSocketHandleRead(CFSocketRef s, Boolean causedByTimeout)
+static void __CFSocketHandleRead(CFSocketRef s, Boolean causedByTimeout, CFMutableArrayRef runLoopsToWakeUp)
 {
     CFDataRef data = NULL, address = NULL;
     CFSocketNativeHandle sock = INVALID_SOCKET;
@@ -1760,30 +1905,7 @@ static void __CFSocketHandleRead(CFSocketRef s, Boolean causedByTimeout)
 #if defined(LOG_CFSOCKET)
     fprintf(stdout, "read signaling source for socket %d\n", s->_socket);
 #endif
-    CFRunLoopSourceSignal(s->_source0);
-    CFMutableArrayRef runLoopsOrig = (CFMutableArrayRef)CFRetain(s->_runLoops);
-    CFMutableArrayRef runLoopsCopy = CFArrayCreateMutableCopy(kCFAllocatorSystemDefault, 0, s->_runLoops);
-    CFRunLoopSourceRef source0 = s->_source0;
-    if (NULL != source0 && !CFRunLoopSourceIsValid(source0)) {
-        source0 = NULL;
-    }
-    if (source0) CFRetain(source0);
-    __CFSocketUnlock(s);
-    CFRunLoopRef rl = __CFSocketCopyRunLoopToWakeUp(source0, runLoopsCopy);
-    if (source0) CFRelease(source0);
-    if (NULL != rl) {
-        CFRunLoopWakeUp(rl);
-        CFRelease(rl);
-    }
-    __CFSocketLock(s);
-    if (runLoopsOrig == s->_runLoops) {
-        s->_runLoops = runLoopsCopy;
-        runLoopsCopy = NULL;
-        CFRelease(runLoopsOrig);
-    }
-    __CFSocketUnlock(s);
-    CFRelease(runLoopsOrig);
-    if (runLoopsCopy) CFRelease(runLoopsCopy);
+    __CFSocketSignalSource(s, runLoopsToWakeUp);
 }
 
 static struct timeval* intervalToTimeval(CFTimeInterval timeout, struct timeval* tv)
@@ -2007,93 +2129,102 @@ Boolean __CFSocketGetBytesAvailable(CFSocketRef s, CFIndex* ctBytesAvailable)
 }
 
 #if defined(LOG_CFSOCKET)
-static void __CFSocketWriteSocketList(CFArrayRef sockets, CFDataRef fdSet, Boolean onlyIfSet) {
-    fd_set *tempfds = (fd_set *)CFDataGetBytePtr(fdSet);
-    SInt32 idx, cnt;
-    for (idx = 0, cnt = CFArrayGetCount(sockets); idx < cnt; idx++) {
-        CFSocketRef s = (CFSocketRef)CFArrayGetValueAtIndex(sockets, idx);
-        if (FD_ISSET(s->_socket, tempfds)) {
-            fprintf(stdout, "%d ", s->_socket);
-        } else if (!onlyIfSet) {
-            fprintf(stdout, "(%d) ", s->_socket);
-        }
+static void __CFSocketWriteSocket(const void *value, void *context) {
+    CFSocketRef s = (CFSocketRef)value;
+    if (0 != (s->_armedEvents & *(uint8_t *)context)) {
+        fprintf(stdout, "%d ", s->_socket);
+    } else {
+        fprintf(stdout, "(%d) ", s->_socket);
     }
 }
+
+static void __CFSocketWriteSocketList(CFSetRef sockets, uint8_t events) {
+    CFSetApplyFunction(sockets, __CFSocketWriteSocket, &events);
+}
 #endif
 
-static void
-clearInvalidFileDescriptors(CFMutableDataRef d)
-{
-    if (d) {
-        SInt32 count = __CFSocketFdGetSize(d);
-        fd_set* s = (fd_set*) CFDataGetMutableBytePtr(d);
-        for (SInt32 idx = 0;  idx < count;  idx++) {
-            if (FD_ISSET(idx, s))
-                if (! __CFNativeSocketIsValid(idx)) {
-                    FD_CLR(idx, s);
-                }
-        }
+static void __CFSocketCollectInvalidSocket(const void *key, const void *value, void *context) {
+    CFSocketRef s = (CFSocketRef)value;
+    if (!__CFNativeSocketIsValid(s->_socket)) {
+#if defined(LOG_CFSOCKET)
+        fprintf(stdout, "socket manager found socket %d invalid\n", s->_socket);
+#endif
+        CFArrayAppendValue((CFMutableArrayRef)context, s);
     }
 }
 
 static void
-manageSelectError()
+manageSelectError(CFMutableArrayRef invalidSockets)
 {
     SInt32 selectError = __CFSocketLastError();
 #if defined(LOG_CFSOCKET)
-    fprintf(stdout, "socket manager received error %ld from select\n", (long)selectError);
+    fprintf(stdout, "socket manager received error %ld from poll\n", (long)selectError);
 #endif
-    if (EBADF == selectError) {
-        CFMutableArrayRef invalidSockets = CFArrayCreateMutable(kCFAllocatorSystemDefault, 0, &kCFTypeArrayCallBacks);
-        
-        __CFLock(&__CFActiveSocketsLock);
-        CFIndex cnt = CFArrayGetCount(__CFWriteSockets);
-        CFIndex idx;
-        for (idx = 0; idx < cnt; idx++) {
-            CFSocketRef s = (CFSocketRef)CFArrayGetValueAtIndex(__CFWriteSockets, idx);
-            if (!__CFNativeSocketIsValid(s->_socket)) {
-#if defined(LOG_CFSOCKET)
-                fprintf(stdout, "socket manager found write socket %d invalid\n", s->_socket);
+#if DEPLOYMENT_TARGET_WINDOWS
+    if (WSAEINTR == selectError) return;
+#else
+    if (EINTR == selectError) return;
 #endif
-                CFArrayAppendValue(invalidSockets, s);
-            }
-        }
-        cnt = CFArrayGetCount(__CFReadSockets);
-        for (idx = 0; idx < cnt; idx++) {
-            CFSocketRef s = (CFSocketRef)CFArrayGetValueAtIndex(__CFReadSockets, idx);
-            if (!__CFNativeSocketIsValid(s->_socket)) {
-#if defined(LOG_CFSOCKET)
-                fprintf(stdout, "socket manager found read socket %d invalid\n", s->_socket);
+    /* Bad descriptors are normally reported one by one, so this is only a last resort; note that
+     * finding none doesn't mean anything is wrong, since fd's may have been invalidated while we were waiting.
+     */
+    __CFLock(&__CFActiveSocketsLock);
+    CFDictionaryApplyFunction(__CFArmedSockets, __CFSocketCollectInvalidSocket, invalidSockets);
+    __CFUnlock(&__CFActiveSocketsLock);
+}
+
+// Called with __CFActiveSocketsLock held, for a socket the poll set reported ready
+static void __CFSocketManagerSelect(CFSocketNativeHandle sock, uint8_t ready, CFMutableArrayRef selectedReadSockets, CFMutableArrayRef selectedWriteSockets) {
+    CFSocketRef s = (CFSocketRef)CFDictionaryGetValue(__CFArmedSockets, (void *)(uintptr_t)sock);
+    if (NULL == s) return;
+    uint8_t selected = s->_armedEvents & ready;
+    uint8_t remaining = s->_armedEvents & ~selected;
+#if USE_EPOLL
+    /* the one-shot entry is disabled now, so whatever wasn't selected has to be armed again */
+    s->_armedEvents = 0;
+    if (0 == remaining) CFDictionaryRemoveValue(__CFArmedSockets, (void *)(uintptr_t)sock);
 #endif
-                CFArrayAppendValue(invalidSockets, s);
-            }
-        }
-        
-        
-        cnt = CFArrayGetCount(invalidSockets);
-        
-        /* Note that we're doing this only when we got EBADF but otherwise
-         * don't have an explicit bad descriptor.  Note that the lock is held now.
-         * Finally, note that cnt == 0 doesn't necessarily mean
-         * that this loop will do anything, since fd's may have been invalidated
-         * while we were in select.
-         */
-        if (cnt == 0) {
+    /* socket is disarmed here, armed again in read handling, in the perform function or by CFSocketReschedule */
+    __CFSocketSetArmedEvents(s, remaining);
+    if (0 != (selected & __kCFSocketManagerWrite)) {
+        CFArrayAppendValue(selectedWriteSockets, s);
+    }
+    if (0 != (selected & __kCFSocketManagerRead)) {
+        s->_hitTheTimeout = false;
+        CFArrayAppendValue(selectedReadSockets, s);
+    }
+}
+
+typedef struct {
+    CFMutableArrayRef selectedReadSockets;
+    const struct timeval *timeNow;  /* NULL when the wait timed out */
+} __CFSocketExpireContext;
+
+// Called with __CFActiveSocketsLock held, for each read socket, when buffered reads may have timed out
+static void __CFSocketManagerExpireRead(const void *value, void *context) {
+    CFSocketRef s = (CFSocketRef)value;
+    __CFSocketExpireContext *expire = (__CFSocketExpireContext *)context;
+    if (0 == (s->_armedEvents & __kCFSocketManagerRead)) return;
+    if (NULL == expire->timeNow) {
+        if (!timerisset(&s->_readBufferTimeout) && !s->_leftoverBytes) return;
 #if defined(LOG_CFSOCKET)
-            fprintf(stdout, "socket manager received EBADF(1): No sockets were marked as invalid, cleaning out fdsets\n");
+        fprintf(stdout, "Expiring socket %d (delta %ld, %d)\n", s->_socket, s->_readBufferTimeout.tv_sec, s->_readBufferTimeout.tv_usec);
 #endif
-            
-            clearInvalidFileDescriptors(__CFReadSocketsFds);
-            clearInvalidFileDescriptors(__CFWriteSocketsFds);
-        }
-        
-        __CFUnlock(&__CFActiveSocketsLock);
-        
-        for (idx = 0; idx < cnt; idx++) {
-            CFSocketInvalidate(((CFSocketRef)CFArrayGetValueAtIndex(invalidSockets, idx)));
-        }
-        CFRelease(invalidSockets);
+    } else {
+        if (!timerisset(&s->_readBufferTimeoutNotificationTime) || !timercmp(expire->timeNow, &s->_readBufferTimeoutNotificationTime, >)) return;
+        s->_hitTheTimeout = true;
+    }
+    CFArrayAppendValue(expire->selectedReadSockets, s);
+    /* socket is disarmed here, will be armed again in read handling or in perform function */
+    __CFSocketSetArmedEvents(s, s->_armedEvents & ~__kCFSocketManagerRead);
+}
+
+static void __CFSocketWakeUpRunLoops(CFMutableArrayRef runLoops) {
+    CFIndex idx, cnt = CFArrayGetCount(runLoops);
+    for (idx = 0; idx < cnt; idx++) {
+        CFRunLoopWakeUp((CFRunLoopRef)CFArrayGetValueAtIndex(runLoops, idx));
     }
+    CFArrayRemoveAllValues(runLoops);
 }
 
 static void *__CFSocketManager(void * arg)
@@ -2104,46 +2235,37 @@ static void *__CFSocketManager(void * arg)
     pthread_setname_np("com.apple.CFSocket.private");
 #endif
     if (objc_collectingEnabled()) objc_registerThreadWithCollector();
-    SInt32 nrfds, maxnrfds, fdentries = 1;
-    SInt32 rfds, wfds;
-    fd_set *exceptfds = NULL;
-    fd_set *writefds = (fd_set *)CFAllocatorAllocate(kCFAllocatorSystemDefault, fdentries * sizeof(fd_mask), 0);
-    fd_set *readfds = (fd_set *)CFAllocatorAllocate(kCFAllocatorSystemDefault, fdentries * sizeof(fd_mask), 0);
-    fd_set *tempfds;
-    SInt32 idx, cnt;
+    SInt32 nrfds;
+    CFIndex idx, cnt, handled;
     uint8_t buffer[256];
     CFMutableArrayRef selectedWriteSockets = CFArrayCreateMutable(kCFAllocatorSystemDefault, 0, &kCFTypeArrayCallBacks);
     CFMutableArrayRef selectedReadSockets = CFArrayCreateMutable(kCFAllocatorSystemDefault, 0, &kCFTypeArrayCallBacks);
-    CFIndex selectedWriteSocketsIndex = 0, selectedReadSocketsIndex = 0;
+    CFMutableArrayRef invalidSockets = CFArrayCreateMutable(kCFAllocatorSystemDefault, 0, &kCFTypeArrayCallBacks);
+    CFMutableArrayRef runLoopsToWakeUp = CFArrayCreateMutable(kCFAllocatorSystemDefault, 0, &kCFTypeArrayCallBacks);
+#if USE_EPOLL
+    struct epoll_event events[MAX_MANAGER_EVENTS];
+#else
+    CFMutableDataRef pollFds = CFDataCreateMutable(kCFAllocatorSystemDefault, 0);  /* the manager's copy of __CFSocketPollFds */
+#endif
     
     struct timeval tv;
     struct timeval* pTimeout = NULL;
     struct timeval timeBeforeSelect;
+    int timeout;
     
     for (;;) {
         __CFLock(&__CFActiveSocketsLock);
         __CFSocketManagerIteration++;
+        __CFSocketManagerWakeUpPending = false;
 #if defined(LOG_CFSOCKET)
         fprintf(stdout, "socket manager iteration %lu looking at read sockets ", (unsigned long)__CFSocketManagerIteration);
-        __CFSocketWriteSocketList(__CFReadSockets, __CFReadSocketsFds, FALSE);
-        if (0 < CFArrayGetCount(__CFWriteSockets)) {
+        __CFSocketWriteSocketList(__CFReadSockets, __kCFSocketManagerRead);
+        if (0 < CFSetGetCount(__CFWriteSockets)) {
             fprintf(stdout, " and write sockets ");
-            __CFSocketWriteSocketList(__CFWriteSockets, __CFWriteSocketsFds, FALSE);
+            __CFSocketWriteSocketList(__CFWriteSockets, __kCFSocketManagerWrite);
         }
         fprintf(stdout, "\n");
 #endif
-        rfds = __CFSocketFdGetSize(__CFReadSocketsFds);
-        wfds = __CFSocketFdGetSize(__CFWriteSocketsFds);
-        maxnrfds = __CFMax(rfds, wfds);
-        if (maxnrfds > fdentries * (int)NFDBITS) {
-            fdentries = (maxnrfds + NFDBITS - 1) / NFDBITS;
-            writefds = (fd_set *)CFAllocatorReallocate(kCFAllocatorSystemDefault, writefds, fdentries * sizeof(fd_mask), 0);
-            readfds = (fd_set *)CFAllocatorReallocate(kCFAllocatorSystemDefault, readfds, fdentries * sizeof(fd_mask), 0);
-        }
-        memset(writefds, 0, fdentries * sizeof(fd_mask));
-        memset(readfds, 0, fdentries * sizeof(fd_mask));
-        CFDataGetBytes(__CFWriteSocketsFds, CFRangeMake(0, CFDataGetLength(__CFWriteSocketsFds)), (UInt8 *)writefds);
-        CFDataGetBytes(__CFReadSocketsFds, CFRangeMake(0, CFDataGetLength(__CFReadSocketsFds)), (UInt8 *)readfds);
         
         if (__CFReadSocketsTimeoutInvalid) {
             struct timeval* minTimeout = NULL;
@@ -2151,7 +2273,7 @@ static void *__CFSocketManager(void * arg)
 #if defined(LOG_CFSOCKET)
             fprintf(stdout, "Figuring out which sockets have timeouts...\n");
 #endif
-            CFArrayApplyFunction(__CFReadSockets, CFRangeMake(0, CFArrayGetCount(__CFReadSockets)), _calcMinTimeout_locked, (void*) &minTimeout);
+            CFSetApplyFunction(__CFReadSockets, _calcMinTimeout_locked, (void*) &minTimeout);
             
             if (minTimeout == NULL) {
 #if defined(LOG_CFSOCKET)
@@ -2165,159 +2287,157 @@ static void *__CFSocketManager(void * arg)
                 tv = *minTimeout;
                 pTimeout = &tv;
             }
+            __CFReadSocketsHaveTimeout = (NULL != pTimeout);
         }
         
         if (pTimeout) {
 #if defined(LOG_CFSOCKET)
-            fprintf(stdout, "select will have a %ld, %d timeout\n", pTimeout->tv_sec, pTimeout->tv_usec);
+            fprintf(stdout, "poll will have a %ld, %d timeout\n", pTimeout->tv_sec, pTimeout->tv_usec);
 #endif
             gettimeofday(&timeBeforeSelect, NULL);
         }
         
+        CFArrayAppendArray(invalidSockets, __CFBadSockets, CFRangeMake(0, CFArrayGetCount(__CFBadSockets)));
+        CFArrayRemoveAllValues(__CFBadSockets);
+#if !USE_EPOLL
+        if (__CFSocketPollFdsChanged) {
+            __CFSocketPollFdsChanged = false;
+            CFDataReplaceBytes(pollFds, CFRangeMake(0, CFDataGetLength(pollFds)), CFDataGetBytePtr(__CFSocketPollFds), CFDataGetLength(__CFSocketPollFds));
+        }
+#endif
+        
         __CFUnlock(&__CFActiveSocketsLock);
         
-#if DEPLOYMENT_TARGET_WINDOWS
-        // On Windows, select checks connection failed sockets via the exceptfds parameter. connection succeeded is checked via writefds. We need both.
-        exceptfds = writefds;
+        cnt = CFArrayGetCount(invalidSockets);
+        if (0 < cnt) {
+            for (idx = 0; idx < cnt; idx++) {
+                CFSocketInvalidate(((CFSocketRef)CFArrayGetValueAtIndex(invalidSockets, idx)));
+            }
+            CFArrayRemoveAllValues(invalidSockets);
+            continue;
+        }
+        
+        timeout = -1;
+        if (pTimeout) {
+            timeout = (INT_MAX / 1000 <= pTimeout->tv_sec) ? INT_MAX : (int)(pTimeout->tv_sec * 1000 + (pTimeout->tv_usec + 999) / 1000);
+        }
+#if USE_EPOLL
+        nrfds = epoll_wait(__CFSocketManagerEpoll, events, MAX_MANAGER_EVENTS, timeout);
+#else
+        nrfds = __CFSocketPoll(__CFSocketGetPollFds(pollFds), __CFSocketGetPollFdCount(pollFds), timeout);
 #endif
-        nrfds = select(maxnrfds, readfds, writefds, exceptfds, pTimeout);
         
 #if defined(LOG_CFSOCKET)
-        fprintf(stdout, "socket manager woke from select, ret=%ld\n", (long)nrfds);
+        fprintf(stdout, "socket manager woke from poll, ret=%ld\n", (long)nrfds);
 #endif
         
+        if (0 > nrfds) {
+            manageSelectError(invalidSockets);
+            continue;
+        }
+        
+        __CFLock(&__CFActiveSocketsLock);
+        
         /*
-         * select returned a timeout
+         * poll returned a timeout
          */
         if (0 == nrfds) {
+#if defined(LOG_CFSOCKET)
             struct timeval timeAfterSelect;
             struct timeval deltaTime;
             gettimeofday(&timeAfterSelect, NULL);
             /* timeBeforeSelect becomes the delta */
             timersub(&timeAfterSelect, &timeBeforeSelect, &deltaTime);
-            
-#if defined(LOG_CFSOCKET)
             fprintf(stdout, "Socket manager received timeout - kicking off expired reads (expired delta %ld, %d)\n", deltaTime.tv_sec, deltaTime.tv_usec);
 #endif
-            
-            __CFLock(&__CFActiveSocketsLock);
-            
-            tempfds = NULL;
-            cnt = CFArrayGetCount(__CFReadSockets);
-            for (idx = 0; idx < cnt; idx++) {
-                CFSocketRef s = (CFSocketRef)CFArrayGetValueAtIndex(__CFReadSockets, idx);
-                if (timerisset(&s->_readBufferTimeout) || s->_leftoverBytes) {
-                    CFSocketNativeHandle sock = s->_socket;
-                    // We might have an new element in __CFReadSockets that we weren't listening to,
-                    // in which case we must be sure not to test a bit in the fdset that is
-                    // outside our mask size.
-                    Boolean sockInBounds = (0 <= sock && sock < maxnrfds);
-                    /* if this sockets timeout is less than or equal elapsed time, then signal it */
-                    if (INVALID_SOCKET != sock && sockInBounds) {
-#if defined(LOG_CFSOCKET)
-                        fprintf(stdout, "Expiring socket %d (delta %ld, %d)\n", sock, s->_readBufferTimeout.tv_sec, s->_readBufferTimeout.tv_usec);
-#endif
-                        CFArraySetValueAtIndex(selectedReadSockets, selectedReadSocketsIndex, s);
-                        selectedReadSocketsIndex++;
-                        /* socket is removed from fds here, will be restored in read handling or in perform function */
-                        if (!tempfds) tempfds = (fd_set *)CFDataGetMutableBytePtr(__CFReadSocketsFds);
-                        FD_CLR(sock, tempfds);
-                    }
-                }
-            }
-            
-            __CFUnlock(&__CFActiveSocketsLock);
+            __CFSocketExpireContext expire = { selectedReadSockets, NULL };
+            CFSetApplyFunction(__CFReadSockets, __CFSocketManagerExpireRead, &expire);
             
             /* and below, we dispatch through the normal read dispatch mechanism */
         }
         
-        if (0 > nrfds) {
-            manageSelectError();
-            continue;
-        }
-        if (FD_ISSET(__CFWakeupSocketPair[1], readfds)) {
-            recv(__CFWakeupSocketPair[1], (char *)buffer, sizeof(buffer), 0);
+#if USE_EPOLL
+        for (idx = 0; idx < nrfds; idx++) {
+            CFSocketNativeHandle sock = events[idx].data.fd;
+            uint32_t revents = events[idx].events;
+            uint8_t ready = 0;
+            if (sock == __CFSocketManagerEvent) {
+                read(__CFSocketManagerEvent, buffer, sizeof(uint64_t));
 #if defined(LOG_CFSOCKET)
-            fprintf(stdout, "socket manager received %c on wakeup socket\n", buffer[0]);
+                fprintf(stdout, "socket manager received wakeup event\n");
 #endif
+                continue;
+            }
+            if (0 != (revents & (EPOLLIN | EPOLLERR | EPOLLHUP))) ready |= __kCFSocketManagerRead;
+            if (0 != (revents & (EPOLLOUT | EPOLLERR | EPOLLHUP))) ready |= __kCFSocketManagerWrite;
+            __CFSocketManagerSelect(sock, ready, selectedReadSockets, selectedWriteSockets);
         }
-        __CFLock(&__CFActiveSocketsLock);
-        tempfds = NULL;
-        cnt = CFArrayGetCount(__CFWriteSockets);
-        for (idx = 0; idx < cnt; idx++) {
-            CFSocketRef s = (CFSocketRef)CFArrayGetValueAtIndex(__CFWriteSockets, idx);
-            CFSocketNativeHandle sock = s->_socket;
-            // We might have an new element in __CFWriteSockets that we weren't listening to,
-            // in which case we must be sure not to test a bit in the fdset that is
-            // outside our mask size.
-            Boolean sockInBounds = (0 <= sock && sock < maxnrfds);
-            if (INVALID_SOCKET != sock && sockInBounds) {
-                if (FD_ISSET(sock, writefds)) {
-                    CFArraySetValueAtIndex(selectedWriteSockets, selectedWriteSocketsIndex, s);
-                    selectedWriteSocketsIndex++;
-                    /* socket is removed from fds here, restored by CFSocketReschedule */
-                    if (!tempfds) tempfds = (fd_set *)CFDataGetMutableBytePtr(__CFWriteSocketsFds);
-                    FD_CLR(sock, tempfds);
-                    // CFLog(5, CFSTR("Manager: cleared socket %p from write fds"), s);
+#else
+        __CFSocketPollFd *fds = __CFSocketGetPollFds(pollFds);
+        cnt = __CFSocketGetPollFdCount(pollFds);
+        for (idx = 0, handled = 0; handled < nrfds && idx < cnt; idx++) {
+            CFSocketNativeHandle sock = fds[idx].fd;
+            short revents = fds[idx].revents;
+            uint8_t ready = 0;
+            if (0 == revents) continue;
+            handled++;
+            if (sock == __CFWakeupSocketPair[1]) {
+                while (0 < recv(__CFWakeupSocketPair[1], (char *)buffer, sizeof(buffer), 0));
+#if defined(LOG_CFSOCKET)
+                fprintf(stdout, "socket manager received %c on wakeup socket\n", buffer[0]);
+#endif
+                continue;
+            }
+            if (0 != (revents & POLLNVAL)) {
+                /* this is where select() would have failed with EBADF */
+                CFSocketRef s = (CFSocketRef)CFDictionaryGetValue(__CFArmedSockets, (void *)(uintptr_t)sock);
+                if (NULL != s && !__CFNativeSocketIsValid(sock)) {
+#if defined(LOG_CFSOCKET)
+                    fprintf(stdout, "socket manager found socket %d invalid\n", sock);
+#endif
+                    __CFSocketSetArmedEvents(s, 0);
+                    CFArrayAppendValue(invalidSockets, s);
                 }
+                continue;
             }
+            if (0 != (revents & (POLLIN | POLLERR | POLLHUP))) ready |= __kCFSocketManagerRead;
+            if (0 != (revents & (POLLOUT | POLLERR | POLLHUP))) ready |= __kCFSocketManagerWrite;
+            __CFSocketManagerSelect(sock, ready, selectedReadSockets, selectedWriteSockets);
         }
-        tempfds = NULL;
-        cnt = CFArrayGetCount(__CFReadSockets);
+#endif
         
-        struct timeval timeNow = { 0 };
-        if (pTimeout) {
+        // Check if we hit the timeout
+        if (pTimeout && 0 != nrfds) {
+            struct timeval timeNow = { 0 };
             gettimeofday(&timeNow, NULL);
-        }
-        
-        for (idx = 0; idx < cnt; idx++) {
-            CFSocketRef s = (CFSocketRef)CFArrayGetValueAtIndex(__CFReadSockets, idx);
-            CFSocketNativeHandle sock = s->_socket;
-            // We might have an new element in __CFReadSockets that we weren't listening to,
-            // in which case we must be sure not to test a bit in the fdset that is
-            // outside our mask size.
-            Boolean sockInBounds = (0 <= sock && sock < maxnrfds);
-            
-            // Check if we hit the timeout
-            s->_hitTheTimeout = false;
-            if (pTimeout && sockInBounds && 0 != nrfds && !FD_ISSET(sock, readfds) &&
-                timerisset(&s->_readBufferTimeoutNotificationTime) &&
-                timercmp(&timeNow, &s->_readBufferTimeoutNotificationTime, >))
-            {
-                s->_hitTheTimeout = true;
-            }
-            
-            if (INVALID_SOCKET != sock && sockInBounds && (FD_ISSET(sock, readfds) || s->_hitTheTimeout)) {
-                CFArraySetValueAtIndex(selectedReadSockets, selectedReadSocketsIndex, s);
-                selectedReadSocketsIndex++;
-                /* socket is removed from fds here, will be restored in read handling or in perform function */
-                if (!tempfds) tempfds = (fd_set *)CFDataGetMutableBytePtr(__CFReadSocketsFds);
-                FD_CLR(sock, tempfds);
-            }
+            __CFSocketExpireContext expire = { selectedReadSockets, &timeNow };
+            CFSetApplyFunction(__CFReadSockets, __CFSocketManagerExpireRead, &expire);
         }
         __CFUnlock(&__CFActiveSocketsLock);
         
-        for (idx = 0; idx < selectedWriteSocketsIndex; idx++) {
+        handled = 0;
+        cnt = CFArrayGetCount(selectedWriteSockets);
+        for (idx = 0; idx < cnt; idx++) {
             CFSocketRef s = (CFSocketRef)CFArrayGetValueAtIndex(selectedWriteSockets, idx);
-            if (kCFNull == (CFNullRef)s) continue;
 #if defined(LOG_CFSOCKET)
             fprintf(stdout, "socket manager signaling socket %d for write\n", s->_socket);
 #endif
-            __CFSocketHandleWrite(s, FALSE);
-            CFArraySetValueAtIndex(selectedWriteSockets, idx, kCFNull);
+            __CFSocketHandleWrite(s, FALSE, runLoopsToWakeUp);
+            if (0 == ++handled % MAX_MANAGER_EVENTS) __CFSocketWakeUpRunLoops(runLoopsToWakeUp);
         }
-        selectedWriteSocketsIndex = 0;
+        CFArrayRemoveAllValues(selectedWriteSockets);
         
-        for (idx = 0; idx < selectedReadSocketsIndex; idx++) {
+        cnt = CFArrayGetCount(selectedReadSockets);
+        for (idx = 0; idx < cnt; idx++) {
             CFSocketRef s = (CFSocketRef)CFArrayGetValueAtIndex(selectedReadSockets, idx);
-            if (kCFNull == (CFNullRef)s) continue;
 #if defined(LOG_CFSOCKET)
             fprintf(stdout, "socket manager signaling socket %d for read\n", s->_socket);
 #endif
-            __CFSocketHandleRead(s, nrfds == 0 || s->_hitTheTimeout);
-            CFArraySetValueAtIndex(selectedReadSockets, idx, kCFNull);
+            __CFSocketHandleRead(s, nrfds == 0 || s->_hitTheTimeout, runLoopsToWakeUp);
+            if (0 == ++handled % MAX_MANAGER_EVENTS) __CFSocketWakeUpRunLoops(runLoopsToWakeUp);
         }
-        selectedReadSocketsIndex = 0;
+        CFArrayRemoveAllValues(selectedReadSockets);
+        __CFSocketWakeUpRunLoops(runLoopsToWakeUp);
     }
     return NULL;
 }
@@ -2417,22 +2537,6 @@ CFTypeID CFSocketGetTypeID(void) {
     return __kCFSocketTypeID;
 }
 
-#if DEPLOYMENT_TARGET_WINDOWS
-struct _args {
-    void *func;
-    void *arg;
-    HANDLE handle;
-};
-static unsigned __stdcall __CFWinThreadFunc(void *arg) {
-    struct _args *args = (struct _args*)arg;
-    ((void (*)(void *))args->func)(args->arg);
-    CloseHandle(args->handle);
-    CFAllocatorDeallocate(kCFAllocatorSystemDefault, arg);
-    // _endthreadex(0); // HACKHACK: UCRT for store apps doesn't make this available.
-    return 0;
-}
-#endif
-
 static CFSocketRef _CFSocketCreateWithNative(CFAllocatorRef allocator, CFSocketNativeHandle sock, CFOptionFlags callBackTypes, CFSocketCallBack callout, const CFSocketContext *context, Boolean useExistingInstance) {
     CHECK_FOR_FORK();
     CFSocketRef memory;
@@ -2496,6 +2600,9 @@ static CFSocketRef _CFSocketCreateWithNative(CFAllocatorRef allocator, CFSocketN
     timerclear(&memory->_readBufferTimeout);
     timerclear(&memory->_readBufferTimeoutNotificationTime);
     memory->_hitTheTimeout = false;
+    memory->_armedEvents = 0;
+    memory->_registered = false;
+    memory->_pollIndex = kCFNotFound;
     memory->_readBuffer = NULL;
     memory->_bytesToBuffer = 0;
     memory->_bytesToBufferPos = 0;
@@ -2506,7 +2613,7 @@ static CFSocketRef _CFSocketCreateWithNative(CFAllocatorRef allocator, CFSocketN
     
     if (INVALID_SOCKET != sock) CFDictionaryAddValue(__CFAllSockets, (void *)(uintptr_t)sock, memory);
     if (NULL == __CFSocketManagerThread) {
-#if DEPLOYMENT_TARGET_MACOSX || DEPLOYMENT_TARGET_EMBEDDED || DEPLOYMENT_TARGET_EMBEDDED_MINI || DEPLOYMENT_TARGET_LINUX || DEPLOYMENT_TARGET_FREEBSD
+        // WINOBJC: _beginthreadex isn't available to store apps, so the manager thread is started with pthreads everywhere.
         pthread_t tid = 0;
         pthread_attr_t attr;
         pthread_attr_init(&attr);
@@ -2519,19 +2626,6 @@ static CFSocketRef _CFSocketCreateWithNative(CFAllocatorRef allocator, CFSocketN
         pthread_attr_destroy(&attr);
         //warning CF: we dont actually know that a pthread_t is the same size as void *
         __CFSocketManagerThread = (void *)tid;
-#elif DEPLOYMENT_TARGET_WINDOWS
-        unsigned tid;
-        struct _args *args = (struct _args*)CFAllocatorAllocate(kCFAllocatorSystemDefault, sizeof(struct _args), 0);
-        if (__CFOASafe) __CFSetLastAllocationEventName(args, "CFUtilities (thread-args)");
-        HANDLE handle;
-        args->func = __CFSocketManager;
-        args->arg = 0;
-        /* The thread is created suspended, because otherwise there would be a race between the assignment below of the handle field, and it's possible use in the thread func above. */
-        args->handle = NULL; // (HANDLE)_beginthreadex(NULL, 0, __CFWinThreadFunc, args, CREATE_SUSPENDED, &tid); // HACKHACK: UCRT for store apps doesn't make this available.
-        handle = args->handle;
-        ResumeThread(handle);
-        __CFSocketManagerThread = handle;
-#endif
     }
     __CFUnlock(&__CFAllSocketsLock);
     if (NULL != context) {
@@ -2573,17 +2667,17 @@ void CFSocketInvalidate(CFSocketRef s) {
         __CFSocketUnsetWriteSignalled(s);
         __CFSocketUnsetReadSignalled(s);
         __CFLock(&__CFActiveSocketsLock);
-        idx = CFArrayGetFirstIndexOfValue(__CFWriteSockets, CFRangeMake(0, CFArrayGetCount(__CFWriteSockets)), s);
-        if (0 <= idx) {
-            CFArrayRemoveValueAtIndex(__CFWriteSockets, idx);
+        if (CFSetContainsValue(__CFWriteSockets, s)) {
+            CFSetRemoveValue(__CFWriteSockets, s);
             __CFSocketClearFDForWrite(s);
         }
         // No need to clear FD's for V1 sources, since we'll just throw the whole event away
-        idx = CFArrayGetFirstIndexOfValue(__CFReadSockets, CFRangeMake(0, CFArrayGetCount(__CFReadSockets)), s);
-        if (0 <= idx) {
-            CFArrayRemoveValueAtIndex(__CFReadSockets, idx);
+        if (CFSetContainsValue(__CFReadSockets, s)) {
+            CFSetRemoveValue(__CFReadSockets, s);
             __CFSocketClearFDForRead(s);
         }
+        /* take it out of the poll set before the descriptor can be closed and reused */
+        __CFSocketSetArmedEvents(s, 0);
         previousSocketManagerIteration = __CFSocketManagerIteration;
         __CFUnlock(&__CFActiveSocketsLock);
         CFDictionaryRemoveValue(__CFAllSockets, (void *)(uintptr_t)(s->_socket));
@@ -2747,7 +2841,7 @@ void CFSocketDisableCallBacks(CFSocketRef s, CFOptionFlags callBackTypes) {
 // "force" means to clear the disabled bits set by DisableCallBacks and always reenable.
 // if (!force) we respect those bits, meaning they may stop us from enabling.
 // In addition, if !force we assume that the sockets have already been added to the
-// __CFReadSockets and __CFWriteSockets arrays.  This is true because the callbacks start
+// __CFReadSockets and __CFWriteSockets sets.  This is true because the callbacks start
 // enabled when the CFSocket is created (at which time we enable with force).
 // Called with SocketLock held, returns with it released!
 void __CFSocketEnableCallBacks(CFSocketRef s, CFOptionFlags callBackTypes, Boolean force, uint8_t wakeupChar) {
@@ -2784,16 +2878,13 @@ void __CFSocketEnableCallBacks(CFSocketRef s, CFOptionFlags callBackTypes, Boole
             __CFLock(&__CFActiveSocketsLock);
             if (turnOnWrite || turnOnConnect) {
                 if (force) {
-                    SInt32 idx = CFArrayGetFirstIndexOfValue(__CFWriteSockets, CFRangeMake(0, CFArrayGetCount(__CFWriteSockets)), s);
-                    if (kCFNotFound == idx) CFArrayAppendValue(__CFWriteSockets, s);
-                    //                     if (kCFNotFound == idx) CFLog(5, CFSTR("__CFSocketEnableCallBacks: put %p in __CFWriteSockets list due to force and non-presence"), s);
+                    CFSetAddValue(__CFWriteSockets, s);
                 }
                 if (__CFSocketSetFDForWrite(s)) wakeup = true;
             }
             if (turnOnRead) {
                 if (force) {
-                    SInt32 idx = CFArrayGetFirstIndexOfValue(__CFReadSockets, CFRangeMake(0, CFArrayGetCount(__CFReadSockets)), s);
-                    if (kCFNotFound == idx) CFArrayAppendValue(__CFReadSockets, s);
+                    CFSetAddValue(__CFReadSockets, s);
                 }
                 if (__CFSocketSetFDForRead(s)) wakeup = true;
             }
@@ -2844,15 +2935,13 @@ static void __CFSocketCancel(void *info, CFRunLoopRef rl, CFStringRef mode) {
     s->_socketSetCount--;
     if (0 == s->_socketSetCount) {
         __CFLock(&__CFActiveSocketsLock);
-        idx = CFArrayGetFirstIndexOfValue(__CFWriteSockets, CFRangeMake(0, CFArrayGetCount(__CFWriteSockets)), s);
-        if (0 <= idx) {
-            // CFLog(5, CFSTR("__CFSocketCancel: removing %p from __CFWriteSockets list"), s);
-            CFArrayRemoveValueAtIndex(__CFWriteSockets, idx);
+        if (CFSetContainsValue(__CFWriteSockets, s)) {
+            // CFLog(5, CFSTR("__CFSocketCancel: removing %p from __CFWriteSockets set"), s);
+            CFSetRemoveValue(__CFWriteSockets, s);
             __CFSocketClearFDForWrite(s);
         }
-        idx = CFArrayGetFirstIndexOfValue(__CFReadSockets, CFRangeMake(0, CFArrayGetCount(__CFReadSockets)), s);
-        if (0 <= idx) {
-            CFArrayRemoveValueAtIndex(__CFReadSockets, idx);
+        if (CFSetContainsValue(__CFReadSockets, s)) {
+            CFSetRemoveValue(__CFReadSockets, s);
             __CFSocketClearFDForRead(s);
         }
         __CFUnlock(&__CFActiveSocketsLock);
@@ -3256,15 +3345,14 @@ CFSocketError CFSocketConnectToAddress(CFSocketRef s, CFDataRef address, CFTimeI
         fprintf(stdout, "connection attempt returns %d error %d on socket %d (flags 0x%x blocking %d)\n", (int) result, (int) connect_err, sock, (int) flags, wasBlocking);
 #endif
         if (EINPROGRESS == connect_err && timeout >= 0.0) {
-            /* select on socket */
+            /* poll on socket */
             SInt32 nrfds;
             int error_size = sizeof(select_err);
-            struct timeval tv;
-            CFMutableDataRef fds = CFDataCreateMutable(kCFAllocatorSystemDefault, 0);
-            __CFSocketFdSet(sock, fds);
-            tv.tv_sec = (timeout <= 0.0 || (CFTimeInterval)INT_MAX <= timeout) ? INT_MAX : (int)floor(timeout);
-            tv.tv_usec = (int)floor(1.0e+6 * (timeout - floor(timeout)));
-            nrfds = select(__CFSocketFdGetSize(fds), NULL, (fd_set *)CFDataGetMutableBytePtr(fds), NULL, &tv);
+            __CFSocketPollFd fd;
+            memset(&fd, 0, sizeof(fd));
+            fd.fd = sock;
+            fd.events = POLLOUT;
+            nrfds = __CFSocketPoll(&fd, 1, (timeout <= 0.0 || (CFTimeInterval)(INT_MAX / 1000) <= timeout) ? -1 : (int)ceil(1.0e+3 * timeout));
             if (nrfds < 0) {
                 select_err = __CFSocketLastError();
                 result = -1;
@@ -3274,9 +3362,8 @@ CFSocketError CFSocketConnectToAddress(CFSocketRef s, CFDataRef address, CFTimeI
                 if (0 != getsockopt(sock, SOL_SOCKET, SO_ERROR, (char *)&select_err, (socklen_t *)&error_size)) select_err = 0;
                 result = (select_err == 0) ? 0 : -1;
             }
-            CFRelease(fds);
 #if defined(LOG_CFSOCKET)
-            fprintf(stdout, "timed connection attempt %s on socket %d, result %d, select returns %d error %d\n", (result == 0) ? "succeeds" : "fails", sock, (int) result, (int) nrfds, (int) select_err);
+            fprintf(stdout, "timed connection attempt %s on socket %d, result %d, poll returns %d error %d\n", (result == 0) ? "succeeds" : "fails", sock, (int) result, (int) nrfds, (int) select_err);
 #endif
         }
         if (wasBlocking && (timeout > 0.0 || timeout < 0.0)) ioctlsocket(sock, FIONBIO, (u_long *)&no);
@@ -22,10 +22,14 @@
 
 #include <Foundation/NSMutableAttributedString.h>
 
+#define __kCFAttributesInternTableSize 8
+
 struct __CFAttributedString {
     CFRuntimeBase base;
     CFStringRef string;
     CFRunArrayRef attributeArray;
+    CFMutableDictionaryRef recentAttributes[__kCFAttributesInternTableSize];   /* Recently stored run attributes, for interning */
+    CFIndex nextRecentAttributes;
 };
 
 /* Mutability is determined by a bit in the CF base. Mutable if bit 0 is 0.  So by default freshly created attributed strings are mutable.  Don't change mutability once the object has been created and initialized!
@@ -120,6 +124,10 @@ static void __CFAttributedStringDeallocate(CFTypeRef cf) {
     CFAttributedStringRef attrStr = (CFAttributedStringRef)cf;
     CFRelease(attrStr->string);
     CFRelease(attrStr->attributeArray);
+    CFIndex cnt;
+    for (cnt = 0; cnt < __kCFAttributesInternTableSize; cnt++) {
+        if (attrStr->recentAttributes[cnt]) CFRelease(attrStr->recentAttributes[cnt]);
+    }
 }
 
 static CFTypeID __kCFAttributedStringTypeID = _kCFRuntimeNotATypeID;
@@ -155,6 +163,64 @@ static CFMutableDictionaryRef __CFAttributedStringCreateAttributesDictionary(CFA
     }
 }
 
+/* Attribute dictionaries are never mutated once they are in the run array, so runs can share them. Takes over the caller's reference to attrs and returns a +1 reference to either attrs or an equal dictionary recently stored in attrStr; runs with equal attributes thus share one dictionary, and compare (and coalesce) by pointer identity.
+*/
+static CFMutableDictionaryRef __CFAttributedStringInternAttributes(struct __CFAttributedString *attrStr, CFMutableDictionaryRef attrs) {
+    CFIndex cnt, slot = attrStr->nextRecentAttributes;
+    for (cnt = 0; cnt < __kCFAttributesInternTableSize; cnt++) {
+        slot = (slot + __kCFAttributesInternTableSize - 1) % __kCFAttributesInternTableSize;   // Most recently stored first
+        CFMutableDictionaryRef recent = attrStr->recentAttributes[slot];
+        if (!recent) break;
+        if ((recent == attrs) || CFEqual(recent, attrs)) {
+            CFRetain(recent);
+            CFRelease(attrs);
+            return recent;
+        }
+    }
+    slot = attrStr->nextRecentAttributes;
+    if (attrStr->recentAttributes[slot]) CFRelease(attrStr->recentAttributes[slot]);
+    attrStr->recentAttributes[slot] = (CFMutableDictionaryRef)CFRetain(attrs);
+    attrStr->nextRecentAttributes = (slot + 1) % __kCFAttributesInternTableSize;
+    return attrs;
+}
+
+/* While an edit walks a range it records which dictionary each source dictionary turned into, so runs that shared a dictionary before the edit get the result without another copy and compare. Sources are retained so that a freed source's address can't be mistaken for a live one.
+*/
+typedef struct {
+    CFIndex count, next;
+    CFDictionaryRef sources[__kCFAttributesInternTableSize];
+    CFMutableDictionaryRef results[__kCFAttributesInternTableSize];
+} __CFAttributesInternTable;
+
+static CFMutableDictionaryRef __CFAttributesInternTableLookup(__CFAttributesInternTable *table, CFDictionaryRef source) {
+    CFIndex cnt;
+    for (cnt = 0; cnt < table->count; cnt++) if (table->sources[cnt] == source) return table->results[cnt];
+    return NULL;
+}
+
+/* Takes over the caller's reference to result. */
+static void __CFAttributesInternTableAdd(__CFAttributesInternTable *table, CFDictionaryRef source, CFMutableDictionaryRef result) {
+    CFIndex slot = table->next;
+    if (table->count < __kCFAttributesInternTableSize) {
+        table->count++;
+    } else {
+        CFRelease(table->sources[slot]);
+        CFRelease(table->results[slot]);
+    }
+    table->sources[slot] = (CFDictionaryRef)CFRetain(source);
+    table->results[slot] = result;
+    table->next = (slot + 1) % __kCFAttributesInternTableSize;
+}
+
+static void __CFAttributesInternTableDestroy(__CFAttributesInternTable *table) {
+    CFIndex cnt;
+    for (cnt = 0; cnt < table->count; cnt++) {
+        CFRelease(table->sources[cnt]);
+        CFRelease(table->results[cnt]);
+    }
+    table->count = table->next = 0;
+}
+
 /* Does no argument checking; doesn't shortcut to doing a copy if the range is the whole string. (This is used by the other functions to create copies). 
 */
 CFMutableAttributedStringRef __CFAttributedStringCreateMutableWithSubstring(CFAllocatorRef alloc, CFAttributedStringRef attrStr, CFRange range) {
@@ -167,15 +233,25 @@ CFMutableAttributedStringRef __CFAttributedStringCreateMutableWithSubstring(CFAl
     
     CFIndex curLoc = range.location;
     CFIndex endLoc = range.location + range.length;
+    // Dictionaries handed out by an ObjC subclass may be reused scratch objects, so only intern our own
+    Boolean canIntern = !CF_IS_OBJC(CFAttributedStringGetTypeID(), attrStr);
+    __CFAttributesInternTable internTable = {0};
   
     while (curLoc < endLoc) {
     CFRange effectiveRange;
     CFDictionaryRef attrs = CFAttributedStringGetAttributes(attrStr, curLoc, &effectiveRange);
     if (curLoc != effectiveRange.location) effectiveRange.length -= (curLoc - effectiveRange.location);
     if (curLoc + effectiveRange.length > endLoc) effectiveRange.length = endLoc - curLoc;
-        CFAttributedStringSetAttributes(newAttrStr, CFRangeMake(curLoc - range.location, effectiveRange.length), attrs, true);
+        CFMutableDictionaryRef newAttrs = canIntern ? __CFAttributesInternTableLookup(&internTable, attrs) : NULL;
+        if (!newAttrs) {
+            newAttrs = __CFAttributedStringInternAttributes(newAttrStr, __CFAttributedStringCreateAttributesDictionary(alloc, attrs));
+            if (canIntern) __CFAttributesInternTableAdd(&internTable, attrs, newAttrs);
+        }
+        CFRunArrayReplace(newAttrStr->attributeArray, CFRangeMake(curLoc - range.location, effectiveRange.length), newAttrs, effectiveRange.length);
+        if (!canIntern) CFRelease(newAttrs);
     curLoc += effectiveRange.length;
     }    
+    __CFAttributesInternTableDestroy(&internTable);
 
     return newAttrStr;
 }
@@ -468,7 +544,7 @@ void CFAttributedStringReplaceString(CFMutableAttributedStringRef attrStr, CFRan
             attributesToBeUsed = (CFMutableDictionaryRef)CFRunArrayGetValueAtIndex(attrStr->attributeArray, 0, NULL, NULL);
         CFRetain(attributesToBeUsed);
        } else {
-            attributesToBeUsed = __CFAttributedStringCreateAttributesDictionary(CFGetAllocator(attrStr), NULL);
+            attributesToBeUsed = __CFAttributedStringInternAttributes(attrStr, __CFAttributedStringCreateAttributesDictionary(CFGetAllocator(attrStr), NULL));
         }
     }
     if (range.length > 0) {
@@ -493,7 +569,7 @@ void CFAttributedStringSetAttributes(CFMutableAttributedStringRef attrStr, CFRan
 
     if (clearOtherAttributes) { // Just blast all attribute dictionaries in the specified range
         if (range.length) {
-            CFMutableDictionaryRef attrs = __CFAttributedStringCreateAttributesDictionary(CFGetAllocator(attrStr), replacementAttrs);
+            CFMutableDictionaryRef attrs = __CFAttributedStringInternAttributes(attrStr, __CFAttributedStringCreateAttributesDictionary(CFGetAllocator(attrStr), replacementAttrs));
             CFRunArrayReplace(attrStr->attributeArray, range, attrs, range.length);
             CFRelease(attrs);
             // !!! [self edited:NSAttributedStringEditedAttributes range:range changeInLength:0];
@@ -505,6 +581,7 @@ void CFAttributedStringSetAttributes(CFMutableAttributedStringRef attrStr, CFRan
             createLocalArray(additionalKeys, numAdditionalItems);
             createLocalArray(additionalValues, numAdditionalItems);
             CFDictionaryGetKeysAndValues(replacementAttrs, additionalKeys, additionalValues);
+            __CFAttributesInternTable internTable = {0};
             
             // CFAttributedStringBeginEditing(attrStr);
             while (range.length) {
@@ -516,15 +593,20 @@ void CFAttributedStringSetAttributes(CFMutableAttributedStringRef attrStr, CFRan
                     effectiveRange.location = range.location;
                 }
                 if (effectiveRange.length > range.length) effectiveRange.length = range.length;
-                // We need to make a new copy
-                attrs = __CFAttributedStringCreateAttributesDictionary(CFGetAllocator(attrStr), attrs);
-                __CFDictionaryAddMultiple(attrs, additionalKeys, additionalValues, numAdditionalItems);
-                CFRunArrayReplace(attrStr->attributeArray, effectiveRange, attrs, effectiveRange.length);
-                CFRelease(attrs);
+                // We need to make a new copy, unless a run sharing this dictionary already got one
+                CFMutableDictionaryRef newAttrs = __CFAttributesInternTableLookup(&internTable, attrs);
+                if (!newAttrs) {
+                    newAttrs = __CFAttributedStringCreateAttributesDictionary(CFGetAllocator(attrStr), attrs);
+                    __CFDictionaryAddMultiple(newAttrs, additionalKeys, additionalValues, numAdditionalItems);
+                    newAttrs = __CFAttributedStringInternAttributes(attrStr, newAttrs);
+                    __CFAttributesInternTableAdd(&internTable, attrs, newAttrs);
+                }
+                CFRunArrayReplace(attrStr->attributeArray, effectiveRange, newAttrs, effectiveRange.length);
                 range.length -= effectiveRange.length;
                 range.location += effectiveRange.length;
             }
             // CFAttributedStringEndEditing(attrStr);
+            __CFAttributesInternTableDestroy(&internTable);
             
             freeLocalArray(additionalKeys);
             freeLocalArray(additionalValues);
@@ -537,6 +619,7 @@ void CFAttributedStringSetAttribute(CFMutableAttributedStringRef attrStr, CFRang
     __CFAssertIsAttributedStringAndMutable(attrStr);
     __CFAssertRangeIsInBounds(attrStr, range.location, range.length);
 
+    __CFAttributesInternTable internTable = {0};
     // CFAttributedStringBeginEditing(attrStr);
     while (range.length) {
         CFRange effectiveRange;
@@ -551,16 +634,21 @@ void CFAttributedStringSetAttribute(CFMutableAttributedStringRef attrStr, CFRang
         // First check to see if the same value already exists; this will avoid a copy
         CFTypeRef existingValue = CFDictionaryGetValue(attrs, attrName);
         if (!existingValue || !CFEqual(existingValue, value)) {
-            // We need to make a new copy
-            attrs = __CFAttributedStringCreateAttributesDictionary(CFGetAllocator(attrStr), attrs);
-            CFDictionarySetValue(attrs, attrName, value);
-            CFRunArrayReplace(attrStr->attributeArray, effectiveRange, attrs, effectiveRange.length);
-            CFRelease(attrs);
+            // We need to make a new copy, unless a run sharing this dictionary already got one
+            CFMutableDictionaryRef newAttrs = __CFAttributesInternTableLookup(&internTable, attrs);
+            if (!newAttrs) {
+                newAttrs = __CFAttributedStringCreateAttributesDictionary(CFGetAllocator(attrStr), attrs);
+                CFDictionarySetValue(newAttrs, attrName, value);
+                newAttrs = __CFAttributedStringInternAttributes(attrStr, newAttrs);
+                __CFAttributesInternTableAdd(&internTable, attrs, newAttrs);
+            }
+            CFRunArrayReplace(attrStr->attributeArray, effectiveRange, newAttrs, effectiveRange.length);
         }
         range.length -= effectiveRange.length;
         range.location += effectiveRange.length;
     }
     // CFAttributedStringEndEditing(attrStr);
+    __CFAttributesInternTableDestroy(&internTable);
 }
 
 void CFAttributedStringRemoveAttribute(CFMutableAttributedStringRef attrStr, CFRange range, CFStringRef attrName) {
@@ -568,6 +656,7 @@ void CFAttributedStringRemoveAttribute(CFMutableAttributedStringRef attrStr, CFR
     __CFAssertIsAttributedStringAndMutable(attrStr);
     __CFAssertRangeIsInBounds(attrStr, range.location, range.length);
 
+    __CFAttributesInternTable internTable = {0};
     // CFAttributedStringBeginEditing(attrStr);
     while (range.length) {
         CFRange effectiveRange;
@@ -580,16 +669,21 @@ void CFAttributedStringRemoveAttribute(CFMutableAttributedStringRef attrStr, CFR
         if (effectiveRange.length > range.length) effectiveRange.length = range.length;
         // First check to see if the value is not there; this will avoid a copy
         if (CFDictionaryContainsKey(attrs, attrName)) {
-            // We need to make a new copy
-            attrs = __CFAttributedStringCreateAttributesDictionary(CFGetAllocator(attrStr), attrs);
-            CFDictionaryRemoveValue(attrs, attrName);
-            CFRunArrayReplace(attrStr->attributeArray, effectiveRange, attrs, effectiveRange.length);
-            CFRelease(attrs);
+            // We need to make a new copy, unless a run sharing this dictionary already got one
+            CFMutableDictionaryRef newAttrs = __CFAttributesInternTableLookup(&internTable, attrs);
+            if (!newAttrs) {
+                newAttrs = __CFAttributedStringCreateAttributesDictionary(CFGetAllocator(attrStr), attrs);
+                CFDictionaryRemoveValue(newAttrs, attrName);
+                newAttrs = __CFAttributedStringInternAttributes(attrStr, newAttrs);
+                __CFAttributesInternTableAdd(&internTable, attrs, newAttrs);
+            }
+            CFRunArrayReplace(attrStr->attributeArray, effectiveRange, newAttrs, effectiveRange.length);
         }
         range.length -= effectiveRange.length;
         range.location += effectiveRange.length;
     }
     // CFAttributedStringEndEditing(attrStr);
+    __CFAttributesInternTableDestroy(&internTable);
 }
 
 void CFAttributedStringReplaceAttributedString(CFMutableAttributedStringRef attrStr, CFRange range, CFAttributedStringRef replacement) {
@@ -602,14 +696,21 @@ void CFAttributedStringReplaceAttributedString(CFMutableAttributedStringRef attr
 
     if (stringLen > 0) {
     CFAllocatorRef allocator = CFGetAllocator(attrStr);
+    Boolean canIntern = !CF_IS_OBJC(CFAttributedStringGetTypeID(), replacement);
+    __CFAttributesInternTable internTable = {0};
     CFRange attrRange = {0, 0};
     while (attrRange.location < stringLen) {
         CFDictionaryRef otherAttrs = CFAttributedStringGetAttributes(replacement, attrRange.location, &attrRange);
-            CFMutableDictionaryRef attrs = __CFAttributedStringCreateAttributesDictionary(allocator, otherAttrs);
+            CFMutableDictionaryRef attrs = canIntern ? __CFAttributesInternTableLookup(&internTable, otherAttrs) : NULL;
+            if (!attrs) {
+                attrs = __CFAttributedStringInternAttributes(attrStr, __CFAttributedStringCreateAttributesDictionary(allocator, otherAttrs));
+                if (canIntern) __CFAttributesInternTableAdd(&internTable, otherAttrs, attrs);
+            }
         CFRunArrayInsert(attrStr->attributeArray, CFRangeMake(attrRange.location + range.location, attrRange.length), attrs);
-        CFRelease(attrs);
+        if (!canIntern) CFRelease(attrs);
         attrRange.location += attrRange.length;
     }
+    __CFAttributesInternTableDestroy(&internTable);
     }
     if (range.length > 0) CFRunArrayDelete(attrStr->attributeArray, CFRangeMake(range.location + stringLen, range.length));
     CFStringReplace((CFMutableStringRef)(attrStr->string), range, otherStr);
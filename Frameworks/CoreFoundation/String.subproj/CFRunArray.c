@@ -23,6 +23,7 @@
 typedef struct {
     CFIndex length;
     CFTypeRef obj;
+    CFIndex location;                       /* Start of this run; only meaningful for blocks below validBlocks */
 } CFRunArrayItem;
 
 typedef struct _CFRunArrayGuts {	/* Variable sized block. */
@@ -30,6 +31,7 @@ typedef struct _CFRunArrayGuts {	/* Variable sized block. */
     CFIndex length;                         /* Total count of values stored by the CFRunArrayItems in list */
     CFIndex numBlocks, maxBlocks;           /* These describe the number of CFRunArrayItems in list */
     CFIndex cachedBlock, cachedLocation;    /* Cache from last lookup */
+    CFIndex validBlocks;                    /* list[0..validBlocks-1].location are up to date */
     CFRunArrayItem list[0]; /* GCC */
 } CFRunArrayGuts;
 
@@ -45,7 +47,7 @@ struct __CFRunArray {
 #define FREE(obj) CFRelease(obj)
 #define COPY(obj) CFRetain(obj)
 #define EXTERNCOPY(obj) CFRetain(obj)
-#define ISSAME(obj1, obj2) (CFEqual(obj1, obj2))
+#define ISSAME(obj1, obj2) (((obj1) == (obj2)) || CFEqual(obj1, obj2))
 
 /* To protect accesses to the refcounts of shared CFRunArrayGuts
 */
@@ -58,19 +60,33 @@ static CFLock_t runArrayLock = CFLockInit;
 /*** Internal utility ***/
 
 /* Return the block number in the run array. Use cache if possible.
+   The cached block and its successor are checked first, which covers typing and sequential enumeration. Otherwise the run start offsets are brought up to date just far enough to cover location (edits only invalidate them from the edited block onwards), and the block is found by binary search.
 */
 static CFIndex blockForLocation(CFRunArrayGuts *guts, CFIndex location, CFRange *effectiveRange) {
-    CFIndex loc, block;
-    if (location > (guts->cachedLocation / 2)) {	/* Yes, we can use the cached values as our starting point */
+    CFIndex loc, block = guts->cachedBlock;
+    if ((block < guts->numBlocks) && (guts->cachedLocation <= location) && (location < guts->cachedLocation + guts->list[block].length)) {	/* Cache hit */
         loc = guts->cachedLocation;
-        block = guts->cachedBlock;
+    } else if ((block + 1 < guts->numBlocks) && (guts->cachedLocation <= location) && (location - guts->cachedLocation - guts->list[block].length < guts->list[block + 1].length)) {	/* The run right after the cached one */
+        loc = guts->cachedLocation + guts->list[block].length;
+        block++;
     } else {
-        loc = block = 0;
-    }
-    if (loc <= location) {	/* Going forwards */
-        while (loc + guts->list[block].length <= location) loc += guts->list[block++].length;
-    } else {	/* Going backwards */
-        do loc -= guts->list[--block].length; while ((block > 0) && (loc > location));
+        CFIndex valid = guts->validBlocks;
+        if (valid == 0) {
+            guts->list[0].location = 0;
+            valid = 1;
+        }
+        while ((valid < guts->numBlocks) && (guts->list[valid - 1].location + guts->list[valid - 1].length <= location)) {
+            guts->list[valid].location = guts->list[valid - 1].location + guts->list[valid - 1].length;
+            valid++;
+        }
+        guts->validBlocks = valid;
+        CFIndex lo = 0, hi = valid - 1;
+        while (lo < hi) {
+            CFIndex mid = lo + (hi - lo + 1) / 2;
+            if (guts->list[mid].location <= location) lo = mid; else hi = mid - 1;
+        }
+        block = lo;
+        loc = guts->list[block].location;
     }
     guts->cachedLocation = loc;
     guts->cachedBlock = block;
@@ -81,6 +97,12 @@ static CFIndex blockForLocation(CFRunArrayGuts *guts, CFIndex location, CFRange
     return block;
 }
 
+/* Called before the lengths of block and later blocks change, or blocks at or after it are inserted or removed.
+*/
+CF_INLINE void __CFRunArrayInvalidateLocations(CFRunArrayGuts *guts, CFIndex block) {
+    if (guts->validBlocks > block) guts->validBlocks = block;
+}
+
 /* Gives the receiver its own copy of the argument list, reduces the ref count of the original. The original list is assumed to have a ref count > 1 (it's not freed). If oldGuts is not NULL, should be called when protected by a lock. Note that this may change array->guts, so any caches of this should be refreshed!
 */
 static void __CFRunArrayMakeNewList(CFRunArrayRef array, CFRunArrayGuts *oldGuts) {
@@ -92,14 +114,16 @@ static void __CFRunArrayMakeNewList(CFRunArrayRef array, CFRunArrayGuts *oldGuts
 	for (cnt = 0; cnt < oldGuts->numBlocks; cnt++) {
 	    newGuts->list[cnt].length = oldGuts->list[cnt].length;
 	    newGuts->list[cnt].obj = COPY(oldGuts->list[cnt].obj);
+	    newGuts->list[cnt].location = oldGuts->list[cnt].location;
 	}
 	newGuts->numBlocks = oldGuts->numBlocks;
 	newGuts->cachedBlock = oldGuts->cachedBlock;
 	newGuts->cachedLocation = oldGuts->cachedLocation;
+	newGuts->validBlocks = oldGuts->validBlocks;
 	newGuts->length = oldGuts->length;
 	oldGuts->numRefs--;	// !!! We assume the caller has locked; if we have separate locks per RLEArray, need one here
     } else {
-	newGuts->length = newGuts->numBlocks = newGuts->cachedBlock = newGuts->cachedLocation = 0;
+	newGuts->length = newGuts->numBlocks = newGuts->cachedBlock = newGuts->cachedLocation = newGuts->validBlocks = 0;
     }
     newGuts->numRefs = 1;
     ((struct __CFRunArray *)array)->guts = newGuts;
@@ -259,6 +283,7 @@ void CFRunArrayInsert(CFRunArrayRef array, CFRange range, CFTypeRef obj) {
     } else {	// At this stage we are inserting, and the length of the list is > 0.
 	CFRange blockRange;
 	CFIndex cnt, block = blockForLocation(guts, range.location, &blockRange);
+	__CFRunArrayInvalidateLocations(guts, block);
 	if (ISSAME(obj, guts->list[block].obj)) {
 	    guts->list[block].length += range.length;
 	} else if ((block > 0) && (blockRange.location == range.location) && (ISSAME(obj, guts->list[block - 1].obj))) {
@@ -310,6 +335,7 @@ void CFRunArrayReplace(CFRunArrayRef array, CFRange range, CFTypeRef newObject,
     
     /* This call also sets the cache to point to this block */
     block = blockForLocation(guts, range.location, &blockRange);
+    __CFRunArrayInvalidateLocations(guts, block);
     guts->length -= range.length;
 
     /* Figure out how much to delete from this block */
@@ -21,6 +21,14 @@
 #include "CFUnicodePrecomposition.h"
 #include "CFStringEncodingConverterPriv.h"
 #include "CFInternal.h"
+#include <string.h>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#define __CF_UTF8_SSE2 1
+#include <emmintrin.h>
+#else
+#define __CF_UTF8_SSE2 0
+#endif
 
 #define ParagraphSeparator 0x2029
 #define ASCIINewLine 0x0a
@@ -932,6 +940,75 @@ CF_INLINE uint16_t __CFToUTF8Core(uint32_t ch, uint8_t *bytes, uint32_t maxByteL
     return bytesToWrite;
 }
 
+/* ASCII runs. Most text handed to the UTF-8 converters is mostly ASCII, which needs no
+ * validation, decoding or decomposition; these move whole runs of it at once and leave
+ * everything else, including all error handling, to the per-sequence code.
+ */
+
+// Widens the ASCII bytes at the start of bytes[0..length) into characters, if not NULL. Returns how many there were.
+CF_INLINE CFIndex __CFUTF8WidenASCII(const uint8_t *bytes, CFIndex length, UniChar *characters) {
+    CFIndex i = 0;
+
+    // Short runs are common in non-Latin text and are quicker done directly
+    for (; (i < length) && (i < 8); i++) {
+        if (bytes[i] >= 0x80) return i;
+        if (characters) characters[i] = bytes[i];
+    }
+
+#if __CF_UTF8_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= length; i += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i *)(bytes + i));
+        if (_mm_movemask_epi8(block)) break;
+        if (characters) {
+            _mm_storeu_si128((__m128i *)(characters + i), _mm_unpacklo_epi8(block, zero));
+            _mm_storeu_si128((__m128i *)(characters + i + 8), _mm_unpackhi_epi8(block, zero));
+        }
+    }
+#else
+    for (; i + 8 <= length; i += 8) {
+        uint64_t block;
+        memcpy(&block, bytes + i, sizeof(block));
+        if (block & 0x8080808080808080ULL) break;
+        if (characters) for (CFIndex j = i; j < i + 8; j++) characters[j] = bytes[j];
+    }
+#endif
+
+    for (; (i < length) && (bytes[i] < 0x80); i++) if (characters) characters[i] = bytes[i];
+    return i;
+}
+
+// Narrows the ASCII characters at the start of characters[0..length) into bytes, if not NULL. Returns how many there were.
+CF_INLINE CFIndex __CFUTF8NarrowASCII(const UniChar *characters, CFIndex length, uint8_t *bytes) {
+    CFIndex i = 0;
+
+    for (; (i < length) && (i < 8); i++) {
+        if (characters[i] >= 0x80) return i;
+        if (bytes) bytes[i] = (uint8_t)characters[i];
+    }
+
+#if __CF_UTF8_SSE2
+    const __m128i nonASCII = _mm_set1_epi16((short)0xFF80);
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= length; i += 16) {
+        __m128i low = _mm_loadu_si128((const __m128i *)(characters + i));
+        __m128i high = _mm_loadu_si128((const __m128i *)(characters + i + 8));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(_mm_or_si128(low, high), nonASCII), zero)) != 0xFFFF) break;
+        if (bytes) _mm_storeu_si128((__m128i *)(bytes + i), _mm_packus_epi16(low, high));
+    }
+#else
+    for (; i + 4 <= length; i += 4) {
+        uint64_t block;
+        memcpy(&block, characters + i, sizeof(block));
+        if (block & 0xFF80FF80FF80FF80ULL) break;
+        if (bytes) for (CFIndex j = i; j < i + 4; j++) bytes[j] = (uint8_t)characters[j];
+    }
+#endif
+
+    for (; (i < length) && (characters[i] < 0x80); i++) if (bytes) bytes[i] = (uint8_t)characters[i];
+    return i;
+}
+
 static CFIndex __CFToUTF8(uint32_t flags, const UniChar *characters, CFIndex numChars, uint8_t *bytes, CFIndex maxByteLen, CFIndex *usedByteLen) {
     uint16_t bytesWritten;
     uint32_t ch;
@@ -947,6 +1024,30 @@ static CFIndex __CFToUTF8(uint32_t flags, const UniChar *characters, CFIndex num
         if (ch < 0x80) { // ASCII
             if (maxByteLen) *bytes = ch;
             ++bytes;
+
+            if ((characters < endCharacter) && (*characters < 0x80)) { // Take the rest of the run in one go
+                CFIndex length = endCharacter - characters;
+                if (maxByteLen && (length > endBytes - bytes)) length = endBytes - bytes;
+                length = __CFUTF8NarrowASCII(characters, length, (maxByteLen ? bytes : NULL));
+                characters += length;
+                bytes += length;
+            }
+        } else if ((ch < kSurrogateHighStart) || (ch > kSurrogateLowEnd)) { // The rest of the BMP, written directly
+            bytesWritten = (ch < 0x800 ? 2 : 3);
+            if (maxByteLen) {
+                if (endBytes - bytes < bytesWritten) {
+                    --characters;
+                    break;
+                }
+                if (bytesWritten == 2) {
+                    bytes[0] = 0xC0 | (ch >> 6);
+                } else {
+                    bytes[0] = 0xE0 | (ch >> 12);
+                    bytes[1] = 0x80 | ((ch >> 6) & 0x3F);
+                }
+                bytes[bytesWritten - 1] = 0x80 | (ch & 0x3F);
+            }
+            bytes += bytesWritten;
         } else {
             if (ch >= kSurrogateHighStart) {
                 if (ch <= kSurrogateHighEnd) {
@@ -999,6 +1100,27 @@ CF_INLINE bool __CFIsLegalUTF8(const uint8_t *source, CFIndex length) {
     return true;
 }
 
+/* Decodes the 2 or 3 byte sequence at source, if it is well formed and for a character
+ * outside the surrogate range, and returns its length. Such a sequence is legal however
+ * strict the conversion, so anything else returns 0 and is left to the general code.
+ */
+CF_INLINE CFIndex __CFUTF8DecodeBMP(const uint8_t *source, CFIndex numBytes, UniChar *character) {
+    UniChar ch;
+
+    if ((*source >= 0xC2) && (*source <= 0xDF)) {
+        if ((numBytes < 2) || ((source[1] & 0xC0) != 0x80)) return 0;
+        *character = ((source[0] & 0x1F) << 6) | (source[1] & 0x3F);
+        return 2;
+    } else if ((*source & 0xF0) == 0xE0) {
+        if ((numBytes < 3) || ((source[1] & 0xC0) != 0x80) || ((source[2] & 0xC0) != 0x80)) return 0;
+        ch = ((source[0] & 0x0F) << 12) | ((source[1] & 0x3F) << 6) | (source[2] & 0x3F);
+        if ((ch < 0x800) || ((ch >= kSurrogateHighStart) && (ch <= kSurrogateLowEnd))) return 0; // Overlong, or a surrogate
+        *character = ch;
+        return 3;
+    }
+    return 0;
+}
+
 static CFIndex __CFFromUTF8(uint32_t flags, const uint8_t *bytes, CFIndex numBytes, UniChar *characters, CFIndex maxCharLen, CFIndex *usedCharLen) {
     const uint8_t *source = bytes;
     uint16_t extraBytesToRead;
@@ -1010,8 +1132,29 @@ static CFIndex __CFFromUTF8(uint32_t flags, const uint8_t *bytes, CFIndex numByt
     UTF32Char decomposed[MAX_DECOMPOSED_LENGTH];
     CFIndex decompLength;
     bool isStrict = !isHFSPlus;
+    CFIndex length;
+    UniChar bmpCharacter;
 
     while (numBytes && (!maxCharLen || (theUsedCharLen < maxCharLen))) {
+        if (*source < 0x80) { // ASCII is always legal and never decomposes
+            length = numBytes;
+            if (maxCharLen && (length > maxCharLen - theUsedCharLen)) length = maxCharLen - theUsedCharLen;
+            length = __CFUTF8WidenASCII(source, length, (maxCharLen ? characters : NULL));
+            if (maxCharLen) characters += length;
+            source += length;
+            numBytes -= length;
+            theUsedCharLen += length;
+            continue;
+        }
+
+        if (!needsToDecompose && (length = __CFUTF8DecodeBMP(source, numBytes, &bmpCharacter))) {
+            if (maxCharLen) *(characters++) = bmpCharacter;
+            source += length;
+            numBytes -= length;
+            ++theUsedCharLen;
+            continue;
+        }
+
         extraBytesToRead = trailingBytesForUTF8[*source];
 
         if (extraBytesToRead > --numBytes) break;
@@ -1098,6 +1241,54 @@ static CFIndex __CFToUTF8Len(uint32_t flags, const UniChar *characters, CFIndex
     uint32_t bytesToWrite = 0;
     uint32_t ch;
 
+#if __CF_UTF8_SSE2
+    /* Characters outside the surrogate range take 1, 2 or 3 bytes depending on just
+     * two comparisons, so blocks without surrogates are counted 8 at a time. The
+     * comparisons give -1 per lane; lanes are summed every so often, before they can
+     * overflow, and the rest goes through the loop below.
+     */
+    const __m128i asciiMask = _mm_set1_epi16((short)0xFF80);
+    const __m128i twoByteMask = _mm_set1_epi16((short)0xF800);
+    const __m128i surrogates = _mm_set1_epi16((short)0xD800);
+    const __m128i zero = _mm_setzero_si128();
+
+    while (numChars >= 8) {
+        __m128i counts = zero;
+        CFIndex blocks = 0;
+
+        while ((numChars >= 8) && (blocks < 8192)) {
+            __m128i block = _mm_loadu_si128((const __m128i *)characters);
+            __m128i upper = _mm_and_si128(block, twoByteMask);
+            if (_mm_movemask_epi8(_mm_cmpeq_epi16(upper, surrogates))) break;
+            counts = _mm_add_epi16(counts, _mm_cmpeq_epi16(_mm_and_si128(block, asciiMask), zero));
+            counts = _mm_add_epi16(counts, _mm_cmpeq_epi16(upper, zero));
+            characters += 8;
+            numChars -= 8;
+            ++blocks;
+        }
+
+        if (blocks) {
+            counts = _mm_madd_epi16(counts, _mm_set1_epi16(1));
+            counts = _mm_add_epi32(counts, _mm_shuffle_epi32(counts, _MM_SHUFFLE(1, 0, 3, 2)));
+            counts = _mm_add_epi32(counts, _mm_shuffle_epi32(counts, _MM_SHUFFLE(2, 3, 0, 1)));
+            bytesToWrite += (uint32_t)(blocks * 24) + (uint32_t)_mm_cvtsi128_si32(counts);
+            continue;
+        }
+
+        // This block has surrogates in it; take it one character at a time
+        const UniChar *blockEnd = characters + 8;
+        while (characters < blockEnd) {
+            ch = *characters++;
+            numChars--;
+            if ((ch >= kSurrogateHighStart && ch <= kSurrogateHighEnd) && numChars && (*characters >= kSurrogateLowStart && *characters <= kSurrogateLowEnd)) {
+                ch = ((ch - kSurrogateHighStart) << halfShift) + (*characters++ - kSurrogateLowStart) + halfBase;
+                numChars--;
+            }
+            bytesToWrite += __CFUTF8BytesToWriteForCharacter(ch);
+        }
+    }
+#endif
+
     while (numChars) {
         ch = *characters++;
         numChars--;
@@ -1121,8 +1312,25 @@ static CFIndex __CFFromUTF8Len(uint32_t flags, const uint8_t *source, CFIndex nu
     UTF32Char decomposed[MAX_DECOMPOSED_LENGTH];
     CFIndex decompLength;
     bool isStrict = !isHFSPlus;
+    CFIndex length;
+    UniChar bmpCharacter;
 
     while (numBytes) {
+        if (*source < 0x80) { // ASCII
+            length = __CFUTF8WidenASCII(source, numBytes, NULL);
+            source += length;
+            numBytes -= length;
+            theUsedCharLen += length;
+            continue;
+        }
+
+        if (!needsToDecompose && (length = __CFUTF8DecodeBMP(source, numBytes, &bmpCharacter))) {
+            source += length;
+            numBytes -= length;
+            ++theUsedCharLen;
+            continue;
+        }
+
         extraBytesToRead = trailingBytesForUTF8[*source];
 
         if (extraBytesToRead > --numBytes) break;
@@ -58,6 +58,7 @@ static char PrintNullStringC[7] = { '(', 'n', 'u', 'l', 'l', ')', 0 };
 
 #include <ctype.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdarg.h>
 #include <string.h>
 #include <math.h>
@@ -89,6 +90,30 @@ static int PrintPutC(int c, PrintOutput* input) {
     return c;
 }
 
+/* Bulk counterpart of PrintPutC: writes up to count characters and returns the
+   number accepted, which is less than count only when the output is full. */
+static int PrintPutS(const PrintType* str, int count, PrintOutput* input) {
+    if (input->s == NULL) {
+        input->pos += count;
+        return count;
+    }
+
+    int room = (input->len & 0x7FFFFFFF) - input->pos;
+    if (room <= 0) {
+        return 0;
+    }
+    int accepted = count < room ? count : room;
+
+    int clippedRoom = (input->len & 0x3FFFFFFF) - input->pos;
+    int copied = accepted < clippedRoom ? accepted : clippedRoom;
+    if (copied > 0) {
+        memcpy(input->s + input->pos, str, copied * sizeof(PrintType));
+    }
+    input->pos += accepted;
+
+    return accepted;
+}
+
 #define FL_LJUST 0x0001 /* left-justify field */
 #define FL_SIGN 0x0002 /* sign in signed conversions */
 #define FL_SPACE 0x0004 /* space in signed conversions */
@@ -657,11 +682,102 @@ static void _dbl_ext_cvt(double value, struct EXTEND* e)
     e->m2 = unsigned(value);
 }
 
+#define FAST_CVT_MAXFDIGITS 64 /* largest fcvt precision handled by _fast_str_cvt */
+#define FAST_CVT_MAXFVALUE 1e21 /* fcvt values at or above this go through the EXTEND engine */
+
+static int _fast_str_cvt(double value, int ndigit, int* decpt, int* sign, int ecvtflag, PrintType* buf)
+/* [<][>][^][v][top][bottom][index][help] */
+{
+    /*      Fast path for cvt(): let the C runtime generate correctly rounded
+            digits for a double and repackage them in the ecvt/fcvt layout the
+            callers expect (digits from the first significant one, no point,
+            decimal exponent in *decpt).  Returns 0 when the value or precision
+            falls outside what this path handles.  The decimal point snprintf
+            writes depends on the C locale and may be more than one byte, so
+            it is skipped as whatever separates the digits.
+    */
+    char tmp[NDIGITS + 32];
+    register char* c;
+    register PrintType* p = buf;
+    register PrintType* pe = &buf[NDIGITS];
+    int intdigits = 0;
+    int len;
+
+    if (!isfinite(value)) {
+        return 0;
+    }
+    if (ecvtflag) {
+        if (ndigit < 1 || ndigit > NDIGITS) {
+            return 0;
+        }
+        len = snprintf(tmp, sizeof(tmp), "%.*e", ndigit - 1, value);
+    } else {
+        if (ndigit < 0 || ndigit > FAST_CVT_MAXFDIGITS || fabs(value) >= FAST_CVT_MAXFVALUE) {
+            return 0;
+        }
+        len = snprintf(tmp, sizeof(tmp), "%.*f", ndigit, value);
+    }
+    if (len <= 0 || len >= (int)sizeof(tmp)) {
+        return 0;
+    }
+
+    c = tmp;
+    *sign = 0;
+    if (*c == '-') {
+        *sign = 1;
+        c++;
+    }
+
+    if (ecvtflag) {
+        /* d[.ddd]e[+-]xx */
+        for (; *c != 'e'; c++) {
+            if (*c >= '0' && *c <= '9') {
+                *p++ = *c;
+            }
+        }
+        *p = '\0';
+        *decpt = (buf[0] == '0') ? 0 : atoi(c + 1) + 1;
+        return 1;
+    }
+
+    /* ddd[.ddd]: drop leading zeros so the result starts at the first
+       significant digit, as _ext_str_cvt does */
+    for (; *c >= '0' && *c <= '9'; c++) {
+        if (p == buf && *c == '0') {
+            continue;
+        }
+        *p++ = *c;
+        intdigits++;
+    }
+    *decpt = intdigits;
+    while (*c && (*c < '0' || *c > '9')) {
+        c++;
+    }
+    for (; *c && p < pe; c++) {
+        if (p == buf && *c == '0') {
+            --*decpt;
+            continue;
+        }
+        *p++ = *c;
+    }
+    if (p == buf) {
+        /* rounded to zero; callers pad with zeros */
+        *decpt = 0;
+    }
+    *p = '\0';
+    return 1;
+}
+
 static PrintType* cvt(long double value, int ndigit, int* decpt, int* sign, int ecvtflag)
 /* [<][>][^][v][top][bottom][index][help] */
 {
+    static thread_local PrintType buf[NDIGITS + 1];
     struct EXTEND e;
 
+    if ((long double)(double)value == value && _fast_str_cvt((double)value, ndigit, decpt, sign, ecvtflag, buf)) {
+        return buf;
+    }
+
     _dbl_ext_cvt(value, &e);
     return _ext_str_cvt(&e, ndigit, decpt, sign, ecvtflag);
 }
@@ -1058,20 +1174,35 @@ int _doprnt(register const PrintType* fmt, va_list ap, PrintOutput* stream)
     char *cs = NULL, *cs1 = NULL;
 
     while ((c = *fmt++)) {
+#ifndef CPM
+        if (c != '%') {
+            /* copy the whole run of literal characters up to the next conversion */
+            const PrintType* run = fmt - 1;
+            while (*fmt && *fmt != '%') {
+                fmt++;
+            }
+            int runLen = fmt - run;
+            int written = PrintPutS(run, runLen, stream);
+            nrchars += written;
+            if (written < runLen) {
+                return nrchars ? -nrchars : -1;
+            }
+            continue;
+        }
+#else
         if (c != '%') {
-#ifdef CPM
             if (c == '\n') {
                 if (PrintPutC('\r', stream) == EOF)
                     return nrchars ? -nrchars : -1;
                 nrchars++;
             }
-#endif
             if (PrintPutC(c, stream) == EOF) {
                 return nrchars ? -nrchars : -1;
             }
             nrchars++;
             continue;
         }
+#endif
         flags = 0;
         do {
             switch (*fmt) {
@@ -1352,10 +1483,16 @@ int _doprnt(register const PrintType* fmt, va_list ap, PrintOutput* stream)
         }
 
         nrchars += j;
-        while (--j >= 0) {
-            if (PrintPutC(cs1 ? *cs1++ : *s1++, stream) == EOF) {
+        if (cs1 == NULL) {
+            if (j > 0 && PrintPutS(s1, j, stream) < j) {
                 return nrchars ? -nrchars : -1;
             }
+        } else {
+            while (--j >= 0) {
+                if (PrintPutC(*cs1++, stream) == EOF) {
+                    return nrchars ? -nrchars : -1;
+                }
+            }
         }
 
         cs = cs1 = NULL;
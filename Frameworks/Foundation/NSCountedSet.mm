@@ -15,13 +15,22 @@
 //******************************************************************************
 
 #include "Starboard.h"
+#include "NSCFCollectionSupport.h"
+#include "CFFoundationInternal.h"
+#include <CoreFoundation/CFDictionary.h>
 #include <Foundation/NSCountedSet.h>
-#include <Foundation/NSMutableDictionary.h>
+#include <Foundation/NSArray.h>
+#include <vector>
+
+// Objects are retained (not copied, unlike NSMutableDictionary keys); counts are stored inline as the raw dictionary value.
+static const CFDictionaryKeyCallBacks _NSCountedSetKeyCallBacks = {
+    0, _NSCFCallbackRetain, _NSCFCallbackRelease, _NSCFCallbackCopyDescription, _NSCFCallbackEquals, _NSCFCallbackHash,
+};
 
 @implementation NSCountedSet {
 @private
-    StrongId<NSMutableSet> _internalSet;
-    StrongId<NSMutableDictionary> _counts; // id -> nsnumber
+    // Each distinct object is stored once and maps to its count, so incrementing a count never allocates.
+    woc::unique_cf<CFMutableDictionaryRef> _counts;
 }
 
 /**
@@ -36,13 +45,19 @@
     return self;
 }
 
+/**
+ @Status Interoperable
+*/
+- (instancetype)init {
+    return [self initWithCapacity:0];
+}
+
 /**
  @Status Interoperable
 */
 - (instancetype)initWithCapacity:(unsigned)capacity {
-    if (self = [self init]) {
-        _internalSet = [NSMutableSet setWithCapacity:capacity];
-        _counts = [NSMutableDictionary dictionary];
+    if (self = [super init]) {
+        _counts.reset(CFDictionaryCreateMutable(kCFAllocatorDefault, 0, &_NSCountedSetKeyCallBacks, nullptr));
     }
     return self;
 }
@@ -51,56 +66,67 @@
  @Status Interoperable
 */
 - (NSUInteger)countForObject:(id)object {
-    NSNumber* count = [_counts objectForKey:object];
-    return count ? [count unsignedIntegerValue] : 0;
+    if (object == nil) {
+        return 0;
+    }
+
+    return reinterpret_cast<NSUInteger>(CFDictionaryGetValue(_counts.get(), object));
 }
 
 /**
  @Status Interoperable
 */
 - (unsigned)count {
-    return [_internalSet count];
+    return CFDictionaryGetCount(_counts.get());
 }
 
 /**
  @Status Interoperable
 */
 - (NSEnumerator*)objectEnumerator {
-    return [_internalSet objectEnumerator];
+    CFIndex count = CFDictionaryGetCount(_counts.get());
+    std::vector<const void*> objects(count);
+    CFDictionaryGetKeysAndValues(_counts.get(), objects.data(), nullptr);
+    return [[NSArray arrayWithObjects:reinterpret_cast<id*>(objects.data()) count:count] objectEnumerator];
 }
 
 /**
  @Status Interoperable
 */
 - (id)member:(id)object {
-    return [_internalSet member:object];
+    const void* member;
+    if (object == nil || !CFDictionaryGetKeyIfPresent(_counts.get(), object, &member)) {
+        return nil;
+    }
+
+    return static_cast<id>(member);
 }
 
 /**
  @Status Interoperable
 */
 - (void)addObject:(id)object {
-    NSNumber* count = [_counts objectForKey:object];
-    if (count) {
-        [_counts setObject:[NSNumber numberWithInt:[count intValue] + 1] forKey:object];
-    } else {
-        [_internalSet addObject:object];
-        [_counts setObject:@1 forKey:object];
+    if (object == nil) {
+        return;
     }
+
+    NSUInteger count = reinterpret_cast<NSUInteger>(CFDictionaryGetValue(_counts.get(), object));
+    CFDictionarySetValue(_counts.get(), object, reinterpret_cast<const void*>(count + 1));
 }
 
 /**
  @Status Interoperable
 */
 - (void)removeObject:(id)object {
-    NSNumber* count = [_counts objectForKey:object];
-    if (count) {
-        if ([count isEqual:@1]) {
-            [_internalSet removeObject:object];
-            [_counts removeObjectForKey:object];
-        } else {
-            [_counts setObject:[NSNumber numberWithInt:[count intValue] - 1] forKey:object];
-        }
+    if (object == nil) {
+        return;
+    }
+
+    NSUInteger count = reinterpret_cast<NSUInteger>(CFDictionaryGetValue(_counts.get(), object));
+    if (count == 1) {
+        CFDictionaryRemoveValue(_counts.get(), object);
+    } else if (count > 1) {
+        CFDictionarySetValue(_counts.get(), object, reinterpret_cast<const void*>(count - 1));
     }
 }
 
@@ -108,8 +134,7 @@
  @Status Interoperable
 */
 - (void)removeAllObjects {
-    [_counts removeAllObjects];
-    [_internalSet removeAllObjects];
+    CFDictionaryRemoveAllValues(_counts.get());
 }
 
 /**
@@ -19,161 +19,283 @@
 #import <algorithm>
 #import <memory>
 #import <string>
+#import <vector>
 #import "Foundation/NSMutableData.h"
 #import "Foundation/NSError.h"
-#import "Foundation/NSScanner.h"
 #import "Foundation/NSString.h"
 #import "Foundation/NSMutableArray.h"
 #import "Foundation/NSValue.h"
 #import "Foundation/NSInputStream.h"
 #import "Foundation/NSOutputStream.h"
 #import <CoreFoundation/CFData.h>
-#include <COMIncludes.h>
-#import "ErrorHandling.h"
-#import "RawBuffer.h"
-#import <wrl\wrappers\corewrappers.h>
-#import <windows.security.cryptography.h>
-#import <windows.storage.streams.h>
-#include <COMIncludes_End.h>
+#import <CoreFoundation/CFString.h>
 #import <string>
 #import <sstream>
 #import <iomanip>
 #import "NSCFData.h"
 #import "NSRaise.h"
-#import "StringHelpers.h"
 #import "LoggingNative.h"
 
 static const wchar_t* TAG = L"NSData";
 
-using namespace Microsoft::WRL;
-using namespace ABI::Windows::Security::Cryptography;
-using namespace ABI::Windows::Storage::Streams;
-using namespace Windows::Foundation;
-
-// TODO: BUG 192601: Enable ARC on this file once the code gen error is fixed
+static const char c_base64EncodeTable[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// Values 0-63 are sextets, c_base64Pad marks '=' and c_base64Invalid marks everything else.
+// Both markers live above the sextet bits so that four lookups can be validated with a single mask.
+static const uint8_t c_base64Pad = 0x40;
+static const uint8_t c_base64Invalid = 0x80;
+static const uint8_t c_base64NonSextetMask = c_base64Pad | c_base64Invalid;
+
+static const uint8_t* _base64DecodeTable() {
+    static uint8_t s_table[256];
+    static dispatch_once_t s_once;
+    dispatch_once(&s_once,
+                  ^{
+                      memset(s_table, c_base64Invalid, sizeof(s_table));
+                      for (uint8_t i = 0; i < 64; ++i) {
+                          s_table[static_cast<uint8_t>(c_base64EncodeTable[i])] = i;
+                      }
+                      s_table['='] = c_base64Pad;
+                  });
+    return s_table;
+}
+
+// Encodes length bytes of input into output, which must hold _base64EncodedLength() characters.
+static void _base64Encode(const uint8_t* input, size_t length, char* output, size_t lineLength, const char* lineEnd, size_t lineEndLength) {
+    size_t quantaPerLine = (lineLength != 0) ? lineLength / 4 : SIZE_MAX;
+    size_t quantaInLine = 0;
+
+    for (; length >= 3; length -= 3, input += 3) {
+        if (quantaInLine == quantaPerLine) {
+            memcpy(output, lineEnd, lineEndLength);
+            output += lineEndLength;
+            quantaInLine = 0;
+        }
 
-@implementation NSData
+        uint32_t triple = (input[0] << 16) | (input[1] << 8) | input[2];
+        output[0] = c_base64EncodeTable[(triple >> 18) & 0x3F];
+        output[1] = c_base64EncodeTable[(triple >> 12) & 0x3F];
+        output[2] = c_base64EncodeTable[(triple >> 6) & 0x3F];
+        output[3] = c_base64EncodeTable[triple & 0x3F];
+        output += 4;
+        ++quantaInLine;
+    }
 
-BASE_CLASS_REQUIRED_IMPLS(NSData, NSDataPrototype, CFDataGetTypeID);
+    if (length > 0) {
+        if (quantaInLine == quantaPerLine) {
+            memcpy(output, lineEnd, lineEndLength);
+            output += lineEndLength;
+        }
 
-/**
- @Status Interoperable
-*/
-- (NSString*)base64EncodedStringWithOptions:(NSDataBase64EncodingOptions)options {
-    ComPtr<IBuffer> wrlBuffer;
-    IBuffer* rawBuffer = nullptr;
-    HRESULT result;
+        uint32_t triple = (input[0] << 16) | ((length > 1) ? (input[1] << 8) : 0);
+        output[0] = c_base64EncodeTable[(triple >> 18) & 0x3F];
+        output[1] = c_base64EncodeTable[(triple >> 12) & 0x3F];
+        output[2] = (length > 1) ? c_base64EncodeTable[(triple >> 6) & 0x3F] : '=';
+        output[3] = '=';
+    }
+}
 
-    result = BufferFromRawData(&rawBuffer, const_cast<byte*>(reinterpret_cast<const byte*>([self bytes])), [self length]);
+static size_t _base64EncodedLength(size_t length, size_t lineLength, size_t lineEndLength) {
+    size_t encodedLength = ((length + 2) / 3) * 4;
 
-    if (FAILED(result)) {
-        return nil;
+    // No line ending is needed after the final line, so subtract 1 from encodedLength when dividing
+    if (lineLength != 0 && encodedLength != 0) {
+        encodedLength += ((encodedLength - 1) / lineLength) * lineEndLength;
     }
 
-    wrlBuffer.Attach(rawBuffer);
-
-    ComPtr<ICryptographicBufferStatics> cryptographicBufferStatics;
-    RETURN_NULL_IF_FAILED(
-        GetActivationFactory(Wrappers::HStringReference(RuntimeClass_Windows_Security_Cryptography_CryptographicBuffer).Get(),
-                             &cryptographicBufferStatics));
+    return encodedLength;
+}
+
+// Decodes base64 characters directly into output, which must hold at least (length / 4 + 1) * 3 bytes.
+// Unknown characters (including whitespace) are skipped when ignoreUnknown is set, otherwise they fail the decode.
+// Padding must complete the final quantum and may only be followed by further padding or ignored characters.
+template <typename TChar>
+static bool _base64Decode(const TChar* input, size_t length, bool ignoreUnknown, uint8_t* output, size_t* outLength) {
+    const uint8_t* table = _base64DecodeTable();
+    auto lookup = [table](TChar c) -> uint32_t { return (c < 256) ? table[static_cast<uint8_t>(c)] : c_base64Invalid; };
+
+    uint8_t* start = output;
+    uint32_t accumulator = 0;
+    size_t sextets = 0;
+    size_t padding = 0;
+    size_t i = 0;
+
+    while (i < length) {
+        if (sextets == 0 && padding == 0) {
+            // Fast path: decode whole quanta for as long as the input is clean.
+            for (; i + 4 <= length; i += 4) {
+                uint32_t a = lookup(input[i]);
+                uint32_t b = lookup(input[i + 1]);
+                uint32_t c = lookup(input[i + 2]);
+                uint32_t d = lookup(input[i + 3]);
+                if ((a | b | c | d) & c_base64NonSextetMask) {
+                    break;
+                }
+
+                uint32_t triple = (a << 18) | (b << 12) | (c << 6) | d;
+                output[0] = static_cast<uint8_t>(triple >> 16);
+                output[1] = static_cast<uint8_t>(triple >> 8);
+                output[2] = static_cast<uint8_t>(triple);
+                output += 3;
+            }
 
-    Wrappers::HString encodedString;
-    RETURN_NULL_IF_FAILED(cryptographicBufferStatics->EncodeToBase64String(wrlBuffer.Get(), encodedString.GetAddressOf()));
+            if (i == length) {
+                break;
+            }
+        }
 
-    unsigned int rawLength;
-    const wchar_t* rawEncodedString = WindowsGetStringRawBuffer(encodedString.Get(), &rawLength);
+        uint32_t value = lookup(input[i++]);
+        if (value == c_base64Invalid) {
+            if (!ignoreUnknown) {
+                return false;
+            }
+            continue;
+        }
 
-    NSString* nsEncodedString = [NSString _stringWithHSTRING:encodedString.Get()];
+        if (value == c_base64Pad) {
+            ++padding;
+            continue;
+        }
 
-    // Do any necessary post-processing for options
-    // If line length specified, place a newline character (/r, /n, or /r/n every (specified number) characters)
-    if ((options & NSDataBase64Encoding64CharacterLineLength) || (options & NSDataBase64Encoding76CharacterLineLength)) {
-        size_t lineLength = (options & NSDataBase64Encoding64CharacterLineLength) ? 64 : 76;
-        // Calculate number of times to insert newlines
-        // Since no newline is needed at the end if stringLength is evenly divisible by lineLength,
-        // subtract 1 from stringLength when dividing
-        size_t stringLength = [nsEncodedString length];
-        size_t newLineCount = (stringLength != 0) ? ((stringLength - 1) / lineLength) : 0;
+        if (padding != 0) {
+            // Data after padding
+            return false;
+        }
 
-        if (newLineCount > 0) {
-            NSDataBase64EncodingOptions useCR = options & NSDataBase64EncodingEndLineWithCarriageReturn;
-            NSDataBase64EncodingOptions useLF = options & NSDataBase64EncodingEndLineWithLineFeed;
+        accumulator = (accumulator << 6) | value;
+        if (++sextets == 4) {
+            output[0] = static_cast<uint8_t>(accumulator >> 16);
+            output[1] = static_cast<uint8_t>(accumulator >> 8);
+            output[2] = static_cast<uint8_t>(accumulator);
+            output += 3;
+            accumulator = 0;
+            sextets = 0;
+        }
+    }
 
-            StrongId<NSString> newLineChar;
-            if (useCR && !useLF) {
-                newLineChar = @"\r";
-            } else if (!useCR && useLF) {
-                newLineChar = @"\n";
-            } else {
-                // Use CRLF by default, but can also be manually specified
-                newLineChar = @"\r\n";
+    switch (sextets) {
+        case 0:
+            if (padding != 0) {
+                return false;
             }
+            break;
+        case 2:
+            if (padding != 2) {
+                return false;
+            }
+            *output++ = static_cast<uint8_t>(accumulator >> 4);
+            break;
+        case 3:
+            if (padding != 1) {
+                return false;
+            }
+            *output++ = static_cast<uint8_t>(accumulator >> 10);
+            *output++ = static_cast<uint8_t>(accumulator >> 2);
+            break;
+        default:
+            return false;
+    }
 
-            NSMutableString* mutableEncodedString = [NSMutableString stringWithString:nsEncodedString];
+    *outLength = output - start;
+    return true;
+}
 
-            // Add new line every (lineLength) chars
-            // Iterate backwards to avoid compensating for changes in length
-            for (size_t i = newLineCount; i > 0; i--) {
-                [mutableEncodedString insertString:newLineChar atIndex:(i * lineLength)];
-            }
+// Decodes base64 characters into a newly allocated buffer, which is left empty for empty input.
+static bool _base64DecodeCharacters(
+    const void* characters, size_t length, bool wide, NSDataBase64DecodingOptions options, woc::unique_iw<uint8_t>& decoded, size_t* decodedLength) {
+    *decodedLength = 0;
+    if (length == 0) {
+        return true;
+    }
 
-            return [NSString stringWithString:mutableEncodedString];
-        }
+    decoded.reset(static_cast<uint8_t*>(IwMalloc((length / 4 + 1) * 3)));
+    if (!decoded) {
+        return false;
     }
 
-    // If line length not specified, or newLineCount <= 0, none of the other options matter, just return nsEncodedString
-    return nsEncodedString;
+    bool ignoreUnknown = (options & NSDataBase64DecodingIgnoreUnknownCharacters) != 0;
+    return wide ? _base64Decode(static_cast<const UniChar*>(characters), length, ignoreUnknown, decoded.get(), decodedLength) :
+                  _base64Decode(static_cast<const uint8_t*>(characters), length, ignoreUnknown, decoded.get(), decodedLength);
 }
 
-/**
- @Status Interoperable
-*/
-- (instancetype)initWithBase64EncodedString:(NSString*)base64String options:(NSDataBase64DecodingOptions)options {
-    StrongId<NSString> stringToUse = base64String;
-
-    // Create a clean version of the string if IgnoreUnknownCharacters is specified
-    if (options & NSDataBase64DecodingIgnoreUnknownCharacters) {
-        NSMutableString* cleanedString = [NSMutableString stringWithCapacity:[base64String length]];
-        StrongId<NSScanner> scanner = [NSScanner scannerWithString:base64String];
-        StrongId<NSCharacterSet> base64AllowedCharacters =
-            [NSCharacterSet characterSetWithCharactersInString:@"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/="];
-
-        while (![scanner isAtEnd]) {
-            NSString* buf;
-            if ([scanner scanCharactersFromSet:base64AllowedCharacters intoString:&buf]) {
-                [cleanedString appendString:buf];
-            } else {
-                [scanner setScanLocation:[scanner scanLocation] + 1];
-            }
-        }
+static bool _base64DecodeString(NSString* base64String,
+                                NSDataBase64DecodingOptions options,
+                                woc::unique_iw<uint8_t>& decoded,
+                                size_t* decodedLength) {
+    NSUInteger length = [base64String length];
+    if (length == 0) {
+        *decodedLength = 0;
+        return true;
+    }
 
-        stringToUse = cleanedString;
+    // Decode straight out of the string's backing store where possible, copying the characters out only as a last resort.
+    CFStringRef cfString = static_cast<CFStringRef>(base64String);
+    const char* asciiCharacters = CFStringGetCStringPtr(cfString, kCFStringEncodingASCII);
+    if (asciiCharacters) {
+        return _base64DecodeCharacters(asciiCharacters, length, false, options, decoded, decodedLength);
     }
 
-    if ([stringToUse length] == 0) {
-        return [self initWithBytes:"" length:0];
+    const UniChar* characters = CFStringGetCharactersPtr(cfString);
+    if (characters) {
+        return _base64DecodeCharacters(characters, length, true, options, decoded, decodedLength);
     }
 
-    ComPtr<ICryptographicBufferStatics> cryptographicBufferStatics;
-    RETURN_NULL_IF_FAILED(
-        GetActivationFactory(Wrappers::HStringReference(RuntimeClass_Windows_Security_Cryptography_CryptographicBuffer).Get(),
-                             &cryptographicBufferStatics));
+    std::vector<UniChar> copiedCharacters(length);
+    [base64String getCharacters:copiedCharacters.data() range:NSMakeRange(0, length)];
+    return _base64DecodeCharacters(copiedCharacters.data(), length, true, options, decoded, decodedLength);
+}
 
-    Wrappers::HString wrlBase64String = Strings::NarrowToWide<HSTRING>(stringToUse);
+// TODO: BUG 192601: Enable ARC on this file once the code gen error is fixed
 
-    ComPtr<IBuffer> wrlBuffer;
-    RETURN_NULL_IF_FAILED(cryptographicBufferStatics->DecodeFromBase64String(wrlBase64String.Get(), wrlBuffer.GetAddressOf()));
+@implementation NSData
 
-    ComPtr<IBufferByteAccess> bufferAccess;
-    RETURN_NULL_IF_FAILED(wrlBuffer.As(&bufferAccess));
+BASE_CLASS_REQUIRED_IMPLS(NSData, NSDataPrototype, CFDataGetTypeID);
 
-    uint8_t* rawBuffer;
-    RETURN_NULL_IF_FAILED(bufferAccess->Buffer(&rawBuffer));
+/**
+ @Status Interoperable
+*/
+- (NSString*)base64EncodedStringWithOptions:(NSDataBase64EncodingOptions)options {
+    // If line length specified, place a newline character (\r, \n, or \r\n) every (specified number) characters
+    size_t lineLength = 0;
+    if (options & NSDataBase64Encoding64CharacterLineLength) {
+        lineLength = 64;
+    } else if (options & NSDataBase64Encoding76CharacterLineLength) {
+        lineLength = 76;
+    }
 
-    unsigned int bufferLength;
-    RETURN_NULL_IF_FAILED(wrlBuffer->get_Length(&bufferLength));
+    NSDataBase64EncodingOptions useCR = options & NSDataBase64EncodingEndLineWithCarriageReturn;
+    NSDataBase64EncodingOptions useLF = options & NSDataBase64EncodingEndLineWithLineFeed;
 
-    return [self initWithBytes:rawBuffer length:bufferLength];
+    const char* lineEnd;
+    if (useCR && !useLF) {
+        lineEnd = "\r";
+    } else if (!useCR && useLF) {
+        lineEnd = "\n";
+    } else {
+        // Use CRLF by default, but can also be manually specified
+        lineEnd = "\r\n";
+    }
+
+    size_t lineEndLength = strlen(lineEnd);
+    size_t length = [self length];
+    size_t encodedLength = _base64EncodedLength(length, lineLength, lineEndLength);
+
+    if (encodedLength == 0) {
+        return @"";
+    }
+
+    // The created NSString takes ownership of freeing this
+    woc::unique_iw<char> encoded(static_cast<char*>(IwMalloc(encodedLength)));
+    if (!encoded) {
+        return nil;
+    }
+
+    _base64Encode(static_cast<const uint8_t*>([self bytes]), length, encoded.get(), lineLength, lineEnd, lineEndLength);
+
+    return [[[NSString alloc] initWithBytesNoCopy:encoded.release()
+                                           length:encodedLength
+                                         encoding:NSASCIIStringEncoding
+                                     freeWhenDone:YES] autorelease];
 }
 
 /**
@@ -415,9 +537,37 @@ BASE_CLASS_REQUIRED_IMPLS(NSData, NSDataPrototype, CFDataGetTypeID);
  @Status Interoperable
 */
 - (instancetype)initWithBase64EncodedData:(NSData*)base64Data options:(NSDataBase64DecodingOptions)options {
-    StrongId<NSString> base64String = [[[NSString alloc] initWithData:base64Data encoding:NSUTF8StringEncoding] autorelease];
-    auto ret = [self initWithBase64EncodedString:base64String options:options];
-    return ret;
+    // Base64 is pure ASCII, so the encoded bytes can be decoded directly without building an intermediate NSString
+    woc::unique_iw<uint8_t> decoded;
+    size_t decodedLength;
+    if (!_base64DecodeCharacters([base64Data bytes], [base64Data length], false, options, decoded, &decodedLength)) {
+        [self release];
+        return nil;
+    }
+
+    if (decodedLength == 0) {
+        return [self initWithBytes:"" length:0];
+    }
+
+    return [self initWithBytesNoCopy:decoded.release() length:decodedLength freeWhenDone:YES];
+}
+
+/**
+ @Status Interoperable
+*/
+- (instancetype)initWithBase64EncodedString:(NSString*)base64String options:(NSDataBase64DecodingOptions)options {
+    woc::unique_iw<uint8_t> decoded;
+    size_t decodedLength;
+    if (!_base64DecodeString(base64String, options, decoded, &decodedLength)) {
+        [self release];
+        return nil;
+    }
+
+    if (decodedLength == 0) {
+        return [self initWithBytes:"" length:0];
+    }
+
+    return [self initWithBytesNoCopy:decoded.release() length:decodedLength freeWhenDone:YES];
 }
 
 /**
@@ -425,11 +575,13 @@ BASE_CLASS_REQUIRED_IMPLS(NSData, NSDataPrototype, CFDataGetTypeID);
 */
 - (instancetype)initWithBase64Encoding:(NSString*)base64String {
     // Documentation states that invalid input should return nil, but reference platform tests show it returns an empty NSData object
-    auto ret = [self initWithBase64EncodedString:base64String options:0];
-    if (!ret) {
-        ret = [self init];
+    woc::unique_iw<uint8_t> decoded;
+    size_t decodedLength;
+    if (!_base64DecodeString(base64String, 0, decoded, &decodedLength) || decodedLength == 0) {
+        return [self initWithBytes:"" length:0];
     }
-    return ret;
+
+    return [self initWithBytesNoCopy:decoded.release() length:decodedLength freeWhenDone:YES];
 }
 
 /**
@@ -29,9 +29,11 @@
 #import <Foundation/Foundation.h>
 #import <NSLocaleInternal.h>
 
+#include <algorithm>
 #include <functional>
 #include <string>
 #include <array>
+#include <vector>
 #include "LoggingNative.h"
 #include "StringHelpers.h"
 
@@ -75,8 +77,81 @@ void _copyPropertiesToFormatter(CFDateFormatterRef source, CFDateFormatterRef de
     }
 }
 
+// Formatters used by +localizedStringFromDate:dateStyle:timeStyle:, kept per thread since ICU formatters
+// are not safe to use concurrently.
+struct _NSDateFormatterCacheEntry {
+    woc::unique_cf<CFStringRef> localeIdentifier;
+    woc::unique_cf<CFStringRef> timeZoneName;
+    CFDateFormatterStyle dateStyle;
+    CFDateFormatterStyle timeStyle;
+    woc::unique_cf<CFDateFormatterRef> formatter;
+};
+
+static const size_t c_dateFormatterCacheSize = 8;
+
+static CFDateFormatterRef _cachedDateFormatter(CFDateFormatterStyle dateStyle, CFDateFormatterStyle timeStyle) {
+    thread_local std::vector<_NSDateFormatterCacheEntry> cache;
+
+    woc::unique_cf<CFLocaleRef> locale(CFLocaleCopyCurrent());
+    woc::unique_cf<CFTimeZoneRef> timeZone(CFTimeZoneCopyDefault());
+    CFStringRef localeIdentifier = CFLocaleGetIdentifier(locale.get());
+    CFStringRef timeZoneName = CFTimeZoneGetName(timeZone.get());
+
+    for (auto it = cache.begin(); it != cache.end(); ++it) {
+        if (it->dateStyle == dateStyle && it->timeStyle == timeStyle && CFEqual(it->localeIdentifier.get(), localeIdentifier) &&
+            CFEqual(it->timeZoneName.get(), timeZoneName)) {
+            // Keep the most recently used formatter at the front.
+            std::rotate(cache.begin(), it, it + 1);
+            return cache.front().formatter.get();
+        }
+    }
+
+    if (cache.size() >= c_dateFormatterCacheSize) {
+        cache.pop_back();
+    }
+
+    _NSDateFormatterCacheEntry entry;
+    entry.localeIdentifier.reset(static_cast<CFStringRef>(CFRetain(localeIdentifier)));
+    entry.timeZoneName.reset(static_cast<CFStringRef>(CFRetain(timeZoneName)));
+    entry.dateStyle = dateStyle;
+    entry.timeStyle = timeStyle;
+    entry.formatter.reset(CFDateFormatterCreate(nullptr, locale.get(), dateStyle, timeStyle));
+    cache.emplace(cache.begin(), std::move(entry));
+    return cache.front().formatter.get();
+}
+
 @implementation NSDateFormatter {
     woc::unique_cf<CFDateFormatterRef> _cfDateFormatter;
+
+    // Locale and style changes only take effect when the formatter is next used, so that configuring several of
+    // them compiles a single ICU formatter instead of one per setter.
+    StrongId<NSLocale> _locale;
+    NSDateFormatterStyle _dateStyle;
+    NSDateFormatterStyle _timeStyle;
+    StrongId<NSString> _pendingDateFormat;
+    BOOL _needsNewFormatter;
+}
+
+- (CFDateFormatterRef)_formatter {
+    if (_needsNewFormatter) {
+        woc::unique_cf<CFDateFormatterRef> formatter(CFDateFormatterCreate(nullptr,
+                                                                           static_cast<CFLocaleRef>(_locale.get()),
+                                                                           static_cast<CFDateFormatterStyle>(_dateStyle),
+                                                                           static_cast<CFDateFormatterStyle>(_timeStyle)));
+        if (_cfDateFormatter) {
+            _copyPropertiesToFormatter(_cfDateFormatter.get(), formatter.get());
+        }
+
+        if (_pendingDateFormat) {
+            CFDateFormatterSetFormat(formatter.get(), static_cast<CFStringRef>(_pendingDateFormat.get()));
+            _pendingDateFormat = nil;
+        }
+
+        _cfDateFormatter.reset(formatter.release());
+        _needsNewFormatter = NO;
+    }
+
+    return _cfDateFormatter.get();
 }
 
 /**
@@ -117,14 +192,22 @@ static NSDateFormatterBehavior s_defaultFormatterBehavior = NSDateFormatterBehav
  @Status Interoperable
 */
 - (instancetype)copyWithZone:(NSZone*)zone {
-    NSDateFormatter* copy = [super copyWithZone:zone];
+    NSDateFormatter* copy = [[[self class] allocWithZone:zone] init];
 
+    CFDateFormatterRef formatter = [self _formatter];
     woc::unique_cf<CFDateFormatterRef> formatterCopy(CFDateFormatterCreate(nullptr,
-                                                                           CFDateFormatterGetLocale(_cfDateFormatter.get()),
-                                                                           CFDateFormatterGetDateStyle(_cfDateFormatter.get()),
-                                                                           CFDateFormatterGetTimeStyle(_cfDateFormatter.get())));
-    _copyPropertiesToFormatter(_cfDateFormatter.get(), formatterCopy.get());
+                                                                           static_cast<CFLocaleRef>(_locale.get()),
+                                                                           static_cast<CFDateFormatterStyle>(_dateStyle),
+                                                                           static_cast<CFDateFormatterStyle>(_timeStyle)));
+    _copyPropertiesToFormatter(formatter, formatterCopy.get());
+    CFDateFormatterSetFormat(formatterCopy.get(), CFDateFormatterGetFormat(formatter));
+
     copy->_cfDateFormatter.reset(formatterCopy.release());
+    copy->_locale = _locale;
+    copy->_dateStyle = _dateStyle;
+    copy->_timeStyle = _timeStyle;
+    copy->_pendingDateFormat = nil;
+    copy->_needsNewFormatter = NO;
 
     return copy;
 }
@@ -149,9 +232,11 @@ static NSDateFormatterBehavior s_defaultFormatterBehavior = NSDateFormatterBehav
     }
 
     if (self = [super init]) {
-        _cfDateFormatter.reset(
-            CFDateFormatterCreate(nullptr, static_cast<CFLocaleRef>(locale), kCFDateFormatterNoStyle, kCFDateFormatterNoStyle));
-        CFDateFormatterSetFormat(_cfDateFormatter.get(), static_cast<CFStringRef>(format));
+        _locale = locale;
+        _dateStyle = NSDateFormatterNoStyle;
+        _timeStyle = NSDateFormatterNoStyle;
+        _pendingDateFormat.attach([format copy]);
+        _needsNewFormatter = YES;
     }
 
     return self;
@@ -161,47 +246,43 @@ static NSDateFormatterBehavior s_defaultFormatterBehavior = NSDateFormatterBehav
  @Status Interoperable
 */
 - (void)setCalendar:(NSCalendar*)cal {
-    CFDateFormatterSetProperty(_cfDateFormatter.get(), kCFDateFormatterCalendar, reinterpret_cast<CFTypeRef>(cal));
+    CFDateFormatterSetProperty([self _formatter], kCFDateFormatterCalendar, reinterpret_cast<CFTypeRef>(cal));
 }
 
 /**
  @Status Interoperable
 */
 - (NSCalendar*)calendar {
-    return (NSCalendar*)(CFAutorelease(CFDateFormatterCopyProperty(_cfDateFormatter.get(), kCFDateFormatterCalendar)));
+    return (NSCalendar*)(CFAutorelease(CFDateFormatterCopyProperty([self _formatter], kCFDateFormatterCalendar)));
 }
 
 /**
  @Status Interoperable
 */
 - (void)setTimeZone:(NSTimeZone*)zone {
-    CFDateFormatterSetProperty(_cfDateFormatter.get(), kCFDateFormatterTimeZone, reinterpret_cast<CFTypeRef>(zone));
+    CFDateFormatterSetProperty([self _formatter], kCFDateFormatterTimeZone, reinterpret_cast<CFTypeRef>(zone));
 }
 
 /**
  @Status Interoperable
 */
 - (NSTimeZone*)timeZone {
-    return (NSTimeZone*)(CFAutorelease(CFDateFormatterCopyProperty(_cfDateFormatter.get(), kCFDateFormatterTimeZone)));
+    return (NSTimeZone*)(CFAutorelease(CFDateFormatterCopyProperty([self _formatter], kCFDateFormatterTimeZone)));
 }
 
 /**
  @Status Interoperable
 */
 - (void)setLocale:(NSLocale*)locale {
-    woc::unique_cf<CFDateFormatterRef> formatterCopy(CFDateFormatterCreate(nullptr,
-                                                                           static_cast<CFLocaleRef>(locale),
-                                                                           CFDateFormatterGetDateStyle(_cfDateFormatter.get()),
-                                                                           CFDateFormatterGetTimeStyle(_cfDateFormatter.get())));
-    _copyPropertiesToFormatter(_cfDateFormatter.get(), formatterCopy.get());
-    _cfDateFormatter.reset(formatterCopy.release());
+    _locale = locale;
+    _needsNewFormatter = YES;
 }
 
 /**
  @Status Interoperable
 */
 - (NSLocale*)locale {
-    return static_cast<NSLocale*>(CFDateFormatterGetLocale(_cfDateFormatter.get()));
+    return _locale;
 }
 
 /**
@@ -209,7 +290,7 @@ static NSDateFormatterBehavior s_defaultFormatterBehavior = NSDateFormatterBehav
 */
 - (void)setLenient:(BOOL)lenient {
     CFBooleanRef isLenient = lenient ? kCFBooleanTrue : kCFBooleanFalse;
-    CFDateFormatterSetProperty(_cfDateFormatter.get(), kCFDateFormatterIsLenient, reinterpret_cast<CFTypeRef>(isLenient));
+    CFDateFormatterSetProperty([self _formatter], kCFDateFormatterIsLenient, reinterpret_cast<CFTypeRef>(isLenient));
 }
 
 /**
@@ -217,59 +298,53 @@ static NSDateFormatterBehavior s_defaultFormatterBehavior = NSDateFormatterBehav
 */
 - (BOOL)isLenient {
     return CFBooleanGetValue(
-        reinterpret_cast<CFBooleanRef>(CFAutorelease(CFDateFormatterCopyProperty(_cfDateFormatter.get(), kCFDateFormatterIsLenient))));
+        reinterpret_cast<CFBooleanRef>(CFAutorelease(CFDateFormatterCopyProperty([self _formatter], kCFDateFormatterIsLenient))));
 }
 
 /**
  @Status Interoperable
 */
 - (void)setDateFormat:(NSString*)format {
-    CFDateFormatterSetFormat(_cfDateFormatter.get(), static_cast<CFStringRef>(format));
+    CFDateFormatterSetFormat([self _formatter], static_cast<CFStringRef>(format));
 }
 
 /**
  @Status Interoperable
 */
 - (NSString*)dateFormat {
-    return static_cast<NSString*>(CFDateFormatterGetFormat(_cfDateFormatter.get()));
+    return static_cast<NSString*>(CFDateFormatterGetFormat([self _formatter]));
 }
 
 /**
  @Status Interoperable
 */
 - (void)setDateStyle:(NSDateFormatterStyle)style {
-    woc::unique_cf<CFDateFormatterRef> formatterCopy(CFDateFormatterCreate(nullptr,
-                                                                           CFDateFormatterGetLocale(_cfDateFormatter.get()),
-                                                                           static_cast<CFDateFormatterStyle>(style),
-                                                                           CFDateFormatterGetTimeStyle(_cfDateFormatter.get())));
-    _copyPropertiesToFormatter(_cfDateFormatter.get(), formatterCopy.get());
-    _cfDateFormatter.reset(formatterCopy.release());
+    _dateStyle = style;
+    _pendingDateFormat = nil;
+    _needsNewFormatter = YES;
 }
 
 /**
  @Status Interoperable
 */
 - (NSDateFormatterStyle)dateStyle {
-    return static_cast<NSDateFormatterStyle>(CFDateFormatterGetDateStyle(_cfDateFormatter.get()));
+    return _dateStyle;
 }
 
 /**
  @Status Interoperable
 */
 - (void)setTimeStyle:(NSDateFormatterStyle)style {
-    woc::unique_cf<CFDateFormatterRef> formatterCopy(CFDateFormatterCreate(nullptr,
-                                                                           CFDateFormatterGetLocale(_cfDateFormatter.get()),
-                                                                           CFDateFormatterGetDateStyle(_cfDateFormatter.get()),
-                                                                           static_cast<CFDateFormatterStyle>(style)));
-    _copyPropertiesToFormatter(_cfDateFormatter.get(), formatterCopy.get());
-    _cfDateFormatter.reset(formatterCopy.release());
+    _timeStyle = style;
+    _pendingDateFormat = nil;
+    _needsNewFormatter = YES;
 }
 
 /**
  @Status Interoperable
 */
 - (NSDateFormatterStyle)timeStyle {
-    return static_cast<NSDateFormatterStyle>(CFDateFormatterGetTimeStyle(_cfDateFormatter.get()));
+    return _timeStyle;
 }
 
 /**
@@ -277,19 +352,16 @@ static NSDateFormatterBehavior s_defaultFormatterBehavior = NSDateFormatterBehav
 */
 - (NSString*)stringFromDate:(NSDate*)date {
     return static_cast<NSString*>(
-        CFAutorelease(CFDateFormatterCreateStringWithDate(nullptr, _cfDateFormatter.get(), static_cast<CFDateRef>(date))));
+        CFAutorelease(CFDateFormatterCreateStringWithDate(nullptr, [self _formatter], static_cast<CFDateRef>(date))));
 }
 
 /**
  @Status Interoperable
  */
 + (NSString*)localizedStringFromDate:(NSDate*)date dateStyle:(NSDateFormatterStyle)dateStyle timeStyle:(NSDateFormatterStyle)timeStyle {
-    woc::unique_cf<CFDateFormatterRef> cfFormatter(CFDateFormatterCreate(nullptr,
-                                                                         static_cast<CFLocaleRef>(CFAutorelease(CFLocaleCopyCurrent())),
-                                                                         static_cast<CFDateFormatterStyle>(dateStyle),
-                                                                         static_cast<CFDateFormatterStyle>(timeStyle)));
-    return static_cast<NSString*>(
-        CFAutorelease(CFDateFormatterCreateStringWithDate(nullptr, cfFormatter.get(), static_cast<CFDateRef>(date))));
+    CFDateFormatterRef cfFormatter =
+        _cachedDateFormatter(static_cast<CFDateFormatterStyle>(dateStyle), static_cast<CFDateFormatterStyle>(timeStyle));
+    return static_cast<NSString*>(CFAutorelease(CFDateFormatterCreateStringWithDate(nullptr, cfFormatter, static_cast<CFDateRef>(date))));
 }
 
 /**
@@ -298,7 +370,7 @@ static NSDateFormatterBehavior s_defaultFormatterBehavior = NSDateFormatterBehav
 - (NSDate*)dateFromString:(NSString*)str {
     CFRange range = CFRange{ 0, [str length] };
     return static_cast<NSDate*>(
-        CFAutorelease(CFDateFormatterCreateDateFromString(nullptr, _cfDateFormatter.get(), static_cast<CFStringRef>(str), &range)));
+        CFAutorelease(CFDateFormatterCreateDateFromString(nullptr, [self _formatter], static_cast<CFStringRef>(str), &range)));
 }
 
 /**
@@ -331,112 +403,112 @@ static NSDateFormatterBehavior s_defaultFormatterBehavior = NSDateFormatterBehav
  @Status Interoperable
 */
 - (void)setAMSymbol:(NSString*)symbol {
-    CFDateFormatterSetProperty(_cfDateFormatter.get(), kCFDateFormatterAMSymbol, reinterpret_cast<CFTypeRef>(symbol));
+    CFDateFormatterSetProperty([self _formatter], kCFDateFormatterAMSymbol, reinterpret_cast<CFTypeRef>(symbol));
 }
 
 /**
  @Status Interoperable
 */
 - (NSString*)AMSymbol {
-    return (NSString*)(CFAutorelease(CFDateFormatterCopyProperty(_cfDateFormatter.get(), kCFDateFormatterAMSymbol)));
+    return (NSString*)(CFAutorelease(CFDateFormatterCopyProperty([self _formatter], kCFDateFormatterAMSymbol)));
 }
 
 /**
  @Status Interoperable
 */
 - (void)setPMSymbol:(NSString*)symbol {
-    CFDateFormatterSetProperty(_cfDateFormatter.get(), kCFDateFormatterPMSymbol, reinterpret_cast<CFTypeRef>(symbol));
+    CFDateFormatterSetProperty([self _formatter], kCFDateFormatterPMSymbol, reinterpret_cast<CFTypeRef>(symbol));
 }
 
 /**
  @Status Interoperable
 */
 - (NSString*)PMSymbol {
-    return (NSString*)(CFAutorelease(CFDateFormatterCopyProperty(_cfDateFormatter.get(), kCFDateFormatterPMSymbol)));
+    return (NSString*)(CFAutorelease(CFDateFormatterCopyProperty([self _formatter], kCFDateFormatterPMSymbol)));
 }
 
 /**
  @Status Interoperable
 */
 - (void)setShortStandaloneWeekdaySymbols:(NSArray*)symbols {
-    CFDateFormatterSetProperty(_cfDateFormatter.get(), kCFDateFormatterShortStandaloneWeekdaySymbols, reinterpret_cast<CFTypeRef>(symbols));
+    CFDateFormatterSetProperty([self _formatter], kCFDateFormatterShortStandaloneWeekdaySymbols, reinterpret_cast<CFTypeRef>(symbols));
 }
 
 /**
  @Status Interoperable
 */
 - (NSArray*)shortStandaloneWeekdaySymbols {
-    return (NSArray*)(CFAutorelease(CFDateFormatterCopyProperty(_cfDateFormatter.get(), kCFDateFormatterShortStandaloneWeekdaySymbols)));
+    return (NSArray*)(CFAutorelease(CFDateFormatterCopyProperty([self _formatter], kCFDateFormatterShortStandaloneWeekdaySymbols)));
 }
 
 /**
  @Status Interoperable
 */
 - (void)setWeekdaySymbols:(NSArray*)symbols {
-    CFDateFormatterSetProperty(_cfDateFormatter.get(), kCFDateFormatterWeekdaySymbols, reinterpret_cast<CFTypeRef>(symbols));
+    CFDateFormatterSetProperty([self _formatter], kCFDateFormatterWeekdaySymbols, reinterpret_cast<CFTypeRef>(symbols));
 }
 
 /**
  @Status Interoperable
 */
 - (NSArray*)weekdaySymbols {
-    return (NSArray*)(CFAutorelease(CFDateFormatterCopyProperty(_cfDateFormatter.get(), kCFDateFormatterWeekdaySymbols)));
+    return (NSArray*)(CFAutorelease(CFDateFormatterCopyProperty([self _formatter], kCFDateFormatterWeekdaySymbols)));
 }
 
 /**
  @Status Interoperable
 */
 - (void)setShortWeekdaySymbols:(NSArray*)symbols {
-    CFDateFormatterSetProperty(_cfDateFormatter.get(), kCFDateFormatterShortWeekdaySymbols, reinterpret_cast<CFTypeRef>(symbols));
+    CFDateFormatterSetProperty([self _formatter], kCFDateFormatterShortWeekdaySymbols, reinterpret_cast<CFTypeRef>(symbols));
 }
 
 /**
  @Status Interoperable
 */
 - (NSArray*)shortWeekdaySymbols {
-    return (NSArray*)(CFAutorelease(CFDateFormatterCopyProperty(_cfDateFormatter.get(), kCFDateFormatterShortWeekdaySymbols)));
+    return (NSArray*)(CFAutorelease(CFDateFormatterCopyProperty([self _formatter], kCFDateFormatterShortWeekdaySymbols)));
 }
 
 /**
  @Status Interoperable
 */
 - (void)setStandaloneWeekdaySymbols:(NSArray*)symbols {
-    CFDateFormatterSetProperty(_cfDateFormatter.get(), kCFDateFormatterStandaloneWeekdaySymbols, reinterpret_cast<CFTypeRef>(symbols));
+    CFDateFormatterSetProperty([self _formatter], kCFDateFormatterStandaloneWeekdaySymbols, reinterpret_cast<CFTypeRef>(symbols));
 }
 
 /**
  @Status Interoperable
 */
 - (NSArray*)standaloneWeekdaySymbols {
-    return (NSArray*)(CFAutorelease(CFDateFormatterCopyProperty(_cfDateFormatter.get(), kCFDateFormatterStandaloneWeekdaySymbols)));
+    return (NSArray*)(CFAutorelease(CFDateFormatterCopyProperty([self _formatter], kCFDateFormatterStandaloneWeekdaySymbols)));
 }
 
 /**
  @Status Interoperable
 */
 - (void)setStandaloneMonthSymbols:(NSArray*)symbols {
-    CFDateFormatterSetProperty(_cfDateFormatter.get(), kCFDateFormatterStandaloneMonthSymbols, reinterpret_cast<CFTypeRef>(symbols));
+    CFDateFormatterSetProperty([self _formatter], kCFDateFormatterStandaloneMonthSymbols, reinterpret_cast<CFTypeRef>(symbols));
 }
 
 /**
  @Status Interoperable
 */
 - (NSArray*)standaloneMonthSymbols {
-    return (NSArray*)(CFAutorelease(CFDateFormatterCopyProperty(_cfDateFormatter.get(), kCFDateFormatterStandaloneMonthSymbols)));
+    return (NSArray*)(CFAutorelease(CFDateFormatterCopyProperty([self _formatter], kCFDateFormatterStandaloneMonthSymbols)));
 }
 
 /**
  @Status Interoperable
 */
 - (void)setMonthSymbols:(NSArray*)symbols {
-    CFDateFormatterSetProperty(_cfDateFormatter.get(), kCFDateFormatterMonthSymbols, reinterpret_cast<CFTypeRef>(symbols));
+    CFDateFormatterSetProperty([self _formatter], kCFDateFormatterMonthSymbols, reinterpret_cast<CFTypeRef>(symbols));
 }
 
 /**
  @Status Interoperable
 */
 - (NSArray*)monthSymbols {
-    return (NSArray*)(CFAutorelease(CFDateFormatterCopyProperty(_cfDateFormatter.get(), kCFDateFormatterMonthSymbols)));
+    return (NSArray*)(CFAutorelease(CFDateFormatterCopyProperty([self _formatter], kCFDateFormatterMonthSymbols)));
 }
 
 /**
@@ -27,13 +27,35 @@
 
 static const wchar_t* TAG = L"NSDirectoryEnumerator";
 
+static NSDictionary* fileAttributesForFilePath(const char* path);
+
+namespace {
+// A directory that is currently being read, along with its path relative to the enumeration root ("" for the root itself).
+struct DirectoryLevel {
+    EbrDir* dir;
+    std::string relativePath;
+};
+}
+
+/*
+* NSDirectoryEnumerator walks a directory tree lazily: only the directories along the current path are held open, and each
+* entry is read from the file system when nextObject asks for it. Entries are returned depth first, a directory before its
+* contents. A directory returned by nextObject is not opened until the following call to nextObject, so skipDescendants
+* prevents its subtree from being read at all. Whether an entry is a directory comes from the directory entry itself, so no
+* entry is stat'ed unless the caller asks for fileAttributes.
+*/
 @implementation NSDirectoryEnumerator {
-    idretaint<NSMutableDictionary> _rootFiles;
-    idretaint<NSString> _currentFile;
-    std::vector<idretaint<NSDirectoryEnumerator>> _currrentEnumerator;
-    int _currentDepth;
+    std::string _rootPath;
+    std::vector<DirectoryLevel> _openDirectories;
+
+    // The relative path of the last directory returned, which is descended into on the next call to nextObject.
+    std::string _pendingDirectory;
+    BOOL _hasPendingDirectory;
     BOOL _skipDescendents;
-    idretaint<NSString> _searchPath;
+
+    BOOL _shallow;
+    BOOL _returnNSURL;
+    idretaint<NSString> _currentFile;
 }
 
 /**
@@ -43,93 +65,12 @@ static const wchar_t* TAG = L"NSDirectoryEnumerator";
     return self;
 }
 
-/*
-* This function search files/directories in a directory path. It starts with rootpath and subpath.
-* (e.g., rootpath is "." and subPath is "saved"). the search will start at "./saved" seach path.  which is "saved" sub-directory of
-* current working directory. together, rootpath + subpath is called searchPath.
-*
-* Search behaviour:  if shallow is YES, the search only happens at the top level of the search path. if shallow is NO,  the search
-* will happen recusively on search path and any of its subdirectories as well.
-
-* Search Result: If returnNSURL is YES, the result objArray will contains NSURL object, if returnNSURL is NO, however,
-* the result objectArray contains NSString object. either of which represent a file or direcotry found during the search
-* If specifying returnNSURL as YES, NSDirectoryEnumerationOptions is used to exclude specified results. e.g.,
-NSDirectoryEnumerationSkipsHiddenFiles
-* will exclude hidden files from the result. Also, If specifying returnNSURL as YES, A NSArray of keys (property bag) can be passed in, so
-that
-* specified properties for the file or drectiroy can be prefeched and included in returned NSURL object.
-*/
-static void searchRecursive(const char* rootpath,
-                            const char* subpath,
-                            BOOL shallow,
-                            id objArray,
-                            NSArray* keys,
-                            NSDirectoryEnumerationOptions mask,
-                            BOOL returnNSURL) {
-    std::string _searchPath = rootpath;
-    if (_searchPath[_searchPath.length() - 1] != '/') {
-        _searchPath.append("/");
+- (void)_openDirectoryAtRelativePath:(const std::string&)relativePath {
+    std::string fullPath = _rootPath + relativePath;
+    EbrDir* dir = EbrOpenDir(fullPath.c_str());
+    if (dir != NULL) {
+        _openDirectories.push_back({ dir, relativePath });
     }
-
-    _searchPath.append(subpath);
-    if (_searchPath[_searchPath.length() - 1] != '/') {
-        _searchPath.push_back('/');
-    }
-
-    EbrDir* ebrDir = EbrOpenDir(_searchPath.c_str());
-    if (ebrDir != NULL) {
-        EbrDirEnt dirEnt;
-        while (EbrReadDir(ebrDir, &dirEnt)) {
-            if (strcmp(dirEnt.fileName, ".") == 0 || strcmp(dirEnt.fileName, "..") == 0) {
-                continue;
-            }
-
-            std::string filename = subpath;
-            if (filename.length() > 0 && filename[filename.length() - 1] != '/') {
-                filename.push_back('/');
-            }
-
-            filename.append(dirEnt.fileName);
-            if (returnNSURL) {
-                // TODO: ignore all mask for now, not needed for 1511
-                std::string fileFullPath = _searchPath;
-                fileFullPath.append(filename);
-
-                if (keys != nil) { // caller wants to fetch some properties for this URL
-                    NSDictionary* fileAttributes = fileAttributesForFilePath(fileFullPath.c_str());
-                    if (fileAttributes != nil) {
-                        NSURL* newURL = [NSURL fileURLWithPath:[NSString stringWithCString:fileFullPath.c_str()]];
-                        for (NSString* key in keys) {
-                            if ([key isEqualToString:NSURLContentModificationDateKey]) {
-                                // TODO 7491994: Implement CFURL resourceValue APIs
-                                // BOOL ret = [newURL setResourceValue:[fileAttributes objectForKey:NSFileModificationDate]
-                                //                              forKey:NSURLContentModificationDateKey
-                                //                               error:nil];
-                                // assert(ret);
-                            } else {
-                                // TODO: add aditional properties, not needed in 1511.
-                            }
-                        }
-
-                        [objArray addObject:newURL];
-                    }
-                }
-
-            } else {
-                NSString* newStr = [NSString stringWithCString:filename.c_str()];
-                [objArray addObject:newStr];
-            }
-
-            if (!shallow) {
-                if (dirEnt.isDir) {
-                    searchRecursive(rootpath, filename.c_str(), shallow, objArray, keys, mask, returnNSURL);
-                }
-            }
-        }
-
-        EbrCloseDir(ebrDir);
-    }
-    return;
 }
 
 /**
@@ -141,28 +82,18 @@ static void searchRecursive(const char* rootpath,
    includingPropertiesForKeys:(NSArray*)keys
                       options:(NSDirectoryEnumerationOptions)mask
                   returnNSURL:(BOOL)returnNSURL {
-    _rootFiles.attach([NSMutableArray new]);
-    _searchPath = [NSString stringWithCString:path];
-    searchRecursive(path, "", shallow, _rootFiles, keys, mask, returnNSURL);
-    _currrentEnumerator.push_back([_rootFiles objectEnumerator]);
-    _currentDepth = 0;
-    return self;
-}
-
-static void addAllFiles(NSDirectoryEnumerator* enumerator, NSMutableArray* allFiles) {
-    id curObj = [enumerator nextObject];
-
-    while (curObj != nil) {
-        if ([curObj isKindOfClass:[NSString class]] || [curObj isKindOfClass:[NSURL class]]) {
-            [allFiles addObject:curObj];
-        } else {
-            id subEnum = [curObj objectEnumerator];
-
-            addAllFiles(subEnum, allFiles);
-        }
-
-        curObj = [enumerator nextObject];
+    // TODO: ignore all mask and keys for now, not needed for 1511
+    _rootPath = path;
+    if (_rootPath.empty() || _rootPath[_rootPath.length() - 1] != '/') {
+        _rootPath.push_back('/');
     }
+
+    _shallow = shallow;
+    _returnNSURL = returnNSURL;
+    _hasPendingDirectory = NO;
+    _skipDescendents = NO;
+    [self _openDirectoryAtRelativePath:""];
+    return self;
 }
 
 /**
@@ -170,9 +101,10 @@ static void addAllFiles(NSDirectoryEnumerator* enumerator, NSMutableArray* allFi
 */
 - (NSMutableArray*)allObjects {
     id ret = [NSMutableArray array];
-    id curEnum = [_rootFiles objectEnumerator];
 
-    addAllFiles(curEnum, ret);
+    for (id curObj = [self nextObject]; curObj != nil; curObj = [self nextObject]) {
+        [ret addObject:curObj];
+    }
 
     return ret;
 }
@@ -190,6 +122,8 @@ static void addAllFiles(NSDirectoryEnumerator* enumerator, NSMutableArray* allFi
 
     unsigned numRet = 0;
     state->itemsPtr = stackBuf;
+
+    // skipDescendants is only meaningful between two calls to nextObject, so hand out a single entry at a time.
     maxCount = 1;
 
     while (maxCount > 0) {
@@ -211,9 +145,12 @@ static void addAllFiles(NSDirectoryEnumerator* enumerator, NSMutableArray* allFi
  @Status Interoperable
 */
 - (void)dealloc {
-    _rootFiles = nil;
+    for (DirectoryLevel& level : _openDirectories) {
+        EbrCloseDir(level.dir);
+    }
+    _openDirectories.clear();
+
     _currentFile = nil;
-    _searchPath = nil;
 
     [super dealloc];
 }
@@ -236,32 +173,52 @@ static void addAllFiles(NSDirectoryEnumerator* enumerator, NSMutableArray* allFi
  @Status Interoperable
 */
 - (id) /* use typed version */ nextObject {
-    id curObj, ret = nil;
-
-    while (_currentDepth >= 0) {
-        curObj = [_currrentEnumerator[_currentDepth] nextObject];
-        if (curObj == nil) {
-            _currrentEnumerator[_currentDepth] = nil;
-            _currrentEnumerator.pop_back();
-            _currentDepth--;
-            _skipDescendents = false;
+    if (_hasPendingDirectory) {
+        _hasPendingDirectory = NO;
+        if (!_skipDescendents) {
+            [self _openDirectoryAtRelativePath:_pendingDirectory];
+        }
+    }
+
+    _skipDescendents = false;
+
+    while (!_openDirectories.empty()) {
+        DirectoryLevel& level = _openDirectories.back();
+
+        EbrDirEnt dirEnt;
+        if (!EbrReadDir(level.dir, &dirEnt)) {
+            EbrCloseDir(level.dir);
+            _openDirectories.pop_back();
             continue;
         }
 
-        if ([curObj isKindOfClass:[NSString class]] || [curObj isKindOfClass:[NSURL class]]) {
-            ret = curObj;
-            break;
-        } else {
-            if (!_skipDescendents) {
-                _currentDepth++;
-                _currrentEnumerator.push_back([curObj objectEnumerator]);
-            }
+        if (strcmp(dirEnt.fileName, ".") == 0 || strcmp(dirEnt.fileName, "..") == 0) {
+            continue;
+        }
+
+        std::string filename = level.relativePath;
+        if (!filename.empty()) {
+            filename.push_back('/');
+        }
+        filename.append(dirEnt.fileName);
+
+        if (!_shallow && dirEnt.isDir) {
+            _pendingDirectory = filename;
+            _hasPendingDirectory = YES;
         }
-    }
 
-    _currentFile = ret;
+        _currentFile = [NSString stringWithCString:filename.c_str()];
 
-    return ret;
+        if (_returnNSURL) {
+            std::string fileFullPath = _rootPath + filename;
+            return [NSURL fileURLWithPath:[NSString stringWithCString:fileFullPath.c_str()]];
+        }
+
+        return _currentFile;
+    }
+
+    _currentFile = nil;
+    return nil;
 }
 
 static NSDictionary* fileAttributesForFilePath(const char* path) {
@@ -286,20 +243,16 @@ static NSDictionary* fileAttributesForFilePath(const char* path) {
  @Notes Only NSFileSize and NSFileCreationDate attributes are supported
 */
 - (NSDictionary*)fileAttributes {
-    const char* rootPath = [_searchPath UTF8String];
-    const char* path = [_currentFile UTF8String];
-
-    char fullPath[4096];
-
-    strcpy_s(fullPath, _countof(fullPath), rootPath);
-    if (fullPath[strlen(fullPath) - 1] != '/') {
-        strcpy_s(fullPath, _countof(fullPath), "/");
+    if (_currentFile == nil) {
+        return nil;
     }
-    strcpy_s(fullPath, _countof(fullPath), path);
 
-    TraceVerbose(TAG, L"fileAttributesAtPath: %hs", fullPath);
+    // Attributes are only fetched on request, for the entry most recently returned by nextObject.
+    std::string fullPath = _rootPath + [_currentFile UTF8String];
+
+    TraceVerbose(TAG, L"fileAttributesAtPath: %hs", fullPath.c_str());
 
-    return fileAttributesForFilePath(fullPath);
+    return fileAttributesForFilePath(fullPath.c_str());
 }
 
 @end
@@ -131,20 +131,15 @@ static NSString* c_archiveKey = @"_NS.IS";
  @Status Interoperable
 */
 - (BOOL)containsIndexesInRange:(NSRange)indexRange {
-    unsigned selfIndex = 0;
-    unsigned selfSize = [static_cast<NSMutableIndexSet*>(self) _count];
-
-    while (selfIndex < selfSize) {
-        NSRange currSelf = [static_cast<NSMutableIndexSet*>(self) _itemAtIndex:selfIndex];
-        if (NSEqualRanges(indexRange, NSIntersectionRange(currSelf, indexRange))) {
-            // indexRange a subset of current range from self
-            return YES;
-        }
+    // Only the last range starting at or before indexRange can contain it.
+    unsigned rangePos = [static_cast<NSMutableIndexSet*>(self) _positionOfRangeLessThanOrEqualToLocation:indexRange.location];
 
-        selfIndex++;
+    if (rangePos == NSNotFound) {
+        return NO;
     }
 
-    return NO;
+    NSRange currSelf = [static_cast<NSMutableIndexSet*>(self) _itemAtIndex:rangePos];
+    return NSEqualRanges(indexRange, NSIntersectionRange(currSelf, indexRange)) ? YES : NO;
 }
 
 /**
@@ -186,8 +181,13 @@ static NSString* c_archiveKey = @"_NS.IS";
 */
 - (NSUInteger)countOfIndexesInRange:(NSRange)range {
     unsigned ret = 0;
+    unsigned start = [static_cast<NSMutableIndexSet*>(self) _positionOfRangeLessThanOrEqualToLocation:range.location];
+
+    if (start == NSNotFound) {
+        start = 0;
+    }
 
-    for (unsigned i = 0; i < [static_cast<NSMutableIndexSet*>(self) _count]; i++) {
+    for (unsigned i = start; i < [static_cast<NSMutableIndexSet*>(self) _count]; i++) {
         NSRange cur = [static_cast<NSMutableIndexSet*>(self) _itemAtIndex:i];
 
         if (cur.location > range.location + range.length) {
@@ -26,10 +26,26 @@
 
 #include <vector>
 #include <memory>
+#include <mutex>
+#include <unordered_map>
 
 static const wchar_t* TAG = L"NSInvocation";
 static constexpr unsigned int NSINVOCATION_SMALL_RETURN_VALUE_SIZE = 16;
 
+const _NSInvocationFrameLayout* _NSInvocationFrameLayout::forMethodSignature(NSMethodSignature* methodSignature) {
+    // Method signatures are uniqued by +[NSMethodSignature signatureWithObjCTypes:] and live for the lifetime
+    // of the process, so they can key the layout cache directly.
+    static std::mutex s_layoutsLock;
+    static std::unordered_map<NSMethodSignature*, std::unique_ptr<_NSInvocationFrameLayout>> s_layouts;
+
+    std::lock_guard<std::mutex> lock(s_layoutsLock);
+    auto& layout = s_layouts[methodSignature];
+    if (!layout) {
+        layout.reset(new _NSInvocationFrameLayout(methodSignature));
+    }
+    return layout.get();
+}
+
 @implementation NSInvocation {
     StrongId<NSMethodSignature> _methodSignature;
 
@@ -23,6 +23,13 @@ struct _NSInvocationAllocationExtent {
     size_t length;
 };
 
+// Where a single argument lives in a call frame, along with what storing it requires.
+struct _NSInvocationArgumentLayout {
+    _NSInvocationAllocationExtent extent;
+    size_t size; // objc_sizeof_type of the argument
+    char type; // first character of the argument's type encoding
+};
+
 #define NSINVOCATION_ALIGN(n, alignment) ((n + (alignment - 1)) & ~(alignment - 1))
 
 // Generated by _ForwardBridge when it calls _ForwardFrame.
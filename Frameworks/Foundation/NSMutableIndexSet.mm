@@ -28,6 +28,8 @@
 #include "NSIndexSetInternal.h"
 #include "Etc.h"
 
+#include <algorithm>
+
 @implementation NSMutableIndexSet {
     std::vector<NSRange> _ranges;
 }
@@ -39,53 +41,41 @@
     // A range is added to the index by finding its appropriate sorted position such
     // that no overlaps exist. This may mean that multiple ranges are subsumed by the addition of this range.
     // Additionally, a candidate range may be a total subset of an existing range which should result in a no-op.
-    // A range is ordered in the _ranges array according to its left edge (range.location). The length of each range is
-    // at most the distance to the next left edge as any range would be coalesced with a longer distance.
-    // In order to coalesce two or more ranges, the current list of ranges will be scanned for any overlaps. When an overlap is
-    // detected the candidate range will be updated to include the new maximal bounds and the current entry marked for removal.
-    // Once all overlaps are accounted for, old items will be removed, and the candidate range will be inserted into the least vacated
-    // index (all removed indices should be contiguous and by definition everything non overlapping was not removed.)
-
-    NSRange removalRange = { 0, 0 }; // The set of ranges to remove during cleanup. Start with removing at index 0 with a length of 0.
-    for (unsigned int i = 0; i < [self _count]; i++) {
-        NSRange cur = [self _itemAtIndex:i];
-
-        // There are six ways two ranges can be arranged relative to each other.
-        //                   |================|
-        // 1. |=====|                                          (left of)
-        // 2.             |====|                               (left overlap)
-        // 3.                     |====|                       (subset)
-        // 4.                             |========|           (right overlap)
-        // 5.                                     |=========|  (right of)
-        // 6.         |==============================|         (super set)
-
-        if (cur.location > NSMaxRange(candidateRange)) {
-            // current range's left side is beyond that of the candidate range's right side.
-            // This is means that the candidate range is (left of) the current range. All overlaps
-            // are done and its time to clean up.
-            break;
-        } else if (NSMaxRange(cur) < candidateRange.location) {
-            // The candidate range's left edge is beyond the current range's right edge.
-            // this means that the candidate range is (right of) the current range. No overlap.
-            // move along.
-            removalRange.location++;
-        } else {
-            // the 4 other cases all involve some overlap (or adjacency). This means that the candidate range needs
-            // to expand to include the maximal range and the current range removed.
-            removalRange.length++;
-            candidateRange = NSUnionRange(candidateRange, cur);
-        }
+    // A range is ordered in the _ranges array according to its left edge (range.location). Because ranges never overlap,
+    // the right edges (NSMaxRange) are sorted as well, so the window of ranges that overlap or abut the candidate can be
+    // located with two binary searches rather than a scan of the whole array:
+    //   - the first range whose right edge reaches the candidate's left edge, and
+    //   - the first range whose left edge lies beyond the candidate's right edge.
+    // Everything in between is coalesced into the candidate, which then takes the place of the first range in the window.
+
+    auto first = std::lower_bound(_ranges.begin(), _ranges.end(), candidateRange.location, [](const NSRange& range, NSUInteger location) {
+        return NSMaxRange(range) < location;
+    });
+
+    // Fast path: indexes are most commonly added in ascending order, which always lands past the last range.
+    if (first == _ranges.end()) {
+        [self _addItem:candidateRange];
+        return;
     }
 
-    // Cleanup step is to first remove everything we need and then to insert at the min removed index.
-    // Since all ranges to be removed are contiguous, simply shift the ranges beyond the removed chunk
-    // down into vacated spots.
-    if (removalRange.length > 0) {
-        [self _removeRanges:removalRange];
+    auto last = std::upper_bound(first, _ranges.end(), NSMaxRange(candidateRange), [](NSUInteger location, const NSRange& range) {
+        return location < range.location;
+    });
+
+    NSUInteger position = first - _ranges.begin();
+    if (first == last) {
+        // No overlap (left of the range at position), insert as a new range.
+        [self _insertItem:candidateRange AtIndex:position];
+        return;
     }
 
-    // Now insert the candidate range
-    [self _insertItem:candidateRange AtIndex:removalRange.location];
+    candidateRange = NSUnionRange(candidateRange, NSUnionRange(*first, *(last - 1)));
+    if (NSNotFound - candidateRange.location < candidateRange.length) {
+        THROW_NS_HR(E_BOUNDS);
+    }
+
+    *first = candidateRange;
+    [self _removeRanges:{ position + 1, static_cast<NSUInteger>(last - first) - 1 }];
 }
 
 /**
@@ -165,9 +155,39 @@
  @Status Interoperable
 */
 - (void)addIndexes:(NSIndexSet*)other {
-    for (unsigned i = 0; i < [static_cast<NSMutableIndexSet*>(other) _count]; ++i) {
-        [self addIndexesInRange:[static_cast<NSMutableIndexSet*>(other) _itemAtIndex:i]];
+    NSMutableIndexSet* otherSet = static_cast<NSMutableIndexSet*>(other);
+    unsigned otherCount = [otherSet _count];
+
+    if (otherCount <= 1 || _ranges.empty()) {
+        for (unsigned i = 0; i < otherCount; ++i) {
+            [self addIndexesInRange:[otherSet _itemAtIndex:i]];
+        }
+        return;
+    }
+
+    // Both sets are sorted runs, so the union is a single linear merge rather than one insertion per range.
+    const NSRange* otherRanges = [otherSet _allRanges];
+    std::vector<NSRange> merged;
+    merged.reserve(_ranges.size() + otherCount);
+
+    size_t selfIndex = 0;
+    size_t otherIndex = 0;
+    while (selfIndex < _ranges.size() || otherIndex < otherCount) {
+        NSRange next;
+        if (otherIndex == otherCount || (selfIndex < _ranges.size() && _ranges[selfIndex].location <= otherRanges[otherIndex].location)) {
+            next = _ranges[selfIndex++];
+        } else {
+            next = otherRanges[otherIndex++];
+        }
+
+        if (!merged.empty() && next.location <= NSMaxRange(merged.back())) {
+            merged.back() = NSUnionRange(merged.back(), next);
+        } else {
+            merged.push_back(next);
+        }
     }
+
+    _ranges.swap(merged);
 }
 
 /**
@@ -290,25 +310,29 @@
 }
 
 - (unsigned)_positionOfRangeGreaterThanOrEqualToLocation:(NSUInteger)location {
-    unsigned length = self->_ranges.size();
-    for (unsigned i = 0; i < length; i++) {
-        if (location < NSMaxRange(self->_ranges[i])) {
-            return i;
-        }
+    // First range whose right edge lies beyond location.
+    auto it = std::upper_bound(_ranges.begin(), _ranges.end(), location, [](NSUInteger location, const NSRange& range) {
+        return location < NSMaxRange(range);
+    });
+
+    if (it == _ranges.end()) {
+        return NSNotFound;
     }
 
-    return NSNotFound;
+    return it - _ranges.begin();
 }
 
 - (unsigned)_positionOfRangeLessThanOrEqualToLocation:(NSUInteger)location {
-    unsigned i = self->_ranges.size();
-    while (i-- >= 1) {
-        if (self->_ranges[i].location <= location) {
-            return i;
-        }
+    // Last range whose left edge is at or before location.
+    auto it = std::upper_bound(_ranges.begin(), _ranges.end(), location, [](NSUInteger location, const NSRange& range) {
+        return location < range.location;
+    });
+
+    if (it == _ranges.begin()) {
+        return NSNotFound;
     }
 
-    return NSNotFound;
+    return (it - _ranges.begin()) - 1;
 }
 
 - (unsigned)_count {
@@ -72,13 +72,7 @@
 */
 - (void)insertObject:(id)object atIndex:(NSUInteger)idx {
     THROW_NS_IF_FALSE(E_INVALIDARG, object != nil);
-
-    if ([self containsObject:object]) {
-        return;
-    }
-
-    [_arrayContainer insertObject:object atIndex:idx];
-    [_setContainer addObject:object];
+    [self _insertObject:object atIndex:idx];
 }
 
 /**
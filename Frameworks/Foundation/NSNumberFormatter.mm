@@ -30,6 +30,12 @@ CFStringRef kCFNumberFormatterUsesCharacterDirectionKey = static_cast<CFStringRe
     woc::unique_cf<CFNumberFormatterRef> _cfNumberFormatter;
     BOOL _wasMaxFractionDigitsSet;
     BOOL _wasMaxIntegerDigitsSet;
+
+    // Locale and style changes only take effect when the formatter is next used, so that configuring both
+    // compiles a single ICU formatter instead of one per setter.
+    StrongId<NSLocale> _locale;
+    NSNumberFormatterStyle _numberStyle;
+    BOOL _needsNewFormatter;
 }
 
 /**
@@ -46,8 +52,9 @@ CFStringRef kCFNumberFormatterUsesCharacterDirectionKey = static_cast<CFStringRe
     if (self = [super init]) {
         _wasMaxFractionDigitsSet = NO;
         _wasMaxIntegerDigitsSet = NO;
-        _cfNumberFormatter.reset(
-            CFNumberFormatterCreate(nullptr, static_cast<CFLocaleRef>([NSLocale currentLocale]), kCFNumberFormatterNoStyle));
+        _locale = [NSLocale currentLocale];
+        _numberStyle = NSNumberFormatterNoStyle;
+        _needsNewFormatter = YES;
     }
 
     return self;
@@ -57,49 +64,49 @@ CFStringRef kCFNumberFormatterUsesCharacterDirectionKey = static_cast<CFStringRe
  @Status Interoperable
 */
 - (void)setCurrencyCode:(NSString*)value {
-    CFNumberFormatterSetProperty(_cfNumberFormatter.get(), kCFNumberFormatterCurrencyCode, reinterpret_cast<CFTypeRef>(value));
+    CFNumberFormatterSetProperty([self _formatter], kCFNumberFormatterCurrencyCode, reinterpret_cast<CFTypeRef>(value));
 }
 
 /**
  @Status Interoperable
 */
 - (NSString*)currencyCode {
-    return [(NSString*)CFNumberFormatterCopyProperty(_cfNumberFormatter.get(), kCFNumberFormatterCurrencyCode) autorelease];
+    return [(NSString*)CFNumberFormatterCopyProperty([self _formatter], kCFNumberFormatterCurrencyCode) autorelease];
 }
 
 /**
  @Status Interoperable
 */
 - (void)setNotANumberSymbol:(NSString*)value {
-    CFNumberFormatterSetProperty(_cfNumberFormatter.get(), kCFNumberFormatterNaNSymbol, reinterpret_cast<CFTypeRef>(value));
+    CFNumberFormatterSetProperty([self _formatter], kCFNumberFormatterNaNSymbol, reinterpret_cast<CFTypeRef>(value));
 }
 
 /**
  @Status Interoperable
 */
 - (NSString*)notANumberSymbol {
-    return [(NSString*)CFNumberFormatterCopyProperty(_cfNumberFormatter.get(), kCFNumberFormatterNaNSymbol) autorelease];
+    return [(NSString*)CFNumberFormatterCopyProperty([self _formatter], kCFNumberFormatterNaNSymbol) autorelease];
 }
 
 /**
  @Status Interoperable
 */
 - (void)setDecimalSeparator:(NSString*)value {
-    CFNumberFormatterSetProperty(_cfNumberFormatter.get(), kCFNumberFormatterDecimalSeparator, reinterpret_cast<CFTypeRef>(value));
+    CFNumberFormatterSetProperty([self _formatter], kCFNumberFormatterDecimalSeparator, reinterpret_cast<CFTypeRef>(value));
 }
 
 /**
  @Status Interoperable
 */
 - (NSString*)decimalSeparator {
-    return [(NSString*)CFNumberFormatterCopyProperty(_cfNumberFormatter.get(), kCFNumberFormatterDecimalSeparator) autorelease];
+    return [(NSString*)CFNumberFormatterCopyProperty([self _formatter], kCFNumberFormatterDecimalSeparator) autorelease];
 }
 
 /**
  @Status Interoperable
 */
 - (void)setAlwaysShowsDecimalSeparator:(BOOL)value {
-    CFNumberFormatterSetProperty(_cfNumberFormatter.get(),
+    CFNumberFormatterSetProperty([self _formatter],
                                  kCFNumberFormatterAlwaysShowDecimalSeparator,
                                  value ? kCFBooleanTrue : kCFBooleanFalse);
 }
@@ -109,35 +116,35 @@ CFStringRef kCFNumberFormatterUsesCharacterDirectionKey = static_cast<CFStringRe
 */
 - (BOOL)alwaysShowsDecimalSeparator {
     return CFBooleanGetValue(
-        static_cast<CFBooleanRef>(CFNumberFormatterCopyProperty(_cfNumberFormatter.get(), kCFNumberFormatterAlwaysShowDecimalSeparator)));
+        static_cast<CFBooleanRef>(CFNumberFormatterCopyProperty([self _formatter], kCFNumberFormatterAlwaysShowDecimalSeparator)));
 }
 
 /**
  @Status Interoperable
 */
 - (void)setGroupingSeparator:(NSString*)value {
-    CFNumberFormatterSetProperty(_cfNumberFormatter.get(), kCFNumberFormatterGroupingSeparator, reinterpret_cast<CFTypeRef>(value));
+    CFNumberFormatterSetProperty([self _formatter], kCFNumberFormatterGroupingSeparator, reinterpret_cast<CFTypeRef>(value));
 }
 
 /**
  @Status Interoperable
 */
 - (NSString*)groupingSeparator {
-    return [(NSString*)CFNumberFormatterCopyProperty(_cfNumberFormatter.get(), kCFNumberFormatterCurrencyGroupingSeparator) autorelease];
+    return [(NSString*)CFNumberFormatterCopyProperty([self _formatter], kCFNumberFormatterCurrencyGroupingSeparator) autorelease];
 }
 
 /**
  @Status Interoperable
 */
 - (void)setMultiplier:(NSNumber*)value {
-    CFNumberFormatterSetProperty(_cfNumberFormatter.get(), kCFNumberFormatterMultiplier, reinterpret_cast<CFTypeRef>(value));
+    CFNumberFormatterSetProperty([self _formatter], kCFNumberFormatterMultiplier, reinterpret_cast<CFTypeRef>(value));
 }
 
 /**
  @Status Interoperable
 */
 - (NSNumber*)multiplier {
-    return [(NSNumber*)CFNumberFormatterCopyProperty(_cfNumberFormatter.get(), kCFNumberFormatterMultiplier) autorelease];
+    return [(NSNumber*)CFNumberFormatterCopyProperty([self _formatter], kCFNumberFormatterMultiplier) autorelease];
 }
 
 /**
@@ -145,7 +152,7 @@ CFStringRef kCFNumberFormatterUsesCharacterDirectionKey = static_cast<CFStringRe
 */
 - (void)setMaximumFractionDigits:(NSUInteger)value {
     _wasMaxFractionDigitsSet = YES;
-    CFNumberFormatterSetProperty(_cfNumberFormatter.get(),
+    CFNumberFormatterSetProperty([self _formatter],
                                  kCFNumberFormatterMaxFractionDigits,
                                  reinterpret_cast<CFTypeRef>([NSNumber numberWithUnsignedInteger:value]));
 }
@@ -154,84 +161,84 @@ CFStringRef kCFNumberFormatterUsesCharacterDirectionKey = static_cast<CFStringRe
  @Status Interoperable
 */
 - (NSUInteger)maximumFractionDigits {
-    return ((NSNumber*)(CFNumberFormatterCopyProperty(_cfNumberFormatter.get(), kCFNumberFormatterMaxFractionDigits))).unsignedIntegerValue;
+    return ((NSNumber*)(CFNumberFormatterCopyProperty([self _formatter], kCFNumberFormatterMaxFractionDigits))).unsignedIntegerValue;
 }
 
 /**
  @Status Interoperable
 */
 - (void)setPositivePrefix:(NSString*)value {
-    CFNumberFormatterSetProperty(_cfNumberFormatter.get(), kCFNumberFormatterPositivePrefix, reinterpret_cast<CFTypeRef>(value));
+    CFNumberFormatterSetProperty([self _formatter], kCFNumberFormatterPositivePrefix, reinterpret_cast<CFTypeRef>(value));
 }
 
 /**
  @Status Interoperable
 */
 - (NSString*)positivePrefix {
-    return [(NSString*)CFNumberFormatterCopyProperty(_cfNumberFormatter.get(), kCFNumberFormatterPositivePrefix) autorelease];
+    return [(NSString*)CFNumberFormatterCopyProperty([self _formatter], kCFNumberFormatterPositivePrefix) autorelease];
 }
 
 /**
  @Status Interoperable
 */
 - (void)setNegativePrefix:(NSString*)value {
-    CFNumberFormatterSetProperty(_cfNumberFormatter.get(), kCFNumberFormatterNegativePrefix, reinterpret_cast<CFTypeRef>(value));
+    CFNumberFormatterSetProperty([self _formatter], kCFNumberFormatterNegativePrefix, reinterpret_cast<CFTypeRef>(value));
 }
 
 /**
  @Status Interoperable
 */
 - (NSString*)negativePrefix {
-    return [(NSString*)CFNumberFormatterCopyProperty(_cfNumberFormatter.get(), kCFNumberFormatterNegativePrefix) autorelease];
+    return [(NSString*)CFNumberFormatterCopyProperty([self _formatter], kCFNumberFormatterNegativePrefix) autorelease];
 }
 
 /**
  @Status Interoperable
 */
 - (void)setPositiveSuffix:(NSString*)value {
-    CFNumberFormatterSetProperty(_cfNumberFormatter.get(), kCFNumberFormatterPositiveSuffix, reinterpret_cast<CFTypeRef>(value));
+    CFNumberFormatterSetProperty([self _formatter], kCFNumberFormatterPositiveSuffix, reinterpret_cast<CFTypeRef>(value));
 }
 
 /**
  @Status Interoperable
 */
 - (NSString*)positiveSuffix {
-    return [(NSString*)CFNumberFormatterCopyProperty(_cfNumberFormatter.get(), kCFNumberFormatterPositiveSuffix) autorelease];
+    return [(NSString*)CFNumberFormatterCopyProperty([self _formatter], kCFNumberFormatterPositiveSuffix) autorelease];
 }
 
 /**
  @Status Interoperable
 */
 - (void)setNegativeSuffix:(NSString*)value {
-    CFNumberFormatterSetProperty(_cfNumberFormatter.get(), kCFNumberFormatterNegativeSuffix, reinterpret_cast<CFTypeRef>(value));
+    CFNumberFormatterSetProperty([self _formatter], kCFNumberFormatterNegativeSuffix, reinterpret_cast<CFTypeRef>(value));
 }
 
 /**
  @Status Interoperable
 */
 - (NSString*)negativeSuffix {
-    return [(NSString*)CFNumberFormatterCopyProperty(_cfNumberFormatter.get(), kCFNumberFormatterNegativeSuffix) autorelease];
+    return [(NSString*)CFNumberFormatterCopyProperty([self _formatter], kCFNumberFormatterNegativeSuffix) autorelease];
 }
 
 /**
  @Status Interoperable
 */
 - (void)setPercentSymbol:(NSString*)value {
-    CFNumberFormatterSetProperty(_cfNumberFormatter.get(), kCFNumberFormatterPercentSymbol, reinterpret_cast<CFTypeRef>(value));
+    CFNumberFormatterSetProperty([self _formatter], kCFNumberFormatterPercentSymbol, reinterpret_cast<CFTypeRef>(value));
 }
 
 /**
  @Status Interoperable
 */
 - (NSString*)percentSymbol {
-    return [(NSString*)CFNumberFormatterCopyProperty(_cfNumberFormatter.get(), kCFNumberFormatterPercentSymbol) autorelease];
+    return [(NSString*)CFNumberFormatterCopyProperty([self _formatter], kCFNumberFormatterPercentSymbol) autorelease];
 }
 
 /**
  @Status Interoperable
 */
 - (void)setUsesGroupingSeparator:(BOOL)value {
-    CFNumberFormatterSetProperty(_cfNumberFormatter.get(),
+    CFNumberFormatterSetProperty([self _formatter],
                                  kCFNumberFormatterUseGroupingSeparator,
                                  (value == YES) ? kCFBooleanTrue : kCFBooleanFalse);
 }
@@ -241,14 +248,14 @@ CFStringRef kCFNumberFormatterUsesCharacterDirectionKey = static_cast<CFStringRe
 */
 - (BOOL)usesGroupingSeparator {
     return CFBooleanGetValue(
-        static_cast<CFBooleanRef>(CFNumberFormatterCopyProperty(_cfNumberFormatter.get(), kCFNumberFormatterUseGroupingSeparator)));
+        static_cast<CFBooleanRef>(CFNumberFormatterCopyProperty([self _formatter], kCFNumberFormatterUseGroupingSeparator)));
 }
 
 /**
  @Status Interoperable
 */
 - (void)setGroupingSize:(NSUInteger)value {
-    CFNumberFormatterSetProperty(_cfNumberFormatter.get(),
+    CFNumberFormatterSetProperty([self _formatter],
                                  kCFNumberFormatterGroupingSize,
                                  reinterpret_cast<CFTypeRef>([NSNumber numberWithUnsignedInteger:value]));
 }
@@ -257,21 +264,21 @@ CFStringRef kCFNumberFormatterUsesCharacterDirectionKey = static_cast<CFStringRe
  @Status Interoperable
 */
 - (NSUInteger)groupingSize {
-    return ((NSNumber*)(CFNumberFormatterCopyProperty(_cfNumberFormatter.get(), kCFNumberFormatterGroupingSize))).unsignedIntegerValue;
+    return ((NSNumber*)(CFNumberFormatterCopyProperty([self _formatter], kCFNumberFormatterGroupingSize))).unsignedIntegerValue;
 }
 
 /**
  @Status Interoperable
 */
 - (void)setCurrencySymbol:(NSString*)value {
-    CFNumberFormatterSetProperty(_cfNumberFormatter.get(), kCFNumberFormatterGroupingSize, reinterpret_cast<CFTypeRef>(value));
+    CFNumberFormatterSetProperty([self _formatter], kCFNumberFormatterGroupingSize, reinterpret_cast<CFTypeRef>(value));
 }
 
 /**
  @Status Interoperable
 */
 - (NSString*)currencySymbol {
-    return [(NSString*)CFNumberFormatterCopyProperty(_cfNumberFormatter.get(), kCFNumberFormatterCurrencySymbol) autorelease];
+    return [(NSString*)CFNumberFormatterCopyProperty([self _formatter], kCFNumberFormatterCurrencySymbol) autorelease];
 }
 
 /**
@@ -303,7 +310,7 @@ CFStringRef kCFNumberFormatterUsesCharacterDirectionKey = static_cast<CFStringRe
  @Status Interoperable
 */
 - (void)setMinimumIntegerDigits:(NSUInteger)value {
-    CFNumberFormatterSetProperty(_cfNumberFormatter.get(),
+    CFNumberFormatterSetProperty([self _formatter],
                                  kCFNumberFormatterMinIntegerDigits,
                                  reinterpret_cast<CFTypeRef>([NSNumber numberWithUnsignedInteger:value]));
 }
@@ -312,42 +319,42 @@ CFStringRef kCFNumberFormatterUsesCharacterDirectionKey = static_cast<CFStringRe
  @Status Interoperable
 */
 - (NSUInteger)minimumIntegerDigits {
-    return ((NSNumber*)(CFNumberFormatterCopyProperty(_cfNumberFormatter.get(), kCFNumberFormatterMinIntegerDigits))).unsignedIntegerValue;
+    return ((NSNumber*)(CFNumberFormatterCopyProperty([self _formatter], kCFNumberFormatterMinIntegerDigits))).unsignedIntegerValue;
 }
 
 /**
  @Status Interoperable
 */
 - (void)setCurrencyDecimalSeparator:(NSString*)value {
-    CFNumberFormatterSetProperty(_cfNumberFormatter.get(), kCFNumberFormatterCurrencyDecimalSeparator, reinterpret_cast<CFTypeRef>(value));
+    CFNumberFormatterSetProperty([self _formatter], kCFNumberFormatterCurrencyDecimalSeparator, reinterpret_cast<CFTypeRef>(value));
 }
 
 /**
  @Status Interoperable
 */
 - (NSString*)currencyDecimalSeparator {
-    return [(NSString*)CFNumberFormatterCopyProperty(_cfNumberFormatter.get(), kCFNumberFormatterCurrencyDecimalSeparator) autorelease];
+    return [(NSString*)CFNumberFormatterCopyProperty([self _formatter], kCFNumberFormatterCurrencyDecimalSeparator) autorelease];
 }
 
 /**
  @Status Interoperable
 */
 - (void)setExponentSymbol:(NSString*)value {
-    CFNumberFormatterSetProperty(_cfNumberFormatter.get(), kCFNumberFormatterExponentSymbol, reinterpret_cast<CFTypeRef>(value));
+    CFNumberFormatterSetProperty([self _formatter], kCFNumberFormatterExponentSymbol, reinterpret_cast<CFTypeRef>(value));
 }
 
 /**
  @Status Interoperable
 */
 - (NSString*)exponentSymbol {
-    return [(NSString*)CFNumberFormatterCopyProperty(_cfNumberFormatter.get(), kCFNumberFormatterExponentSymbol) autorelease];
+    return [(NSString*)CFNumberFormatterCopyProperty([self _formatter], kCFNumberFormatterExponentSymbol) autorelease];
 }
 
 /**
  @Status Interoperable
 */
 - (void)setFormatWidth:(NSUInteger)value {
-    CFNumberFormatterSetProperty(_cfNumberFormatter.get(),
+    CFNumberFormatterSetProperty([self _formatter],
                                  kCFNumberFormatterFormatWidth,
                                  reinterpret_cast<CFTypeRef>([NSNumber numberWithUnsignedInteger:value]));
 }
@@ -356,14 +363,14 @@ CFStringRef kCFNumberFormatterUsesCharacterDirectionKey = static_cast<CFStringRe
  @Status Interoperable
 */
 - (NSUInteger)formatWidth {
-    return ((NSNumber*)(CFNumberFormatterCopyProperty(_cfNumberFormatter.get(), kCFNumberFormatterFormatWidth))).unsignedIntegerValue;
+    return ((NSNumber*)(CFNumberFormatterCopyProperty([self _formatter], kCFNumberFormatterFormatWidth))).unsignedIntegerValue;
 }
 
 /**
  @Status Interoperable
 */
 - (void)setInternationalCurrencySymbol:(NSString*)value {
-    CFNumberFormatterSetProperty(_cfNumberFormatter.get(),
+    CFNumberFormatterSetProperty([self _formatter],
                                  kCFNumberFormatterInternationalCurrencySymbol,
                                  reinterpret_cast<CFTypeRef>(value));
 }
@@ -372,91 +379,91 @@ CFStringRef kCFNumberFormatterUsesCharacterDirectionKey = static_cast<CFStringRe
  @Status Interoperable
 */
 - (NSString*)internationalCurrencySymbol {
-    return [(NSString*)CFNumberFormatterCopyProperty(_cfNumberFormatter.get(), kCFNumberFormatterInternationalCurrencySymbol) autorelease];
+    return [(NSString*)CFNumberFormatterCopyProperty([self _formatter], kCFNumberFormatterInternationalCurrencySymbol) autorelease];
 }
 
 /**
  @Status Interoperable
 */
 - (void)setMinusSign:(NSString*)value {
-    CFNumberFormatterSetProperty(_cfNumberFormatter.get(), kCFNumberFormatterMinusSign, reinterpret_cast<CFTypeRef>(value));
+    CFNumberFormatterSetProperty([self _formatter], kCFNumberFormatterMinusSign, reinterpret_cast<CFTypeRef>(value));
 }
 
 /**
  @Status Interoperable
 */
 - (NSString*)minusSign {
-    return [(NSString*)CFNumberFormatterCopyProperty(_cfNumberFormatter.get(), kCFNumberFormatterMinusSign) autorelease];
+    return [(NSString*)CFNumberFormatterCopyProperty([self _formatter], kCFNumberFormatterMinusSign) autorelease];
 }
 
 /**
  @Status Interoperable
 */
 - (void)setPaddingCharacter:(NSString*)value {
-    CFNumberFormatterSetProperty(_cfNumberFormatter.get(), kCFNumberFormatterPaddingCharacter, reinterpret_cast<CFTypeRef>(value));
+    CFNumberFormatterSetProperty([self _formatter], kCFNumberFormatterPaddingCharacter, reinterpret_cast<CFTypeRef>(value));
 }
 
 /**
  @Status Interoperable
 */
 - (NSString*)paddingCharacter {
-    return [(NSString*)CFNumberFormatterCopyProperty(_cfNumberFormatter.get(), kCFNumberFormatterPaddingCharacter) autorelease];
+    return [(NSString*)CFNumberFormatterCopyProperty([self _formatter], kCFNumberFormatterPaddingCharacter) autorelease];
 }
 
 /**
  @Status Interoperable
 */
 - (void)setPerMillSymbol:(NSString*)value {
-    CFNumberFormatterSetProperty(_cfNumberFormatter.get(), kCFNumberFormatterPerMillSymbol, reinterpret_cast<CFTypeRef>(value));
+    CFNumberFormatterSetProperty([self _formatter], kCFNumberFormatterPerMillSymbol, reinterpret_cast<CFTypeRef>(value));
 }
 
 /**
  @Status Interoperable
 */
 - (NSString*)perMillSymbol {
-    return [(NSString*)CFNumberFormatterCopyProperty(_cfNumberFormatter.get(), kCFNumberFormatterPerMillSymbol) autorelease];
+    return [(NSString*)CFNumberFormatterCopyProperty([self _formatter], kCFNumberFormatterPerMillSymbol) autorelease];
 }
 
 /**
  @Status Interoperable
 */
 - (void)setPlusSign:(NSString*)value {
-    CFNumberFormatterSetProperty(_cfNumberFormatter.get(), kCFNumberFormatterPlusSign, reinterpret_cast<CFTypeRef>(value));
+    CFNumberFormatterSetProperty([self _formatter], kCFNumberFormatterPlusSign, reinterpret_cast<CFTypeRef>(value));
 }
 
 /**
  @Status Interoperable
 */
 - (NSString*)plusSign {
-    return [(NSString*)CFNumberFormatterCopyProperty(_cfNumberFormatter.get(), kCFNumberFormatterPlusSign) autorelease];
+    return [(NSString*)CFNumberFormatterCopyProperty([self _formatter], kCFNumberFormatterPlusSign) autorelease];
 }
 
 /**
  @Status Interoperable
 */
 - (void)setZeroSymbol:(NSString*)value {
-    CFNumberFormatterSetProperty(_cfNumberFormatter.get(), kCFNumberFormatterZeroSymbol, reinterpret_cast<CFTypeRef>(value));
+    CFNumberFormatterSetProperty([self _formatter], kCFNumberFormatterZeroSymbol, reinterpret_cast<CFTypeRef>(value));
 }
 
 /**
  @Status Interoperable
 */
 - (NSString*)zeroSymbol {
-    return [(NSString*)CFNumberFormatterCopyProperty(_cfNumberFormatter.get(), kCFNumberFormatterZeroSymbol) autorelease];
+    return [(NSString*)CFNumberFormatterCopyProperty([self _formatter], kCFNumberFormatterZeroSymbol) autorelease];
 }
 
 /**
  @Status Interoperable
 */
 - (void)setRoundingIncrement:(NSNumber*)value {
-    CFNumberFormatterSetProperty(_cfNumberFormatter.get(), kCFNumberFormatterRoundingIncrement, reinterpret_cast<CFTypeRef>(value));
+    CFNumberFormatterSetProperty([self _formatter], kCFNumberFormatterRoundingIncrement, reinterpret_cast<CFTypeRef>(value));
 }
 
 /**
  @Status Interoperable
 */
 - (NSNumber*)roundingIncrement {
-    return [(NSNumber*)CFNumberFormatterCopyProperty(_cfNumberFormatter.get(), kCFNumberFormatterRoundingIncrement) autorelease];
+    return [(NSNumber*)CFNumberFormatterCopyProperty([self _formatter], kCFNumberFormatterRoundingIncrement) autorelease];
 }
 
 /**
@@ -464,7 +471,7 @@ CFStringRef kCFNumberFormatterUsesCharacterDirectionKey = static_cast<CFStringRe
 */
 - (void)setMaximumIntegerDigits:(NSUInteger)value {
     _wasMaxIntegerDigitsSet = YES;
-    CFNumberFormatterSetProperty(_cfNumberFormatter.get(),
+    CFNumberFormatterSetProperty([self _formatter],
                                  kCFNumberFormatterMaxIntegerDigits,
                                  reinterpret_cast<CFTypeRef>([NSNumber numberWithUnsignedInteger:value]));
 }
@@ -473,14 +480,14 @@ CFStringRef kCFNumberFormatterUsesCharacterDirectionKey = static_cast<CFStringRe
  @Status Interoperable
 */
 - (NSUInteger)maximumIntegerDigits {
-    return ((NSNumber*)(CFNumberFormatterCopyProperty(_cfNumberFormatter.get(), kCFNumberFormatterMaxIntegerDigits))).unsignedIntegerValue;
+    return ((NSNumber*)(CFNumberFormatterCopyProperty([self _formatter], kCFNumberFormatterMaxIntegerDigits))).unsignedIntegerValue;
 }
 
 /**
  @Status Interoperable
 */
 - (void)setMaximumSignificantDigits:(NSUInteger)value {
-    CFNumberFormatterSetProperty(_cfNumberFormatter.get(),
+    CFNumberFormatterSetProperty([self _formatter],
                                  kCFNumberFormatterMaxSignificantDigits,
                                  reinterpret_cast<CFTypeRef>([NSNumber numberWithUnsignedInteger:value]));
 }
@@ -489,7 +496,7 @@ CFStringRef kCFNumberFormatterUsesCharacterDirectionKey = static_cast<CFStringRe
  @Status Interoperable
 */
 - (NSUInteger)maximumSignificantDigits {
-    return ((NSNumber*)(CFNumberFormatterCopyProperty(_cfNumberFormatter.get(), kCFNumberFormatterMaxSignificantDigits)))
+    return ((NSNumber*)(CFNumberFormatterCopyProperty([self _formatter], kCFNumberFormatterMaxSignificantDigits)))
         .unsignedIntegerValue;
 }
 
@@ -497,7 +504,7 @@ CFStringRef kCFNumberFormatterUsesCharacterDirectionKey = static_cast<CFStringRe
  @Status Interoperable
 */
 - (void)setMinimumFractionDigits:(NSUInteger)value {
-    CFNumberFormatterSetProperty(_cfNumberFormatter.get(),
+    CFNumberFormatterSetProperty([self _formatter],
                                  kCFNumberFormatterMinFractionDigits,
                                  reinterpret_cast<CFTypeRef>([NSNumber numberWithUnsignedInteger:value]));
 }
@@ -506,14 +513,14 @@ CFStringRef kCFNumberFormatterUsesCharacterDirectionKey = static_cast<CFStringRe
  @Status Interoperable
 */
 - (NSUInteger)minimumFractionDigits {
-    return ((NSNumber*)(CFNumberFormatterCopyProperty(_cfNumberFormatter.get(), kCFNumberFormatterMinFractionDigits))).unsignedIntegerValue;
+    return ((NSNumber*)(CFNumberFormatterCopyProperty([self _formatter], kCFNumberFormatterMinFractionDigits))).unsignedIntegerValue;
 }
 
 /**
  @Status Interoperable
 */
 - (void)setMinimumSignificantDigits:(NSUInteger)value {
-    CFNumberFormatterSetProperty(_cfNumberFormatter.get(),
+    CFNumberFormatterSetProperty([self _formatter],
                                  kCFNumberFormatterMinSignificantDigits,
                                  reinterpret_cast<CFTypeRef>([NSNumber numberWithUnsignedInteger:value]));
 }
@@ -522,7 +529,7 @@ CFStringRef kCFNumberFormatterUsesCharacterDirectionKey = static_cast<CFStringRe
  @Status Interoperable
 */
 - (NSUInteger)minimumSignificantDigits {
-    return ((NSNumber*)(CFNumberFormatterCopyProperty(_cfNumberFormatter.get(), kCFNumberFormatterMinSignificantDigits)))
+    return ((NSNumber*)(CFNumberFormatterCopyProperty([self _formatter], kCFNumberFormatterMinSignificantDigits)))
         .unsignedIntegerValue;
 }
 
@@ -530,7 +537,7 @@ CFStringRef kCFNumberFormatterUsesCharacterDirectionKey = static_cast<CFStringRe
  @Status Interoperable
 */
 - (void)setSecondaryGroupingSize:(NSUInteger)value {
-    CFNumberFormatterSetProperty(_cfNumberFormatter.get(),
+    CFNumberFormatterSetProperty([self _formatter],
                                  kCFNumberFormatterSecondaryGroupingSize,
                                  reinterpret_cast<CFTypeRef>([NSNumber numberWithUnsignedInteger:value]));
 }
@@ -539,7 +546,7 @@ CFStringRef kCFNumberFormatterUsesCharacterDirectionKey = static_cast<CFStringRe
  @Status Interoperable
 */
 - (NSUInteger)secondaryGroupingSize {
-    return ((NSNumber*)(CFNumberFormatterCopyProperty(_cfNumberFormatter.get(), kCFNumberFormatterSecondaryGroupingSize)))
+    return ((NSNumber*)(CFNumberFormatterCopyProperty([self _formatter], kCFNumberFormatterSecondaryGroupingSize)))
         .unsignedIntegerValue;
 }
 
@@ -547,7 +554,7 @@ CFStringRef kCFNumberFormatterUsesCharacterDirectionKey = static_cast<CFStringRe
  @Status Interoperable
 */
 - (void)setLenient:(BOOL)value {
-    CFNumberFormatterSetProperty(_cfNumberFormatter.get(), kCFNumberFormatterIsLenient, value ? kCFBooleanTrue : kCFBooleanFalse);
+    CFNumberFormatterSetProperty([self _formatter], kCFNumberFormatterIsLenient, value ? kCFBooleanTrue : kCFBooleanFalse);
 }
 
 /**
@@ -555,14 +562,14 @@ CFStringRef kCFNumberFormatterUsesCharacterDirectionKey = static_cast<CFStringRe
 */
 - (BOOL)isLenient {
     return CFBooleanGetValue(
-        static_cast<CFBooleanRef>(CFNumberFormatterCopyProperty(_cfNumberFormatter.get(), kCFNumberFormatterIsLenient)));
+        static_cast<CFBooleanRef>(CFNumberFormatterCopyProperty([self _formatter], kCFNumberFormatterIsLenient)));
 }
 
 /**
  @Status Interoperable
 */
 - (void)setUsesSignificantDigits:(BOOL)value {
-    CFNumberFormatterSetProperty(_cfNumberFormatter.get(),
+    CFNumberFormatterSetProperty([self _formatter],
                                  kCFNumberFormatterUseSignificantDigits,
                                  value ? kCFBooleanTrue : kCFBooleanFalse);
 }
@@ -572,31 +579,29 @@ CFStringRef kCFNumberFormatterUsesCharacterDirectionKey = static_cast<CFStringRe
 */
 - (BOOL)usesSignificantDigits {
     return CFBooleanGetValue(
-        static_cast<CFBooleanRef>(CFNumberFormatterCopyProperty(_cfNumberFormatter.get(), kCFNumberFormatterUseSignificantDigits)));
+        static_cast<CFBooleanRef>(CFNumberFormatterCopyProperty([self _formatter], kCFNumberFormatterUseSignificantDigits)));
 }
 
 /**
  @Status Interoperable
 */
 - (void)setNumberStyle:(NSNumberFormatterStyle)value {
-    woc::unique_cf<CFNumberFormatterRef> formatterCopy(
-        CFNumberFormatterCreate(nullptr, static_cast<CFLocaleRef>([self locale]), (CFNumberFormatterStyle(value))));
-    _copyPropertiesToFormatter(_cfNumberFormatter.get(), formatterCopy.get(), _wasMaxFractionDigitsSet, _wasMaxIntegerDigitsSet);
-    _cfNumberFormatter.reset(formatterCopy.release());
+    _numberStyle = value;
+    _needsNewFormatter = YES;
 }
 
 /**
  @Status Interoperable
 */
 - (NSNumberFormatterStyle)numberStyle {
-    return (NSNumberFormatterStyle)(CFNumberFormatterGetStyle(_cfNumberFormatter.get()));
+    return _numberStyle;
 }
 
 /**
  @Status Interoperable
 */
 - (void)setRoundingMode:(NSNumberFormatterRoundingMode)value {
-    CFNumberFormatterSetProperty(_cfNumberFormatter.get(),
+    CFNumberFormatterSetProperty([self _formatter],
                                  kCFNumberFormatterRoundingMode,
                                  reinterpret_cast<CFTypeRef>([NSNumber numberWithUnsignedInteger:value]));
 }
@@ -605,14 +610,14 @@ CFStringRef kCFNumberFormatterUsesCharacterDirectionKey = static_cast<CFStringRe
  @Status Interoperable
 */
 - (NSNumberFormatterRoundingMode)roundingMode {
-    return (NSNumberFormatterRoundingMode)(CFNumberFormatterCopyProperty(_cfNumberFormatter.get(), kCFNumberFormatterRoundingMode));
+    return (NSNumberFormatterRoundingMode)(CFNumberFormatterCopyProperty([self _formatter], kCFNumberFormatterRoundingMode));
 }
 
 /**
  @Status Interoperable
 */
 - (void)setPaddingPosition:(NSNumberFormatterRoundingMode)value {
-    CFNumberFormatterSetProperty(_cfNumberFormatter.get(),
+    CFNumberFormatterSetProperty([self _formatter],
                                  kCFNumberFormatterPaddingPosition,
                                  reinterpret_cast<CFTypeRef>([NSNumber numberWithUnsignedInteger:value]));
 }
@@ -621,7 +626,7 @@ CFStringRef kCFNumberFormatterUsesCharacterDirectionKey = static_cast<CFStringRe
  @Status Interoperable
 */
 - (NSNumberFormatterPadPosition)paddingPosition {
-    return (NSNumberFormatterPadPosition)(CFNumberFormatterCopyProperty(_cfNumberFormatter.get(), kCFNumberFormatterPaddingPosition));
+    return (NSNumberFormatterPadPosition)(CFNumberFormatterCopyProperty([self _formatter], kCFNumberFormatterPaddingPosition));
 }
 
 static void _setCFInfinitySymbol(CFNumberFormatterRef formatter, NSString* value) {
@@ -694,21 +699,34 @@ void _copyPropertiesToFormatter(CFNumberFormatterRef source,
     }
 }
 
+- (CFNumberFormatterRef)_formatter {
+    if (_needsNewFormatter) {
+        woc::unique_cf<CFNumberFormatterRef> formatter(
+            CFNumberFormatterCreate(nullptr, static_cast<CFLocaleRef>(_locale.get()), static_cast<CFNumberFormatterStyle>(_numberStyle)));
+        if (_cfNumberFormatter) {
+            _copyPropertiesToFormatter(_cfNumberFormatter.get(), formatter.get(), _wasMaxFractionDigitsSet, _wasMaxIntegerDigitsSet);
+        }
+
+        _cfNumberFormatter.reset(formatter.release());
+        _needsNewFormatter = NO;
+    }
+
+    return _cfNumberFormatter.get();
+}
+
 /**
  @Status Interoperable
 */
 - (void)setLocale:(NSLocale*)value {
-    woc::unique_cf<CFNumberFormatterRef> formatterCopy(
-        CFNumberFormatterCreate(nullptr, static_cast<CFLocaleRef>(value), CFNumberFormatterGetStyle(_cfNumberFormatter.get())));
-    _copyPropertiesToFormatter(_cfNumberFormatter.get(), formatterCopy.get(), _wasMaxFractionDigitsSet, _wasMaxIntegerDigitsSet);
-    _cfNumberFormatter.reset(formatterCopy.release());
+    _locale = value;
+    _needsNewFormatter = YES;
 }
 
 /**
  @Status Interoperable
 */
 - (NSLocale*)locale {
-    return static_cast<NSLocale*>(CFNumberFormatterGetLocale(_cfNumberFormatter.get()));
+    return _locale;
 }
 
 static id multipliedNumber(id number, id multiplierNumber) {
@@ -732,7 +750,7 @@ static BOOL numberIsNegative(id number) {
     CFRange range = CFRangeMake(0, string.length);
 
     return [static_cast<NSNumber*>(
-        CFNumberFormatterCreateNumberFromString(nullptr, _cfNumberFormatter.get(), static_cast<CFStringRef>(string), &range, 0))
+        CFNumberFormatterCreateNumberFromString(nullptr, [self _formatter], static_cast<CFStringRef>(string), &range, 0))
         autorelease];
 }
 
@@ -743,14 +761,14 @@ static BOOL numberIsNegative(id number) {
 
     if (!_finite(number.floatValue)) {
         if (number.floatValue > 0) {
-            _setCFInfinitySymbol(_cfNumberFormatter.get(), _positiveInfinitySymbol);
+            _setCFInfinitySymbol([self _formatter], _positiveInfinitySymbol);
         } else {
-            _setCFInfinitySymbol(_cfNumberFormatter.get(), _negativeInfinitySymbol);
+            _setCFInfinitySymbol([self _formatter], _negativeInfinitySymbol);
         }
     }
 
     return [static_cast<NSString*>(
-        CFNumberFormatterCreateStringWithNumber(nullptr, _cfNumberFormatter.get(), static_cast<CFNumberRef>(number))) autorelease];
+        CFNumberFormatterCreateStringWithNumber(nullptr, [self _formatter], static_cast<CFNumberRef>(number))) autorelease];
 }
 
 /**
@@ -16,10 +16,18 @@
 
 #import <Foundation/NSException.h>
 #import <NSOrderedSetInternal.h>
+#import <NSCFCollectionSupport.h>
 #import <Starboard.h>
 #import <StubReturn.h>
 #import <VAListHelper.h>
 
+#import <algorithm>
+
+// Elements are owned by _arrayContainer, so the index table neither retains nor releases its keys.
+static const CFDictionaryKeyCallBacks _NSOrderedSetIndexKeyCallBacks = {
+    0, nullptr, nullptr, _NSCFCallbackCopyDescription, _NSCFCallbackEquals, _NSCFCallbackHash,
+};
+
 // Needed to make sure that the returned array behaves like a one way proxy to an array
 @implementation _NSProxyOrderedSetArray
 - (instancetype)initWithOrderedSet:(NSOrderedSet*)orderedSet {
@@ -165,12 +173,47 @@
 }
 
 - (void)_insertObject:(id)object {
+    [self _insertObject:object atIndex:[_arrayContainer count]];
+}
+
+- (void)_insertObject:(id)object atIndex:(NSUInteger)index {
     if ([self containsObject:object]) {
         return;
     }
 
-    [_arrayContainer addObject:object];
-    [_setContainer addObject:object];
+    NSUInteger count = [_arrayContainer count];
+    THROW_NS_IF_FALSE(E_BOUNDS, index <= count);
+
+    [_arrayContainer insertObject:object atIndex:index];
+    CFDictionarySetValue(_indexes.get(), object, reinterpret_cast<const void*>(index));
+
+    if (index == count && _validIndexCount == count) {
+        // Appending keeps every stored index current.
+        _validIndexCount = count + 1;
+    } else {
+        _validIndexCount = std::min(_validIndexCount, index);
+    }
+}
+
+- (NSUInteger)_indexOfObject:(id)object {
+    const void* value;
+    if (object == nil || !CFDictionaryGetValueIfPresent(_indexes.get(), object, &value)) {
+        return NSNotFound;
+    }
+
+    NSUInteger index = reinterpret_cast<NSUInteger>(value);
+    if (index < _validIndexCount) {
+        return index;
+    }
+
+    // Renumber the stale tail once, after which lookups are constant time again.
+    NSUInteger count = [_arrayContainer count];
+    for (NSUInteger i = _validIndexCount; i < count; ++i) {
+        CFDictionarySetValue(_indexes.get(), [_arrayContainer objectAtIndex:i], reinterpret_cast<const void*>(i));
+    }
+
+    _validIndexCount = count;
+    return reinterpret_cast<NSUInteger>(CFDictionaryGetValue(_indexes.get(), object));
 }
 
 /**
@@ -192,7 +235,7 @@
  @Notes returned set does not reflect future changes.
 */
 - (NSSet*)set {
-    return [[_setContainer copy] autorelease];
+    return [NSSet setWithArray:_arrayContainer];
 }
 
 /**
@@ -273,12 +316,7 @@
         return [self init];
     }
 
-    if (self = [super init]) {
-        _setContainer.attach([[NSMutableSet alloc] initWithSet:set copyItems:flag]);
-        _arrayContainer.attach([[NSMutableArray alloc] initWithArray:[set allObjects] copyItems:flag]);
-    }
-
-    return self;
+    return [self initWithArray:[set allObjects] copyItems:flag];
 }
 
 /**
@@ -286,7 +324,7 @@
 */
 - (instancetype)init {
     if (self = [super init]) {
-        _setContainer = [NSMutableSet new];
+        _indexes.reset(CFDictionaryCreateMutable(kCFAllocatorDefault, 0, &_NSOrderedSetIndexKeyCallBacks, nullptr));
         _arrayContainer = [NSMutableArray new];
     }
 
@@ -300,7 +338,7 @@
     if (object == nil) {
         return NO;
     }
-    return [_setContainer containsObject:object];
+    return CFDictionaryContainsKey(_indexes.get(), object);
 }
 
 /**
@@ -366,7 +404,7 @@
  @Status Interoperable
 */
 - (NSUInteger)indexOfObject:(id)object {
-    return [_arrayContainer indexOfObject:object];
+    return [self _indexOfObject:object];
 }
 
 /**
@@ -511,7 +549,13 @@
  @Status Interoperable
 */
 - (BOOL)intersectsSet:(NSSet*)set {
-    return [_setContainer intersectsSet:set];
+    for (id object in set) {
+        if ([self containsObject:object]) {
+            return YES;
+        }
+    }
+
+    return NO;
 }
 
 /**
@@ -525,7 +569,17 @@
  @Status Interoperable
 */
 - (BOOL)isSubsetOfSet:(NSSet*)set {
-    return [_setContainer isSubsetOfSet:set];
+    if ([_arrayContainer count] > [set count]) {
+        return NO;
+    }
+
+    for (id object in static_cast<NSArray*>(_arrayContainer)) {
+        if (![set containsObject:object]) {
+            return NO;
+        }
+    }
+
+    return YES;
 }
 
 /**
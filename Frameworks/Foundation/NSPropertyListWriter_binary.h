@@ -19,8 +19,12 @@
 @interface NSPropertyListWriter_Binary : NSObject {
 @public
     id _dest;
+    // Maps every object in the graph, by identity, to its index in the object table
     CFMutableDictionaryRef _objList;
-    id objectsToDoList;
+    // Maps strings, numbers, dates and data, by value, to their index so that equal scalars are written once
+    CFMutableDictionaryRef _uniqueScalars;
+    // Objects in object table order
+    std::vector<id> _objects;
     id root;
 
     // Number of bytes per object table index
@@ -29,8 +33,7 @@
     unsigned int offset_size;
 
     unsigned int table_start;
-    unsigned int table_size;
-    unsigned int* table;
+    std::vector<unsigned int> _offsets;
 
     char* outBuf;
     int outBufLen;
@@ -42,9 +45,9 @@
 - (void)setup;
 - (void)cleanup;
 - (void)writeObjects;
--(void) markOffset:(unsigned int)offset for:(id)object;
 - (void)writeObjectTable;
 - (void)writeMetaData;
+- (unsigned)addObject:(id)object;
 - (unsigned)indexForObject:(id)object;
 - (void)storeIndex:(int)index;
 - (void)storeCount:(int)count;
@@ -61,17 +61,68 @@ void storeReversed(void* pos, unsigned value, unsigned width) {
     }
 }
 
-void appendBytes(NSPropertyListWriter_Binary* self, const void* data, int len) {
-    while (self->outBufLen + len > self->outBufMaxLen) {
-        self->outBufMaxLen += 64000;
+static char* reserveBytes(NSPropertyListWriter_Binary* self, int len) {
+    if (self->outBufLen + len > self->outBufMaxLen) {
+        int newMaxLen = self->outBufMaxLen ? self->outBufMaxLen : 4096;
+        while (self->outBufLen + len > newMaxLen) {
+            newMaxLen *= 2;
+        }
 
-        self->outBuf = (char*)IwRealloc(self->outBuf, self->outBufMaxLen);
+        self->outBuf = (char*)IwRealloc(self->outBuf, newMaxLen);
+        self->outBufMaxLen = newMaxLen;
     }
 
-    memcpy(&self->outBuf[self->outBufLen], data, len);
+    return &self->outBuf[self->outBufLen];
+}
+
+void appendBytes(NSPropertyListWriter_Binary* self, const void* data, int len) {
+    memcpy(reserveBytes(self, len), data, len);
     self->outBufLen += len;
 }
 
+enum {
+    SCALAR_NONE = 0,
+    SCALAR_STRING,
+    SCALAR_DATA,
+    SCALAR_DATE,
+    SCALAR_BOOL,
+    SCALAR_INTEGER,
+    SCALAR_REAL
+};
+
+// Returns which kind of value-uniqued scalar object is, or SCALAR_NONE for containers. Numbers are split by
+// representation so that @YES, @1 and @1.0 stay distinct objects in the output.
+static int scalarKind(id object) {
+    if ([object isKindOfClass:[NSString class]]) {
+        return SCALAR_STRING;
+    } else if ([object isKindOfClass:[NSNumber class]]) {
+        if (object == static_cast<id>(kCFBooleanTrue) || object == static_cast<id>(kCFBooleanFalse)) {
+            return SCALAR_BOOL;
+        }
+
+        const char* type = [object objCType];
+        return (*type == 'f' || *type == 'd') ? SCALAR_REAL : SCALAR_INTEGER;
+    } else if ([object isKindOfClass:[NSData class]]) {
+        return SCALAR_DATA;
+    } else if ([object isKindOfClass:[NSDate class]]) {
+        return SCALAR_DATE;
+    }
+
+    return SCALAR_NONE;
+}
+
+static Boolean scalarEqual(const void* value1, const void* value2) {
+    id first = (id)value1;
+    id second = (id)value2;
+    return (scalarKind(first) == scalarKind(second)) && [first isEqual:second];
+}
+
+static CFHashCode scalarHash(const void* value) {
+    return [(id)value hash];
+}
+
+static const CFDictionaryKeyCallBacks s_scalarKeyCallBacks = { 0, nullptr, nullptr, nullptr, scalarEqual, scalarHash };
+
 @implementation NSPropertyListWriter_Binary
 
 + (void)serializePropertyList:(id)aPropertyList intoData:(NSMutableData*)destination {
@@ -101,67 +152,78 @@ void appendBytes(NSPropertyListWriter_Binary* self, const void* data, int len) {
     return _dest;
 }
 
+// Flattens the object graph into the object table before anything is written, so that the object reference width is
+// known up front and every object is visited once.
 - (void)setup {
     [_dest setLength:0];
-    if (index_size == 1) {
-        table_size = 256;
-    } else if (index_size == 2) {
-        table_size = 256 * 256;
-    } else if (index_size == 3) {
-        table_size = 256 * 256 * 256;
-    } else if (index_size == 4) {
-        table_size = std::numeric_limits<unsigned int>::max();
-    }
 
-    table = (unsigned int*)IwMalloc(table_size * sizeof(int));
+    _objList = CFDictionaryCreateMutable(NULL, 0, NULL, NULL);
+    _uniqueScalars = CFDictionaryCreateMutable(NULL, 0, &s_scalarKeyCallBacks, NULL);
+    _objects.clear();
+
+    [self addObject:root];
+
+    for (size_t i = 0; i < _objects.size(); i++) {
+        id object = _objects[i];
 
-    objectsToDoList = [[NSMutableArray alloc] init];
-    _objList = CFDictionaryCreateMutable(NULL, 10, &kCFTypeDictionaryKeyCallBacks, NULL);
+        if ([object isKindOfClass:[NSArray class]]) {
+            for (id child in static_cast<NSArray*>(object)) {
+                [self addObject:child];
+            }
+        } else if ([object isKindOfClass:[NSDictionary class]] && [object objectForKey:@"CF$UID"] == nil) {
+            NSUInteger count = [object count];
+            std::vector<id> keys(count);
+            std::vector<id> values(count);
+            [object getObjects:values.data() andKeys:keys.data()];
+
+            for (id key : keys) {
+                [self addObject:key];
+            }
+
+            for (id value : values) {
+                [self addObject:value];
+            }
+        }
+    }
 
-    [objectsToDoList addObject:root];
-    CFDictionarySetValue(_objList, (const void*)root, 0);
+    size_t count = _objects.size();
+    if (count <= 0xFF) {
+        index_size = 1;
+    } else if (count <= 0xFFFF) {
+        index_size = 2;
+    } else {
+        index_size = 4;
+    }
+
+    _offsets.resize(count);
 }
 
 - (void)cleanup {
-    DESTROY(objectsToDoList);
-    [(id)_objList release];
-    if (table != NULL) {
-        IwFree(table);
-        table = NULL;
+    if (_objList != NULL) {
+        CFRelease(_objList);
+        _objList = NULL;
     }
+
+    if (_uniqueScalars != NULL) {
+        CFRelease(_uniqueScalars);
+        _uniqueScalars = NULL;
+    }
+
+    _objects.clear();
+    _offsets.clear();
 }
 
 - (void)writeObjects {
-    id object;
     const char* prefix = "bplist00";
 
     appendBytes(self, prefix, strlen(prefix));
 
-    while ([objectsToDoList count] != 0) {
-        object = [objectsToDoList objectAtIndex:0];
-        [self storeObject:object];
-        [objectsToDoList removeObjectAtIndex:0];
+    for (size_t i = 0; i < _objects.size(); i++) {
+        _offsets[i] = outBufLen;
+        [self storeObject:_objects[i]];
     }
 }
 
--(void) markOffset:(unsigned int)offset for:(id)object {
-    unsigned int oid = 0;
-
-    if (!CFDictionaryGetValueIfPresent(_objList, (void*)object, (const void**)&oid)) {
-        assert(0);
-        //[NSException raise: NSGenericException
-        // format: @"Unknown object %@.", object];
-    }
-
-    if (oid >= table_size) {
-        assert(0);
-        //[NSException raise: NSRangeException
-        // format: @"Object table index out of bounds %d.", oid];
-    }
-
-    table[oid] = offset;
-}
-
 - (void)writeObjectTable {
     table_start = outBufLen;
 
@@ -174,34 +236,17 @@ void appendBytes(NSPropertyListWriter_Binary* self, const void* data, int len) {
     else
         offset_size = 4;
 
-    unsigned len = CFDictionaryGetCount(_objList);
+    unsigned len = _offsets.size();
     unsigned size = offset_size * len;
 
-    unsigned char* buffer = (unsigned char*)IwMalloc(size);
-    int bufpos = 0;
+    unsigned char* buffer = (unsigned char*)reserveBytes(self, size);
 
     for (unsigned i = 0; i < len; i++) {
-        int curOffset = table[i];
-
-        if (offset_size == 4) {
-            buffer[bufpos++] = (curOffset >> 24) & 0xFF;
-            buffer[bufpos++] = (curOffset >> 16) & 0xFF;
-            buffer[bufpos++] = (curOffset >> 8) & 0xFF;
-            buffer[bufpos++] = curOffset & 0xFF;
-        } else if (offset_size == 3) {
-            buffer[bufpos++] = (curOffset >> 16) & 0xFF;
-            buffer[bufpos++] = (curOffset >> 8) & 0xFF;
-            buffer[bufpos++] = curOffset & 0xFF;
-        } else if (offset_size == 2) {
-            buffer[bufpos++] = (curOffset >> 8) & 0xFF;
-            buffer[bufpos++] = curOffset & 0xFF;
-        } else {
-            buffer[bufpos++] = curOffset & 0xFF;
-        }
+        storeReversed(buffer, _offsets[i], offset_size);
+        buffer += offset_size;
     }
 
-    appendBytes(self, buffer, size);
-    IwFree(buffer);
+    outBufLen += size;
 }
 
 - (void)writeMetaData {
@@ -210,22 +255,45 @@ void appendBytes(NSPropertyListWriter_Binary* self, const void* data, int len) {
     meta[6] = offset_size;
     meta[7] = index_size;
 
-    storeReversed(meta + 12, CFDictionaryGetCount(_objList), 4);
+    storeReversed(meta + 12, _objects.size(), 4);
     storeReversed(meta + 28, table_start, 4);
 
     appendBytes(self, meta, 32);
 }
 
+// Assigns object a slot in the object table. Objects are matched by identity first; strings, numbers, dates and
+// data that are equal to an already added object share its slot.
+- (unsigned)addObject:(id)object {
+    const void* index = NULL;
+
+    if (CFDictionaryGetValueIfPresent(_objList, (const void*)object, &index)) {
+        return (unsigned)(uintptr_t)index;
+    }
+
+    bool isScalar = (scalarKind(object) != SCALAR_NONE);
+    if (!isScalar || !CFDictionaryGetValueIfPresent(_uniqueScalars, (const void*)object, &index)) {
+        index = (const void*)(uintptr_t)_objects.size();
+        _objects.push_back(object);
+
+        if (isScalar) {
+            CFDictionarySetValue(_uniqueScalars, (const void*)object, index);
+        }
+    }
+
+    CFDictionarySetValue(_objList, (const void*)object, index);
+    return (unsigned)(uintptr_t)index;
+}
+
 - (unsigned)indexForObject:(id)object {
-    unsigned index = 0;
+    const void* index = NULL;
 
-    if (!CFDictionaryGetValueIfPresent(_objList, (void*)object, (const void**)&index)) {
-        index = CFDictionaryGetCount(_objList);
-        CFDictionarySetValue(_objList, (const void*)object, (void*)index);
-        [objectsToDoList addObject:object];
+    if (!CFDictionaryGetValueIfPresent(_objList, (const void*)object, &index)) {
+        assert(0);
+        //[NSException raise: NSGenericException
+        // format: @"Unknown object %@.", object];
     }
 
-    return index;
+    return (unsigned)(uintptr_t)index;
 }
 
 - (void)storeIndex:(int)index {
@@ -295,61 +363,38 @@ void appendBytes(NSPropertyListWriter_Binary* self, const void* data, int len) {
 }
 
 - (void)storeString:(NSString*)string {
-    BOOL ascii = YES;
-    unsigned char code;
-    unsigned int i;
+    CFStringRef cfString = static_cast<CFStringRef>(string);
+    CFIndex len = CFStringGetLength(cfString);
+    CFRange range = CFRangeMake(0, len);
 
-    unsigned len = [string length];
+    // Strings that are entirely ASCII are stored one byte per character, everything else as big-endian UTF-16.
+    const char* asciiPtr = CFStringGetCStringPtr(cfString, kCFStringEncodingASCII);
+    BOOL ascii = (asciiPtr != nullptr) || (CFStringGetBytes(cfString, range, kCFStringEncodingASCII, 0, false, nullptr, 0, nullptr) == len);
 
-    /*
-    for (i = 0; i < len; i++)
-    {
-    WORD uchar = [string characterAtIndex:i];
-    if (uchar > 127)
-    {
-    ascii = NO;
-    break;
-    }
+    unsigned char code = ascii ? ASCIITAG : UTF16TAG;
+    if (len < 0x0F) {
+        code += len;
+        appendBytes(self, &code, 1);
+    } else {
+        code |= 0xF;
+        appendBytes(self, &code, 1);
+        [self storeCount:len];
     }
-    */
 
     if (ascii) {
-        if (len < 0x0F) {
-            code = ASCIITAG + len;
-            appendBytes(self, &code, 1);
-            appendBytes(self, (char*)[string UTF8String], len);
+        if (asciiPtr != nullptr) {
+            appendBytes(self, asciiPtr, len);
         } else {
-            code = ASCIITAG | 0xF;
-            appendBytes(self, &code, 1);
-            [self storeCount:len];
-            appendBytes(self, (char*)[string UTF8String], len);
+            CFStringGetBytes(cfString, range, kCFStringEncodingASCII, 0, false, (UInt8*)reserveBytes(self, len), len, nullptr);
+            outBufLen += len;
         }
     } else {
-        if (len < 0x0F) {
-            WORD* buffer = (WORD*)IwMalloc((len + 1) * 2);
-
-            code = UTF16TAG + len;
-            appendBytes(self, &code, 1);
-            [string getCharacters:buffer];
-            for (unsigned int i = 0; i < len; i++) {
-                buffer[i] = NSSwapHostShortToBig(buffer[i]);
-            }
-            appendBytes(self, buffer, len * sizeof(WORD));
-            IwFree(buffer);
-        } else {
-            WORD* buffer;
-
-            code = UTF16TAG | 0xF;
-            appendBytes(self, &code, 1);
-            buffer = (WORD*)IwMalloc(sizeof(WORD) * (len + 1));
-            [self storeCount:len];
-            [string getCharacters:buffer];
-            for (i = 0; i < len; i++) {
-                buffer[i] = NSSwapHostShortToBig(buffer[i]);
-            }
-            appendBytes(self, buffer, sizeof(WORD) * len);
-            IwFree(buffer);
+        WORD* buffer = (WORD*)reserveBytes(self, len * sizeof(WORD));
+        CFStringGetCharacters(cfString, range, buffer);
+        for (CFIndex i = 0; i < len; i++) {
+            buffer[i] = NSSwapHostShortToBig(buffer[i]);
         }
+        outBufLen += len * sizeof(WORD);
     }
 }
 
@@ -446,7 +491,6 @@ void appendBytes(NSPropertyListWriter_Binary* self, const void* data, int len) {
 
 - (void)storeArray:(id)array {
     unsigned char code;
-    unsigned int i;
 
     unsigned len = [array count];
 
@@ -459,13 +503,8 @@ void appendBytes(NSPropertyListWriter_Binary* self, const void* data, int len) {
         [self storeCount:len];
     }
 
-    for (i = 0; i < len; i++) {
-        id obj;
-        unsigned int oid;
-
-        obj = [array objectAtIndex:i];
-        oid = [self indexForObject:obj];
-        [self storeIndex:oid];
+    for (id obj in static_cast<NSArray*>(array)) {
+        [self storeIndex:[self indexForObject:obj]];
     }
 }
 
@@ -496,14 +535,9 @@ void appendBytes(NSPropertyListWriter_Binary* self, const void* data, int len) {
         }
     } else {
         unsigned int len = [dict count];
-        NSArray* keys = [dict allKeys];
-        NSMutableArray* objects = [NSMutableArray arrayWithCapacity:len];
-        id key;
-
-        for (i = 0; i < len; i++) {
-            key = [keys objectAtIndex:i];
-            [objects addObject:[dict objectForKey:key]];
-        }
+        std::vector<id> keys(len);
+        std::vector<id> objects(len);
+        [dict getObjects:objects.data() andKeys:keys.data()];
 
         if (len < 0x0F) {
             code = DICTIONARYTAG + len;
@@ -518,7 +552,7 @@ void appendBytes(NSPropertyListWriter_Binary* self, const void* data, int len) {
             id obj;
             unsigned int oid;
 
-            obj = [keys objectAtIndex:i];
+            obj = keys[i];
             oid = [self indexForObject:obj];
             [self storeIndex:oid];
         }
@@ -527,7 +561,7 @@ void appendBytes(NSPropertyListWriter_Binary* self, const void* data, int len) {
             id obj;
             unsigned int oid;
 
-            obj = [objects objectAtIndex:i];
+            obj = objects[i];
             oid = [self indexForObject:obj];
             [self storeIndex:oid];
         }
@@ -535,36 +569,30 @@ void appendBytes(NSPropertyListWriter_Binary* self, const void* data, int len) {
 }
 
 - (void)storeObject:(id)object {
-[self markOffset:outBufLen for:object];
-
-if ([object isKindOfClass:[NSString class]]) {
-    [self storeString:object];
-} else if ([object isKindOfClass:[NSData class]]) {
-    [self storeData:object];
-} else if ([object isKindOfClass:[NSNumber class]]) {
-    [self storeNumber:object];
-} else if ([object isKindOfClass:[NSDate class]]) {
-    [self storeDate:object];
-} else if ([object isKindOfClass:[NSArray class]]) {
-    [self storeArray:object];
-} else if ([object isKindOfClass:[NSDictionary class]]) {
-    [self storeDictionary:object];
-} else {
-    TraceVerbose(TAG, L"Unknown object class %hs", object_getClassName(object));
-}
+    if ([object isKindOfClass:[NSString class]]) {
+        [self storeString:object];
+    } else if ([object isKindOfClass:[NSData class]]) {
+        [self storeData:object];
+    } else if ([object isKindOfClass:[NSNumber class]]) {
+        [self storeNumber:object];
+    } else if ([object isKindOfClass:[NSDate class]]) {
+        [self storeDate:object];
+    } else if ([object isKindOfClass:[NSArray class]]) {
+        [self storeArray:object];
+    } else if ([object isKindOfClass:[NSDictionary class]]) {
+        [self storeDictionary:object];
+    } else {
+        TraceVerbose(TAG, L"Unknown object class %hs", object_getClassName(object));
+    }
 }
 
 - (void)generate {
-    BOOL done = NO;
+    [self setup];
 
-    index_size = 2;
-
-    while (!done && (index_size <= 4)) {
-        [self setup];
-        [self writeObjects];
-        done = YES;
-    }
+    // Objects average well under 16 bytes each; starting there avoids most regrowth of the output buffer.
+    reserveBytes(self, _objects.size() * 16 + 64);
 
+    [self writeObjects];
     [self writeObjectTable];
     [self writeMetaData];
 
@@ -26,7 +26,6 @@
 #import <Windows.Storage.Streams.h>
 #import <Windows.System.Threading.h>
 #include <COMIncludes_end.h>
-#import <mutex>
 
 #import "Starboard/SmartTypes.h"
 #import "ErrorHandling.h"
@@ -65,18 +64,7 @@ static const wchar_t TAG[] = L"NSURLProtocol (HTTP)";
 
 namespace {
 #pragma region WinRT Initialization
-// To reduce the number of live HttpClient instances in the case of parallel requests, we vend the current one iff it exists.
-// They're all set up in the same way, and they are not stateful, so we can get away with this.
-static ComPtr<IHttpClient> _getHttpClient() {
-    static WeakRef weakHttpClient;
-    static std::mutex mutex;
-    std::lock_guard<std::mutex> lock(mutex);
-    ComPtr<IHttpClient> httpClient;
-    weakHttpClient.As(&httpClient);
-    if (httpClient) {
-        return httpClient;
-    }
-
+static ComPtr<IHttpClient> _createHttpClient() {
     ComPtr<IHttpClientFactory> httpClientFactory;
     THROW_NS_IF_FAILED(
         GetActivationFactory(Wrappers::HStringReference(RuntimeClass_Windows_Web_Http_HttpClient).Get(), &httpClientFactory));
@@ -100,8 +88,19 @@ static ComPtr<IHttpClient> _getHttpClient() {
     THROW_NS_IF_FAILED(filter.As(&filter3));
     THROW_NS_IF_FAILED(filter3->put_CookieUsageBehavior(HttpCookieUsageBehavior::HttpCookieUsageBehavior_NoCookies));
 
+    ComPtr<IHttpClient> httpClient;
     THROW_NS_IF_FAILED(httpClientFactory->Create(httpFilter.Get(), &httpClient));
-    httpClient.AsWeak(&weakHttpClient);
+    return httpClient;
+}
+
+// Every request is served by the same HttpClient. They're all set up in the same way, and they are not stateful, so we can get away
+// with this. The client is kept alive for the lifetime of the process rather than only while requests are in flight: its base
+// protocol filter owns the per-host keep-alive connection pool, and releasing it between requests would force a fresh TCP/TLS
+// handshake for every sequential request.
+// The client is deliberately leaked: releasing it from a static destructor would run after COM has been torn down and under the
+// loader lock.
+static ComPtr<IHttpClient> _getHttpClient() {
+    static IHttpClient* httpClient = _createHttpClient().Detach();
     return httpClient;
 }
 #pragma endregion
@@ -156,17 +155,18 @@ static ComPtr<IHttpRequestMessage> _requestMessageForNS(NSURLRequest* nsRequest)
         // VSO 6693048: Properly support streaming bodies instead of flattening the data up front.
         NSInputStream* bodyStream = nsRequest.HTTPBodyStream;
         std::vector<uint8_t> flattenedBodyStream(kHTTPContentBufferSize);
-        ptrdiff_t offset = 0;
+        size_t offset = 0;
         while ([bodyStream hasBytesAvailable]) {
-            ptrdiff_t read = [bodyStream read:flattenedBodyStream.data() + offset maxLength:flattenedBodyStream.capacity() - offset];
-            if (read == 0) {
+            if (offset == flattenedBodyStream.size()) {
+                flattenedBodyStream.resize(flattenedBodyStream.size() + kHTTPContentBufferSize);
+            }
+
+            NSInteger read = [bodyStream read:flattenedBodyStream.data() + offset maxLength:flattenedBodyStream.size() - offset];
+            if (read <= 0) {
                 break;
             }
 
             offset += read;
-            if (offset > flattenedBodyStream.capacity()) {
-                flattenedBodyStream.reserve(flattenedBodyStream.capacity() + kHTTPContentBufferSize);
-            }
         }
         [bodyStream close];
 
@@ -27,32 +27,41 @@
 constexpr size_t GPR_COUNT = 4;
 constexpr size_t SPFR_COUNT = 16;
 
-// It is a _NSInvocationCallFrame's job to carve out allocation extents from a buffer.
-class _NSInvocationCallFrame {
+// The frame layout for a method signature. It is computed once per signature and shared by every
+// _NSInvocationCallFrame built from it.
+class _NSInvocationFrameLayout {
 private:
-    // Reference guaranteed owned by NSInvocation
-    NSMethodSignature* _methodSignature;
-
-    uint8_t* _buffer;
-    size_t _length;
-    size_t _returnLength;
-    unsigned int _returnType;
-
     std::bitset<GPR_COUNT> gprUsage;
     std::bitset<SPFR_COUNT> spUsage;
     unsigned int stackBytes;
 
-    bool _structReturn;
-    _NSInvocationAllocationExtent _structReturnExtent;
-
-    std::vector<_NSInvocationAllocationExtent> _allocationExtents;
-
     _NSInvocationAllocationExtent _allocateStackWords(size_t count, size_t alignment = alignof(uintptr_t));
     _NSInvocationAllocationExtent _allocateMachineWords(unsigned int count, size_t alignment = alignof(uintptr_t));
     _NSInvocationAllocationExtent _allocateFloats(size_t count);
     _NSInvocationAllocationExtent _allocateDoubles(size_t count);
     _NSInvocationAllocationExtent _allocateArgument(const char* typeEncoding);
 
+    _NSInvocationFrameLayout(NSMethodSignature* methodSignature);
+
+public:
+    size_t frameLength;
+    size_t returnLength;
+    unsigned int returnType;
+    unsigned int fpRegisterCount; // single-precision float registers in use
+
+    bool structReturn;
+    _NSInvocationAllocationExtent structReturnExtent;
+    std::vector<_NSInvocationArgumentLayout> arguments;
+
+    static const _NSInvocationFrameLayout* forMethodSignature(NSMethodSignature* methodSignature);
+};
+
+// It is a _NSInvocationCallFrame's job to hold argument values at the extents described by its layout.
+class _NSInvocationCallFrame {
+private:
+    const _NSInvocationFrameLayout* _layout;
+    uint8_t* _buffer;
+
 public:
     _NSInvocationCallFrame(NSMethodSignature* methodTypeEncoding);
     ~_NSInvocationCallFrame();
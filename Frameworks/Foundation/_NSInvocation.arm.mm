@@ -153,52 +153,51 @@ static return_type _getReturnType(const char* typeEncoding) {
     return RETURN_TYPE_NONE;
 }
 
-_NSInvocationCallFrame::_NSInvocationCallFrame(NSMethodSignature* methodSignature)
-    : _methodSignature(methodSignature),
-      gprUsage(0),
-      spUsage(0),
-      stackBytes(0),
-      _structReturn(false),
-      _allocationExtents([methodSignature numberOfArguments]) {
-    _returnType = _getReturnType([_methodSignature methodReturnType]);
-
-    _returnLength = [_methodSignature methodReturnLength];
-
-    if (_returnType == RETURN_TYPE_STRUCT) {
-        _structReturn = true;
-        _structReturnExtent = _allocateArgument("^v");
-    } else if (_returnType == RETURN_TYPE_VFP_HOMOGENOUS) {
+_NSInvocationFrameLayout::_NSInvocationFrameLayout(NSMethodSignature* methodSignature)
+    : gprUsage(0), spUsage(0), stackBytes(0), structReturn(false), arguments([methodSignature numberOfArguments]) {
+    returnType = _getReturnType([methodSignature methodReturnType]);
+
+    returnLength = [methodSignature methodReturnLength];
+
+    if (returnType == RETURN_TYPE_STRUCT) {
+        structReturn = true;
+        structReturnExtent = _allocateArgument("^v");
+    } else if (returnType == RETURN_TYPE_VFP_HOMOGENOUS) {
         // Promote all homogenous vfp returns to the size of all four double-width registers
-        _returnLength = std::max(sizeof(double) * 4, _returnLength);
-    } else if (_returnType != RETURN_TYPE_NONE) {
+        returnLength = std::max(sizeof(double) * 4, returnLength);
+    } else if (returnType != RETURN_TYPE_NONE) {
         // Promote all non-stret return lengths to one machine word.
-        _returnLength = std::max(sizeof(uintptr_t), _returnLength);
+        returnLength = std::max(sizeof(uintptr_t), returnLength);
     }
 
     size_t length = 0;
 
-    unsigned int nArguments = [_methodSignature numberOfArguments];
+    unsigned int nArguments = [methodSignature numberOfArguments];
     for (unsigned int i = 0; i < nArguments; ++i) {
         // Some arguments are <4 bytes, but we need to make sure that we only allocate in register-width chunks.
-        auto& extent = _allocationExtents[i] = std::move(_allocateArgument([_methodSignature getArgumentTypeAtIndex:i]));
-        if (length < extent.offset + extent.length) {
-            length = extent.offset + extent.length;
+        const char* type = [methodSignature getArgumentTypeAtIndex:i];
+        auto& argument = arguments[i] = { _allocateArgument(type), objc_sizeof_type(type), type[0] };
+        if (length < argument.extent.offset + argument.extent.length) {
+            length = argument.extent.offset + argument.extent.length;
         }
     }
 
     // Because of how _CallFrame_Internal loads the registers, we
     // always allocate enough space for them.
-    length = std::max(length, g_gprLength + g_sfprLength);
+    frameLength = std::max(length, g_gprLength + g_sfprLength);
+    fpRegisterCount = spUsage.count();
+}
 
-    _length = length;
-    _buffer = static_cast<uint8_t*>(IwCalloc(length, 1));
+_NSInvocationCallFrame::_NSInvocationCallFrame(NSMethodSignature* methodSignature)
+    : _layout(_NSInvocationFrameLayout::forMethodSignature(methodSignature)) {
+    _buffer = static_cast<uint8_t*>(IwCalloc(_layout->frameLength, 1));
 }
 
 _NSInvocationCallFrame::~_NSInvocationCallFrame() {
     IwFree(_buffer);
 }
 
-_NSInvocationAllocationExtent _NSInvocationCallFrame::_allocateStackWords(size_t count, size_t alignment) {
+_NSInvocationAllocationExtent _NSInvocationFrameLayout::_allocateStackWords(size_t count, size_t alignment) {
     stackBytes = NSINVOCATION_ALIGN(stackBytes, alignment);
     _NSInvocationAllocationExtent extent{ g_sfprLength + g_gprLength + stackBytes, count * sizeof(uintptr_t) };
     stackBytes += extent.length;
@@ -206,7 +205,7 @@ _NSInvocationAllocationExtent _NSInvocationCallFrame::_allocateStackWords(size_t
     return extent;
 }
 
-_NSInvocationAllocationExtent _NSInvocationCallFrame::_allocateMachineWords(unsigned int count, size_t alignment) {
+_NSInvocationAllocationExtent _NSInvocationFrameLayout::_allocateMachineWords(unsigned int count, size_t alignment) {
     // ARM: Many cases.
     // 1. #words < 4*remaining_reg = all in registers (consecutive)
     // 2. #words > 4*remaining_reg =
@@ -246,7 +245,7 @@ redo:
     }
 }
 
-_NSInvocationAllocationExtent _NSInvocationCallFrame::_allocateFloats(size_t count) {
+_NSInvocationAllocationExtent _NSInvocationFrameLayout::_allocateFloats(size_t count) {
     size_t nreg = 0;
 redo:
     nreg = firstUnused(spUsage, nreg);
@@ -270,7 +269,7 @@ redo:
     }
 }
 
-_NSInvocationAllocationExtent _NSInvocationCallFrame::_allocateDoubles(size_t count) {
+_NSInvocationAllocationExtent _NSInvocationFrameLayout::_allocateDoubles(size_t count) {
     unsigned int nreg = firstUnused(spUsage);
     if (nreg % 2 == 1) {
         ++nreg; // doubles take up even-numbered single-precision registers.
@@ -291,7 +290,7 @@ _NSInvocationAllocationExtent _NSInvocationCallFrame::_allocateDoubles(size_t co
     }
 }
 
-_NSInvocationAllocationExtent _NSInvocationCallFrame::_allocateArgument(const char* typeEncoding) {
+_NSInvocationAllocationExtent _NSInvocationFrameLayout::_allocateArgument(const char* typeEncoding) {
     switch (typeEncoding[0]) {
         // All integral types < qword are promoted.
         case _C_BOOL:
@@ -338,9 +337,8 @@ _NSInvocationAllocationExtent _NSInvocationCallFrame::_allocateArgument(const ch
 }
 
 void _NSInvocationCallFrame::storeArgument(const void* value, unsigned int index) {
-    auto& extent = _allocationExtents[index];
-    const char* type = [_methodSignature getArgumentTypeAtIndex:index];
-    size_t size = objc_sizeof_type(type);
+    auto& argument = _layout->arguments[index];
+    size_t size = argument.size;
 
     union {
         uintptr_t u;
@@ -348,7 +346,7 @@ void _NSInvocationCallFrame::storeArgument(const void* value, unsigned int index
     } itou; // "i" to "u"
 
     { // integral arguments less than 4 bytes in width need sign- or zero-extension.
-        switch (type[0]) {
+        switch (argument.type) {
             case _C_CHR:
                 itou.i = *(signed char*)value;
                 value = &itou.i;
@@ -375,34 +373,32 @@ void _NSInvocationCallFrame::storeArgument(const void* value, unsigned int index
         }
     }
 
-    memcpy(_buffer + extent.offset, value, size);
+    memcpy(_buffer + argument.extent.offset, value, size);
 }
 
 void _NSInvocationCallFrame::loadArgument(void* value, unsigned int index) const {
-    auto& extent = _allocationExtents[index];
-    const char* type = [_methodSignature getArgumentTypeAtIndex:index];
-    size_t size = objc_sizeof_type(type);
-    memcpy(value, _buffer + extent.offset, size);
+    auto& argument = _layout->arguments[index];
+    memcpy(value, _buffer + argument.extent.offset, argument.size);
 }
 
 size_t _NSInvocationCallFrame::getReturnLength() const {
-    return _returnLength;
+    return _layout->returnLength;
 }
 
 bool _NSInvocationCallFrame::getRequiresStructReturn() const {
-    return _structReturn;
+    return _layout->structReturn;
 }
 
 void _NSInvocationCallFrame::copyInExistingFrame(void* frame) {
     // On x86, we can copy the frame as-is; for ARM we have to only copy the allocated portions.
     uint8_t* base = _buffer;
-    for(auto& extent: _allocationExtents) {
-        memcpy(base + extent.offset, (uint8_t*)frame + extent.offset, extent.length);
+    for (auto& argument : _layout->arguments) {
+        memcpy(base + argument.extent.offset, (uint8_t*)frame + argument.extent.offset, argument.extent.length);
     }
 }
 
 unsigned int _NSInvocationCallFrame::getOpaquePlatformReturnType() const {
-    return _returnType;
+    return _layout->returnType;
 }
 
 struct armFrame {
@@ -416,7 +412,7 @@ struct armFrame {
 
 void _NSInvocationCallFrame::execute(void* functionPointer, void* returnValuePointer) const {
     // alloca is guaranteed to give us a 16-byte aligned return.
-    size_t frameLength = _length;
+    size_t frameLength = _layout->frameLength;
     size_t promotedFrameLength = NSINVOCATION_ALIGN(frameLength, alignof(struct armFrame));
 
     uint8_t* arena = (uint8_t*)_alloca(promotedFrameLength + sizeof(struct armFrame));
@@ -424,15 +420,15 @@ void _NSInvocationCallFrame::execute(void* functionPointer, void* returnValuePoi
 
     memcpy(arena, _buffer, frameLength);
 
-    if (_structReturn) {
+    if (_layout->structReturn) {
         // populate stret out if necessary. we only do this on the local copy.
-        memcpy(arena + _structReturnExtent.offset, &returnValuePointer, _structReturnExtent.length);
+        memcpy(arena + _layout->structReturnExtent.offset, &returnValuePointer, _layout->structReturnExtent.length);
     }
 
     frame->returnValue = returnValuePointer;
-    frame->returnType = _returnType;
+    frame->returnType = _layout->returnType;
 
-    unsigned int fpCount = spUsage.count();
+    unsigned int fpCount = _layout->fpRegisterCount;
     if (fpCount > 0) {
         _CallFrameInternal_VFP(arena, frame, functionPointer, (fpCount + 1) / 2 /* ceil */);
     } else {
@@ -23,23 +23,34 @@
 #import <algorithm>
 #import <vector>
 
-// It is a _NSInvocationCallFrame's job to carve out allocation extents from a buffer.
-class _NSInvocationCallFrame {
+// The frame layout for a method signature. It is computed once per signature and shared by every
+// _NSInvocationCallFrame built from it.
+class _NSInvocationFrameLayout {
 private:
-    // Reference guaranteed owned by NSInvocation
-    NSMethodSignature* _methodSignature;
-
-    uint8_t* _buffer;
     off_t _offset;
-    size_t _returnLength;
-    unsigned int _returnType; /* platform-specific/opaque */
-
-    bool _structReturn;
-    _NSInvocationAllocationExtent _structReturnExtent;
-    std::vector<_NSInvocationAllocationExtent> _allocationExtents;
 
     _NSInvocationAllocationExtent _allocateArgument(const char* objcTypeEncoding);
 
+    _NSInvocationFrameLayout(NSMethodSignature* methodSignature);
+
+public:
+    size_t frameLength;
+    size_t returnLength;
+    unsigned int returnType; /* platform-specific/opaque */
+
+    bool structReturn;
+    _NSInvocationAllocationExtent structReturnExtent;
+    std::vector<_NSInvocationArgumentLayout> arguments;
+
+    static const _NSInvocationFrameLayout* forMethodSignature(NSMethodSignature* methodSignature);
+};
+
+// It is a _NSInvocationCallFrame's job to hold argument values at the extents described by its layout.
+class _NSInvocationCallFrame {
+private:
+    const _NSInvocationFrameLayout* _layout;
+    uint8_t* _buffer;
+
 public:
     _NSInvocationCallFrame(NSMethodSignature* methodTypeEncoding);
     ~_NSInvocationCallFrame();
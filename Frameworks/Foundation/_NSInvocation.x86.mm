@@ -96,34 +96,31 @@ static return_type _getReturnType(const char* typeEncoding) {
     return RETURN_TYPE_NONE;
 }
 
-_NSInvocationCallFrame::_NSInvocationCallFrame(NSMethodSignature* methodSignature)
-    : _methodSignature(methodSignature), _offset(0), _structReturn(false), _allocationExtents([_methodSignature numberOfArguments]) {
-    _returnType = _getReturnType([_methodSignature methodReturnType]);
-    _returnLength = [_methodSignature methodReturnLength];
+_NSInvocationFrameLayout::_NSInvocationFrameLayout(NSMethodSignature* methodSignature)
+    : _offset(0), structReturn(false), arguments([methodSignature numberOfArguments]) {
+    returnType = _getReturnType([methodSignature methodReturnType]);
+    returnLength = [methodSignature methodReturnLength];
 
     // 1, 2, 4, and 8-byte structs are returned in registers.
-    if (_returnType == RETURN_TYPE_STRUCT) {
-        _structReturn = true;
-        _structReturnExtent = _allocateArgument("^v");
-    } else if (_returnType != RETURN_TYPE_NONE) {
+    if (returnType == RETURN_TYPE_STRUCT) {
+        structReturn = true;
+        structReturnExtent = _allocateArgument("^v");
+    } else if (returnType != RETURN_TYPE_NONE) {
         // Promote all non-stret return lengths to one machine word.
-        _returnLength = std::max(sizeof(uintptr_t), _returnLength);
+        returnLength = std::max(sizeof(uintptr_t), returnLength);
     }
 
-    unsigned int nArguments = [_methodSignature numberOfArguments];
+    unsigned int nArguments = [methodSignature numberOfArguments];
     for (unsigned int i = 0; i < nArguments; ++i) {
-        _allocationExtents[i] = std::move(_allocateArgument([_methodSignature getArgumentTypeAtIndex:i]));
+        const char* type = [methodSignature getArgumentTypeAtIndex:i];
+        arguments[i] = { _allocateArgument(type), objc_sizeof_type(type), type[0] };
     }
 
-    _buffer = static_cast<uint8_t*>(IwCalloc(_offset, 1));
-};
-
-_NSInvocationCallFrame::~_NSInvocationCallFrame() {
-    IwFree(_buffer);
+    frameLength = _offset;
 }
 
 /* private */
-_NSInvocationAllocationExtent _NSInvocationCallFrame::_allocateArgument(const char* objcTypeEncoding) {
+_NSInvocationAllocationExtent _NSInvocationFrameLayout::_allocateArgument(const char* objcTypeEncoding) {
     size_t nWords = std::max(1U, objc_aligned_size(objcTypeEncoding) / sizeof(uintptr_t));
     size_t length = nWords * sizeof(uintptr_t);
 
@@ -132,10 +129,18 @@ _NSInvocationAllocationExtent _NSInvocationCallFrame::_allocateArgument(const ch
     return extent;
 }
 
+_NSInvocationCallFrame::_NSInvocationCallFrame(NSMethodSignature* methodSignature)
+    : _layout(_NSInvocationFrameLayout::forMethodSignature(methodSignature)) {
+    _buffer = static_cast<uint8_t*>(IwCalloc(_layout->frameLength, 1));
+};
+
+_NSInvocationCallFrame::~_NSInvocationCallFrame() {
+    IwFree(_buffer);
+}
+
 void _NSInvocationCallFrame::storeArgument(const void* value, unsigned int index) {
-    auto& extent = _allocationExtents[index];
-    const char* type = [_methodSignature getArgumentTypeAtIndex:index];
-    size_t size = objc_sizeof_type(type);
+    auto& argument = _layout->arguments[index];
+    size_t size = argument.size;
 
     union {
         uintptr_t u;
@@ -143,7 +148,7 @@ void _NSInvocationCallFrame::storeArgument(const void* value, unsigned int index
     } itou; // "i" to "u"
 
     { // integral arguments less than 4 bytes in width need sign- or zero-extension.
-        switch (type[0]) {
+        switch (argument.type) {
             case _C_CHR:
                 itou.i = *(signed char*)value;
                 value = &itou.i;
@@ -170,46 +175,44 @@ void _NSInvocationCallFrame::storeArgument(const void* value, unsigned int index
         }
     }
 
-    memcpy(_buffer + extent.offset, value, size);
+    memcpy(_buffer + argument.extent.offset, value, size);
 }
 
 void _NSInvocationCallFrame::loadArgument(void* value, unsigned int index) const {
-    auto& extent = _allocationExtents[index];
-    const char* type = [_methodSignature getArgumentTypeAtIndex:index];
-    size_t size = objc_sizeof_type(type);
-    memcpy(value, _buffer + extent.offset, size);
+    auto& argument = _layout->arguments[index];
+    memcpy(value, _buffer + argument.extent.offset, argument.size);
 }
 
 size_t _NSInvocationCallFrame::getReturnLength() const {
-    return _returnLength;
+    return _layout->returnLength;
 }
 
 bool _NSInvocationCallFrame::getRequiresStructReturn() const {
-    return _structReturn;
+    return _layout->structReturn;
 }
 
 void _NSInvocationCallFrame::copyInExistingFrame(void* frame) {
-    memcpy(_buffer, frame, _offset);
+    memcpy(_buffer, frame, _layout->frameLength);
 }
 
 unsigned int _NSInvocationCallFrame::getOpaquePlatformReturnType() const {
-    return _returnType;
+    return _layout->returnType;
 }
 
 void _NSInvocationCallFrame::execute(void* functionPointer, void* returnValuePointer) const {
-    size_t frameLength = _offset;
+    size_t frameLength = _layout->frameLength;
 
     // alloca is guaranteed to give us a 16-byte aligned return.
     uint8_t* stack = (uint8_t*)alloca(frameLength + sizeof(struct x86Frame));
     x86Frame* frame = (x86Frame*)(stack + frameLength);
 
     memcpy(stack, _buffer, frameLength);
-    if (_structReturn) {
+    if (_layout->structReturn) {
         // populate stret out if necessary. we only do this on the local copy.
-        memcpy(stack + _structReturnExtent.offset, &returnValuePointer, _structReturnExtent.length);
+        memcpy(stack + _layout->structReturnExtent.offset, &returnValuePointer, _layout->structReturnExtent.length);
     }
 
-    *frame = { 0, 0, 0, _returnType, _returnLength, returnValuePointer, functionPointer };
+    *frame = { 0, 0, 0, _layout->returnType, _layout->returnLength, returnValuePointer, functionPointer };
 
     _CallFrameInternal(frame, stack);
 }
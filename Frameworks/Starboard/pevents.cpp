@@ -34,11 +34,12 @@ THE SOFTWARE.
 #include "pevents.h"
 #include <assert.h>
 #include <errno.h>
+#include <atomic>
 #include <sys/time.h>
 #include <sys/timespec.h>
 #ifdef WFMO
 #include <algorithm>
-#include <deque>
+#include <vector>
 #include "LoggingNative.h"
 
 static const wchar_t* TAG = L"pevents";
@@ -47,19 +48,27 @@ static const wchar_t* TAG = L"pevents";
 
 namespace neosmart {
 #ifdef WFMO
+// One per thread, reused by every WaitForMultipleEvents call on that thread.
+// A waiter is only ever registered with events while its thread is inside WaitForMultipleEvents,
+// and removes its registrations before returning, so events never see a stale waiter.
 struct neosmart_wfmo_t_ {
     pthread_mutex_t Mutex;
     pthread_cond_t CVariable;
-    union {
-        int FiredEvent; // WFSO
-        int EventsLeft; // WFMO
-    } Status;
+    int FiredEvent; // WFSO
+    int EventsLeft; // WFMO
     bool StillWaiting;
-    int RefCount;
     bool WaitAll;
     int WakeupSocket;
 
-    void Destroy() {
+    neosmart_wfmo_t_() {
+        int ret = pthread_mutex_init(&Mutex, 0);
+        assert(ret == 0);
+
+        ret = pthread_cond_init(&CVariable, 0);
+        assert(ret == 0);
+    }
+
+    ~neosmart_wfmo_t_() {
         int ret = pthread_mutex_destroy(&Mutex);
         if (ret != 0) {
             TraceError(TAG, L"pevents mutex destroy error: %d", ret);
@@ -85,44 +94,36 @@ struct neosmart_event_t_ {
     bool AutoReset;
     pthread_cond_t CVariable;
     pthread_mutex_t Mutex;
-    bool State;
+
+    // State is published with atomics so that signalled events can be taken, and events with no waiters
+    // signalled, without taking Mutex. Anyone that goes to sleep on the event bumps Waiters (under Mutex)
+    // before its final check of State; SetEvent sets State before checking Waiters. One of the two is
+    // therefore guaranteed to see the other.
+    std::atomic<bool> State;
+    std::atomic<int> Waiters;
 #ifdef WFMO
-    std::deque<neosmart_wfmo_info_t_> RegisteredWaits;
+    std::vector<neosmart_wfmo_info_t_> RegisteredWaits;
 #endif
 };
 
-#ifdef WFMO
-bool RemoveExpiredWaitHelper(neosmart_wfmo_info_t_ wait) {
-    int result = pthread_mutex_trylock(&wait.Waiter->Mutex);
-
-    if (result == EBUSY) {
+// Takes the event if it's signalled, resetting it if it's an auto-reset event.
+static bool TryAcquireEvent(neosmart_event_t event) {
+    if (!event->State.load()) {
         return false;
     }
 
-    assert(result == 0);
-
-    if (wait.Waiter->StillWaiting == false) {
-        --wait.Waiter->RefCount;
-        assert(wait.Waiter->RefCount >= 0);
-        if (wait.Waiter->RefCount == 0) {
-            result = pthread_mutex_unlock(&wait.Waiter->Mutex);
-            assert(result == 0);
-            wait.Waiter->Destroy();
-            delete wait.Waiter;
-        } else {
-            result = pthread_mutex_unlock(&wait.Waiter->Mutex);
-            assert(result == 0);
-        }
+    return !event->AutoReset || event->State.exchange(false);
+}
 
-        return true;
-    }
+static void GetAbsoluteTimeout(uint64_t milliseconds, timespec& ts) {
+    EbrTimeval tv;
+    EbrGetTimeOfDay(&tv);
 
-    result = pthread_mutex_unlock(&wait.Waiter->Mutex);
-    assert(result == 0);
+    uint64_t nanoseconds = ((uint64_t)tv.tv_sec) * 1000 * 1000 * 1000 + milliseconds * 1000 * 1000 + ((uint64_t)tv.tv_usec) * 1000;
 
-    return false;
+    ts.tv_sec = long(nanoseconds / 1000 / 1000 / 1000);
+    ts.tv_nsec = long(nanoseconds - ((uint64_t)ts.tv_sec) * 1000 * 1000 * 1000);
 }
-#endif
 
 neosmart_event_t NeoCreateEvent(bool manualReset, bool initialState) {
     neosmart_event_t event = new neosmart_event_t_;
@@ -134,6 +135,7 @@ neosmart_event_t NeoCreateEvent(bool manualReset, bool initialState) {
     assert(result == 0);
 
     event->State = false;
+    event->Waiters = 0;
     event->AutoReset = !manualReset;
 
     if (initialState) {
@@ -145,61 +147,49 @@ neosmart_event_t NeoCreateEvent(bool manualReset, bool initialState) {
 }
 
 int UnlockedWaitForEvent(neosmart_event_t event, uint64_t milliseconds) {
-    int result = 0;
-    if (!event->State) {
-        // Zero-timeout event state check optimization
-        if (milliseconds == 0) {
-            return ETIMEDOUT;
-        }
+    if (TryAcquireEvent(event)) {
+        return 0;
+    }
 
-        timespec ts;
-        if (milliseconds != (uint64_t)-1) {
-            EbrTimeval tv;
-            EbrGetTimeOfDay(&tv);
+    // Zero-timeout event state check optimization
+    if (milliseconds == 0) {
+        return ETIMEDOUT;
+    }
 
-            uint64_t nanoseconds = ((uint64_t)tv.tv_sec) * 1000 * 1000 * 1000 + milliseconds * 1000 * 1000 + ((uint64_t)tv.tv_usec) * 1000;
+    timespec ts;
+    if (milliseconds != (uint64_t)-1) {
+        GetAbsoluteTimeout(milliseconds, ts);
+    }
 
-            ts.tv_sec = long(nanoseconds / 1000 / 1000 / 1000);
-            ts.tv_nsec = long(nanoseconds - ((uint64_t)ts.tv_sec) * 1000 * 1000 * 1000);
+    int result = 0;
+    ++event->Waiters;
+    while (!TryAcquireEvent(event)) {
+        // Regardless of whether it's an auto-reset or manual-reset event:
+        // wait to obtain the event, then lock anyone else out
+        if (milliseconds != (uint64_t)-1) {
+            result = pthread_cond_timedwait(&event->CVariable, &event->Mutex, &ts);
+        } else {
+            result = pthread_cond_wait(&event->CVariable, &event->Mutex);
         }
 
-        do {
-            // Regardless of whether it's an auto-reset or manual-reset event:
-            // wait to obtain the event, then lock anyone else out
-            if (milliseconds != (uint64_t)-1) {
-                result = pthread_cond_timedwait(&event->CVariable, &event->Mutex, &ts);
-            } else {
-                result = pthread_cond_wait(&event->CVariable, &event->Mutex);
-            }
-        } while (result == 0 && !event->State);
-
-        if (result == 0 && event->AutoReset) {
-            // We've only accquired the event if the wait succeeded
-            event->State = false;
+        if (result != 0) {
+            break;
         }
-    } else if (event->AutoReset) {
-        // It's an auto-reset event that's currently available;
-        // we need to stop anyone else from using it
-        result = 0;
-        event->State = false;
     }
-    // Else we're trying to obtain a manual reset event with a signalled state;
-    // don't do anything
+    --event->Waiters;
 
     return result;
 }
 
 int WaitForEvent(neosmart_event_t event, uint64_t milliseconds) {
-    int tempResult;
-    if (milliseconds == 0) {
-        tempResult = pthread_mutex_trylock(&event->Mutex);
-        if (tempResult == EBUSY) {
-            return ETIMEDOUT;
-        }
-    } else {
-        tempResult = pthread_mutex_lock(&event->Mutex);
+    // Signalled events, and polls of unsignalled ones, don't need the lock
+    if (TryAcquireEvent(event)) {
+        return 0;
+    } else if (milliseconds == 0) {
+        return ETIMEDOUT;
     }
 
+    int tempResult = pthread_mutex_lock(&event->Mutex);
     assert(tempResult == 0);
 
     int result = UnlockedWaitForEvent(event, milliseconds);
@@ -216,154 +206,161 @@ int WaitForMultipleEvents(neosmart_event_t* events, int count, bool waitAll, uin
     return WaitForMultipleEvents(events, count, waitAll, milliseconds, unused, NULL);
 }
 
-int WaitForMultipleEvents(neosmart_event_t* events, int count, bool waitAll, uint64_t milliseconds, int& waitIndex, SocketWait* sockets) {
-    neosmart_wfmo_t wfmo = new neosmart_wfmo_t_;
-
-    int result = 0;
-    int tempResult = pthread_mutex_init(&wfmo->Mutex, 0);
+static void UnregisterWait(neosmart_event_t event, neosmart_wfmo_t wfmo, int waitIndex) {
+    int tempResult = pthread_mutex_lock(&event->Mutex);
     assert(tempResult == 0);
 
-    tempResult = pthread_cond_init(&wfmo->CVariable, 0);
-    assert(tempResult == 0);
+    // SetEvent drops the registration itself when it hands the event to us
+    for (auto cur = event->RegisteredWaits.begin(); cur != event->RegisteredWaits.end(); ++cur) {
+        if (cur->Waiter == wfmo && cur->WaitIndex == waitIndex) {
+            event->RegisteredWaits.erase(cur);
+            --event->Waiters;
+            break;
+        }
+    }
 
-    neosmart_wfmo_info_t_ waitInfo;
-    waitInfo.Waiter = wfmo;
-    waitInfo.WaitIndex = -1;
+    tempResult = pthread_mutex_unlock(&event->Mutex);
+    assert(tempResult == 0);
+}
 
-    wfmo->WaitAll = waitAll;
-    wfmo->StillWaiting = true;
-    wfmo->RefCount = 1;
-    wfmo->WakeupSocket = -1;
+int WaitForMultipleEvents(neosmart_event_t* events, int count, bool waitAll, uint64_t milliseconds, int& waitIndex, SocketWait* sockets) {
+    waitIndex = -1;
     if (sockets) {
-        wfmo->WakeupSocket = sockets->WakeupSocketWrite;
         sockets->result = -1;
     }
 
-    if (waitAll) {
-        wfmo->Status.EventsLeft = count;
-    } else {
-        wfmo->Status.FiredEvent = -1;
+    // Fast path: take the first signalled event without locking anything
+    if (!waitAll) {
+        for (int i = 0; i < count; ++i) {
+            if (TryAcquireEvent(events[i])) {
+                waitIndex = i;
+                return 0;
+            }
+        }
+
+        if (milliseconds == 0) {
+            return ETIMEDOUT;
+        }
     }
 
-    tempResult = pthread_mutex_lock(&wfmo->Mutex);
-    assert(tempResult == 0);
+    static thread_local neosmart_wfmo_t_ s_waiter;
+    neosmart_wfmo_t wfmo = &s_waiter;
 
-    bool done = false;
-    waitIndex = -1;
+    int result = 0;
+    int tempResult = pthread_mutex_lock(&wfmo->Mutex);
+    assert(tempResult == 0);
 
-    for (int i = 0; i < count; ++i) {
-        waitInfo.WaitIndex = i;
+    wfmo->WaitAll = waitAll;
+    wfmo->StillWaiting = true;
+    wfmo->FiredEvent = -1;
+    wfmo->EventsLeft = count;
+    wfmo->WakeupSocket = sockets ? sockets->WakeupSocketWrite : -1;
 
-        // Must not release lock until RegisteredWait is potentially added
-        tempResult = pthread_mutex_lock(&events[i]->Mutex);
-        assert(tempResult == 0);
+    tempResult = pthread_mutex_unlock(&wfmo->Mutex);
+    assert(tempResult == 0);
 
-        // Before adding this wait to the list of registered waits, let's clean up old, expired waits while we have the
-        // event lock anyway
-        events[i]->RegisteredWaits.erase(std::remove_if(events[i]->RegisteredWaits.begin(),
-                                                        events[i]->RegisteredWaits.end(),
-                                                        RemoveExpiredWaitHelper),
-                                         events[i]->RegisteredWaits.end());
+    // Register with each event in turn. Events are always locked before the waiter (as in SetEvent), so
+    // the waiter lock is taken inside each event's lock to find out whether an event we've already
+    // registered with has fired in the meantime.
+    int registered = 0;
+    for (; registered < count; ++registered) {
+        neosmart_event_t event = events[registered];
 
-        if (UnlockedWaitForEvent(events[i], 0) == 0) {
-            tempResult = pthread_mutex_unlock(&events[i]->Mutex);
-            assert(tempResult == 0);
+        tempResult = pthread_mutex_lock(&event->Mutex);
+        assert(tempResult == 0);
+        tempResult = pthread_mutex_lock(&wfmo->Mutex);
+        assert(tempResult == 0);
 
-            if (waitAll) {
-                --wfmo->Status.EventsLeft;
-                assert(wfmo->Status.EventsLeft >= 0);
+        bool done = !wfmo->StillWaiting;
+        if (!done) {
+            ++event->Waiters;
+            if (TryAcquireEvent(event)) {
+                --event->Waiters;
+                if (waitAll) {
+                    --wfmo->EventsLeft;
+                    assert(wfmo->EventsLeft >= 0);
+                    wfmo->StillWaiting = wfmo->EventsLeft != 0;
+                } else {
+                    wfmo->FiredEvent = registered;
+                    wfmo->StillWaiting = false;
+                    done = true;
+                }
             } else {
-                wfmo->Status.FiredEvent = i;
-                waitIndex = i;
-                done = true;
-                break;
+                neosmart_wfmo_info_t_ waitInfo;
+                waitInfo.Waiter = wfmo;
+                waitInfo.WaitIndex = registered;
+                event->RegisteredWaits.push_back(waitInfo);
             }
-        } else {
-            events[i]->RegisteredWaits.push_back(waitInfo);
-            ++wfmo->RefCount;
+        }
 
-            tempResult = pthread_mutex_unlock(&events[i]->Mutex);
-            assert(tempResult == 0);
+        tempResult = pthread_mutex_unlock(&wfmo->Mutex);
+        assert(tempResult == 0);
+        tempResult = pthread_mutex_unlock(&event->Mutex);
+        assert(tempResult == 0);
+
+        if (done) {
+            break;
         }
     }
 
+    tempResult = pthread_mutex_lock(&wfmo->Mutex);
+    assert(tempResult == 0);
+
     timespec ts;
-    if (!done) {
+    if (wfmo->StillWaiting) {
         if (milliseconds == 0) {
             result = ETIMEDOUT;
-            done = true;
         } else if (milliseconds != (uint64_t)-1) {
-            EbrTimeval tv;
-            EbrGetTimeOfDay(&tv);
-
-            uint64_t nanoseconds = ((uint64_t)tv.tv_sec) * 1000 * 1000 * 1000 + milliseconds * 1000 * 1000 + ((uint64_t)tv.tv_usec) * 1000;
-
-            ts.tv_sec = long(nanoseconds / 1000 / 1000 / 1000);
-            ts.tv_nsec = long(nanoseconds - ((uint64_t)ts.tv_sec) * 1000 * 1000 * 1000);
+            GetAbsoluteTimeout(milliseconds, ts);
         }
     }
 
-    while (!done) {
-        // One (or more) of the events we're monitoring has been triggered?
-
-        // If we're waiting for all events, assume we're done and check if there's an event that hasn't fired
-        // But if we're waiting for just one event, assume we're not done until we find a fired event
-        done = (waitAll && wfmo->Status.EventsLeft == 0) || (!waitAll && wfmo->Status.FiredEvent != -1);
-
-        if (!done) {
-            if (milliseconds != (uint64_t)-1) {
-                if (wfmo->WakeupSocket != -1) {
-                    pthread_mutex_unlock(&wfmo->Mutex);
-                    struct timeval tv;
-                    tv.tv_sec = long(milliseconds / 1000);
-                    tv.tv_usec = (milliseconds % 1000) * 1000;
-                    int selectResult =
-                        select(sockets->max + 1, (fd_set*)sockets->fdread, (fd_set*)sockets->fdwrite, (fd_set*)sockets->fderror, &tv);
-                    pthread_mutex_lock(&wfmo->Mutex);
-                    if (selectResult == -1) {
-                        //  Timeout or error
-                        result = -1;
+    // One (or more) of the events we're monitoring has been triggered?
+    while (wfmo->StillWaiting && result == 0) {
+        if (milliseconds != (uint64_t)-1) {
+            if (wfmo->WakeupSocket != -1) {
+                pthread_mutex_unlock(&wfmo->Mutex);
+                struct timeval tv;
+                tv.tv_sec = long(milliseconds / 1000);
+                tv.tv_usec = (milliseconds % 1000) * 1000;
+                int selectResult =
+                    select(sockets->max + 1, (fd_set*)sockets->fdread, (fd_set*)sockets->fdwrite, (fd_set*)sockets->fderror, &tv);
+                pthread_mutex_lock(&wfmo->Mutex);
+                if (selectResult == -1) {
+                    //  Timeout or error
+                    result = -1;
+                } else {
+                    if (FD_ISSET(sockets->WakeupSocketRead, (fd_set*)sockets->fdread)) {
+                        //  Clear the socket
+                        char buf[256];
+                        while (recv(sockets->WakeupSocketRead, buf, 256, 0) == 256)
+                            ;
+                        result = 0;
                     } else {
-                        if (FD_ISSET(sockets->WakeupSocketRead, (fd_set*)sockets->fdread)) {
-                            //  Clear the socket
-                            char buf[256];
-                            while (recv(sockets->WakeupSocketRead, buf, 256, 0) == 256)
-                                ;
-                            result = 0;
-                        } else {
-                            sockets->result = selectResult;
-                            result = -1;
-                        }
+                        sockets->result = selectResult;
+                        result = -1;
                     }
-                } else {
-                    result = pthread_cond_timedwait(&wfmo->CVariable, &wfmo->Mutex, &ts);
                 }
             } else {
-                result = pthread_cond_wait(&wfmo->CVariable, &wfmo->Mutex);
-            }
-
-            if (result != 0) {
-                break;
+                result = pthread_cond_timedwait(&wfmo->CVariable, &wfmo->Mutex, &ts);
             }
+        } else {
+            result = pthread_cond_wait(&wfmo->CVariable, &wfmo->Mutex);
         }
     }
 
-    waitIndex = wfmo->Status.FiredEvent;
-    if (waitIndex != -1) {
+    // Stop SetEvent from handing us any more events before we unregister
+    wfmo->StillWaiting = false;
+    if (waitAll ? wfmo->EventsLeft == 0 : wfmo->FiredEvent != -1) {
         result = 0;
     }
-    wfmo->StillWaiting = false;
+    waitIndex = wfmo->FiredEvent;
 
-    --wfmo->RefCount;
-    assert(wfmo->RefCount >= 0);
-    if (wfmo->RefCount == 0) {
-        pthread_mutex_unlock(&wfmo->Mutex);
+    tempResult = pthread_mutex_unlock(&wfmo->Mutex);
+    assert(tempResult == 0);
 
-        wfmo->Destroy();
-        delete wfmo;
-    } else {
-        tempResult = pthread_mutex_unlock(&wfmo->Mutex);
-        assert(tempResult == 0);
+    for (int i = 0; i < registered; ++i) {
+        UnregisterWait(events[i], wfmo, i);
     }
 
     return result;
@@ -375,24 +372,8 @@ int DestroyEvent(neosmart_event_t event) {
     assert(result == 0);
 
 #ifdef WFMO
-    while (!event->RegisteredWaits.empty()) {
-        neosmart_wfmo_info_t i = &event->RegisteredWaits.front();
-
-        result = pthread_mutex_lock(&i->Waiter->Mutex);
-        assert(result == 0);
-
-        --i->Waiter->RefCount;
-        assert(i->Waiter->RefCount >= 0);
-        if (i->Waiter->RefCount == 0) {
-            pthread_mutex_unlock(&i->Waiter->Mutex);
-            i->Waiter->Destroy();
-            delete i->Waiter;
-        } else {
-            result = pthread_mutex_unlock(&i->Waiter->Mutex);
-            assert(result == 0);
-        }
-        event->RegisteredWaits.pop_front();
-    }
+    // Registered waits belong to threads still blocked in WaitForMultipleEvents, which own them
+    event->RegisteredWaits.clear();
 #endif
     result = pthread_mutex_unlock(&event->Mutex);
     assert(result == 0);
@@ -409,60 +390,61 @@ int DestroyEvent(neosmart_event_t event) {
 }
 
 int SetEvent(neosmart_event_t event) {
-    int result = pthread_mutex_lock(&event->Mutex);
-    assert(result == 0);
-
-    event->State = true;
-
     // Depending on the event type, we either trigger everyone or only one
     if (event->AutoReset) {
+        event->State = true;
+
+        // Nobody is waiting; whoever waits next will find the event signalled
+        if (event->Waiters.load() == 0) {
+            return 0;
+        }
+
+        int result = pthread_mutex_lock(&event->Mutex);
+        assert(result == 0);
+
 #ifdef WFMO
-        while (!event->RegisteredWaits.empty()) {
-            neosmart_wfmo_info_t i = &event->RegisteredWaits.front();
+        // Hand the event to the first waiter that still wants it. Waiters that have already been satisfied
+        // elsewhere unregister themselves, so just skip them.
+        for (auto cur = event->RegisteredWaits.begin(); cur != event->RegisteredWaits.end(); ++cur) {
+            neosmart_wfmo_info_t i = &*cur;
 
             result = pthread_mutex_lock(&i->Waiter->Mutex);
             assert(result == 0);
 
-            --i->Waiter->RefCount;
-            assert(i->Waiter->RefCount >= 0);
             if (!i->Waiter->StillWaiting) {
-                if (i->Waiter->RefCount == 0) {
-                    pthread_mutex_unlock(&i->Waiter->Mutex);
-                    i->Waiter->Destroy();
-                    delete i->Waiter;
-                } else {
-                    result = pthread_mutex_unlock(&i->Waiter->Mutex);
-                    assert(result == 0);
-                }
-                event->RegisteredWaits.pop_front();
+                result = pthread_mutex_unlock(&i->Waiter->Mutex);
+                assert(result == 0);
                 continue;
             }
 
-            event->State = false;
+            // Someone may have taken the event without the lock since it was signalled
+            bool acquired = event->State.exchange(false);
+            if (acquired) {
+                if (i->Waiter->WaitAll) {
+                    --i->Waiter->EventsLeft;
+                    assert(i->Waiter->EventsLeft >= 0);
+                    i->Waiter->StillWaiting = i->Waiter->EventsLeft != 0;
+                } else {
+                    i->Waiter->FiredEvent = i->WaitIndex;
+                    i->Waiter->StillWaiting = false;
+                }
 
-            if (i->Waiter->WaitAll) {
-                --i->Waiter->Status.EventsLeft;
-                assert(i->Waiter->Status.EventsLeft >= 0);
-                // We technically should do i->Waiter->StillWaiting = Waiter->Status.EventsLeft != 0
-                // but the only time it'll be equal to zero is if we're the last event, so no one
-                // else will be checking the StillWaiting flag. We're good to go without it.
-            } else {
-                i->Waiter->Status.FiredEvent = i->WaitIndex;
-                i->Waiter->StillWaiting = false;
-            }
+                //  Kick the socket if it has one
+                if (i->Waiter->WakeupSocket != -1) {
+                    send(i->Waiter->WakeupSocket, "x", 1, 0);
+                }
 
-            //  Kick the socket if it has one
-            if (i->Waiter->WakeupSocket != -1) {
-                send(i->Waiter->WakeupSocket, "x", 1, 0);
+                result = pthread_cond_signal(&i->Waiter->CVariable);
+                assert(result == 0);
             }
 
-            result = pthread_cond_signal(&i->Waiter->CVariable);
-            assert(result == 0);
-
             result = pthread_mutex_unlock(&i->Waiter->Mutex);
             assert(result == 0);
 
-            event->RegisteredWaits.pop_front();
+            if (acquired) {
+                event->RegisteredWaits.erase(cur);
+                --event->Waiters;
+            }
 
             result = pthread_mutex_unlock(&event->Mutex);
             assert(result == 0);
@@ -474,65 +456,19 @@ int SetEvent(neosmart_event_t event) {
         if (event->State) {
             result = pthread_cond_signal(&event->CVariable);
             assert(result == 0);
-
-            result = pthread_mutex_unlock(&event->Mutex);
-            assert(result == 0);
-
-            return 0;
         }
+
+        result = pthread_mutex_unlock(&event->Mutex);
+        assert(result == 0);
     } else {
         //
         *((char*)0xBAADF00D) = 0;
 #ifdef WFMO
-#if 0
-for(size_t i = 0; i < event->RegisteredWaits.size(); ++i)
-{
-neosmart_wfmo_info_t info = &event->RegisteredWaits[i];
-
-result = pthread_mutex_lock(&info->Waiter->Mutex);
-assert(result == 0);
-
---info->Waiter->RefCount;
-assert(info->Waiter->RefCount >= 0);
-
-if(!info->Waiter->StillWaiting)
-{
-if(info->Waiter->RefCount == 0)
-{
-pthread_mutex_unlock(&info->Waiter->Mutex);
-info->Waiter->Destroy();
-delete info->Waiter;
-}
-else
-{
-result = pthread_mutex_unlock(&info->Waiter->Mutex);
-assert(result == 0);
-}
-continue;
-}
-
-if(info->Waiter->WaitAll)
-{
---info->Waiter->Status.EventsLeft;
-assert(info->Waiter->Status.EventsLeft >= 0);
-//We technically should do i->Waiter->StillWaiting = Waiter->Status.EventsLeft != 0
-//but the only time it'll be equal to zero is if we're the last event, so no one
-//else will be checking the StillWaiting flag. We're good to go without it.
-}
-else
-{
-info->Waiter->Status.FiredEvent = info->WaitIndex;
-info->Waiter->StillWaiting = false;
-}
+        int result = pthread_mutex_lock(&event->Mutex);
+        assert(result == 0);
 
-result = pthread_cond_signal(&info->Waiter->CVariable);
-assert(result == 0);
+        event->State = true;
 
-result = pthread_mutex_unlock(&info->Waiter->Mutex);
-assert(result == 0);
-}
-event->RegisteredWaits.clear();
-#endif
         result = pthread_cond_broadcast(&event->CVariable);
         assert(result == 0);
 
@@ -545,14 +481,8 @@ event->RegisteredWaits.clear();
 }
 
 int ResetEvent(neosmart_event_t event) {
-    int result = pthread_mutex_lock(&event->Mutex);
-    assert(result == 0);
-
     event->State = false;
 
-    result = pthread_mutex_unlock(&event->Mutex);
-    assert(result == 0);
-
     return 0;
 }
 }
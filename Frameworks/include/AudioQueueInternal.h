@@ -0,0 +1,70 @@
+//******************************************************************************
+//
+// Copyright (c) 2016 Microsoft Corporation. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+#pragma once
+
+#import <AudioToolbox/AudioQueue.h>
+
+#include <functional>
+#include <memory>
+
+// Where an output queue's audio ends up. A sink is fed interleaved, native endian
+// Float32 at the queue's sample rate and channel count, one period at a time, and
+// only ever from the queue's render thread.
+class AudioQueueSink {
+public:
+    virtual ~AudioQueueSink() {
+    }
+
+    virtual OSStatus open(double sampleRate, UInt32 channels, UInt32 periodFrames) = 0;
+
+    // Blocks until the device can take the next period; that wait is what paces rendering
+    virtual OSStatus write(const float* samples, UInt32 frames) = 0;
+
+    virtual void close() = 0;
+
+    // Frames that have been written but not heard yet
+    virtual UInt32 latencyFrames() {
+        return 0;
+    }
+};
+
+typedef std::function<std::unique_ptr<AudioQueueSink>()> AudioQueueSinkFactory;
+
+// Discards everything. A real time sink consumes audio at the sample rate, with two
+// periods of buffering, the way a device would; otherwise write() never blocks.
+std::unique_ptr<AudioQueueSink> AudioQueueCreateNullSink(bool realTime);
+
+// Writes 16 bit PCM to a WAV file, paced like the null sink when realTime is set
+std::unique_ptr<AudioQueueSink> AudioQueueCreateWAVSink(const char* path, bool realTime);
+
+// Sets the factory used by queues created from now on. An empty factory restores the
+// default, which is a real time null sink since there is no device backend yet.
+void AudioQueueSetDefaultSinkFactory(AudioQueueSinkFactory factory);
+std::unique_ptr<AudioQueueSink> AudioQueueCreateDefaultSink();
+
+// Replaces the sink of a queue that is stopped
+OSStatus AudioQueueSetSink(AudioQueueRef queue, std::unique_ptr<AudioQueueSink> sink);
+
+struct AudioQueueRenderStatistics {
+    UInt64 periods; // Periods handed to the sink
+    UInt64 frames;
+    UInt64 underruns; // Periods that ran out of enqueued audio while playing
+    UInt64 underrunFrames; // Silence rendered because of them
+    UInt64 buffersCompleted; // Output callbacks for buffers that were played out
+};
+
+OSStatus AudioQueueGetRenderStatistics(AudioQueueRef queue, AudioQueueRenderStatistics* statistics);
@@ -44,6 +44,7 @@ CF_EXPORT unsigned long _CFDictionaryFastEnumeration(CFDictionaryRef dictionary,
                                                      unsigned long count);
 CF_EXPORT unsigned long _CFSetFastEnumeration(CFSetRef set, NSFastEnumerationState* state, void* stackbuffer, unsigned long count);
 CF_EXPORT Boolean _CFDictionaryIsMutable(CFDictionaryRef dictionary);
+CF_EXPORT Boolean CFDictionaryGetKeyIfPresent(CFDictionaryRef dictionary, const void* key, const void** actualKey);
 CF_EXPORT Boolean _CFArrayIsMutable(CFArrayRef array);
 CF_PRIVATE Boolean __CFCharacterSetIsMutable(CFCharacterSetRef cset);
 CF_EXPORT Boolean _CFDataIsMutable(CFDataRef data);
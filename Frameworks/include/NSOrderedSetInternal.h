@@ -16,13 +16,21 @@
 #pragma once
 
 #import <Foundation/NSOrderedSet.h>
+#import <CoreFoundation/CFDictionary.h>
 #import <Starboard.h>
 
 @interface NSOrderedSet () {
 @package
-    StrongId<NSMutableSet*> _setContainer;
+    // Maps each element (unretained, _arrayContainer owns it) to its index in _arrayContainer, stored inline as the value.
+    woc::unique_cf<CFMutableDictionaryRef> _indexes;
     StrongId<NSMutableArray*> _arrayContainer;
+
+    // Indexes stored in _indexes below this watermark are known to be current. Inserting before the end lowers the watermark
+    // and the stale tail is renumbered lazily by the next lookup that needs it.
+    NSUInteger _validIndexCount;
 }
+
+- (void)_insertObject:(id)object atIndex:(NSUInteger)index;
 @end
 
 @interface _NSProxyOrderedSetArray : NSArray {
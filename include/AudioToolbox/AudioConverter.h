@@ -100,40 +100,40 @@ typedef OSStatus (*AudioConverterComplexInputDataProc)(AudioConverterRef inAudio
 typedef OSStatus (*AudioConverterInputDataProc)(AudioConverterRef inAudioConverter, UInt32* ioDataSize, void** outData, void* inUserData);
 typedef struct AudioConverterPrimeInfo AudioConverterPrimeInfo;
 
-AUDIOTOOLBOX_EXPORT OSStatus AudioConverterDispose(AudioConverterRef inAudioConverter) STUB_METHOD;
+AUDIOTOOLBOX_EXPORT OSStatus AudioConverterDispose(AudioConverterRef inAudioConverter);
 AUDIOTOOLBOX_EXPORT OSStatus AudioConverterNew(const AudioStreamBasicDescription* inSourceFormat,
                                                const AudioStreamBasicDescription* inDestinationFormat,
-                                               AudioConverterRef _Nullable* outAudioConverter) STUB_METHOD;
+                                               AudioConverterRef _Nullable* outAudioConverter);
 AUDIOTOOLBOX_EXPORT OSStatus AudioConverterNewSpecific(const AudioStreamBasicDescription* inSourceFormat,
                                                        const AudioStreamBasicDescription* inDestinationFormat,
                                                        UInt32 inNumberClassDescriptions,
                                                        const AudioClassDescription* inClassDescriptions,
-                                                       AudioConverterRef _Nullable* outAudioConverter) STUB_METHOD;
-AUDIOTOOLBOX_EXPORT OSStatus AudioConverterReset(AudioConverterRef inAudioConverter) STUB_METHOD;
+                                                       AudioConverterRef _Nullable* outAudioConverter);
+AUDIOTOOLBOX_EXPORT OSStatus AudioConverterReset(AudioConverterRef inAudioConverter);
 AUDIOTOOLBOX_EXPORT OSStatus AudioConverterGetProperty(AudioConverterRef inAudioConverter,
                                                        AudioConverterPropertyID inPropertyID,
                                                        UInt32* ioPropertyDataSize,
-                                                       void* outPropertyData) STUB_METHOD;
+                                                       void* outPropertyData);
 AUDIOTOOLBOX_EXPORT OSStatus AudioConverterGetPropertyInfo(AudioConverterRef inAudioConverter,
                                                            AudioConverterPropertyID inPropertyID,
                                                            UInt32* outSize,
-                                                           Boolean* outWritable) STUB_METHOD;
+                                                           Boolean* outWritable);
 AUDIOTOOLBOX_EXPORT OSStatus AudioConverterSetProperty(AudioConverterRef inAudioConverter,
                                                        AudioConverterPropertyID inPropertyID,
                                                        UInt32 inPropertyDataSize,
-                                                       const void* inPropertyData) STUB_METHOD;
+                                                       const void* inPropertyData);
 AUDIOTOOLBOX_EXPORT OSStatus AudioConverterConvertBuffer(AudioConverterRef inAudioConverter,
                                                          UInt32 inInputDataSize,
                                                          const void* inInputData,
                                                          UInt32* ioOutputDataSize,
-                                                         void* outOutputData) STUB_METHOD;
+                                                         void* outOutputData);
 AUDIOTOOLBOX_EXPORT OSStatus AudioConverterFillComplexBuffer(AudioConverterRef inAudioConverter,
                                                              AudioConverterComplexInputDataProc inInputDataProc,
                                                              void* inInputDataProcUserData,
                                                              UInt32* ioOutputDataPacketSize,
                                                              AudioBufferList* outOutputData,
-                                                             AudioStreamPacketDescription* outPacketDescription) STUB_METHOD;
+                                                             AudioStreamPacketDescription* outPacketDescription);
 AUDIOTOOLBOX_EXPORT OSStatus AudioConverterConvertComplexBuffer(AudioConverterRef inAudioConverter,
                                                                 UInt32 inNumberPCMFrames,
                                                                 const AudioBufferList* inInputData,
-                                                                AudioBufferList* outOutputData) STUB_METHOD;
\ No newline at end of file
+                                                                AudioBufferList* outOutputData);
\ No newline at end of file
@@ -114,21 +114,39 @@ enum {
     kAudioQueueProperty_ConverterError = 'qcve'
 };
 
-AUDIOTOOLBOX_EXPORT OSStatus AudioQueueStart(AudioQueueRef inAQ, const AudioTimeStamp* inStartTime) STUB_METHOD;
+typedef struct OpaqueAudioQueueProcessingTap* AudioQueueProcessingTapRef;
+typedef UInt32 AudioQueueProcessingTapFlags;
+enum {
+    kAudioQueueProcessingTap_PreEffects = (1 << 0),
+    kAudioQueueProcessingTap_PostEffects = (1 << 1),
+    kAudioQueueProcessingTap_Siphon = (1 << 2),
+    kAudioQueueProcessingTap_StartOfStream = (1 << 8),
+    kAudioQueueProcessingTap_EndOfStream = (1 << 9)
+};
+
+typedef void (*AudioQueueProcessingTapCallback)(void* inClientData,
+                                                AudioQueueProcessingTapRef inAQTap,
+                                                UInt32 inNumberFrames,
+                                                AudioTimeStamp* ioTimeStamp,
+                                                AudioQueueProcessingTapFlags* ioFlags,
+                                                UInt32* outNumberFrames,
+                                                AudioBufferList* ioData);
+
+AUDIOTOOLBOX_EXPORT OSStatus AudioQueueStart(AudioQueueRef inAQ, const AudioTimeStamp* inStartTime);
 AUDIOTOOLBOX_EXPORT OSStatus AudioQueuePrime(AudioQueueRef inAQ,
                                              UInt32 inNumberOfFramesToPrepare,
-                                             UInt32* outNumberOfFramesPrepared) STUB_METHOD;
-AUDIOTOOLBOX_EXPORT OSStatus AudioQueueFlush(AudioQueueRef inAQ) STUB_METHOD;
-AUDIOTOOLBOX_EXPORT OSStatus AudioQueueStop(AudioQueueRef inAQ, Boolean inImmediate) STUB_METHOD;
-AUDIOTOOLBOX_EXPORT OSStatus AudioQueuePause(AudioQueueRef inAQ) STUB_METHOD;
-AUDIOTOOLBOX_EXPORT OSStatus AudioQueueReset(AudioQueueRef inAQ) STUB_METHOD;
+                                             UInt32* outNumberOfFramesPrepared);
+AUDIOTOOLBOX_EXPORT OSStatus AudioQueueFlush(AudioQueueRef inAQ);
+AUDIOTOOLBOX_EXPORT OSStatus AudioQueueStop(AudioQueueRef inAQ, Boolean inImmediate);
+AUDIOTOOLBOX_EXPORT OSStatus AudioQueuePause(AudioQueueRef inAQ);
+AUDIOTOOLBOX_EXPORT OSStatus AudioQueueReset(AudioQueueRef inAQ);
 AUDIOTOOLBOX_EXPORT OSStatus AudioQueueNewOutput(const AudioStreamBasicDescription* inFormat,
                                                  AudioQueueOutputCallback inCallbackProc,
                                                  void* inUserData,
                                                  CFRunLoopRef inCallbackRunLoop,
                                                  CFStringRef inCallbackRunLoopMode,
                                                  UInt32 inFlags,
-                                                 AudioQueueRef _Nullable* outAQ) STUB_METHOD;
+                                                 AudioQueueRef _Nullable* outAQ);
 AUDIOTOOLBOX_EXPORT OSStatus AudioQueueNewInput(const AudioStreamBasicDescription* inFormat,
                                                 AudioQueueInputCallback inCallbackProc,
                                                 void* inUserData,
@@ -136,19 +154,19 @@ AUDIOTOOLBOX_EXPORT OSStatus AudioQueueNewInput(const AudioStreamBasicDescriptio
                                                 CFStringRef inCallbackRunLoopMode,
                                                 UInt32 inFlags,
                                                 AudioQueueRef _Nullable* outAQ) STUB_METHOD;
-AUDIOTOOLBOX_EXPORT OSStatus AudioQueueDispose(AudioQueueRef inAQ, Boolean inImmediate) STUB_METHOD;
+AUDIOTOOLBOX_EXPORT OSStatus AudioQueueDispose(AudioQueueRef inAQ, Boolean inImmediate);
 AUDIOTOOLBOX_EXPORT OSStatus AudioQueueAllocateBuffer(AudioQueueRef inAQ,
                                                       UInt32 inBufferByteSize,
-                                                      AudioQueueBufferRef _Nullable* outBuffer) STUB_METHOD;
+                                                      AudioQueueBufferRef _Nullable* outBuffer);
 AUDIOTOOLBOX_EXPORT OSStatus AudioQueueAllocateBufferWithPacketDescriptions(AudioQueueRef inAQ,
                                                                             UInt32 inBufferByteSize,
                                                                             UInt32 inNumberPacketDescriptions,
-                                                                            AudioQueueBufferRef _Nullable* outBuffer) STUB_METHOD;
-AUDIOTOOLBOX_EXPORT OSStatus AudioQueueFreeBuffer(AudioQueueRef inAQ, AudioQueueBufferRef inBuffer) STUB_METHOD;
+                                                                            AudioQueueBufferRef _Nullable* outBuffer);
+AUDIOTOOLBOX_EXPORT OSStatus AudioQueueFreeBuffer(AudioQueueRef inAQ, AudioQueueBufferRef inBuffer);
 AUDIOTOOLBOX_EXPORT OSStatus AudioQueueEnqueueBuffer(AudioQueueRef inAQ,
                                                      AudioQueueBufferRef inBuffer,
                                                      UInt32 inNumPacketDescs,
-                                                     const AudioStreamPacketDescription* inPacketDescs) STUB_METHOD;
+                                                     const AudioStreamPacketDescription* inPacketDescs);
 AUDIOTOOLBOX_EXPORT OSStatus AudioQueueEnqueueBufferWithParameters(AudioQueueRef inAQ,
                                                                    AudioQueueBufferRef inBuffer,
                                                                    UInt32 inNumPacketDescs,
@@ -158,29 +176,27 @@ AUDIOTOOLBOX_EXPORT OSStatus AudioQueueEnqueueBufferWithParameters(AudioQueueRef
                                                                    UInt32 inNumParamValues,
                                                                    const AudioQueueParameterEvent* inParamValues,
                                                                    const AudioTimeStamp* inStartTime,
-                                                                   AudioTimeStamp* outActualStartTime) STUB_METHOD;
+                                                                   AudioTimeStamp* outActualStartTime);
 AUDIOTOOLBOX_EXPORT OSStatus AudioQueueGetParameter(AudioQueueRef inAQ,
                                                     AudioQueueParameterID inParamID,
-                                                    AudioQueueParameterValue* outValue) STUB_METHOD;
+                                                    AudioQueueParameterValue* outValue);
 AUDIOTOOLBOX_EXPORT OSStatus AudioQueueSetParameter(AudioQueueRef inAQ,
                                                     AudioQueueParameterID inParamID,
-                                                    AudioQueueParameterValue inValue) STUB_METHOD;
-AUDIOTOOLBOX_EXPORT OSStatus AudioQueueGetProperty(AudioQueueRef inAQ, AudioQueuePropertyID inID, void* outData, UInt32* ioDataSize)
-    STUB_METHOD;
-AUDIOTOOLBOX_EXPORT OSStatus AudioQueueSetProperty(AudioQueueRef inAQ, AudioQueuePropertyID inID, const void* inData, UInt32 inDataSize)
-    STUB_METHOD;
-AUDIOTOOLBOX_EXPORT OSStatus AudioQueueGetPropertySize(AudioQueueRef inAQ, AudioQueuePropertyID inID, UInt32* outDataSize) STUB_METHOD;
+                                                    AudioQueueParameterValue inValue);
+AUDIOTOOLBOX_EXPORT OSStatus AudioQueueGetProperty(AudioQueueRef inAQ, AudioQueuePropertyID inID, void* outData, UInt32* ioDataSize);
+AUDIOTOOLBOX_EXPORT OSStatus AudioQueueSetProperty(AudioQueueRef inAQ, AudioQueuePropertyID inID, const void* inData, UInt32 inDataSize);
+AUDIOTOOLBOX_EXPORT OSStatus AudioQueueGetPropertySize(AudioQueueRef inAQ, AudioQueuePropertyID inID, UInt32* outDataSize);
 AUDIOTOOLBOX_EXPORT OSStatus AudioQueueAddPropertyListener(AudioQueueRef inAQ,
                                                            AudioQueuePropertyID inID,
                                                            AudioQueuePropertyListenerProc inProc,
-                                                           void* inUserData) STUB_METHOD;
+                                                           void* inUserData);
 AUDIOTOOLBOX_EXPORT OSStatus AudioQueueRemovePropertyListener(AudioQueueRef inAQ,
                                                               AudioQueuePropertyID inID,
                                                               AudioQueuePropertyListenerProc inProc,
-                                                              void* inUserData) STUB_METHOD;
-AUDIOTOOLBOX_EXPORT OSStatus AudioQueueCreateTimeline(AudioQueueRef inAQ, AudioQueueTimelineRef _Nullable* outTimeline) STUB_METHOD;
-AUDIOTOOLBOX_EXPORT OSStatus AudioQueueDisposeTimeline(AudioQueueRef inAQ, AudioQueueTimelineRef inTimeline) STUB_METHOD;
-AUDIOTOOLBOX_EXPORT OSStatus AudioQueueDeviceGetCurrentTime(AudioQueueRef inAQ, AudioTimeStamp* outTimeStamp) STUB_METHOD;
+                                                              void* inUserData);
+AUDIOTOOLBOX_EXPORT OSStatus AudioQueueCreateTimeline(AudioQueueRef inAQ, AudioQueueTimelineRef _Nullable* outTimeline);
+AUDIOTOOLBOX_EXPORT OSStatus AudioQueueDisposeTimeline(AudioQueueRef inAQ, AudioQueueTimelineRef inTimeline);
+AUDIOTOOLBOX_EXPORT OSStatus AudioQueueDeviceGetCurrentTime(AudioQueueRef inAQ, AudioTimeStamp* outTimeStamp);
 AUDIOTOOLBOX_EXPORT OSStatus AudioQueueDeviceGetNearestStartTime(AudioQueueRef inAQ,
                                                                  AudioTimeStamp* ioRequestedStartTime,
                                                                  UInt32 inFlags) STUB_METHOD;
@@ -190,11 +206,28 @@ AUDIOTOOLBOX_EXPORT OSStatus AudioQueueDeviceTranslateTime(AudioQueueRef inAQ,
 AUDIOTOOLBOX_EXPORT OSStatus AudioQueueGetCurrentTime(AudioQueueRef inAQ,
                                                       AudioQueueTimelineRef inTimeline,
                                                       AudioTimeStamp* outTimeStamp,
-                                                      Boolean* outTimelineDiscontinuity) STUB_METHOD;
+                                                      Boolean* outTimelineDiscontinuity);
 AUDIOTOOLBOX_EXPORT OSStatus AudioQueueSetOfflineRenderFormat(AudioQueueRef inAQ,
                                                               const AudioStreamBasicDescription* inFormat,
                                                               const AudioChannelLayout* inLayout) STUB_METHOD;
 AUDIOTOOLBOX_EXPORT OSStatus AudioQueueOfflineRender(AudioQueueRef inAQ,
                                                      const AudioTimeStamp* inTimestamp,
                                                      AudioQueueBufferRef ioBuffer,
-                                                     UInt32 inNumberFrames) STUB_METHOD;
\ No newline at end of file
+                                                     UInt32 inNumberFrames) STUB_METHOD;
+AUDIOTOOLBOX_EXPORT OSStatus AudioQueueProcessingTapNew(AudioQueueRef inAQ,
+                                                        AudioQueueProcessingTapCallback inCallback,
+                                                        void* inClientData,
+                                                        AudioQueueProcessingTapFlags inFlags,
+                                                        UInt32* outMaxFrames,
+                                                        AudioStreamBasicDescription* outProcessingFormat,
+                                                        AudioQueueProcessingTapRef _Nullable* outAQTap);
+AUDIOTOOLBOX_EXPORT OSStatus AudioQueueProcessingTapDispose(AudioQueueProcessingTapRef inAQTap);
+AUDIOTOOLBOX_EXPORT OSStatus AudioQueueProcessingTapGetSourceAudio(AudioQueueProcessingTapRef inAQTap,
+                                                                   UInt32 inNumberFrames,
+                                                                   AudioTimeStamp* ioTimeStamp,
+                                                                   AudioQueueProcessingTapFlags* outFlags,
+                                                                   UInt32* outNumberFrames,
+                                                                   AudioBufferList* ioData);
+AUDIOTOOLBOX_EXPORT OSStatus AudioQueueProcessingTapGetQueueTime(AudioQueueProcessingTapRef inAQTap,
+                                                                 Float64* outQueueSampleTime,
+                                                                 UInt32* outQueueFrameCount);
\ No newline at end of file
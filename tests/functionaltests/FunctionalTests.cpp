@@ -165,6 +165,7 @@ extern void NSURLSessionDataTaskWithURL();
 extern void NSURLSessionDataTaskWithURL_Failure();
 extern void NSURLSessionDataTaskWithURL_WithCompletionHandler();
 extern void NSURLSessionDataTaskWithURL_WithCompletionHandler_Failure();
+extern void NSURLSessionDataTaskWithURL_Sequential();
 extern void NSURLSessionDownloadTaskWithURL();
 extern void NSURLSessionDownloadTaskWithURL_Failure();
 extern void NSURLSessionDownloadTaskWithURL_WithCompletionHandler();
@@ -223,6 +224,10 @@ public:
         NSURLSessionDataTaskWithURL_WithCompletionHandler_Failure();
     }
 
+    TEST_METHOD(NSURLSession_DataTaskWithURL_Sequential) {
+        NSURLSessionDataTaskWithURL_Sequential();
+    }
+
     TEST_METHOD(NSURLSession_DownloadTaskWithURL) {
         NSURLSessionDownloadTaskWithURL();
     }
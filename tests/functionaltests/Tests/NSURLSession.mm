@@ -363,6 +363,48 @@ TEST(NSURLSession, DataTaskWithURL_WithCompletionHandler_Failure) {
     ASSERT_EQ_MSG(nil, taskError, "FAILED: Connection returned error!");
 }
 
+/**
+ * Test to verify that sequential data tasks on separate sessions, which share the underlying HTTP client, all complete successfully.
+ */
+TEST(NSURLSession, DataTaskWithURL_Sequential) {
+    NSURL* url = [NSURL URLWithString:@"https://httpbin.org/get"];
+
+    for (int request = 0; request < 3; request++) {
+        __block NSCondition* condition = [[NSCondition alloc] init];
+        __block NSURLResponse* taskResponse;
+        __block NSData* taskData;
+        __block NSError* taskError;
+
+        NSURLSessionDataTaskTestHelper* dataTaskTestHelper = [[NSURLSessionDataTaskTestHelper alloc] init];
+        NSURLSession* session = [dataTaskTestHelper createSession];
+        LOG_INFO("Establishing data task %d with url %@", request, url);
+        NSURLSessionDataTask* dataTask = [session dataTaskWithURL:url
+                                                completionHandler:^(NSData* data, NSURLResponse* response, NSError* error) {
+                                                    [condition lock];
+                                                    taskResponse = response;
+                                                    taskData = data;
+                                                    taskError = error;
+                                                    [condition signal];
+                                                    [condition unlock];
+                                                }];
+        [dataTask resume];
+
+        // Wait for data.
+        [condition lock];
+        ASSERT_TRUE_MSG((taskResponse || taskData || taskError) ||
+                            [condition waitUntilDate:[NSDate dateWithTimeIntervalSinceNow:c_testTimeoutInSec]],
+                        "FAILED: Waiting for connection timed out!");
+        [condition unlock];
+
+        // Make sure each request received a response and data.
+        ASSERT_TRUE_MSG((taskResponse != nil), "FAILED: Response cannot be empty!");
+        ASSERT_TRUE_MSG([taskResponse isKindOfClass:[NSHTTPURLResponse class]], "FAILED: Response should be of kind NSHTTPURLResponse class!");
+        ASSERT_EQ_MSG(200, [(NSHTTPURLResponse*)taskResponse statusCode], "FAILED: HTTP status 200 expected!");
+        ASSERT_TRUE_MSG((taskData != nil), "FAILED: We should have received some data!");
+        ASSERT_EQ_MSG(nil, taskError, "FAILED: Task returned error!");
+    }
+}
+
 //
 // NSURLSessionDownloadTask tests
 //
@@ -0,0 +1,329 @@
+//******************************************************************************
+//
+// Copyright (c) 2016 Microsoft Corporation. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+#include <TestFramework.h>
+#import <AudioToolbox/AudioConverter.h>
+
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+static const double c_pi = 3.14159265358979323846;
+
+static AudioStreamBasicDescription lpcmFormat(double sampleRate, UInt32 channels, UInt32 bits, UInt32 flags) {
+    AudioStreamBasicDescription desc = {};
+    desc.mSampleRate = sampleRate;
+    desc.mFormatID = kAudioFormatLinearPCM;
+    desc.mFormatFlags = flags;
+    desc.mChannelsPerFrame = channels;
+    desc.mBitsPerChannel = bits;
+    desc.mFramesPerPacket = 1;
+    desc.mBytesPerFrame = (flags & kAudioFormatFlagIsNonInterleaved) ? bits / 8 : bits / 8 * channels;
+    desc.mBytesPerPacket = desc.mBytesPerFrame;
+    return desc;
+}
+
+struct FloatSource {
+    const float* samples;
+    UInt32 frames;
+    UInt32 position;
+    UInt32 maxChunk;
+    bool overDeliver; // Hand over maxChunk frames whatever was asked for
+};
+
+static OSStatus floatSourceProc(AudioConverterRef converter,
+                                UInt32* ioNumberDataPackets,
+                                AudioBufferList* ioData,
+                                AudioStreamPacketDescription** outDataPacketDescription,
+                                void* inUserData) {
+    FloatSource* source = (FloatSource*)inUserData;
+    UInt32 requested = source->overDeliver ? source->maxChunk : *ioNumberDataPackets;
+    UInt32 frames = std::min(std::min(requested, source->maxChunk), source->frames - source->position);
+
+    // Hand over our own memory rather than copying into the converter's
+    ioData->mBuffers[0].mData = const_cast<float*>(source->samples + source->position);
+    ioData->mBuffers[0].mDataByteSize = frames * sizeof(float);
+    source->position += frames;
+    *ioNumberDataPackets = frames;
+    return noErr;
+}
+
+// Pulls a whole mono float signal through a sample rate converter
+static std::vector<float> resample(const std::vector<float>& input,
+                                   double inputRate,
+                                   double outputRate,
+                                   UInt32 quality,
+                                   UInt32 chunk,
+                                   UInt32 complexity = 0,
+                                   UInt32 inputChunk = 0) {
+    AudioStreamBasicDescription inputFormat = lpcmFormat(inputRate, 1, 32, kAudioFormatFlagIsFloat | kAudioFormatFlagIsPacked);
+    AudioStreamBasicDescription outputFormat = lpcmFormat(outputRate, 1, 32, kAudioFormatFlagIsFloat | kAudioFormatFlagIsPacked);
+
+    AudioConverterRef converter = nullptr;
+    EXPECT_EQ(noErr, AudioConverterNew(&inputFormat, &outputFormat, &converter));
+    EXPECT_EQ(noErr, AudioConverterSetProperty(converter, kAudioConverterSampleRateConverterQuality, sizeof(quality), &quality));
+    if (complexity) {
+        EXPECT_EQ(noErr,
+                  AudioConverterSetProperty(converter, kAudioConverterSampleRateConverterComplexity, sizeof(complexity), &complexity));
+    }
+
+    FloatSource source = { input.data(), (UInt32)input.size(), 0, inputChunk ? inputChunk : chunk, inputChunk != 0 };
+    std::vector<float> output;
+    std::vector<float> buffer(chunk);
+    for (;;) {
+        AudioBufferList bufferList = { 1, { { 1, chunk * (UInt32)sizeof(float), buffer.data() } } };
+        UInt32 frames = chunk;
+        EXPECT_EQ(noErr, AudioConverterFillComplexBuffer(converter, floatSourceProc, &source, &frames, &bufferList, nullptr));
+        output.insert(output.end(), buffer.begin(), buffer.begin() + frames);
+        if (frames < chunk) {
+            break;
+        }
+    }
+
+    AudioConverterDispose(converter);
+    return output;
+}
+
+// Everything that isn't a sine at the given frequency, relative to the sine, in dB
+static double thdPlusNoise(const std::vector<float>& signal, double frequency, double sampleRate, size_t begin, size_t end) {
+    double ss = 0, sc = 0, cc = 0, ys = 0, yc = 0;
+    for (size_t i = begin; i < end; i++) {
+        double phase = 2 * c_pi * frequency * i / sampleRate;
+        ss += sin(phase) * sin(phase);
+        sc += sin(phase) * cos(phase);
+        cc += cos(phase) * cos(phase);
+        ys += signal[i] * sin(phase);
+        yc += signal[i] * cos(phase);
+    }
+
+    double det = ss * cc - sc * sc;
+    double a = (ys * cc - yc * sc) / det;
+    double b = (yc * ss - ys * sc) / det;
+
+    double signalEnergy = 0, residualEnergy = 0;
+    for (size_t i = begin; i < end; i++) {
+        double phase = 2 * c_pi * frequency * i / sampleRate;
+        double fit = a * sin(phase) + b * cos(phase);
+        signalEnergy += fit * fit;
+        residualEnergy += (signal[i] - fit) * (signal[i] - fit);
+    }
+
+    return 10 * log10(residualEnergy / signalEnergy);
+}
+
+TEST(AudioConverter, Int16RoundTripsThroughNonInterleavedFloat) {
+    AudioStreamBasicDescription int16Format = lpcmFormat(44100, 2, 16, kAudioFormatFlagIsSignedInteger | kAudioFormatFlagIsPacked);
+    AudioStreamBasicDescription floatFormat =
+        lpcmFormat(44100, 2, 32, kAudioFormatFlagIsFloat | kAudioFormatFlagIsPacked | kAudioFormatFlagIsNonInterleaved);
+
+    AudioConverterRef toFloat = nullptr;
+    AudioConverterRef toInt16 = nullptr;
+    ASSERT_EQ(noErr, AudioConverterNew(&int16Format, &floatFormat, &toFloat));
+    ASSERT_EQ(noErr, AudioConverterNew(&floatFormat, &int16Format, &toInt16));
+
+    const UInt32 frames = 3001;
+    std::vector<int16_t> samples(2 * frames);
+    for (UInt32 i = 0; i < samples.size(); i++) {
+        samples[i] = (int16_t)(i * 37 - 30000 + (i % 7) * 1000);
+    }
+    samples[0] = -32768;
+    samples[1] = 32767;
+
+    std::vector<float> left(frames), right(frames);
+    char storage[sizeof(AudioBufferList) + sizeof(AudioBuffer)];
+    AudioBufferList* planar = (AudioBufferList*)storage;
+    planar->mNumberBuffers = 2;
+    planar->mBuffers[0] = { 1, frames * (UInt32)sizeof(float), left.data() };
+    planar->mBuffers[1] = { 1, frames * (UInt32)sizeof(float), right.data() };
+
+    AudioBufferList interleaved = { 1, { { 2, frames * 2 * (UInt32)sizeof(int16_t), samples.data() } } };
+    ASSERT_EQ(noErr, AudioConverterConvertComplexBuffer(toFloat, frames, &interleaved, planar));
+    EXPECT_EQ(-1.0f, left[0]);
+    EXPECT_EQ(samples[11] / 32768.0f, right[5]);
+
+    std::vector<int16_t> roundTripped(2 * frames);
+    AudioBufferList output = { 1, { { 2, frames * 2 * (UInt32)sizeof(int16_t), roundTripped.data() } } };
+    ASSERT_EQ(noErr, AudioConverterConvertComplexBuffer(toInt16, frames, planar, &output));
+    EXPECT_TRUE(samples == roundTripped);
+
+    AudioConverterDispose(toFloat);
+    AudioConverterDispose(toInt16);
+}
+
+TEST(AudioConverter, ConvertsOtherLinearPCMLayouts) {
+    AudioStreamBasicDescription floatFormat = lpcmFormat(8000, 2, 32, kAudioFormatFlagIsFloat | kAudioFormatFlagIsPacked);
+    AudioStreamBasicDescription int24BigEndian =
+        lpcmFormat(8000, 2, 24, kAudioFormatFlagIsSignedInteger | kAudioFormatFlagIsBigEndian | kAudioFormatFlagIsPacked);
+    AudioStreamBasicDescription unsignedMono = lpcmFormat(8000, 1, 8, kAudioFormatFlagIsPacked);
+
+    AudioConverterRef toInt24 = nullptr;
+    AudioConverterRef toMono = nullptr;
+    ASSERT_EQ(noErr, AudioConverterNew(&floatFormat, &int24BigEndian, &toInt24));
+    ASSERT_EQ(noErr, AudioConverterNew(&int24BigEndian, &unsignedMono, &toMono));
+
+    float input[4] = { 0.5f, -0.25f, -1.0f, 0.75f };
+    uint8_t int24[12];
+    UInt32 size = sizeof(int24);
+    ASSERT_EQ(noErr, AudioConverterConvertBuffer(toInt24, sizeof(input), input, &size, int24));
+    EXPECT_EQ(sizeof(int24), size);
+    EXPECT_EQ(0x40, int24[0]);
+    EXPECT_EQ(0x80, int24[6]);
+
+    // Stereo to mono mixes the channels down
+    uint8_t mono[2];
+    size = sizeof(mono);
+    ASSERT_EQ(noErr, AudioConverterConvertBuffer(toMono, sizeof(int24), int24, &size, mono));
+    EXPECT_EQ(128 + 16, mono[0]);
+    EXPECT_EQ(128 - 16, mono[1]);
+
+    AudioConverterDispose(toInt24);
+    AudioConverterDispose(toMono);
+
+    AudioStreamBasicDescription padded = lpcmFormat(8000, 2, 20, kAudioFormatFlagIsSignedInteger);
+    AudioConverterRef unsupported = nullptr;
+    EXPECT_EQ(kAudioConverterErr_FormatNotSupported, AudioConverterNew(&padded, &floatFormat, &unsupported));
+}
+
+TEST(AudioConverter, ChannelMap) {
+    AudioStreamBasicDescription stereo = lpcmFormat(8000, 2, 32, kAudioFormatFlagIsFloat | kAudioFormatFlagIsPacked);
+    AudioConverterRef converter = nullptr;
+    ASSERT_EQ(noErr, AudioConverterNew(&stereo, &stereo, &converter));
+
+    SInt32 map[2] = { 1, -1 };
+    ASSERT_EQ(noErr, AudioConverterSetProperty(converter, kAudioConverterChannelMap, sizeof(map), map));
+
+    float input[4] = { 0.5f, -0.25f, 0.125f, 1.0f };
+    float output[4];
+    UInt32 size = sizeof(output);
+    ASSERT_EQ(noErr, AudioConverterConvertBuffer(converter, sizeof(input), input, &size, output));
+    EXPECT_EQ(-0.25f, output[0]);
+    EXPECT_EQ(0.0f, output[1]);
+    EXPECT_EQ(1.0f, output[2]);
+
+    AudioConverterDispose(converter);
+}
+
+TEST(AudioConverter, ResamplingQuality) {
+    const double rates[][2] = { { 44100, 48000 }, { 48000, 44100 }, { 22050, 44100 }, { 44100, 8000 } };
+    const double frequency = 997;
+
+    for (auto& rate : rates) {
+        std::vector<float> input((size_t)rate[0]);
+        for (size_t i = 0; i < input.size(); i++) {
+            input[i] = 0.5f * (float)sin(2 * c_pi * frequency * i / rate[0]);
+        }
+
+        // Output length is independent of how the input and output get chunked
+        std::vector<float> output = resample(input, rate[0], rate[1], kAudioConverterQuality_Medium, 333);
+        EXPECT_TRUE(output == resample(input, rate[0], rate[1], kAudioConverterQuality_Medium, 4096));
+        ASSERT_EQ((size_t)ceil(input.size() * rate[1] / rate[0]), output.size());
+
+        double medium = thdPlusNoise(output, frequency, rate[1], 200, output.size() - 200);
+        output = resample(input, rate[0], rate[1], kAudioConverterQuality_Max, 512);
+        double max = thdPlusNoise(output, frequency, rate[1], 200, output.size() - 200);
+
+        LOG_INFO("%.0f Hz -> %.0f Hz: THD+N %.1f dB (medium), %.1f dB (max)", rate[0], rate[1], medium, max);
+        EXPECT_LT(medium, -85.0);
+        EXPECT_LT(max, -105.0);
+    }
+
+    // A tone above the output Nyquist frequency has to be filtered out, not aliased
+    std::vector<float> input(48000);
+    for (size_t i = 0; i < input.size(); i++) {
+        input[i] = 0.5f * (float)sin(2 * c_pi * 15000 * i / 48000);
+    }
+
+    std::vector<float> output = resample(input, 48000, 22050, kAudioConverterQuality_High, 1024);
+    double energy = 0;
+    for (size_t i = 100; i < output.size() - 100; i++) {
+        energy += output[i] * output[i];
+    }
+    EXPECT_LT(10 * log10(energy / (output.size() - 200) / 0.125), -60.0);
+}
+
+TEST(AudioConverter, LinearResampling) {
+    const double rates[][2] = { { 44100, 48000 }, { 48000, 44100 }, { 44100, 8000 }, { 96000, 8000 } };
+    const double frequency = 997;
+
+    for (auto& rate : rates) {
+        std::vector<float> input((size_t)rate[0]);
+        for (size_t i = 0; i < input.size(); i++) {
+            input[i] = 0.5f * (float)sin(2 * c_pi * frequency * i / rate[0]);
+        }
+
+        // Two taps interpolate straight between neighbouring input frames, so the output stays
+        // close to the sine at every frame, whatever the chunking
+        std::vector<float> output =
+            resample(input, rate[0], rate[1], kAudioConverterQuality_Medium, 512, kAudioConverterSampleRateConverterComplexity_Linear);
+        EXPECT_TRUE(output ==
+                    resample(input, rate[0], rate[1], kAudioConverterQuality_Medium, 7, kAudioConverterSampleRateConverterComplexity_Linear));
+        ASSERT_EQ((size_t)ceil(input.size() * rate[1] / rate[0]), output.size());
+
+        double maxError = 0;
+        for (size_t i = 0; i < output.size() - 1; i++) {
+            maxError = std::max(maxError, fabs(output[i] - 0.5 * sin(2 * c_pi * frequency * i / rate[1])));
+        }
+        EXPECT_LT(maxError, 0.01) << rate[0] << " Hz -> " << rate[1] << " Hz";
+    }
+}
+
+TEST(AudioConverter, KeepsInputBeyondWhatWasRequested) {
+    std::vector<float> input(10007);
+    for (size_t i = 0; i < input.size(); i++) {
+        input[i] = (float)((i * 7919) % 2001) / 1000.0f - 1.0f;
+    }
+
+    // Without resampling, frames that don't fit in this pull come out at the start of the next
+    AudioStreamBasicDescription format = lpcmFormat(44100, 1, 32, kAudioFormatFlagIsFloat | kAudioFormatFlagIsPacked);
+    AudioConverterRef converter = nullptr;
+    ASSERT_EQ(noErr, AudioConverterNew(&format, &format, &converter));
+
+    FloatSource source = { input.data(), (UInt32)input.size(), 0, 1000, true };
+    std::vector<float> output;
+    std::vector<float> buffer(300);
+    for (;;) {
+        AudioBufferList bufferList = { 1, { { 1, (UInt32)(buffer.size() * sizeof(float)), buffer.data() } } };
+        UInt32 frames = (UInt32)buffer.size();
+        ASSERT_EQ(noErr, AudioConverterFillComplexBuffer(converter, floatSourceProc, &source, &frames, &bufferList, nullptr));
+        output.insert(output.end(), buffer.begin(), buffer.begin() + frames);
+        if (frames < buffer.size()) {
+            break;
+        }
+    }
+    AudioConverterDispose(converter);
+    EXPECT_TRUE(input == output);
+
+    // Resampling takes all of it into the filter, so the output doesn't depend on how the input arrives
+    std::vector<float> expected = resample(input, 44100, 48000, kAudioConverterQuality_Medium, 512);
+    std::vector<float> actual = resample(input, 44100, 48000, kAudioConverterQuality_Medium, 512, 0, 5000);
+    EXPECT_TRUE(expected == actual);
+}
+
+TEST(AudioConverter, ResamplingThroughput) {
+    const double seconds = 20;
+    std::vector<float> input((size_t)(44100 * seconds));
+    for (size_t i = 0; i < input.size(); i++) {
+        input[i] = 0.5f * (float)sin(i * 0.01);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<float> output = resample(input, 44100, 48000, kAudioConverterQuality_Medium, 4096);
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+
+    LOG_INFO("Resampled %.0f s of mono audio from 44.1 kHz to 48 kHz in %lld ms", seconds, (long long)elapsed.count());
+    EXPECT_EQ((size_t)(48000 * seconds), output.size());
+}
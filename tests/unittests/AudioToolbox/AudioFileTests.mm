@@ -0,0 +1,425 @@
+//******************************************************************************
+//
+// Copyright (c) 2016 Microsoft Corporation. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+#include <TestFramework.h>
+#import <Foundation/Foundation.h>
+#import <AudioToolbox/AudioFile.h>
+#import <AudioToolbox/ExtendedAudioFile.h>
+#include <vector>
+
+static void appendBigEndian(std::vector<uint8_t>& out, uint64_t value, int bytes) {
+    for (int i = bytes - 1; i >= 0; i--) {
+        out.push_back((uint8_t)(value >> (i * 8)));
+    }
+}
+
+static void appendChunkHeader(std::vector<uint8_t>& out, const char* type, int64_t size) {
+    out.insert(out.end(), type, type + 4);
+    appendBigEndian(out, (uint64_t)size, 8);
+}
+
+static NSString* writeTestFile(NSString* name, const std::vector<uint8_t>& file) {
+    NSArray* cachesPaths = NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSAllDomainsMask, YES);
+    NSString* path = cachesPaths[0];
+    [[NSFileManager defaultManager] createDirectoryAtPath:path withIntermediateDirectories:YES attributes:nil error:nil];
+    NSString* filePath = [path stringByAppendingPathComponent:name];
+    [[NSData dataWithBytes:file.data() length:file.size()] writeToFile:filePath atomically:NO];
+    return filePath;
+}
+
+static int16_t testSample(int frame, int channel) {
+    return (int16_t)(frame * 7 + channel * 1000 - 30000);
+}
+
+// Writes a 16 bit big endian linear PCM CAF, with an unknown chunk ahead of the audio
+static NSString* writeTestCAF(NSString* name, int channels, int frames) {
+    std::vector<uint8_t> file;
+    file.insert(file.end(), { 'c', 'a', 'f', 'f' });
+    appendBigEndian(file, 1, 2);
+    appendBigEndian(file, 0, 2);
+
+    double sampleRate = 22050.0;
+    appendChunkHeader(file, "desc", 32);
+    appendBigEndian(file, *(uint64_t*)&sampleRate, 8);
+    file.insert(file.end(), { 'l', 'p', 'c', 'm' });
+    appendBigEndian(file, 0, 4);
+    appendBigEndian(file, 2 * channels, 4);
+    appendBigEndian(file, 1, 4);
+    appendBigEndian(file, channels, 4);
+    appendBigEndian(file, 16, 4);
+
+    appendChunkHeader(file, "free", 10);
+    file.insert(file.end(), 10, 0);
+
+    appendChunkHeader(file, "data", 4 + frames * channels * 2);
+    appendBigEndian(file, 0, 4);
+    for (int frame = 0; frame < frames; frame++) {
+        for (int channel = 0; channel < channels; channel++) {
+            appendBigEndian(file, (uint16_t)testSample(frame, channel), 2);
+        }
+    }
+
+    return writeTestFile(name, file);
+}
+
+TEST(AudioFile, CAFReadsAtArbitraryOffsets) {
+    const int channels = 2;
+    const int frames = 10000;
+    NSString* path = writeTestCAF(@"audiofile_offsets.caf", channels, frames);
+
+    AudioFileID file = nullptr;
+    ASSERT_EQ(0, AudioFileOpenURL((__bridge CFURLRef)[NSURL fileURLWithPath:path], kAudioFileReadPermission, 0, &file));
+    ASSERT_NE(nullptr, file);
+
+    SInt64 lengthFrames = 0;
+    UInt32 size = sizeof(lengthFrames);
+    AudioFileGetProperty(file, kExtAudioFileProperty_FileLengthFrames, &size, &lengthFrames);
+    EXPECT_EQ(frames, lengthFrames);
+
+    // Out of order reads, across decode block boundaries and back again
+    const int startFrames[] = { 9000, 0, 4090, 8191, 123, 4090 };
+    for (int startFrame : startFrames) {
+        int16_t buffer[64 * channels];
+        UInt32 numBytes = sizeof(buffer);
+        ASSERT_EQ(0, AudioFileReadBytes(file, false, startFrame * channels * sizeof(int16_t), &numBytes, buffer));
+        ASSERT_EQ(sizeof(buffer), numBytes);
+
+        for (int i = 0; i < 64; i++) {
+            EXPECT_EQ(testSample(startFrame + i, 0), buffer[i * channels]);
+            EXPECT_EQ(testSample(startFrame + i, 1), buffer[i * channels + 1]);
+        }
+    }
+
+    // Reads are clipped at the end of the audio
+    int16_t tail[100 * channels];
+    UInt32 numBytes = sizeof(tail);
+    ASSERT_EQ(0, AudioFileReadBytes(file, false, (frames - 10) * channels * sizeof(int16_t), &numBytes, tail));
+    EXPECT_EQ(10 * channels * sizeof(int16_t), numBytes);
+    EXPECT_EQ(testSample(frames - 1, 1), tail[10 * channels - 1]);
+
+    AudioFileClose(file);
+    [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+}
+
+TEST(AudioFile, CAFReadsWholeFile) {
+    const int channels = 1;
+    const int frames = 20000;
+    NSString* path = writeTestCAF(@"audiofile_whole.caf", channels, frames);
+
+    AudioFileID file = nullptr;
+    ASSERT_EQ(0, AudioFileOpenURL((__bridge CFURLRef)[NSURL fileURLWithPath:path], kAudioFileReadPermission, 0, &file));
+    ASSERT_NE(nullptr, file);
+
+    UInt64 byteCount = 0;
+    UInt32 size = sizeof(byteCount);
+    AudioFileGetProperty(file, kAudioFilePropertyAudioDataByteCount, &size, &byteCount);
+    ASSERT_EQ(frames * channels * sizeof(int16_t), byteCount);
+
+    std::vector<int16_t> samples(frames * channels);
+    UInt32 numBytes = (UInt32)byteCount;
+    ASSERT_EQ(0, AudioFileReadBytes(file, false, 0, &numBytes, samples.data()));
+    ASSERT_EQ(byteCount, numBytes);
+
+    for (int frame = 0; frame < frames; frame++) {
+        ASSERT_EQ(testSample(frame, 0), samples[frame]);
+    }
+
+    AudioFileClose(file);
+    [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+}
+
+// Packs bits least significant first, the way Vorbis reads them
+class VorbisBitWriter {
+public:
+    void write(uint32_t value, int bits) {
+        for (int i = 0; i < bits; i++) {
+            if (_used % 8 == 0) {
+                bytes.push_back(0);
+            }
+            bytes.back() |= ((value >> i) & 1) << (_used % 8);
+            _used++;
+        }
+    }
+
+    void writeHeader(int type) {
+        write(type, 8);
+        for (const char* c = "vorbis"; *c; c++) {
+            write(*c, 8);
+        }
+    }
+
+    std::vector<uint8_t> bytes;
+
+private:
+    int _used = 0;
+};
+
+// A dimension 1 codebook of two one bit codewords, optionally mapping them to the values -1 and 1
+static void writeVorbisCodebook(VorbisBitWriter& bits, bool signs) {
+    bits.write(0x564342, 24);
+    bits.write(1, 16);
+    bits.write(2, 24);
+    bits.write(0, 1);
+    bits.write(0, 1);
+    bits.write(0, 5);
+    bits.write(0, 5);
+    bits.write(signs ? 1 : 0, 4);
+    if (signs) {
+        // Floats are a 21 bit mantissa scaled by 2 to the power of a biased exponent
+        const uint32_t one = 788 << 21 | 1;
+        bits.write(0x80000000 | one, 32);
+        bits.write(one + (1 << 21), 32);
+        bits.write(0, 4);
+        bits.write(0, 1);
+        bits.write(0, 1);
+        bits.write(1, 1);
+    }
+}
+
+static uint32_t oggCRC(const uint8_t* data, size_t size) {
+    uint32_t crc = 0;
+    for (size_t i = 0; i < size; i++) {
+        crc ^= (uint32_t)data[i] << 24;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04c11db7 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+static void appendLittleEndian(std::vector<uint8_t>& out, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        out.push_back((uint8_t)(value >> (i * 8)));
+    }
+}
+
+static void appendOggPage(
+    std::vector<uint8_t>& out, const std::vector<std::vector<uint8_t>>& packets, uint8_t flags, int64_t granule, uint32_t sequence) {
+    std::vector<uint8_t> page = { 'O', 'g', 'g', 'S', 0, flags };
+    appendLittleEndian(page, (uint64_t)granule, 8);
+    appendLittleEndian(page, 0x5ea1, 4);
+    appendLittleEndian(page, sequence, 4);
+    appendLittleEndian(page, 0, 4);
+
+    std::vector<uint8_t> lacing;
+    for (const auto& packet : packets) {
+        lacing.insert(lacing.end(), packet.size() / 255, 255);
+        lacing.push_back((uint8_t)(packet.size() % 255));
+    }
+    page.push_back((uint8_t)lacing.size());
+    page.insert(page.end(), lacing.begin(), lacing.end());
+    for (const auto& packet : packets) {
+        page.insert(page.end(), packet.begin(), packet.end());
+    }
+
+    uint32_t crc = oggCRC(page.data(), page.size());
+    for (int i = 0; i < 4; i++) {
+        page[22 + i] = (uint8_t)(crc >> (i * 8));
+    }
+    out.insert(out.end(), page.begin(), page.end());
+}
+
+// Encodes a mono Vorbis stream of short blocks by hand: a straight line floor, and a residue of
+// pseudo-random signs, so that every block sounds different. Each packet after the first adds 128 frames.
+static NSString* writeTestOgg(NSString* name, int packets) {
+    std::vector<uint8_t> file;
+
+    VorbisBitWriter identification;
+    identification.writeHeader(1);
+    identification.write(0, 32);
+    identification.write(1, 8);
+    identification.write(8000, 32);
+    identification.write(0, 32);
+    identification.write(0, 32);
+    identification.write(0, 32);
+    identification.write(8, 4);
+    identification.write(8, 4);
+    identification.write(1, 1);
+    appendOggPage(file, { identification.bytes }, 2, 0, 0);
+
+    VorbisBitWriter comment;
+    comment.writeHeader(3);
+    comment.write(0, 32);
+    comment.write(0, 32);
+    comment.write(1, 1);
+
+    VorbisBitWriter setup;
+    setup.writeHeader(5);
+    setup.write(1, 8); // Two codebooks: residue classes, then residue values
+    writeVorbisCodebook(setup, false);
+    writeVorbisCodebook(setup, true);
+    setup.write(0, 6); // One unused time domain transform
+    setup.write(0, 16);
+    setup.write(0, 6); // One floor 1 with only its two end points
+    setup.write(1, 16);
+    setup.write(0, 5);
+    setup.write(0, 2);
+    setup.write(7, 4);
+    setup.write(0, 6); // One residue over all 128 bins, in partitions of 16
+    setup.write(1, 16);
+    setup.write(0, 24);
+    setup.write(128, 24);
+    setup.write(15, 24);
+    setup.write(0, 6);
+    setup.write(0, 8);
+    setup.write(1, 3);
+    setup.write(0, 1);
+    setup.write(1, 8);
+    setup.write(0, 6); // One mapping, one mode
+    setup.write(0, 16);
+    setup.write(0, 1);
+    setup.write(0, 1);
+    setup.write(0, 2);
+    setup.write(0, 8);
+    setup.write(0, 8);
+    setup.write(0, 8);
+    setup.write(0, 6);
+    setup.write(0, 1);
+    setup.write(0, 16);
+    setup.write(0, 16);
+    setup.write(0, 8);
+    setup.write(1, 1);
+    appendOggPage(file, { comment.bytes, setup.bytes }, 0, 0, 1);
+
+    uint32_t random = 12345;
+    std::vector<std::vector<uint8_t>> page;
+    for (int packet = 0; packet < packets; packet++) {
+        VorbisBitWriter audio;
+        audio.write(0, 1);
+        audio.write(1, 1);
+        audio.write(200 + packet % 40, 8);
+        audio.write(239 - packet % 40, 8);
+        for (int partition = 0; partition < 8; partition++) {
+            audio.write(0, 1);
+        }
+        for (int partition = 0; partition < 8; partition++) {
+            random = random * 1103515245 + 12345;
+            audio.write(random >> 16, 16);
+        }
+        page.push_back(audio.bytes);
+
+        bool last = packet == packets - 1;
+        if (page.size() == 10 || last) {
+            appendOggPage(file, page, last ? 4 : 0, (int64_t)packet * 128, 2 + packet / 10);
+            page.clear();
+        }
+    }
+    return writeTestFile(name, file);
+}
+
+// Decodes the whole stream in one read, to compare reads elsewhere against
+static std::vector<int16_t> readWholeOgg(AudioFileID file, SInt64 lengthFrames) {
+    std::vector<int16_t> samples(lengthFrames + 100);
+    UInt32 numBytes = samples.size() * sizeof(int16_t);
+    if (AudioFileReadBytes(file, false, 0, &numBytes, samples.data()) != 0) {
+        numBytes = 0;
+    }
+    samples.resize(numBytes / sizeof(int16_t));
+    return samples;
+}
+
+TEST(AudioFile, OggReadsAtArbitraryOffsets) {
+    const int packets = 200;
+    NSString* path = writeTestOgg(@"audiofile_offsets.ogg", packets);
+
+    AudioFileID file = nullptr;
+    ASSERT_EQ(0, AudioFileOpenURL((__bridge CFURLRef)[NSURL fileURLWithPath:path], kAudioFileReadPermission, 0, &file));
+    ASSERT_NE(nullptr, file);
+
+    SInt64 lengthFrames = 0;
+    UInt32 size = sizeof(lengthFrames);
+    AudioFileGetProperty(file, kExtAudioFileProperty_FileLengthFrames, &size, &lengthFrames);
+    EXPECT_EQ((packets - 1) * 128, lengthFrames);
+
+    std::vector<int16_t> whole = readWholeOgg(file, lengthFrames);
+    ASSERT_EQ(lengthFrames, whole.size());
+
+    // Out of order reads, forwards and backwards across pages, and back to where the decoder already is
+    const int startFrames[] = { 20000, 0, 4090, 12345, 123, 25000, 4090, 4154 };
+    for (int startFrame : startFrames) {
+        int16_t buffer[64];
+        UInt32 numBytes = sizeof(buffer);
+        ASSERT_EQ(0, AudioFileReadBytes(file, false, startFrame * sizeof(int16_t), &numBytes, buffer));
+        ASSERT_EQ(sizeof(buffer), numBytes);
+
+        for (int i = 0; i < 64; i++) {
+            EXPECT_EQ(whole[startFrame + i], buffer[i]) << "at frame " << startFrame + i;
+        }
+    }
+
+    // Offsets inside a frame are refused
+    int16_t sample;
+    UInt32 numBytes = sizeof(sample);
+    EXPECT_NE(0, AudioFileReadBytes(file, false, 1001, &numBytes, &sample));
+    EXPECT_EQ(0, numBytes);
+
+    // Reads are clipped at the end of the audio
+    int16_t tail[100];
+    numBytes = sizeof(tail);
+    ASSERT_EQ(0, AudioFileReadBytes(file, false, (lengthFrames - 10) * sizeof(int16_t), &numBytes, tail));
+    EXPECT_EQ(10 * sizeof(int16_t), numBytes);
+    EXPECT_EQ(whole[lengthFrames - 1], tail[9]);
+
+    AudioFileClose(file);
+    [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+}
+
+TEST(AudioFile, OggFindsPacketsAfterSeeking) {
+    const int packets = 200;
+    NSString* path = writeTestOgg(@"audiofile_packets.ogg", packets);
+
+    AudioFileID file = nullptr;
+    ASSERT_EQ(0, AudioFileOpenURL((__bridge CFURLRef)[NSURL fileURLWithPath:path], kAudioFileReadPermission, 0, &file));
+    ASSERT_NE(nullptr, file);
+
+    SInt64 lengthFrames = 0;
+    UInt32 size = sizeof(lengthFrames);
+    AudioFileGetProperty(file, kExtAudioFileProperty_FileLengthFrames, &size, &lengthFrames);
+    std::vector<int16_t> whole = readWholeOgg(file, lengthFrames);
+    ASSERT_EQ(lengthFrames, whole.size());
+
+    // Ogg is decoded to linear PCM, one frame to a packet
+    AudioStreamBasicDescription format = {};
+    size = sizeof(format);
+    AudioFileGetProperty(file, kAudioFilePropertyDataFormat, &size, &format);
+    ASSERT_EQ(1, format.mFramesPerPacket);
+    ASSERT_EQ(sizeof(int16_t), format.mBytesPerPacket);
+
+    // Seek to the last page, then look packets up behind it, reading on without seeking from each
+    const int startPackets[] = { 25400, 8000, 7000, 17, 24000 };
+    for (int startPacket : startPackets) {
+        for (int run = 0; run < 3; run++) {
+            SInt64 packet = startPacket + run * 20;
+            int16_t buffer[20];
+            UInt32 numBytes = sizeof(buffer);
+            ASSERT_EQ(0, AudioFileReadBytes(file, false, packet * format.mBytesPerPacket, &numBytes, buffer));
+            ASSERT_EQ(sizeof(buffer), numBytes);
+
+            for (int i = 0; i < 20; i++) {
+                EXPECT_EQ(whole[packet + i], buffer[i]) << "at packet " << packet + i;
+            }
+        }
+
+        // Seeking doesn't change where the stream ends
+        SInt64 length = 0;
+        size = sizeof(length);
+        AudioFileGetProperty(file, kExtAudioFileProperty_FileLengthFrames, &size, &length);
+        EXPECT_EQ(lengthFrames, length);
+    }
+
+    AudioFileClose(file);
+    [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+}
@@ -0,0 +1,635 @@
+//******************************************************************************
+//
+// Copyright (c) 2016 Microsoft Corporation. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+#include <TestFramework.h>
+#import <Foundation/Foundation.h>
+#import <AudioToolbox/AudioQueue.h>
+#include "AudioQueueInternal.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+static AudioStreamBasicDescription lpcmFormat(double sampleRate, UInt32 channels, UInt32 bits, UInt32 flags) {
+    AudioStreamBasicDescription desc = {};
+    desc.mSampleRate = sampleRate;
+    desc.mFormatID = kAudioFormatLinearPCM;
+    desc.mFormatFlags = flags;
+    desc.mChannelsPerFrame = channels;
+    desc.mBitsPerChannel = bits;
+    desc.mFramesPerPacket = 1;
+    desc.mBytesPerFrame = bits / 8 * channels;
+    desc.mBytesPerPacket = desc.mBytesPerFrame;
+    return desc;
+}
+
+// Keeps everything the queue renders, and when each period arrived
+class CaptureSink : public AudioQueueSink {
+public:
+    explicit CaptureSink(bool realTime) : _device(AudioQueueCreateNullSink(realTime)) {
+    }
+
+    OSStatus open(double sampleRate, UInt32 channels, UInt32 periodFrames) override {
+        return _device->open(sampleRate, channels, periodFrames);
+    }
+
+    OSStatus write(const float* samples, UInt32 frames) override {
+        OSStatus status = _device->write(samples, frames);
+        std::lock_guard<std::mutex> lock(_lock);
+        _samples.insert(_samples.end(), samples, samples + frames * channels());
+        _writes.push_back({ Clock::now(), frames, _device->latencyFrames() });
+        _written.notify_all();
+        return status;
+    }
+
+    void close() override {
+        _device->close();
+    }
+
+    UInt32 latencyFrames() override {
+        return _device->latencyFrames();
+    }
+
+    UInt32 channels() const {
+        return _channels;
+    }
+
+    struct Write {
+        Clock::time_point time;
+        UInt32 frames;
+        UInt32 latency;
+    };
+
+    std::vector<float> samples() {
+        std::lock_guard<std::mutex> lock(_lock);
+        return _samples;
+    }
+
+    std::vector<Write> writes() {
+        std::lock_guard<std::mutex> lock(_lock);
+        return _writes;
+    }
+
+    // Waits for the device to have taken at least count writes; false if it stops taking them
+    bool waitForWrites(size_t count) {
+        std::unique_lock<std::mutex> lock(_lock);
+        return _written.wait_for(lock, std::chrono::seconds(10), [&]() { return _writes.size() >= count; });
+    }
+
+    UInt32 _channels = 1;
+
+private:
+    std::unique_ptr<AudioQueueSink> _device;
+    std::mutex _lock;
+    std::condition_variable _written;
+    std::vector<float> _samples;
+    std::vector<Write> _writes;
+};
+
+static CaptureSink* attachCaptureSink(AudioQueueRef queue, UInt32 channels, bool realTime) {
+    CaptureSink* sink = new CaptureSink(realTime);
+    sink->_channels = channels;
+    AudioQueueSetSink(queue, std::unique_ptr<AudioQueueSink>(sink));
+    return sink;
+}
+
+static bool waitUntilStopped(AudioQueueRef queue) {
+    for (int i = 0; i < 5000; i++) {
+        UInt32 running = 1;
+        UInt32 size = sizeof(running);
+        AudioQueueGetProperty(queue, kAudioQueueProperty_IsRunning, &running, &size);
+        if (!running) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return false;
+}
+
+static int16_t rampSample(UInt32 frame, UInt32 channel) {
+    return (int16_t)((frame * 13 + channel * 5000) % 20000 - 10000);
+}
+
+// Plays totalFrames of a 16 bit ramp, refilling buffers from the output callback
+struct RampPlayer {
+    UInt32 channels;
+    UInt32 totalFrames;
+    UInt32 nextFrame;
+    bool stopping;
+    int completed;
+    std::atomic<int> runningChanges;
+
+    RampPlayer(UInt32 channels, UInt32 totalFrames)
+        : channels(channels), totalFrames(totalFrames), nextFrame(0), stopping(false), completed(0), runningChanges(0) {
+    }
+
+    bool fill(AudioQueueBufferRef buffer) {
+        UInt32 frames = std::min(buffer->mAudioDataBytesCapacity / (2 * channels), totalFrames - nextFrame);
+        if (frames == 0) {
+            return false;
+        }
+
+        int16_t* out = (int16_t*)buffer->mAudioData;
+        for (UInt32 frame = 0; frame < frames; frame++) {
+            for (UInt32 channel = 0; channel < channels; channel++) {
+                *out++ = rampSample(nextFrame + frame, channel);
+            }
+        }
+        buffer->mAudioDataByteSize = frames * 2 * channels;
+        nextFrame += frames;
+        return true;
+    }
+};
+
+static void rampCallback(void* userData, AudioQueueRef queue, AudioQueueBufferRef buffer) {
+    RampPlayer* player = (RampPlayer*)userData;
+    player->completed++;
+    if (player->fill(buffer)) {
+        AudioQueueEnqueueBuffer(queue, buffer, 0, nullptr);
+    } else if (!player->stopping) {
+        player->stopping = true;
+        AudioQueueStop(queue, false);
+    }
+}
+
+static void runningListener(void* userData, AudioQueueRef queue, AudioQueuePropertyID id) {
+    ((RampPlayer*)userData)->runningChanges++;
+}
+
+TEST(AudioQueue, PlaysEnqueuedBuffersInOrder) {
+    const UInt32 channels = 2;
+    const UInt32 totalFrames = 48000;
+    AudioStreamBasicDescription format = lpcmFormat(48000, channels, 16, kAudioFormatFlagIsSignedInteger | kAudioFormatFlagIsPacked);
+
+    RampPlayer player(channels, totalFrames);
+    AudioQueueRef queue = nullptr;
+    ASSERT_EQ(noErr, AudioQueueNewOutput(&format, rampCallback, &player, nullptr, nullptr, 0, &queue));
+    CaptureSink* sink = attachCaptureSink(queue, channels, false);
+    ASSERT_EQ(noErr, AudioQueueAddPropertyListener(queue, kAudioQueueProperty_IsRunning, runningListener, &player));
+
+    for (int i = 0; i < 3; i++) {
+        AudioQueueBufferRef buffer;
+        ASSERT_EQ(noErr, AudioQueueAllocateBuffer(queue, 1000 * 2 * channels, &buffer));
+        ASSERT_TRUE(player.fill(buffer));
+        ASSERT_EQ(noErr, AudioQueueEnqueueBuffer(queue, buffer, 0, nullptr));
+    }
+
+    ASSERT_EQ(noErr, AudioQueueStart(queue, nullptr));
+    ASSERT_TRUE(waitUntilStopped(queue));
+
+    // Everything comes out exactly once, in order, and the drained stop adds no padding
+    std::vector<float> samples = sink->samples();
+    ASSERT_EQ(totalFrames * channels, samples.size());
+    bool matches = true;
+    for (UInt32 frame = 0; frame < totalFrames && matches; frame++) {
+        for (UInt32 channel = 0; channel < channels; channel++) {
+            matches &= samples[frame * channels + channel] == rampSample(frame, channel) / 32768.0f;
+        }
+    }
+    EXPECT_TRUE(matches);
+    EXPECT_EQ(totalFrames / 1000, (UInt32)player.completed);
+    EXPECT_EQ(2, player.runningChanges.load());
+
+    AudioQueueRenderStatistics stats;
+    ASSERT_EQ(noErr, AudioQueueGetRenderStatistics(queue, &stats));
+    EXPECT_EQ(0, stats.underruns);
+    EXPECT_EQ(totalFrames, stats.frames);
+
+    EXPECT_EQ(noErr, AudioQueueDispose(queue, true));
+}
+
+struct ResetRecorder {
+    int callbacks = 0;
+    OSStatus enqueueStatus = noErr;
+};
+
+static void resetCallback(void* userData, AudioQueueRef queue, AudioQueueBufferRef buffer) {
+    ResetRecorder* recorder = (ResetRecorder*)userData;
+    recorder->callbacks++;
+    recorder->enqueueStatus = AudioQueueEnqueueBuffer(queue, buffer, 0, nullptr);
+}
+
+TEST(AudioQueue, ResetReturnsEnqueuedBuffers) {
+    AudioStreamBasicDescription format = lpcmFormat(44100, 1, 16, kAudioFormatFlagIsSignedInteger | kAudioFormatFlagIsPacked);
+    ResetRecorder recorder;
+    AudioQueueRef queue = nullptr;
+    ASSERT_EQ(noErr, AudioQueueNewOutput(&format, resetCallback, &recorder, nullptr, nullptr, 0, &queue));
+
+    AudioQueueBufferRef buffers[3];
+    for (int i = 0; i < 3; i++) {
+        ASSERT_EQ(noErr, AudioQueueAllocateBuffer(queue, 256, &buffers[i]));
+        buffers[i]->mAudioDataByteSize = 256;
+        ASSERT_EQ(noErr, AudioQueueEnqueueBuffer(queue, buffers[i], 0, nullptr));
+    }
+
+    UInt32 prepared = 0;
+    EXPECT_EQ(noErr, AudioQueuePrime(queue, 0, &prepared));
+    EXPECT_EQ(3 * 128, prepared);
+
+    ASSERT_EQ(noErr, AudioQueueReset(queue));
+    EXPECT_EQ(3, recorder.callbacks);
+    EXPECT_EQ(kAudioQueueErr_EnqueueDuringReset, recorder.enqueueStatus);
+
+    // Once the reset is over, the buffers can be used again
+    EXPECT_EQ(noErr, AudioQueueEnqueueBuffer(queue, buffers[0], 0, nullptr));
+    EXPECT_EQ(noErr, AudioQueueDispose(queue, true));
+}
+
+TEST(AudioQueue, RejectsInvalidUse) {
+    AudioStreamBasicDescription format = lpcmFormat(44100, 1, 16, kAudioFormatFlagIsSignedInteger | kAudioFormatFlagIsPacked);
+    ResetRecorder recorder;
+    AudioQueueRef queue = nullptr;
+
+    AudioStreamBasicDescription aac = {};
+    aac.mSampleRate = 44100;
+    aac.mFormatID = kAudioFormatMPEG4AAC;
+    aac.mChannelsPerFrame = 2;
+    EXPECT_EQ(kAudioQueueErr_CodecNotFound, AudioQueueNewOutput(&aac, resetCallback, &recorder, nullptr, nullptr, 0, &queue));
+
+    ASSERT_EQ(noErr, AudioQueueNewOutput(&format, resetCallback, &recorder, nullptr, nullptr, 0, &queue));
+
+    AudioQueueBufferRef buffer;
+    ASSERT_EQ(noErr, AudioQueueAllocateBuffer(queue, 64, &buffer));
+    EXPECT_EQ(64, buffer->mAudioDataBytesCapacity);
+    EXPECT_EQ(kAudioQueueErr_BufferEmpty, AudioQueueEnqueueBuffer(queue, buffer, 0, nullptr));
+
+    buffer->mAudioDataByteSize = 64;
+    EXPECT_EQ(noErr, AudioQueueEnqueueBuffer(queue, buffer, 0, nullptr));
+    EXPECT_EQ(kAudioQueueErr_BufferInQueue, AudioQueueEnqueueBuffer(queue, buffer, 0, nullptr));
+    EXPECT_EQ(kAudioQueueErr_BufferInQueue, AudioQueueFreeBuffer(queue, buffer));
+
+    AudioQueueParameterValue value = 0;
+    EXPECT_EQ(kAudioQueueErr_InvalidParameter, AudioQueueSetParameter(queue, kAudioQueueParam_PlayRate, 2.0f));
+    EXPECT_EQ(noErr, AudioQueueSetParameter(queue, kAudioQueueParam_Volume, 0.25f));
+    EXPECT_EQ(noErr, AudioQueueGetParameter(queue, kAudioQueueParam_Volume, &value));
+    EXPECT_EQ(0.25f, value);
+
+    AudioStreamBasicDescription reported;
+    UInt32 size = sizeof(reported);
+    EXPECT_EQ(noErr, AudioQueueGetProperty(queue, kAudioQueueProperty_StreamDescription, &reported, &size));
+    EXPECT_EQ(0, memcmp(&format, &reported, sizeof(format)));
+    EXPECT_EQ(kAudioQueueErr_InvalidProperty, AudioQueueGetPropertySize(queue, 'none', &size));
+
+    ASSERT_EQ(noErr, AudioQueueReset(queue));
+    EXPECT_EQ(noErr, AudioQueueFreeBuffer(queue, buffer));
+    EXPECT_EQ(noErr, AudioQueueDispose(queue, true));
+}
+
+static void ignoreCallback(void* userData, AudioQueueRef queue, AudioQueueBufferRef buffer) {
+}
+
+static void enqueueConstant(AudioQueueRef queue, float value, UInt32 frames, UInt32 trimStart, UInt32 trimEnd, float volume) {
+    AudioQueueBufferRef buffer;
+    AudioQueueAllocateBuffer(queue, frames * sizeof(float), &buffer);
+    std::fill((float*)buffer->mAudioData, (float*)buffer->mAudioData + frames, value);
+    buffer->mAudioDataByteSize = frames * sizeof(float);
+
+    AudioQueueParameterEvent parameters[] = { { kAudioQueueParam_Volume, volume } };
+    AudioQueueEnqueueBufferWithParameters(queue, buffer, 0, nullptr, trimStart, trimEnd, 1, parameters, nullptr, nullptr);
+}
+
+static bool isRunning(AudioQueueRef queue) {
+    UInt32 running = 0;
+    UInt32 size = sizeof(running);
+    AudioQueueGetProperty(queue, kAudioQueueProperty_IsRunning, &running, &size);
+    return running != 0;
+}
+
+// Notes when the last enqueued buffer comes back, and how far the device had got by then
+struct DrainRecorder {
+    std::mutex lock;
+    std::condition_variable drained;
+    int returned = 0;
+    int expected = 0;
+    size_t writesAtDrain = 0;
+    CaptureSink* sink = nullptr;
+};
+
+static void drainCallback(void* userData, AudioQueueRef queue, AudioQueueBufferRef buffer) {
+    DrainRecorder* recorder = (DrainRecorder*)userData;
+    size_t writes = recorder->sink->writes().size();
+    std::lock_guard<std::mutex> lock(recorder->lock);
+    if (++recorder->returned == recorder->expected) {
+        recorder->writesAtDrain = writes;
+        recorder->drained.notify_all();
+    }
+}
+
+TEST(AudioQueue, StartCancelsPendingStop) {
+    AudioStreamBasicDescription format = lpcmFormat(48000, 1, 16, kAudioFormatFlagIsSignedInteger | kAudioFormatFlagIsPacked);
+    RampPlayer player(1, 0);
+    DrainRecorder recorder;
+    recorder.expected = 2;
+    AudioQueueRef queue = nullptr;
+    ASSERT_EQ(noErr, AudioQueueNewOutput(&format, drainCallback, &recorder, nullptr, nullptr, 0, &queue));
+    recorder.sink = attachCaptureSink(queue, 1, true);
+    ASSERT_EQ(noErr, AudioQueueAddPropertyListener(queue, kAudioQueueProperty_IsRunning, runningListener, &player));
+
+    // 100ms of audio, played in real time
+    for (int i = 0; i < 2; i++) {
+        AudioQueueBufferRef buffer;
+        ASSERT_EQ(noErr, AudioQueueAllocateBuffer(queue, 2400 * 2, &buffer));
+        buffer->mAudioDataByteSize = 2400 * 2;
+        memset(buffer->mAudioData, 0, buffer->mAudioDataByteSize);
+        ASSERT_EQ(noErr, AudioQueueEnqueueBuffer(queue, buffer, 0, nullptr));
+    }
+
+    ASSERT_EQ(noErr, AudioQueueStart(queue, nullptr));
+    ASSERT_EQ(noErr, AudioQueueStop(queue, false));
+    ASSERT_EQ(noErr, AudioQueueStart(queue, nullptr));
+
+    // The restart overrides the asynchronous stop, so the device keeps being fed once the audio has drained
+    size_t writesAtDrain;
+    {
+        std::unique_lock<std::mutex> lock(recorder.lock);
+        ASSERT_TRUE(recorder.drained.wait_for(lock, std::chrono::seconds(10), [&]() { return recorder.returned == recorder.expected; }));
+        writesAtDrain = recorder.writesAtDrain;
+    }
+    EXPECT_TRUE(recorder.sink->waitForWrites(writesAtDrain + 3));
+    EXPECT_TRUE(isRunning(queue));
+    EXPECT_EQ(1, player.runningChanges.load());
+
+    ASSERT_EQ(noErr, AudioQueueStop(queue, true));
+    EXPECT_FALSE(isRunning(queue));
+    EXPECT_EQ(2, player.runningChanges.load());
+    EXPECT_EQ(noErr, AudioQueueDispose(queue, true));
+}
+
+TEST(AudioQueue, AppliesTrimAndBufferParameters) {
+    AudioStreamBasicDescription format = lpcmFormat(44100, 1, 32, kAudioFormatFlagsNativeFloatPacked);
+    AudioQueueRef queue = nullptr;
+    ASSERT_EQ(noErr, AudioQueueNewOutput(&format, ignoreCallback, nullptr, nullptr, nullptr, 0, &queue));
+    CaptureSink* sink = attachCaptureSink(queue, 1, false);
+
+    enqueueConstant(queue, 0.8f, 1000, 100, 50, 0.5f);
+    enqueueConstant(queue, 0.8f, 1000, 0, 0, 1.0f);
+
+    ASSERT_EQ(noErr, AudioQueueStart(queue, nullptr));
+    ASSERT_EQ(noErr, AudioQueueStop(queue, false));
+    ASSERT_TRUE(waitUntilStopped(queue));
+
+    std::vector<float> samples = sink->samples();
+    ASSERT_EQ(1850, samples.size());
+    EXPECT_LT(fabsf(samples[0] - 0.4f), 1e-6f);
+    EXPECT_LT(fabsf(samples[849] - 0.4f), 1e-6f);
+    EXPECT_LT(fabsf(samples[850] - 0.8f), 1e-6f);
+    EXPECT_LT(fabsf(samples[1849] - 0.8f), 1e-6f);
+
+    EXPECT_EQ(noErr, AudioQueueDispose(queue, true));
+}
+
+struct TapState {
+    bool siphon = false;
+    UInt32 framesSeen = 0;
+    int startOfStream = 0;
+};
+
+static void tapCallback(void* clientData,
+                        AudioQueueProcessingTapRef tap,
+                        UInt32 frames,
+                        AudioTimeStamp* timeStamp,
+                        AudioQueueProcessingTapFlags* flags,
+                        UInt32* outFrames,
+                        AudioBufferList* data) {
+    TapState* state = (TapState*)clientData;
+    if (*flags & kAudioQueueProcessingTap_StartOfStream) {
+        state->startOfStream++;
+    }
+
+    AudioQueueProcessingTapGetSourceAudio(tap, frames, timeStamp, flags, outFrames, data);
+    state->framesSeen += *outFrames;
+
+    if (!state->siphon) {
+        float* samples = (float*)data->mBuffers[0].mData;
+        for (UInt32 i = 0; i < *outFrames; i++) {
+            samples[i] = -samples[i];
+        }
+    }
+}
+
+static std::vector<float> renderThroughTap(TapState* state, AudioQueueProcessingTapFlags flags) {
+    AudioStreamBasicDescription format = lpcmFormat(44100, 1, 32, kAudioFormatFlagsNativeFloatPacked);
+    AudioQueueRef queue = nullptr;
+    AudioQueueNewOutput(&format, ignoreCallback, nullptr, nullptr, nullptr, 0, &queue);
+    CaptureSink* sink = attachCaptureSink(queue, 1, false);
+
+    UInt32 maxFrames = 0;
+    AudioStreamBasicDescription processingFormat;
+    AudioQueueProcessingTapRef tap = nullptr;
+    EXPECT_EQ(noErr, AudioQueueProcessingTapNew(queue, tapCallback, state, flags, &maxFrames, &processingFormat, &tap));
+    EXPECT_TRUE(maxFrames > 0);
+    EXPECT_EQ(kAudioFormatFlagsNativeFloatPacked | kAudioFormatFlagIsNonInterleaved, processingFormat.mFormatFlags);
+
+    enqueueConstant(queue, 0.5f, 2000, 0, 0, 1.0f);
+    AudioQueueStart(queue, nullptr);
+    AudioQueueStop(queue, false);
+    EXPECT_TRUE(waitUntilStopped(queue));
+
+    std::vector<float> samples = sink->samples();
+    EXPECT_EQ(noErr, AudioQueueProcessingTapDispose(tap));
+    AudioQueueDispose(queue, true);
+    return samples;
+}
+
+TEST(AudioQueue, ProcessingTapReplacesAudio) {
+    TapState state;
+    std::vector<float> samples = renderThroughTap(&state, kAudioQueueProcessingTap_PreEffects);
+    ASSERT_EQ(2000, samples.size());
+    EXPECT_EQ(-0.5f, samples[0]);
+    EXPECT_EQ(-0.5f, samples[1999]);
+    EXPECT_TRUE(state.framesSeen >= 2000);
+    EXPECT_EQ(1, state.startOfStream);
+}
+
+TEST(AudioQueue, SiphoningTapLeavesAudioAlone) {
+    TapState state;
+    state.siphon = true;
+    std::vector<float> samples =
+        renderThroughTap(&state, kAudioQueueProcessingTap_PostEffects | kAudioQueueProcessingTap_Siphon);
+    ASSERT_EQ(2000, samples.size());
+    EXPECT_EQ(0.5f, samples[0]);
+    EXPECT_EQ(0.5f, samples[1999]);
+    EXPECT_TRUE(state.framesSeen >= 2000);
+}
+
+TEST(AudioQueue, WAVSinkWritesRenderedAudio) {
+    const UInt32 channels = 2;
+    const UInt32 totalFrames = 5000;
+    AudioStreamBasicDescription format = lpcmFormat(22050, channels, 16, kAudioFormatFlagIsSignedInteger | kAudioFormatFlagIsPacked);
+
+    NSArray* cachesPaths = NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSAllDomainsMask, YES);
+    NSString* directory = cachesPaths[0];
+    [[NSFileManager defaultManager] createDirectoryAtPath:directory withIntermediateDirectories:YES attributes:nil error:nil];
+    const char* path = [[directory stringByAppendingPathComponent:@"audioqueue_sink.wav"] UTF8String];
+
+    RampPlayer player(channels, totalFrames);
+    AudioQueueRef queue = nullptr;
+    ASSERT_EQ(noErr, AudioQueueNewOutput(&format, rampCallback, &player, nullptr, nullptr, 0, &queue));
+    ASSERT_EQ(noErr, AudioQueueSetSink(queue, AudioQueueCreateWAVSink(path, false)));
+
+    for (int i = 0; i < 2; i++) {
+        AudioQueueBufferRef buffer;
+        ASSERT_EQ(noErr, AudioQueueAllocateBuffer(queue, 700 * 2 * channels, &buffer));
+        player.fill(buffer);
+        ASSERT_EQ(noErr, AudioQueueEnqueueBuffer(queue, buffer, 0, nullptr));
+    }
+    ASSERT_EQ(noErr, AudioQueueStart(queue, nullptr));
+    ASSERT_TRUE(waitUntilStopped(queue));
+    EXPECT_EQ(noErr, AudioQueueDispose(queue, true));
+
+    FILE* file = fopen(path, "rb");
+    ASSERT_TRUE(file != nullptr);
+    std::vector<uint8_t> contents;
+    uint8_t chunk[4096];
+    size_t read;
+    while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        contents.insert(contents.end(), chunk, chunk + read);
+    }
+    fclose(file);
+
+    ASSERT_EQ(44 + totalFrames * channels * 2, contents.size());
+    EXPECT_EQ(0, memcmp(&contents[0], "RIFF", 4));
+    EXPECT_EQ(0, memcmp(&contents[36], "data", 4));
+    EXPECT_EQ(totalFrames * channels * 2, *(uint32_t*)&contents[40]);
+
+    // 16 bit samples survive the trip through Float32 unchanged
+    const int16_t* samples = (const int16_t*)&contents[44];
+    bool matches = true;
+    for (UInt32 frame = 0; frame < totalFrames; frame++) {
+        for (UInt32 channel = 0; channel < channels; channel++) {
+            matches &= samples[frame * channels + channel] == rampSample(frame, channel);
+        }
+    }
+    EXPECT_TRUE(matches);
+}
+
+// Paced by a real time sink, the way a device would pace it. Only what does not depend on the
+// machine being idle is checked; the timings are logged for comparison.
+TEST(AudioQueue, RealTimeJitterUnderrunsAndLatency) {
+    const UInt32 channels = 2;
+    const double sampleRate = 48000;
+    const UInt32 periodFrames = 480;
+    AudioStreamBasicDescription format = lpcmFormat(sampleRate, channels, 16, kAudioFormatFlagIsSignedInteger | kAudioFormatFlagIsPacked);
+
+    RampPlayer player(channels, 24000);
+    AudioQueueRef queue = nullptr;
+    ASSERT_EQ(noErr, AudioQueueNewOutput(&format, rampCallback, &player, nullptr, nullptr, 0, &queue));
+    CaptureSink* sink = attachCaptureSink(queue, channels, true);
+    ASSERT_EQ(noErr, AudioQueueSetProperty(queue, kAudioQueueProperty_DecodeBufferSizeFrames, &periodFrames, sizeof(periodFrames)));
+
+    for (int i = 0; i < 3; i++) {
+        AudioQueueBufferRef buffer;
+        ASSERT_EQ(noErr, AudioQueueAllocateBuffer(queue, 960 * 2 * channels, &buffer));
+        player.fill(buffer);
+        ASSERT_EQ(noErr, AudioQueueEnqueueBuffer(queue, buffer, 0, nullptr));
+    }
+
+    Clock::time_point started = Clock::now();
+    ASSERT_EQ(noErr, AudioQueueStart(queue, nullptr));
+    ASSERT_TRUE(waitUntilStopped(queue));
+    double elapsed = std::chrono::duration<double>(Clock::now() - started).count();
+
+    // Buffers are refilled from the render thread itself, so however late it runs it never starves
+    AudioQueueRenderStatistics stats;
+    ASSERT_EQ(noErr, AudioQueueGetRenderStatistics(queue, &stats));
+    EXPECT_EQ(0, stats.underruns);
+    EXPECT_EQ(player.totalFrames, stats.frames);
+    EXPECT_EQ(player.totalFrames / 960, (UInt32)player.completed);
+
+    // Every write is a whole period, bar the last of the drained stop, and the ramp is intact
+    std::vector<CaptureSink::Write> writes = sink->writes();
+    ASSERT_EQ(player.totalFrames / periodFrames, writes.size());
+    for (const CaptureSink::Write& write : writes) {
+        EXPECT_EQ(periodFrames, write.frames);
+    }
+    std::vector<float> rendered = sink->samples();
+    ASSERT_EQ(player.totalFrames * channels, rendered.size());
+    bool matches = true;
+    for (UInt32 frame = 0; frame < player.totalFrames && matches; frame++) {
+        for (UInt32 channel = 0; channel < channels; channel++) {
+            matches &= rendered[frame * channels + channel] == rampSample(frame, channel) / 32768.0f;
+        }
+    }
+    EXPECT_TRUE(matches);
+
+    // Skip the writes that only fill the device's buffer
+    double period = periodFrames / sampleRate;
+    double worst = 0;
+    for (size_t i = 3; i + 1 < writes.size(); i++) {
+        double interval = std::chrono::duration<double>(writes[i].time - writes[i - 1].time).count();
+        worst = std::max(worst, fabs(interval - period));
+    }
+    LOG_INFO("%zu periods in %.3f s, worst jitter %.2f ms", writes.size(), elapsed, worst * 1000);
+
+    // End-to-end latency: an impulse enqueued into a running queue, until the device plays it
+    std::vector<float> impulse(periodFrames * channels, 1.0f);
+    AudioQueueBufferRef buffer;
+    ASSERT_EQ(noErr, AudioQueueAllocateBuffer(queue, impulse.size() * 2, &buffer));
+    std::fill((int16_t*)buffer->mAudioData, (int16_t*)buffer->mAudioData + impulse.size(), 16384);
+    buffer->mAudioDataByteSize = impulse.size() * 2;
+
+    size_t before = sink->writes().size();
+    size_t samplesBefore = sink->samples().size();
+    player.stopping = true;
+    ASSERT_EQ(noErr, AudioQueueStart(queue, nullptr));
+    ASSERT_TRUE(sink->waitForWrites(before + 2));
+
+    // The impulse is picked up by the next period rendered, at most two writes on
+    size_t queued = sink->writes().size();
+    Clock::time_point enqueued = Clock::now();
+    ASSERT_EQ(noErr, AudioQueueEnqueueBuffer(queue, buffer, 0, nullptr));
+    ASSERT_TRUE(sink->waitForWrites(queued + 3));
+    ASSERT_EQ(noErr, AudioQueueStop(queue, true));
+
+    std::vector<CaptureSink::Write> after = sink->writes();
+    std::vector<float> samples = sink->samples();
+    double latency = -1;
+    size_t offset = samplesBefore;
+    for (size_t i = before; i < after.size() && latency < 0; i++) {
+        for (UInt32 frame = 0; frame < after[i].frames; frame++) {
+            if (samples[offset + frame * channels] != 0.0f) {
+                // Played once everything already queued at the device, then the frames ahead of it in this write, are heard
+                double heard = ((double)after[i].latency - after[i].frames + frame) / sampleRate;
+                latency = std::chrono::duration<double>(after[i].time - enqueued).count() + heard;
+                break;
+            }
+        }
+        offset += after[i].frames * channels;
+    }
+    LOG_INFO("End-to-end latency %.2f ms", latency * 1000);
+    EXPECT_TRUE(latency >= 0);
+
+    // It comes out exactly once and whole, between silent underrun periods
+    size_t played = 0;
+    for (size_t i = samplesBefore; i < samples.size(); i++) {
+        if (samples[i] != 0.0f) {
+            EXPECT_EQ(0.5f, samples[i]);
+            played++;
+        }
+    }
+    EXPECT_EQ(impulse.size(), played);
+
+    EXPECT_EQ(noErr, AudioQueueDispose(queue, true));
+}
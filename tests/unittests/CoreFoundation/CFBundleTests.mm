@@ -0,0 +1,294 @@
+//******************************************************************************
+//
+// Copyright (c) 2016 Microsoft Corporation. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+#import <TestFramework.h>
+#import <CoreFoundation/CoreFoundation.h>
+#import <Foundation/Foundation.h>
+#import <windows.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+CF_EXPORT CFURLRef _CFURLCreateCurrentDirectoryURL(CFAllocatorRef allocator);
+CF_EXPORT void _CFBundleFlushCachesForURL(CFURLRef url);
+
+// Lookups through a bundle object are answered from its resource index, while lookups by bundle URL
+// still read the directories, so the two are compared against each other on a bundle built on disk.
+
+static const char* s_files[] = {
+    "Root.png",
+    "Root@2x.png",
+    "Data.json",
+    "Images/Icon.png",
+    "Images/Icon@2x.png",
+    "Images/Large/Icon.png",
+    "Sounds/Click.wav",
+    "Base.lproj/Main.storyboardc/Info.plist",
+    "Base.lproj/Images/Header.png",
+    "Base.lproj/Localizable.strings",
+    "en.lproj/Localizable.strings",
+    "en.lproj/Images/Icon.png",
+    "fr.lproj/Localizable.strings",
+    "fr.lproj/Data.json",
+};
+
+static const struct {
+    const char* name;
+    const char* type;
+    const char* subDirectory;
+} s_queries[] = {
+    { "Root", "png", nullptr },
+    { "Root@2x", "png", nullptr },
+    { "Root.png", nullptr, nullptr },
+    { "Data", "json", nullptr },
+    { "Icon", "png", "Images" },
+    { "Icon", "png", "Images/Large" },
+    { "Icon", "png", "Images/Large/" },
+    { "Icon", "png", "Images/Missing" },
+    { "Icon", "png", nullptr },
+    { "Header", "png", "Images" },
+    { "Main", "storyboardc", nullptr },
+    { "Info", "plist", "Main.storyboardc" },
+    { "Localizable", "strings", nullptr },
+    { "Click", "wav", "Sounds" },
+    { "Images", nullptr, nullptr },
+    { "Missing", "png", nullptr },
+    { "Icon", "png", "../Images" },
+};
+
+static CFURLRef createURL(CFURLRef base, const std::string& relativePath, bool isDirectory) {
+    CFStringRef path = CFStringCreateWithCString(nullptr, relativePath.c_str(), kCFStringEncodingUTF8);
+    CFURLRef url = CFURLCreateCopyAppendingPathComponent(nullptr, base, path, isDirectory);
+    CFRelease(path);
+    return url;
+}
+
+static void writeFile(CFURLRef bundleURL, const std::string& relativePath) {
+    for (size_t slash = relativePath.find('/'); slash != std::string::npos; slash = relativePath.find('/', slash + 1)) {
+        CFURLRef directory = createURL(bundleURL, relativePath.substr(0, slash), true);
+        CFURLWriteDataAndPropertiesToResource(directory, nullptr, nullptr, nullptr);
+        CFRelease(directory);
+    }
+
+    CFURLRef url = createURL(bundleURL, relativePath, false);
+    CFDataRef data = CFDataCreate(nullptr, reinterpret_cast<const UInt8*>(relativePath.c_str()), relativePath.size());
+    EXPECT_TRUE(CFURLWriteDataAndPropertiesToResource(url, data, nullptr, nullptr)) << relativePath;
+    CFRelease(data);
+    CFRelease(url);
+}
+
+static CFURLRef createBundleOnDisk(const std::vector<std::string>& files) {
+    CFURLRef currentDirectory = _CFURLCreateCurrentDirectoryURL(nullptr);
+    CFURLRef tmp = createURL(currentDirectory, "tmp", true);
+    CFURLWriteDataAndPropertiesToResource(tmp, nullptr, nullptr, nullptr);
+
+    CFUUIDRef uuid = CFUUIDCreate(nullptr);
+    CFStringRef uuidString = CFUUIDCreateString(nullptr, uuid);
+    CFStringRef name = CFStringCreateWithFormat(nullptr, nullptr, CFSTR("CFBundleTests-%@.bundle"), uuidString);
+    CFURLRef bundleURL = CFURLCreateCopyAppendingPathComponent(nullptr, tmp, name, true);
+    EXPECT_TRUE(CFURLWriteDataAndPropertiesToResource(bundleURL, nullptr, nullptr, nullptr));
+    CFRelease(name);
+    CFRelease(uuidString);
+    CFRelease(uuid);
+    CFRelease(tmp);
+    CFRelease(currentDirectory);
+
+    CFURLRef infoURL = createURL(bundleURL, "Info.plist", false);
+    const char info[] =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<plist version=\"1.0\"><dict><key>CFBundleDevelopmentRegion</key><string>en</string></dict></plist>\n";
+    CFDataRef data = CFDataCreate(nullptr, reinterpret_cast<const UInt8*>(info), sizeof(info) - 1);
+    EXPECT_TRUE(CFURLWriteDataAndPropertiesToResource(infoURL, data, nullptr, nullptr));
+    CFRelease(data);
+    CFRelease(infoURL);
+
+    for (const std::string& file : files) {
+        writeFile(bundleURL, file);
+    }
+    return bundleURL;
+}
+
+// Forgets the bundle and its saved index, and deletes it from disk
+static void destroyBundleOnDisk(CFURLRef bundleURL) {
+    _CFBundleFlushCachesForURL(bundleURL);
+    CFURLRef absoluteURL = CFURLCopyAbsoluteURL(bundleURL);
+    CFStringRef path = CFURLCopyFileSystemPath(absoluteURL, kCFURLWindowsPathStyle);
+    EXPECT_TRUE([[NSFileManager defaultManager] removeItemAtPath:(__bridge NSString*)path error:nil]);
+    CFRelease(path);
+    CFRelease(absoluteURL);
+    CFRelease(bundleURL);
+}
+
+// Moves the modification date of the bundle directory back past the time its resource index needs
+// to settle before it is saved, as if the bundle had been written a while ago
+static void backdateBundleOnDisk(CFURLRef bundleURL) {
+    CFURLRef absoluteURL = CFURLCopyAbsoluteURL(bundleURL);
+    CFStringRef path = CFURLCopyFileSystemPath(absoluteURL, kCFURLWindowsPathStyle);
+    std::vector<UniChar> characters(CFStringGetLength(path) + 1);
+    CFStringGetCharacters(path, CFRangeMake(0, characters.size() - 1), characters.data());
+    CFRelease(path);
+    CFRelease(absoluteURL);
+
+    CREATEFILE2_EXTENDED_PARAMETERS parameters = {};
+    parameters.dwSize = sizeof(parameters);
+    parameters.dwFileFlags = FILE_FLAG_BACKUP_SEMANTICS; // Needed to open a directory
+    HANDLE directory = CreateFile2(reinterpret_cast<const wchar_t*>(characters.data()),
+                                   FILE_WRITE_ATTRIBUTES,
+                                   FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                   OPEN_EXISTING,
+                                   &parameters);
+    ASSERT_NE(INVALID_HANDLE_VALUE, directory);
+
+    FILETIME now;
+    GetSystemTimeAsFileTime(&now);
+    ULARGE_INTEGER time;
+    time.LowPart = now.dwLowDateTime;
+    time.HighPart = now.dwHighDateTime;
+    time.QuadPart -= 10 * 10000000ULL; // Ten seconds, in 100 ns units
+    FILETIME modified = { time.LowPart, time.HighPart };
+    EXPECT_TRUE(SetFileTime(directory, nullptr, nullptr, &modified));
+    CloseHandle(directory);
+}
+
+static std::string copyPath(CFURLRef url) {
+    if (!url) {
+        return "(none)";
+    }
+    CFURLRef absoluteURL = CFURLCopyAbsoluteURL(url);
+    CFStringRef path = CFURLCopyFileSystemPath(absoluteURL, kCFURLWindowsPathStyle);
+    char buffer[1024] = {};
+    CFStringGetCString(path, buffer, sizeof(buffer), kCFStringEncodingUTF8);
+    CFRelease(path);
+    CFRelease(absoluteURL);
+    CFRelease(url);
+    return buffer;
+}
+
+static CFStringRef createString(const char* string) {
+    return string ? CFStringCreateWithCString(nullptr, string, kCFStringEncodingUTF8) : nullptr;
+}
+
+static void releaseIfNotNull(CFTypeRef object) {
+    if (object) {
+        CFRelease(object);
+    }
+}
+
+static void expectIndexedLookupsMatchDirectoryLookups(CFURLRef bundleURL) {
+    CFBundleRef bundle = CFBundleCreate(nullptr, bundleURL);
+    ASSERT_NE(nullptr, bundle);
+
+    for (const auto& query : s_queries) {
+        CFStringRef name = createString(query.name);
+        CFStringRef type = createString(query.type);
+        CFStringRef subDirectory = createString(query.subDirectory);
+
+        EXPECT_EQ(copyPath(CFBundleCopyResourceURLInDirectory(bundleURL, name, type, subDirectory)),
+                  copyPath(CFBundleCopyResourceURL(bundle, name, type, subDirectory)))
+            << query.name << "." << (query.type ? query.type : "") << " in " << (query.subDirectory ? query.subDirectory : "(root)");
+
+        if (type) {
+            CFArrayRef expected = CFBundleCopyResourceURLsOfTypeInDirectory(bundleURL, type, subDirectory);
+            CFArrayRef actual = CFBundleCopyResourceURLsOfType(bundle, type, subDirectory);
+            EXPECT_EQ(expected ? CFArrayGetCount(expected) : 0, actual ? CFArrayGetCount(actual) : 0) << "all ." << query.type;
+            releaseIfNotNull(expected);
+            releaseIfNotNull(actual);
+        }
+
+        releaseIfNotNull(subDirectory);
+        releaseIfNotNull(type);
+        releaseIfNotNull(name);
+    }
+
+    CFRelease(bundle);
+}
+
+static bool bundleHasResource(CFURLRef bundleURL, CFStringRef name, CFStringRef type, CFStringRef subDirectory) {
+    CFBundleRef bundle = CFBundleCreate(nullptr, bundleURL);
+    CFURLRef url = CFBundleCopyResourceURL(bundle, name, type, subDirectory);
+    releaseIfNotNull(url);
+    CFRelease(bundle);
+    return url != nullptr;
+}
+
+TEST(CFBundle, ResourceIndexMatchesDirectoryLookups) {
+    CFURLRef bundleURL = createBundleOnDisk(std::vector<std::string>(std::begin(s_files), std::end(s_files)));
+
+    // Once while the bundle is still being written to, when the index is not kept, and again after
+    // it has settled and the index has been saved and read back
+    expectIndexedLookupsMatchDirectoryLookups(bundleURL);
+    backdateBundleOnDisk(bundleURL);
+    expectIndexedLookupsMatchDirectoryLookups(bundleURL);
+    expectIndexedLookupsMatchDirectoryLookups(bundleURL);
+
+    // A new file at the top changes the modification date of the bundle directory
+    writeFile(bundleURL, "Added.png");
+    EXPECT_TRUE(bundleHasResource(bundleURL, CFSTR("Added"), CFSTR("png"), nullptr));
+
+    // Further down it does not, so the cache has to be flushed
+    backdateBundleOnDisk(bundleURL);
+    EXPECT_FALSE(bundleHasResource(bundleURL, CFSTR("Added"), CFSTR("png"), CFSTR("Images")));
+    writeFile(bundleURL, "Images/Added.png");
+    _CFBundleFlushCachesForURL(bundleURL);
+    EXPECT_TRUE(bundleHasResource(bundleURL, CFSTR("Added"), CFSTR("png"), CFSTR("Images")));
+    expectIndexedLookupsMatchDirectoryLookups(bundleURL);
+
+    destroyBundleOnDisk(bundleURL);
+}
+
+TEST(CFBundle, ResourceIndexColdStart) {
+    // An app sized bundle: a few hundred images across nested folders and a dozen localizations
+    std::vector<std::string> files;
+    const char* localizations[] = { "Base", "en", "fr", "de", "es", "it", "ja", "ko", "nl", "pt", "ru", "zh-Hans" };
+    for (int folder = 0; folder < 16; folder++) {
+        for (int image = 0; image < 24; image++) {
+            files.push_back("Assets/Folder" + std::to_string(folder) + "/Image" + std::to_string(image) + ".png");
+        }
+    }
+    for (const char* localization : localizations) {
+        files.push_back(std::string(localization) + ".lproj/Localizable.strings");
+        files.push_back(std::string(localization) + ".lproj/Assets/Folder0/Title.png");
+    }
+    CFURLRef bundleURL = createBundleOnDisk(files);
+    backdateBundleOnDisk(bundleURL);
+    _CFBundleFlushCachesForURL(bundleURL);
+
+    // Each launch opens the bundle and looks up one image in every folder
+    auto launch = [bundleURL]() {
+        auto start = std::chrono::steady_clock::now();
+        CFBundleRef bundle = CFBundleCreate(nullptr, bundleURL);
+        for (int folder = 0; folder < 16; folder++) {
+            CFStringRef subDirectory = CFStringCreateWithFormat(nullptr, nullptr, CFSTR("Assets/Folder%d"), folder);
+            CFURLRef url = CFBundleCopyResourceURL(bundle, CFSTR("Image7"), CFSTR("png"), subDirectory);
+            EXPECT_NE(nullptr, url);
+            releaseIfNotNull(url);
+            CFRelease(subDirectory);
+        }
+        CFRelease(bundle);
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    const int launches = 20;
+    double first = launch();
+    double later = 0;
+    for (int i = 0; i < launches; i++) {
+        later += launch();
+    }
+    LOG_INFO("Bundle with %d files: first launch %.2f ms, later launches %.2f ms", (int)files.size(), first, later / launches);
+
+    destroyBundleOnDisk(bundleURL);
+}
@@ -0,0 +1,201 @@
+//******************************************************************************
+//
+// Copyright (c) 2016 Microsoft Corporation. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+#import <TestFramework.h>
+#import <CoreFoundation/CoreFoundation.h>
+
+#import <cmath>
+#import <memory>
+#import <random>
+#import <string>
+#import <vector>
+#import <unicode/basictz.h>
+#import <unicode/strenum.h>
+#import <unicode/timezone.h>
+#import <unicode/tztrans.h>
+#import <unicode/ucal.h>
+
+// Gregorian dates are worked out natively, without ICU, so every component is compared against a
+// UCalendar set up the same way: over the whole fast path range and either side of it, and at
+// every transition, where a wall clock time can be skipped or repeated.
+
+static const struct {
+    char ch;
+    UCalendarDateFields field;
+} s_fields[] = { { 'G', UCAL_ERA },
+                 { 'y', UCAL_YEAR },
+                 { 'M', UCAL_MONTH },
+                 { 'd', UCAL_DAY_OF_MONTH },
+                 { 'h', UCAL_HOUR },
+                 { 'H', UCAL_HOUR_OF_DAY },
+                 { 'm', UCAL_MINUTE },
+                 { 's', UCAL_SECOND },
+                 { 'S', UCAL_MILLISECOND },
+                 { 'w', UCAL_WEEK_OF_YEAR },
+                 { 'W', UCAL_WEEK_OF_MONTH },
+                 { 'Y', UCAL_YEAR_WOY },
+                 { 'E', UCAL_DAY_OF_WEEK },
+                 { 'D', UCAL_DAY_OF_YEAR },
+                 { 'F', UCAL_DAY_OF_WEEK_IN_MONTH },
+                 { 'a', UCAL_AM_PM },
+                 { 'l', UCAL_IS_LEAP_MONTH },
+                 { 'g', UCAL_JULIAN_DAY } };
+
+static std::vector<int> decompose(CFCalendarRef calendar, CFAbsoluteTime at) {
+    std::vector<int> v(18, -1);
+    EXPECT_TRUE(CFCalendarDecomposeAbsoluteTime(calendar,
+                                                 at,
+                                                 "GyMdhHmsSwWYEDFalg",
+                                                 &v[0],
+                                                 &v[1],
+                                                 &v[2],
+                                                 &v[3],
+                                                 &v[4],
+                                                 &v[5],
+                                                 &v[6],
+                                                 &v[7],
+                                                 &v[8],
+                                                 &v[9],
+                                                 &v[10],
+                                                 &v[11],
+                                                 &v[12],
+                                                 &v[13],
+                                                 &v[14],
+                                                 &v[15],
+                                                 &v[16],
+                                                 &v[17]));
+    return v;
+}
+
+static std::vector<int> decompose(UCalendar* calendar, CFAbsoluteTime at) {
+    UErrorCode status = U_ZERO_ERROR;
+    ucal_clear(calendar);
+    ucal_setMillis(calendar, floor((at + kCFAbsoluteTimeIntervalSince1970) * 1000.0), &status);
+    std::vector<int> v;
+    for (const auto& field : s_fields) {
+        v.push_back(ucal_get(calendar, field.field, &status) + (UCAL_MONTH == field.field ? 1 : 0));
+    }
+    EXPECT_TRUE(U_SUCCESS(status));
+    return v;
+}
+
+// year, month, day, hour, minute, second, millisecond
+static CFAbsoluteTime compose(UCalendar* calendar, const int (&v)[7]) {
+    static const UCalendarDateFields fields[] = { UCAL_YEAR, UCAL_MONTH, UCAL_DAY_OF_MONTH, UCAL_HOUR_OF_DAY, UCAL_MINUTE, UCAL_SECOND, UCAL_MILLISECOND };
+    UErrorCode status = U_ZERO_ERROR;
+    ucal_clear(calendar);
+    for (int i = 0; i < 7; i++) {
+        ucal_set(calendar, fields[i], v[i] - (UCAL_MONTH == fields[i] ? 1 : 0));
+    }
+    UDate udate = ucal_getMillis(calendar, &status);
+    EXPECT_TRUE(U_SUCCESS(status));
+    return (udate / 1000.0) - kCFAbsoluteTimeIntervalSince1970;
+}
+
+TEST(CFCalendar, GregorianMatchesICU) {
+    const CFAbsoluteTime start = -14000000000.0; // 1557, before the fast path starts
+    const CFAbsoluteTime end = 300000000000.0; // 11507, after it ends
+    std::mt19937 random(73);
+
+    UErrorCode status = U_ZERO_ERROR;
+    std::unique_ptr<icu::StringEnumeration> ids(icu::TimeZone::createEnumeration(status));
+    ASSERT_TRUE(U_SUCCESS(status));
+
+    int zones = 0;
+    const icu::UnicodeString* id;
+    while ((id = ids->snext(status)) != nullptr) {
+        CFStringRef name = CFStringCreateWithCharacters(nullptr, reinterpret_cast<const UniChar*>(id->getBuffer()), id->length());
+        CFTimeZoneRef tz = CFTimeZoneCreateWithName(nullptr, name, false);
+        CFRelease(name);
+        if (!tz) {
+            continue;
+        }
+
+        std::string utf8Name;
+        id->toUTF8String(utf8Name);
+        std::unique_ptr<icu::TimeZone> icuZone(icu::TimeZone::createTimeZone(*id));
+
+        // Week numbering depends on these, so move them around from zone to zone
+        int firstWeekday = 1 + random() % 7;
+        int minimumDays = 1 + random() % 7;
+        CFCalendarRef calendar = CFCalendarCreateWithIdentifier(nullptr, kCFGregorianCalendar);
+        CFCalendarSetTimeZone(calendar, tz);
+        CFCalendarSetFirstWeekday(calendar, firstWeekday);
+        CFCalendarSetMinimumDaysInFirstWeek(calendar, minimumDays);
+
+        UCalendar* reference = ucal_open(id->getBuffer(), id->length(), "en_US@calendar=gregorian", UCAL_DEFAULT, &status);
+        ASSERT_TRUE(U_SUCCESS(status));
+        ucal_setAttribute(reference, UCAL_FIRST_DAY_OF_WEEK, firstWeekday);
+        ucal_setAttribute(reference, UCAL_MINIMAL_DAYS_IN_FIRST_WEEK, minimumDays);
+
+        std::vector<CFAbsoluteTime> times;
+        for (int i = 0; i < 200; i++) {
+            times.push_back(start + (end - start) * (random() / (double)random.max()));
+            times.push_back(-3187296000.0 + 6311433600.0 * (random() / (double)random.max())); // 1900 to 2100
+        }
+        icu::BasicTimeZone* basicZone = dynamic_cast<icu::BasicTimeZone*>(icuZone.get());
+        icu::TimeZoneTransition transition;
+        UDate date = -2300000000000.0;
+        while (basicZone && basicZone->getNextTransition(date, false, transition) && (transition.getTime() < 4200000000000.0)) {
+            date = transition.getTime();
+            CFAbsoluteTime at = date / 1000 - kCFAbsoluteTimeIntervalSince1970;
+            times.insert(times.end(), { at - 3600, at - 1800, at - 0.001, at, at + 1800, at + 3600 });
+        }
+
+        for (CFAbsoluteTime at : times) {
+            std::vector<int> expected = decompose(reference, at);
+            ASSERT_EQ(expected, decompose(calendar, at)) << utf8Name << " at " << at;
+
+            // Back again, and with fields out of their ranges, which ICU carries into the next one
+            int fields[7] = { expected[1], expected[2], expected[3], expected[5], expected[6], expected[7], expected[8] };
+            for (int variant = 0; variant < 2; variant++) {
+                if (variant) {
+                    fields[1] += (int)(random() % 30) - 15;
+                    fields[2] += (int)(random() % 80) - 40;
+                    fields[3] += (int)(random() % 60) - 30;
+                    fields[4] += (int)(random() % 200) - 100;
+                }
+                CFAbsoluteTime composed = NAN;
+                EXPECT_TRUE(CFCalendarComposeAbsoluteTime(
+                    calendar, &composed, "yMdHmsS", fields[0], fields[1], fields[2], fields[3], fields[4], fields[5], fields[6]));
+                ASSERT_EQ(compose(reference, fields), composed) << utf8Name << " from " << fields[0] << "-" << fields[1] << "-" << fields[2]
+                                                                << " " << fields[3] << ":" << fields[4] << ":" << fields[5];
+            }
+        }
+
+        ucal_close(reference);
+        CFRelease(calendar);
+        CFRelease(tz);
+        zones++;
+    }
+
+    EXPECT_LT(300, zones);
+}
+
+TEST(CFCalendar, OtherCalendarsAreUnaffected) {
+    // Other calendars keep going through ICU
+    CFCalendarRef hebrew = CFCalendarCreateWithIdentifier(nullptr, kCFHebrewCalendar);
+    CFTimeZoneRef gmt = CFTimeZoneCreateWithTimeIntervalFromGMT(nullptr, 0);
+    CFCalendarSetTimeZone(hebrew, gmt);
+
+    int year = 0, month = 0, day = 0;
+    ASSERT_TRUE(CFCalendarDecomposeAbsoluteTime(hebrew, 0, "yMd", &year, &month, &day));
+    EXPECT_EQ(5761, year); // 2001-01-01 is 6 Tevet 5761
+    EXPECT_EQ(6, day);
+
+    CFRelease(gmt);
+    CFRelease(hebrew);
+}
@@ -0,0 +1,305 @@
+//******************************************************************************
+//
+// Copyright (c) 2016 Microsoft Corporation. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+#import <TestFramework.h>
+#import <CoreFoundation/CoreFoundation.h>
+
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <windows.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <random>
+#include <thread>
+#include <vector>
+
+// The socket manager keeps a poll set that sockets are armed in and disarmed from as their
+// callbacks are enabled and disabled, so these tests use far more sockets than fit in an fd_set
+// and check that every datagram is delivered, again after the callbacks are re-enabled.
+
+class WinSock {
+public:
+    WinSock() {
+        WSADATA data;
+        EXPECT_EQ(0, WSAStartup(MAKEWORD(2, 2), &data));
+    }
+    ~WinSock() {
+        WSACleanup();
+    }
+};
+
+static SOCKET createUDPSocket(sockaddr_in* address) {
+    SOCKET sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    EXPECT_NE(INVALID_SOCKET, sock);
+    memset(address, 0, sizeof(*address));
+    address->sin_family = AF_INET;
+    address->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    EXPECT_EQ(0, bind(sock, reinterpret_cast<sockaddr*>(address), sizeof(*address)));
+    int length = sizeof(*address);
+    EXPECT_EQ(0, getsockname(sock, reinterpret_cast<sockaddr*>(address), &length));
+    return sock;
+}
+
+static int64_t now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct Received {
+    int count = 0;
+    CFIndex bytes = 0;
+    std::vector<int64_t> latencies;
+};
+
+static void dataCallBack(CFSocketRef s, CFSocketCallBackType type, CFDataRef address, const void* data, void* info) {
+    Received* received = static_cast<Received*>(info);
+    CFDataRef bytes = static_cast<CFDataRef>(data);
+    if (type != kCFSocketDataCallBack || CFDataGetLength(bytes) == 0) {
+        return;
+    }
+    received->count++;
+    received->bytes += CFDataGetLength(bytes);
+    if (CFDataGetLength(bytes) == sizeof(int64_t)) {
+        int64_t sent;
+        memcpy(&sent, CFDataGetBytePtr(bytes), sizeof(sent));
+        received->latencies.push_back(now() - sent);
+    }
+}
+
+struct Sockets {
+    std::vector<CFSocketRef> sockets;
+    std::vector<CFRunLoopSourceRef> sources;
+    std::vector<sockaddr_in> addresses;
+
+    Sockets(int count, Received* received) {
+        CFSocketContext context = { 0, received, nullptr, nullptr, nullptr };
+        for (int i = 0; i < count; i++) {
+            sockaddr_in address;
+            SOCKET sock = createUDPSocket(&address);
+            CFSocketRef s = CFSocketCreateWithNative(nullptr, sock, kCFSocketDataCallBack, dataCallBack, &context);
+            CFRunLoopSourceRef source = CFSocketCreateRunLoopSource(nullptr, s, 0);
+            CFRunLoopAddSource(CFRunLoopGetCurrent(), source, kCFRunLoopDefaultMode);
+            sockets.push_back(s);
+            sources.push_back(source);
+            addresses.push_back(address);
+        }
+    }
+
+    ~Sockets() {
+        for (size_t i = 0; i < sockets.size(); i++) {
+            CFSocketInvalidate(sockets[i]);
+            CFRelease(sources[i]);
+            CFRelease(sockets[i]);
+        }
+    }
+};
+
+static void sendToEach(SOCKET sender, const std::vector<sockaddr_in>& addresses, int times) {
+    for (int i = 0; i < times; i++) {
+        for (const sockaddr_in& address : addresses) {
+            char c = 'x';
+            EXPECT_EQ(1, sendto(sender, &c, 1, 0, reinterpret_cast<const sockaddr*>(&address), sizeof(address)));
+        }
+    }
+}
+
+static bool runUntil(const std::function<bool()>& done, double seconds) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(seconds);
+    while (!done()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        CFRunLoopRunInMode(kCFRunLoopDefaultMode, 0.01, true);
+    }
+    return true;
+}
+
+TEST(CFSocket, DeliversToManySockets) {
+    WinSock winsock;
+    const int count = 2000;
+    Received received;
+    sockaddr_in senderAddress;
+    SOCKET sender = createUDPSocket(&senderAddress);
+    {
+        Sockets sockets(count, &received);
+
+        sendToEach(sender, sockets.addresses, 1);
+        EXPECT_TRUE(runUntil([&]() { return received.count == count; }, 10));
+        EXPECT_EQ(count, received.count);
+
+        // Data callbacks are re-enabled after each one, so every socket hears from us again
+        sendToEach(sender, sockets.addresses, 2);
+        EXPECT_TRUE(runUntil([&]() { return received.count == 3 * count; }, 10));
+        EXPECT_EQ(3 * count, received.count);
+
+        // Nothing is delivered to a disabled socket until it is enabled again
+        CFSocketDisableCallBacks(sockets.sockets[0], kCFSocketDataCallBack);
+        sendToEach(sender, sockets.addresses, 1);
+        EXPECT_TRUE(runUntil([&]() { return received.count == 4 * count - 1; }, 10));
+        runUntil([]() { return false; }, 0.1);
+        EXPECT_EQ(4 * count - 1, received.count);
+        CFSocketEnableCallBacks(sockets.sockets[0], kCFSocketDataCallBack);
+        EXPECT_TRUE(runUntil([&]() { return received.count == 4 * count; }, 10));
+    }
+
+    // Sockets created after those were invalidated may be handed the same descriptors
+    Received reused;
+    {
+        Sockets sockets(count / 4, &reused);
+        sendToEach(sender, sockets.addresses, 1);
+        EXPECT_TRUE(runUntil([&]() { return reused.count == count / 4; }, 10));
+    }
+    EXPECT_EQ(4 * count, received.count);
+    closesocket(sender);
+}
+
+struct Connection {
+    CFSocketRef accepted = nullptr;
+    CFRunLoopSourceRef acceptedSource = nullptr;
+    bool connected = false;
+    int writable = 0;
+    Received received;
+};
+
+static void connectionCallBack(CFSocketRef s, CFSocketCallBackType type, CFDataRef address, const void* data, void* info) {
+    Connection* connection = static_cast<Connection*>(info);
+    if (type == kCFSocketAcceptCallBack) {
+        CFSocketContext context = { 0, &connection->received, nullptr, nullptr, nullptr };
+        connection->accepted =
+            CFSocketCreateWithNative(nullptr, *static_cast<const CFSocketNativeHandle*>(data), kCFSocketDataCallBack, dataCallBack, &context);
+        connection->acceptedSource = CFSocketCreateRunLoopSource(nullptr, connection->accepted, 0);
+        CFRunLoopAddSource(CFRunLoopGetCurrent(), connection->acceptedSource, kCFRunLoopDefaultMode);
+    } else if (type == kCFSocketConnectCallBack) {
+        connection->connected = (data == nullptr);
+    } else if (type == kCFSocketWriteCallBack) {
+        connection->writable++;
+    }
+}
+
+TEST(CFSocket, ConnectAcceptAndWrite) {
+    WinSock winsock;
+    Connection connection;
+    CFSocketContext context = { 0, &connection, nullptr, nullptr, nullptr };
+
+    CFSocketRef listener =
+        CFSocketCreate(nullptr, PF_INET, SOCK_STREAM, IPPROTO_TCP, kCFSocketAcceptCallBack, connectionCallBack, &context);
+    ASSERT_NE(nullptr, listener);
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    CFDataRef addressData = CFDataCreate(nullptr, reinterpret_cast<const UInt8*>(&address), sizeof(address));
+    ASSERT_EQ(kCFSocketSuccess, CFSocketSetAddress(listener, addressData));
+    CFRelease(addressData);
+    addressData = CFSocketCopyAddress(listener);
+    CFRunLoopSourceRef listenerSource = CFSocketCreateRunLoopSource(nullptr, listener, 0);
+    CFRunLoopAddSource(CFRunLoopGetCurrent(), listenerSource, kCFRunLoopDefaultMode);
+
+    CFSocketRef client = CFSocketCreate(nullptr,
+                                        PF_INET,
+                                        SOCK_STREAM,
+                                        IPPROTO_TCP,
+                                        kCFSocketConnectCallBack | kCFSocketWriteCallBack,
+                                        connectionCallBack,
+                                        &context);
+    ASSERT_NE(nullptr, client);
+    CFRunLoopSourceRef clientSource = CFSocketCreateRunLoopSource(nullptr, client, 0);
+    CFRunLoopAddSource(CFRunLoopGetCurrent(), clientSource, kCFRunLoopDefaultMode);
+
+    // A negative timeout connects in the background and reports back through the run loop
+    EXPECT_EQ(kCFSocketSuccess, CFSocketConnectToAddress(client, addressData, -1));
+    EXPECT_TRUE(runUntil([&]() { return connection.connected && connection.accepted; }, 10));
+    EXPECT_TRUE(runUntil([&]() { return connection.writable == 1; }, 10));
+
+    // Write callbacks aren't re-enabled automatically
+    runUntil([]() { return false; }, 0.1);
+    EXPECT_EQ(1, connection.writable);
+    CFSocketEnableCallBacks(client, kCFSocketWriteCallBack);
+    EXPECT_TRUE(runUntil([&]() { return connection.writable == 2; }, 10));
+
+    EXPECT_EQ(5, send(CFSocketGetNative(client), "hello", 5, 0));
+    EXPECT_TRUE(runUntil([&]() { return connection.received.bytes == 5; }, 10));
+
+    CFSocketInvalidate(client);
+    if (connection.accepted) {
+        CFSocketInvalidate(connection.accepted);
+        CFRelease(connection.acceptedSource);
+        CFRelease(connection.accepted);
+    }
+    CFSocketInvalidate(listener);
+    CFRelease(clientSource);
+    CFRelease(client);
+    CFRelease(listenerSource);
+    CFRelease(listener);
+    CFRelease(addressData);
+}
+
+static double processSeconds() {
+    FILETIME creation, exit, kernel, user;
+    GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user);
+    auto seconds = [](const FILETIME& time) {
+        return ((static_cast<uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime) / 1.0e7;
+    };
+    return seconds(kernel) + seconds(user);
+}
+
+TEST(CFSocket, ManagerLatency) {
+    // Many idle sockets and a steady trickle of datagrams to random ones among them, timed from
+    // the send to the data callback on this thread
+    WinSock winsock;
+    const int count = 10000;
+    const int datagrams = 50000;
+    Received received;
+    Sockets sockets(count, &received);
+    runUntil([]() { return false; }, 0.2);
+
+    sockaddr_in senderAddress;
+    SOCKET sender = createUDPSocket(&senderAddress);
+    double cpu = processSeconds();
+    auto start = std::chrono::steady_clock::now();
+    std::thread thread([&]() {
+        std::mt19937 random(75);
+        for (int i = 0; i < datagrams; i++) {
+            int64_t sent = now();
+            const sockaddr_in& address = sockets.addresses[random() % count];
+            sendto(sender, reinterpret_cast<const char*>(&sent), sizeof(sent), 0, reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+            if (i % 50 == 49) {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        }
+    });
+    runUntil([&]() { return received.count == datagrams; }, 60);
+    thread.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    cpu = processSeconds() - cpu;
+    closesocket(sender);
+
+    EXPECT_EQ(datagrams, received.count);
+    ASSERT_FALSE(received.latencies.empty());
+    std::sort(received.latencies.begin(), received.latencies.end());
+    double mean = 0;
+    for (int64_t latency : received.latencies) {
+        mean += latency;
+    }
+    mean /= received.latencies.size();
+    LOG_INFO("%d sockets: mean latency %.1f us, p99 %.1f us, %.0f datagrams/s, %.2f us CPU per datagram",
+             count,
+             mean / 1e3,
+             received.latencies[received.latencies.size() * 99 / 100] / 1e3,
+             received.count / seconds,
+             cpu * 1e6 / std::max(1, received.count));
+}
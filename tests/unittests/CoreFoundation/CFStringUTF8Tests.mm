@@ -0,0 +1,246 @@
+//******************************************************************************
+//
+// Copyright (c) 2016 Microsoft Corporation. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+#import <TestFramework.h>
+#import <CoreFoundation/CoreFoundation.h>
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+// The converters move ASCII 16 bytes at a time and the rest one sequence at a time, so these
+// tests mix runs of every length with every sequence length and compare against a plain
+// one-code-point-at-a-time reference.
+
+static void appendUTF8(std::vector<UInt8>& bytes, UInt32 ch) {
+    if (ch < 0x80) {
+        bytes.push_back((UInt8)ch);
+    } else if (ch < 0x800) {
+        bytes.push_back((UInt8)(0xC0 | (ch >> 6)));
+        bytes.push_back((UInt8)(0x80 | (ch & 0x3F)));
+    } else if (ch < 0x10000) {
+        bytes.push_back((UInt8)(0xE0 | (ch >> 12)));
+        bytes.push_back((UInt8)(0x80 | ((ch >> 6) & 0x3F)));
+        bytes.push_back((UInt8)(0x80 | (ch & 0x3F)));
+    } else {
+        bytes.push_back((UInt8)(0xF0 | (ch >> 18)));
+        bytes.push_back((UInt8)(0x80 | ((ch >> 12) & 0x3F)));
+        bytes.push_back((UInt8)(0x80 | ((ch >> 6) & 0x3F)));
+        bytes.push_back((UInt8)(0x80 | (ch & 0x3F)));
+    }
+}
+
+static void appendUTF16(std::vector<UniChar>& characters, UInt32 ch) {
+    if (ch < 0x10000) {
+        characters.push_back((UniChar)ch);
+    } else {
+        characters.push_back((UniChar)(0xD800 + ((ch - 0x10000) >> 10)));
+        characters.push_back((UniChar)(0xDC00 + ((ch - 0x10000) & 0x3FF)));
+    }
+}
+
+// Code points of every UTF-8 length, weighted towards ASCII
+static UInt32 randomCodePoint(std::mt19937& random) {
+    switch (random() % 6) {
+        case 0:
+            return 0x100 + random() % 0x80; // Latin Extended-A
+        case 1:
+            return 0x4E00 + random() % 0x5000; // CJK
+        case 2:
+            return 0x1F600 + random() % 0x50; // Emoji
+        case 3:
+            return 0xE000 + random() % 0x1900; // Private use, just past the surrogates
+        default:
+            return 0x20 + random() % 0x5F;
+    }
+}
+
+struct Sample {
+    std::vector<UInt32> codePoints;
+    std::vector<UInt8> bytes;
+    std::vector<UniChar> characters;
+};
+
+static Sample randomSample(std::mt19937& random) {
+    Sample sample;
+    int count = random() % 96;
+    for (int i = 0; i < count; i++) {
+        UInt32 ch = randomCodePoint(random);
+        int repeat = (ch < 0x80 && random() % 4 == 0) ? random() % 40 : 1;
+        while (repeat--) {
+            sample.codePoints.push_back(ch);
+            appendUTF8(sample.bytes, ch);
+            appendUTF16(sample.characters, ch);
+        }
+    }
+    return sample;
+}
+
+static std::vector<UniChar> getCharacters(CFStringRef string) {
+    std::vector<UniChar> characters(CFStringGetLength(string));
+    CFStringGetCharacters(string, CFRangeMake(0, characters.size()), characters.data());
+    return characters;
+}
+
+TEST(CFStringUTF8, DecodingMatchesReference) {
+    std::mt19937 random(71);
+    for (int i = 0; i < 2000; i++) {
+        Sample sample = randomSample(random);
+        CFStringRef string = CFStringCreateWithBytes(nullptr, sample.bytes.data(), sample.bytes.size(), kCFStringEncodingUTF8, false);
+        ASSERT_NE(nullptr, string);
+        EXPECT_EQ(sample.characters, getCharacters(string));
+        CFRelease(string);
+    }
+}
+
+TEST(CFStringUTF8, EncodingMatchesReference) {
+    std::mt19937 random(72);
+    for (int i = 0; i < 2000; i++) {
+        Sample sample = randomSample(random);
+        CFStringRef string = CFStringCreateWithCharacters(nullptr, sample.characters.data(), sample.characters.size());
+        CFRange range = CFRangeMake(0, sample.characters.size());
+
+        CFIndex needed = -1;
+        EXPECT_EQ(range.length, CFStringGetBytes(string, range, kCFStringEncodingUTF8, 0, false, nullptr, 0, &needed));
+        EXPECT_EQ((CFIndex)sample.bytes.size(), needed);
+
+        std::vector<UInt8> bytes(sample.bytes.size());
+        CFIndex used = -1;
+        EXPECT_EQ(range.length, CFStringGetBytes(string, range, kCFStringEncodingUTF8, 0, false, bytes.data(), bytes.size(), &used));
+        EXPECT_EQ(sample.bytes, bytes);
+
+        // A short buffer takes as many whole characters as fit
+        CFIndex max = sample.bytes.empty() ? 0 : random() % sample.bytes.size();
+        CFIndex fitCharacters = 0;
+        CFIndex fitBytes = 0;
+        for (UInt32 ch : sample.codePoints) {
+            std::vector<UInt8> encoded;
+            appendUTF8(encoded, ch);
+            if (fitBytes + (CFIndex)encoded.size() > max) {
+                break;
+            }
+            fitBytes += encoded.size();
+            fitCharacters += (ch < 0x10000 ? 1 : 2);
+        }
+        EXPECT_EQ(fitCharacters, CFStringGetBytes(string, range, kCFStringEncodingUTF8, 0, false, bytes.data(), max, &used));
+        EXPECT_EQ(fitBytes, used);
+
+        CFRelease(string);
+    }
+}
+
+TEST(CFStringUTF8, IllFormedInputIsRejected) {
+    static const std::vector<UInt8> illFormed[] = {
+        { 0x80 }, // Lone continuation byte
+        { 0xC0, 0xAF }, // Overlong
+        { 0xE0, 0x80, 0xAF }, // Overlong
+        { 0xED, 0xA0, 0x80 }, // Surrogate
+        { 0xF4, 0x90, 0x80, 0x80 }, // Past U+10FFFF
+        { 0xF8, 0x88, 0x80, 0x80, 0x80 }, // Five bytes
+        { 0xE4, 0xB8 }, // Truncated
+    };
+
+    for (const std::vector<UInt8>& sequence : illFormed) {
+        for (size_t prefix = 0; prefix < 40; prefix++) {
+            std::vector<UInt8> bytes(prefix, 'a');
+            bytes.insert(bytes.end(), sequence.begin(), sequence.end());
+            bytes.insert(bytes.end(), 20, 'z');
+            CFStringRef string = CFStringCreateWithBytes(nullptr, bytes.data(), bytes.size(), kCFStringEncodingUTF8, false);
+            EXPECT_EQ(nullptr, string) << "ill-formed sequence after " << prefix << " bytes";
+            if (string) {
+                CFRelease(string);
+            }
+        }
+    }
+}
+
+TEST(CFStringUTF8, StrayCopyrightSignIsReplaced) {
+    // Existing content relies on a bare MacRoman copyright sign turning into U+FFFD rather than failing
+    std::vector<UInt8> bytes(33, 'a');
+    bytes.push_back(0xA9);
+    bytes.push_back('b');
+    CFStringRef string = CFStringCreateWithBytes(nullptr, bytes.data(), bytes.size(), kCFStringEncodingUTF8, false);
+    ASSERT_NE(nullptr, string);
+
+    std::vector<UniChar> expected(33, 'a');
+    expected.push_back(0xFFFD);
+    expected.push_back('b');
+    EXPECT_EQ(expected, getCharacters(string));
+    CFRelease(string);
+}
+
+TEST(CFStringUTF8, EncodingStopsAtUnpairedSurrogates) {
+    for (UniChar surrogate : { (UniChar)0xD83D, (UniChar)0xDE00 }) {
+        for (size_t prefix = 0; prefix < 40; prefix++) {
+            std::vector<UniChar> characters(prefix, 'a');
+            characters.push_back(surrogate);
+            characters.insert(characters.end(), 20, 'z');
+            CFStringRef string = CFStringCreateWithCharacters(nullptr, characters.data(), characters.size());
+
+            UInt8 bytes[128];
+            CFIndex used = -1;
+            EXPECT_EQ((CFIndex)prefix,
+                      CFStringGetBytes(string, CFRangeMake(0, characters.size()), kCFStringEncodingUTF8, 0, false, bytes, sizeof(bytes), &used));
+            EXPECT_EQ((CFIndex)prefix, used);
+            CFRelease(string);
+        }
+    }
+}
+
+TEST(CFStringUTF8, Throughput) {
+    static const struct {
+        const char* name;
+        UInt32 first;
+        UInt32 count;
+        int asciiRun;
+    } corpora[] = {
+        { "ASCII", 0x20, 0x5F, 0 }, { "Latin", 0xC0, 0x40, 6 }, { "CJK", 0x4E00, 0x5000, 0 }, { "emoji", 0x1F600, 0x50, 1 },
+    };
+
+    for (const auto& corpus : corpora) {
+        std::vector<UInt8> bytes;
+        for (UInt32 i = 0; bytes.size() < (1 << 20); i++) {
+            for (int run = 0; run < corpus.asciiRun; run++) {
+                bytes.push_back((UInt8)('a' + (i + run) % 26));
+            }
+            appendUTF8(bytes, corpus.first + i % corpus.count);
+        }
+
+        const int rounds = 20;
+        std::vector<UInt8> output(bytes.size());
+        std::chrono::steady_clock::duration decoding(0), encoding(0);
+        for (int round = 0; round < rounds; round++) {
+            auto start = std::chrono::steady_clock::now();
+            CFStringRef string = CFStringCreateWithBytes(nullptr, bytes.data(), bytes.size(), kCFStringEncodingUTF8, false);
+            auto decoded = std::chrono::steady_clock::now();
+            ASSERT_NE(nullptr, string);
+
+            CFIndex used = 0;
+            CFStringGetBytes(string, CFRangeMake(0, CFStringGetLength(string)), kCFStringEncodingUTF8, 0, false, output.data(), output.size(), &used);
+            encoding += std::chrono::steady_clock::now() - decoded;
+            decoding += decoded - start;
+            EXPECT_EQ((CFIndex)bytes.size(), used);
+            CFRelease(string);
+        }
+
+        double gigabytes = (double)bytes.size() * rounds / 1e9;
+        LOG_INFO("UTF-8 %s: decoding %.2f GB/s, encoding %.2f GB/s",
+                 corpus.name,
+                 gigabytes / std::chrono::duration<double>(decoding).count(),
+                 gigabytes / std::chrono::duration<double>(encoding).count());
+        EXPECT_EQ(bytes, output);
+    }
+}
@@ -20,6 +20,14 @@
 #import <CoreFoundation/CoreFoundation.h>
 
 #import <array>
+#import <chrono>
+#import <memory>
+#import <random>
+#import <string>
+#import <vector>
+#import <unicode/basictz.h>
+#import <unicode/strenum.h>
+#import <unicode/tztrans.h>
 
 class PropertyTests
     : public ::testing::TestWithParam<
@@ -229,4 +237,169 @@ TEST(CFTimeZone, CreateWithTimeIntervalFromGMT) {
     est = CFTimeZoneCreateWithName(kCFAllocatorDefault, CFSTR("EST"), false);
     CFAutorelease(est);
     ASSERT_EQ(false, CFTimeZoneIsDaylightSavingTime(est, 180 * 24 * 60 * 60));
-}
\ No newline at end of file
+}
+
+static icu::UnicodeString toUnicodeString(CFStringRef string) {
+    std::vector<UniChar> characters(CFStringGetLength(string));
+    CFStringGetCharacters(string, CFRangeMake(0, characters.size()), characters.data());
+    return icu::UnicodeString(reinterpret_cast<const UChar*>(characters.data()), characters.size());
+}
+
+static UDate toUDate(CFAbsoluteTime at) {
+    return (at + kCFAbsoluteTimeIntervalSince1970) * 1000;
+}
+
+// Offsets between 1900 and 2100 come from a table built out of ICU's transitions, and from ICU
+// itself outside it; either way they should be exactly what ICU says, at and around every transition.
+// Checks tz against ICU a month either side of that range, every stride seconds, at samples random
+// times and around each of ICU's transitions.
+static void checkOffsetsMatchICU(CFTimeZoneRef tz, CFAbsoluteTime stride, int samples, std::mt19937& random) {
+    const CFAbsoluteTime start = -3187296000.0 - 30 * 86400; // A month before 1900
+    const CFAbsoluteTime end = 3124137600.0 + 30 * 86400; // A month after 2100
+
+    UErrorCode status = U_ZERO_ERROR;
+    icu::UnicodeString name = toUnicodeString(CFTimeZoneGetName(tz));
+    std::string utf8Name;
+    name.toUTF8String(utf8Name);
+    std::unique_ptr<icu::BasicTimeZone> reference(static_cast<icu::BasicTimeZone*>(icu::TimeZone::createTimeZone(name)));
+
+    std::vector<CFAbsoluteTime> times;
+    for (CFAbsoluteTime at = start; at < end; at += stride) {
+        times.push_back(at);
+    }
+    for (int i = 0; i < samples; i++) {
+        times.push_back(start + (end - start) * (random() / (double)random.max()));
+    }
+    icu::TimeZoneTransition transition;
+    UDate date = toUDate(start);
+    while (reference->getNextTransition(date, false, transition) && (transition.getTime() < toUDate(end))) {
+        date = transition.getTime();
+        CFAbsoluteTime at = date / 1000 - kCFAbsoluteTimeIntervalSince1970;
+        times.insert(times.end(), { at - 1, at - 0.001, at, at + 1 });
+    }
+
+    for (CFAbsoluteTime at : times) {
+        int32_t rawOffset, dstOffset;
+        reference->getOffset(toUDate(at), false, rawOffset, dstOffset, status);
+        ASSERT_TRUE(U_SUCCESS(status));
+
+        ASSERT_EQ((rawOffset + dstOffset) / 1000, CFTimeZoneGetSecondsFromGMT(tz, at)) << utf8Name << " at " << at;
+        ASSERT_EQ(dstOffset / 1000, CFTimeZoneGetDaylightSavingTimeOffset(tz, at)) << utf8Name << " at " << at;
+        ASSERT_EQ((bool)reference->inDaylightTime(toUDate(at), status), (bool)CFTimeZoneIsDaylightSavingTime(tz, at)) << utf8Name << " at " << at;
+
+        // Past a zone's last transition ICU leaves next as constructed, and CF answers with that too
+        icu::TimeZoneTransition next;
+        reference->getNextTransition(toUDate(at), false, next);
+        ASSERT_EQ(next.getTime() / 1000 - kCFAbsoluteTimeIntervalSince1970, CFTimeZoneGetNextDaylightSavingTimeTransition(tz, at))
+            << utf8Name << " at " << at;
+    }
+}
+
+// Zones whose rules stress the table: half hour and negative DST, skipped and repeated days,
+// offsets that aren't whole hours, rules that stop or change late, and zones with no transitions.
+TEST(CFTimeZone, OffsetsMatchICU) {
+    const char* names[] = { "America/New_York",
+                            "America/St_Johns",
+                            "America/Sao_Paulo",
+                            "America/Caracas",
+                            "Europe/London",
+                            "Europe/Dublin",
+                            "Europe/Moscow",
+                            "Africa/Casablanca",
+                            "Asia/Tehran",
+                            "Asia/Kolkata",
+                            "Asia/Kathmandu",
+                            "Australia/Lord_Howe",
+                            "Pacific/Apia",
+                            "Pacific/Chatham",
+                            "Antarctica/Troll",
+                            "Etc/GMT+5",
+                            "UTC" };
+    std::mt19937 random(72);
+
+    for (const char* name : names) {
+        CFStringRef string = CFStringCreateWithCString(nullptr, name, kCFStringEncodingUTF8);
+        CFTimeZoneRef tz = CFTimeZoneCreateWithName(nullptr, string, false);
+        CFRelease(string);
+        ASSERT_NE(nullptr, tz) << name;
+
+        checkOffsetsMatchICU(tz, 97 * 86400 + 3607.5, 50, random);
+        CFRelease(tz);
+        if (HasFatalFailure()) {
+            return;
+        }
+    }
+}
+
+// The same comparison for every zone ICU knows, more densely; several million lookups, so run it by hand.
+TEST(CFTimeZone, DISABLED_OffsetsMatchICUForAllZones) {
+    std::mt19937 random(72);
+
+    UErrorCode status = U_ZERO_ERROR;
+    std::unique_ptr<icu::StringEnumeration> ids(icu::TimeZone::createEnumeration(status));
+    ASSERT_TRUE(U_SUCCESS(status));
+
+    int zones = 0;
+    const icu::UnicodeString* id;
+    while ((id = ids->snext(status)) != nullptr) {
+        CFStringRef name = CFStringCreateWithCharacters(nullptr, reinterpret_cast<const UniChar*>(id->getBuffer()), id->length());
+        CFTimeZoneRef tz = CFTimeZoneCreateWithName(nullptr, name, false);
+        CFRelease(name);
+        if (!tz) {
+            continue;
+        }
+
+        checkOffsetsMatchICU(tz, 11 * 86400 + 3607.5, 500, random);
+        CFRelease(tz);
+        if (HasFatalFailure()) {
+            return;
+        }
+        zones++;
+    }
+
+    EXPECT_LT(300, zones);
+}
+
+TEST(CFTimeZone, OffsetQueryThroughput) {
+    CFTimeZoneRef tz = CFTimeZoneCreateWithName(nullptr, CFSTR("America/New_York"), false);
+    ASSERT_NE(nullptr, tz);
+    std::unique_ptr<icu::TimeZone> reference(icu::TimeZone::createTimeZone("America/New_York"));
+
+    // Scattered over 1970 to 2033, and a log's worth of nearby timestamps
+    std::mt19937 random(72);
+    std::vector<CFAbsoluteTime> scattered(1000000), sequential(1000000);
+    for (size_t i = 0; i < scattered.size(); i++) {
+        scattered[i] = -kCFAbsoluteTimeIntervalSince1970 + (random() % 2000000000);
+        sequential[i] = 500000000.0 + i * 0.25;
+    }
+
+    const struct {
+        const char* name;
+        const std::vector<CFAbsoluteTime>& times;
+    } runs[] = { { "Scattered", scattered }, { "Sequential", sequential } };
+
+    for (const auto& run : runs) {
+        const std::vector<CFAbsoluteTime>& times = run.times;
+        double total = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (CFAbsoluteTime at : times) {
+            total += CFTimeZoneGetSecondsFromGMT(tz, at);
+        }
+        auto queried = std::chrono::steady_clock::now();
+        for (CFAbsoluteTime at : times) {
+            int32_t rawOffset, dstOffset;
+            UErrorCode status = U_ZERO_ERROR;
+            reference->getOffset(toUDate(at), false, rawOffset, dstOffset, status);
+            total -= (rawOffset + dstOffset) / 1000;
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        LOG_INFO("%s offsets: %.1f million queries/s, against %.1f million/s from ICU",
+                 run.name,
+                 times.size() / std::chrono::duration<double>(queried - start).count() / 1e6,
+                 times.size() / std::chrono::duration<double>(end - queried).count() / 1e6);
+        EXPECT_EQ(0, total);
+    }
+
+    CFRelease(tz);
+}
@@ -168,6 +168,31 @@ TEST(NSArray, NSArray_initWithContentsOfFile) {
     [[NSFileManager defaultManager] removeItemAtPath:file error:nil];
 }
 
+TEST(NSArray, WriteToFileRoundTripsSharedAndNonASCIIObjects) {
+    NSMutableArray* expectedArray = [NSMutableArray array];
+    NSString* shared = @"shared";
+    for (int i = 0; i < 300; i++) {
+        [expectedArray addObject:@{ @"index" : @(i), @"name" : [NSString stringWithFormat:@"item %d", i], @"shared" : shared }];
+    }
+    [expectedArray addObject:@[ @YES, @1, @1.0, @"\u00e9t\u00e9", [[@"shared" mutableCopy] autorelease] ]];
+
+    NSArray* cachesPaths = NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSAllDomainsMask, YES);
+    ASSERT_NE(0, [cachesPaths count]);
+    NSString* path = cachesPaths[0];
+    NSString* file = [path stringByAppendingPathComponent:@"sharedarray.data"];
+    [[NSFileManager defaultManager] createDirectoryAtPath:path withIntermediateDirectories:YES attributes:nil error:nil];
+    ASSERT_TRUE([expectedArray writeToFile:file atomically:NO]);
+
+    NSArray* actualArray = [[[NSArray alloc] initWithContentsOfFile:file] autorelease];
+    ASSERT_OBJCEQ(expectedArray, actualArray);
+
+    NSArray* scalars = [actualArray lastObject];
+    ASSERT_OBJCEQ(@YES, scalars[0]);
+    ASSERT_EQ(strcmp(@YES.objCType, [scalars[0] objCType]), 0);
+    ASSERT_EQ(strcmp(@1.0.objCType, [scalars[2] objCType]), 0);
+    [[NSFileManager defaultManager] removeItemAtPath:file error:nil];
+}
+
 TEST(NSArray, Enumerate) {
     __block NSArray* testArray = @[ @0, @1, @2, @3 ];
 
@@ -742,6 +742,33 @@ TEST(NSAttributedString, EnumerateAttributes) {
     ASSERT_EQ(expectedAttributes.size(), index);
 }
 
+TEST(NSAttributedString, ManyRunsShareAttributeDictionaries) {
+    NSMutableAttributedString* aStr = [[[NSMutableAttributedString alloc] initWithString:[@"" stringByPaddingToLength:4000
+                                                                                                          withString:@"A"
+                                                                                                     startingAtIndex:0]] autorelease];
+    for (NSUInteger i = 0; i < 1000; ++i) {
+        [aStr addAttribute:c_defaultAttributeName value:((i % 2) ? @"odd" : @"even") range:NSMakeRange(i * 4, 4)];
+    }
+    [aStr addAttribute:@"otherAttributeName" value:@"shared" range:NSMakeRange(0, 4000)];
+
+    // Lookups out of order still find the right run
+    for (NSUInteger run = 997; run > 0; run -= 37) {
+        NSRange range;
+        NSDictionary* attributes = [aStr attributesAtIndex:(run * 4 + 1) effectiveRange:&range];
+        ASSERT_TRUE(NSEqualRanges(NSMakeRange(run * 4, 4), range));
+        ASSERT_OBJCEQ((run % 2) ? @"odd" : @"even", attributes[c_defaultAttributeName]);
+        ASSERT_OBJCEQ(@"shared", attributes[@"otherAttributeName"]);
+    }
+
+    // Runs which had the same attributes before the edit keep sharing a single dictionary
+    ASSERT_EQ([aStr attributesAtIndex:0 effectiveRange:nullptr], [aStr attributesAtIndex:3992 effectiveRange:nullptr]);
+    ASSERT_EQ([aStr attributesAtIndex:4 effectiveRange:nullptr], [aStr attributesAtIndex:3996 effectiveRange:nullptr]);
+
+    // Making neighbours equal coalesces them
+    [aStr addAttribute:c_defaultAttributeName value:@"even" range:NSMakeRange(4, 4)];
+    assertAttributeAt(aStr, c_defaultAttributeName, @"even", 0, 12);
+}
+
 @interface NSAttributedStringTestSubclassNoOverrides : NSAttributedString
 @end
 
@@ -17,6 +17,10 @@
 #import <Foundation/Foundation.h>
 #import <TestFramework.h>
 
+#include <chrono>
+#include <random>
+#include <vector>
+
 TEST(NSCalendar, GetDates) {
     // Test enumeration block, block expects to find 50 dates referencing the leap year dates, Feb, 29th every ~4years
     NSCalendar* calendar = [NSCalendar calendarWithIdentifier:NSCalendarIdentifierGregorian];
@@ -534,4 +538,36 @@ WIN32_DISABLED_TEST(NSCalendar, RangeOfWeekOfMonthTest) {
     range = [calendar rangeOfUnit:NSCalendarUnitWeekOfYear inUnit:NSCalendarUnitMonth forDate:expectedDate];
     EXPECT_EQ(range.location, 27);
     EXPECT_EQ(range.length, 6);
-}
\ No newline at end of file
+}
+
+TEST(NSCalendar, ComponentsThroughput) {
+    // Gregorian components are worked out without ICU; the Hebrew calendar still goes through it
+    NSCalendarUnit units = NSCalendarUnitEra | NSCalendarUnitYear | NSCalendarUnitMonth | NSCalendarUnitDay | NSCalendarUnitHour |
+                           NSCalendarUnitMinute | NSCalendarUnitSecond | NSCalendarUnitWeekday | NSCalendarUnitWeekOfYear;
+    std::mt19937 random(73);
+    std::vector<NSDate*> dates;
+    for (int i = 0; i < 100000; i++) {
+        dates.push_back([NSDate dateWithTimeIntervalSinceReferenceDate:-1000000000.0 + (random() % 2000000000)]);
+    }
+
+    for (NSString* identifier in @[ NSCalendarIdentifierGregorian, NSCalendarIdentifierHebrew ]) {
+        NSCalendar* calendar = [NSCalendar calendarWithIdentifier:identifier];
+        calendar.timeZone = [NSTimeZone timeZoneWithName:@"America/New_York"];
+
+        NSInteger total = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (NSDate* date : dates) {
+            @autoreleasepool {
+                NSDateComponents* components = [calendar components:units fromDate:date];
+                total += components.year + components.day;
+            }
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        LOG_INFO("%s: %.0f thousand components:fromDate: calls/s (%ld)",
+                 [identifier UTF8String],
+                 dates.size() / std::chrono::duration<double>(end - start).count() / 1e3,
+                 (long)total);
+        EXPECT_LT(0, total);
+    }
+}
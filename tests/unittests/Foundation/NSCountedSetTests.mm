@@ -119,4 +119,37 @@ TEST(NSCountedSet, RemoveFromSetTest) {
     ASSERT_EQ_MSG(0, roundShapeCount, "FAILED: roundShapeCount should be 0!\n");
 
     [shapeSet release];
-}
\ No newline at end of file
+}
+
+TEST(NSCountedSet, DistinctObjectsTest) {
+    NSCountedSet* countedSet = [[NSCountedSet new] autorelease];
+    for (int i = 0; i < 100; ++i) {
+        for (int j = 0; j <= i % 5; ++j) {
+            [countedSet addObject:@(i)];
+        }
+    }
+
+    ASSERT_EQ(100, [countedSet count]);
+    ASSERT_EQ(1, [countedSet countForObject:@0]);
+    ASSERT_EQ(5, [countedSet countForObject:@99]);
+
+    // Enumeration visits each distinct object exactly once
+    NSMutableSet* seen = [NSMutableSet set];
+    for (id object in countedSet) {
+        ASSERT_FALSE([seen containsObject:object]);
+        [seen addObject:object];
+    }
+    ASSERT_EQ(100, [seen count]);
+
+    NSNumber* member = [countedSet member:@42];
+    ASSERT_OBJCEQ(@42, member);
+    ASSERT_EQ(nil, [countedSet member:@1000]);
+
+    [countedSet removeObject:@99];
+    ASSERT_EQ(4, [countedSet countForObject:@99]);
+    ASSERT_EQ(100, [countedSet count]);
+
+    [countedSet removeObject:@0];
+    ASSERT_EQ(0, [countedSet countForObject:@0]);
+    ASSERT_EQ(99, [countedSet count]);
+}
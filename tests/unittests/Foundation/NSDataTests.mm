@@ -20,6 +20,8 @@
 
 #import "TestUtils.h"
 
+#import <vector>
+
 // TODO: BUG 5403859: Enable ARC on this test file once load order issue is fixed
 
 // Helper function for testing decoding of base64 encoded strings
@@ -184,6 +186,40 @@ TEST(NSData, Base64EncodeDecodeWrappers) {
                       base64EncodedDataWithOptions:NSDataBase64Encoding76CharacterLineLength]);
 }
 
+TEST(NSData, Base64RoundTripAllByteValues) {
+    std::vector<uint8_t> bytes(64 * 1024 + 2);
+    for (size_t i = 0; i < bytes.size(); ++i) {
+        bytes[i] = static_cast<uint8_t>(i * 7 + (i >> 8));
+    }
+
+    StrongId<NSData> data = [NSData dataWithBytes:bytes.data() length:bytes.size()];
+
+    StrongId<NSString> encoded = [data base64EncodedStringWithOptions:0];
+    ASSERT_EQ(((bytes.size() + 2) / 3) * 4, [encoded length]);
+    ASSERT_OBJCEQ(data, [[[NSData alloc] initWithBase64EncodedString:encoded options:0] autorelease]);
+
+    StrongId<NSString> encodedWithLines = [data base64EncodedStringWithOptions:NSDataBase64Encoding76CharacterLineLength];
+    ASSERT_OBJCEQ(nil, [[[NSData alloc] initWithBase64EncodedString:encodedWithLines options:0] autorelease]);
+    ASSERT_OBJCEQ(data,
+                  [[[NSData alloc] initWithBase64EncodedString:encodedWithLines options:NSDataBase64DecodingIgnoreUnknownCharacters]
+                      autorelease]);
+
+    StrongId<NSData> encodedData = [data base64EncodedDataWithOptions:NSDataBase64Encoding64CharacterLineLength];
+    ASSERT_OBJCEQ(data, [[[NSData alloc] initWithBase64EncodedData:encodedData options:NSDataBase64DecodingIgnoreUnknownCharacters] autorelease]);
+}
+
+TEST(NSData, Base64InvalidPadding) {
+    ASSERT_OBJCEQ(nil, [[[NSData alloc] initWithBase64EncodedString:@"QQ" options:0] autorelease]);
+    ASSERT_OBJCEQ(nil, [[[NSData alloc] initWithBase64EncodedString:@"QQ=" options:0] autorelease]);
+    ASSERT_OBJCEQ(nil, [[[NSData alloc] initWithBase64EncodedString:@"Q===" options:0] autorelease]);
+    ASSERT_OBJCEQ(nil, [[[NSData alloc] initWithBase64EncodedString:@"QQ==QUFB" options:0] autorelease]);
+    ASSERT_OBJCEQ(nil, [[[NSData alloc] initWithBase64EncodedString:@"QQ==QUFB" options:NSDataBase64DecodingIgnoreUnknownCharacters] autorelease]);
+
+    // Non-ASCII characters are unknown characters
+    testDecode(@"Wl\u00e9pa\u4e2d", @"ZZZ", YES);
+    ASSERT_OBJCEQ(nil, [[[NSData alloc] initWithBase64EncodedString:@"Wl\u00e9pa" options:0] autorelease]);
+}
+
 TEST(NSData, WriteToFile) {
     // first, write the test string to NSURL which represents as a file
     // ensure it succeeds
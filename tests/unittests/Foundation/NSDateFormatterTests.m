@@ -110,4 +110,25 @@ TEST(NSDateFormatter, NSDateFormatter) {
     NSString* strMyDate = [dateFormatter stringFromDate:date];
 
     ASSERT_OBJCEQ(@"18-03-2009", strMyDate);
-}
\ No newline at end of file
+}
+
+TEST(NSDateFormatter, CopyPreservesConfiguration) {
+    NSDateFormatter* dateFormatter = [[[NSDateFormatter alloc] init] autorelease];
+    [dateFormatter setLocale:[NSLocale localeWithLocaleIdentifier:@"en_GB"]];
+    [dateFormatter setDateStyle:NSDateFormatterMediumStyle];
+    [dateFormatter setTimeStyle:NSDateFormatterMediumStyle];
+    [dateFormatter setTimeZone:[NSTimeZone timeZoneWithName:@"GMT"]];
+
+    NSDate* date = [NSDate dateWithTimeIntervalSince1970:0];
+    ASSERT_OBJCEQ(@"1 Jan 1970, 00:00:00", [dateFormatter stringFromDate:date]);
+
+    NSDateFormatter* copy = [[dateFormatter copy] autorelease];
+    ASSERT_EQ(NSDateFormatterMediumStyle, [copy dateStyle]);
+    ASSERT_EQ(NSDateFormatterMediumStyle, [copy timeStyle]);
+    ASSERT_OBJCEQ(@"1 Jan 1970, 00:00:00", [copy stringFromDate:date]);
+
+    // Changing the copy must not affect the original.
+    [copy setDateFormat:@"dd-MM-yyyy"];
+    ASSERT_OBJCEQ(@"01-01-1970", [copy stringFromDate:date]);
+    ASSERT_OBJCEQ(@"1 Jan 1970, 00:00:00", [dateFormatter stringFromDate:date]);
+}
@@ -234,3 +234,44 @@ TEST(NSFileManager, MoveFileViaURL) {
     // Verify data.
     ASSERT_OBJCEQ([content dataUsingEncoding:NSUTF8StringEncoding], [NSData dataWithContentsOfURL:destURL]);
 }
+
+TEST(NSFileManager, EnumeratorAtPathSkipDescendants) {
+    NSString* rootName = @"NSFileManagerEnumeratorTest";
+    SCOPE_DELETE_FILE(rootName);
+
+    NSFileManager* manager = [NSFileManager defaultManager];
+    NSString* rootPath = getPathToFile(rootName);
+    NSData* content = [@"The Quick Brown Fox." dataUsingEncoding:NSUTF8StringEncoding];
+
+    ASSERT_TRUE([manager createDirectoryAtPath:[rootPath stringByAppendingPathComponent:@"a/sub"]
+                   withIntermediateDirectories:YES
+                                    attributes:nil
+                                         error:nullptr]);
+    ASSERT_TRUE([manager createFileAtPath:[rootPath stringByAppendingPathComponent:@"a/x.txt"] contents:content attributes:nil]);
+    ASSERT_TRUE([manager createFileAtPath:[rootPath stringByAppendingPathComponent:@"a/sub/y.txt"] contents:content attributes:nil]);
+    ASSERT_TRUE([manager createFileAtPath:[rootPath stringByAppendingPathComponent:@"b.txt"] contents:content attributes:nil]);
+
+    NSSet* expected = [NSSet setWithObjects:@"a", @"a/x.txt", @"a/sub", @"a/sub/y.txt", @"b.txt", nil];
+    NSSet* actual = [NSSet setWithArray:[[manager enumeratorAtPath:rootPath] allObjects]];
+    ASSERT_OBJCEQ(expected, actual);
+
+    // Descendants of a skipped directory are never returned, and a directory's contents follow the directory itself.
+    NSDirectoryEnumerator* enumerator = [manager enumeratorAtPath:rootPath];
+    NSMutableArray* visited = [NSMutableArray array];
+    for (NSString* path in enumerator) {
+        [visited addObject:path];
+        if ([path isEqualToString:@"a"]) {
+            [enumerator skipDescendants];
+        }
+    }
+
+    ASSERT_OBJCEQ([NSSet setWithObjects:@"a", @"b.txt", nil], [NSSet setWithArray:visited]);
+
+    enumerator = [manager enumeratorAtPath:rootPath];
+    NSString* path = nil;
+    while ((path = [enumerator nextObject]) != nil) {
+        if ([path isEqualToString:@"a/sub/y.txt"]) {
+            ASSERT_OBJCEQ(@20, [[enumerator fileAttributes] objectForKey:NSFileSize]);
+        }
+    }
+}
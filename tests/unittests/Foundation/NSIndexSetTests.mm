@@ -328,4 +328,53 @@ TEST(NSIndexSet, NSCodingNonemptySet) {
     NSKeyedUnarchiver* decoder = [[NSKeyedUnarchiver alloc] initForReadingWithData:data];
     NSMutableIndexSet* decodedSet = [[NSMutableIndexSet alloc] initWithCoder:decoder];
     EXPECT_OBJCEQ(set, decodedSet);
-}
\ No newline at end of file
+}
+
+TEST(NSIndexSet, AddIndexesMergesRanges) {
+    NSMutableIndexSet* set = [NSMutableIndexSet indexSet];
+    [set addIndexesInRange:NSMakeRange(0, 2)]; // [0-1]
+    [set addIndexesInRange:NSMakeRange(10, 5)]; // [10-14]
+    [set addIndexesInRange:NSMakeRange(30, 1)]; // [30]
+
+    NSMutableIndexSet* other = [NSMutableIndexSet indexSet];
+    [other addIndexesInRange:NSMakeRange(2, 3)]; // [2-4], abuts [0-1]
+    [other addIndexesInRange:NSMakeRange(12, 10)]; // [12-21], overlaps [10-14]
+    [other addIndexesInRange:NSMakeRange(40, 2)]; // [40-41]
+
+    [set addIndexes:other];
+
+    NSMutableIndexSet* expected = [NSMutableIndexSet indexSet];
+    [expected addIndexesInRange:NSMakeRange(0, 5)];
+    [expected addIndexesInRange:NSMakeRange(10, 12)];
+    [expected addIndexesInRange:NSMakeRange(30, 1)];
+    [expected addIndexesInRange:NSMakeRange(40, 2)];
+    ASSERT_OBJCEQ(expected, set);
+    EXPECT_EQ(20, [set count]);
+}
+
+TEST(NSIndexSet, ManyScatteredIndexes) {
+    NSMutableIndexSet* set = [NSMutableIndexSet indexSet];
+
+    // Even indexes in descending order, then odd indexes below 1000 to coalesce the front of the set.
+    for (NSUInteger i = 20000; i > 0; i -= 2) {
+        [set addIndex:i];
+    }
+    for (NSUInteger i = 1; i < 1000; i += 2) {
+        [set addIndex:i];
+    }
+
+    EXPECT_EQ(10500, [set count]);
+    EXPECT_EQ(1, [set firstIndex]);
+    EXPECT_EQ(20000, [set lastIndex]);
+    EXPECT_TRUE([set containsIndexesInRange:NSMakeRange(1, 1000)]);
+    EXPECT_FALSE([set containsIndexesInRange:NSMakeRange(1000, 3)]);
+    EXPECT_TRUE([set containsIndex:19998]);
+    EXPECT_FALSE([set containsIndex:19999]);
+    EXPECT_EQ(5, [set countOfIndexesInRange:NSMakeRange(2000, 10)]);
+    EXPECT_EQ(1002, [set indexGreaterThanIndex:1000]);
+    EXPECT_EQ(1000, [set indexLessThanIndex:1001]);
+
+    [set removeIndexesInRange:NSMakeRange(0, 1001)];
+    EXPECT_EQ(1002, [set firstIndex]);
+    EXPECT_EQ(9500, [set count]);
+}
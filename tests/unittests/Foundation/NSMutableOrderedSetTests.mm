@@ -359,4 +359,33 @@ TEST(NSMutableOrderedSet, oneWayArray) {
     ASSERT_TRUE([arrayObjs containsObject:@"i5"]);
 
     ASSERT_ANY_THROW([((NSMutableArray*)arrayObjs) addObject:@"test"]);
-}
\ No newline at end of file
+}
+
+TEST(NSMutableOrderedSet, IndexOfObjectAfterInserts) {
+    NSMutableOrderedSet* orderedSet = [NSMutableOrderedSet orderedSet];
+    for (int i = 0; i < 1000; ++i) {
+        [orderedSet addObject:@(i)];
+    }
+
+    ASSERT_EQ(500, [orderedSet indexOfObject:@500]);
+
+    // Inserting before the end shifts every following index.
+    [orderedSet insertObject:@-1 atIndex:0];
+    [orderedSet insertObject:@-2 atIndex:500];
+    [orderedSet addObject:@1000];
+
+    ASSERT_EQ(1003, [orderedSet count]);
+    ASSERT_EQ(0, [orderedSet indexOfObject:@-1]);
+    ASSERT_EQ(1, [orderedSet indexOfObject:@0]);
+    ASSERT_EQ(499, [orderedSet indexOfObject:@498]);
+    ASSERT_EQ(500, [orderedSet indexOfObject:@-2]);
+    ASSERT_EQ(501, [orderedSet indexOfObject:@499]);
+    ASSERT_EQ(1001, [orderedSet indexOfObject:@999]);
+    ASSERT_EQ(1002, [orderedSet indexOfObject:@1000]);
+    ASSERT_EQ(NSNotFound, [orderedSet indexOfObject:@2000]);
+    ASSERT_EQ(NSNotFound, [orderedSet indexOfObject:nil]);
+
+    for (NSUInteger i = 0; i < [orderedSet count]; ++i) {
+        ASSERT_EQ(i, [orderedSet indexOfObject:[orderedSet objectAtIndex:i]]);
+    }
+}
@@ -18,6 +18,7 @@
 #import <Foundation/Foundation.h>
 
 #import <windows.h>
+#include <locale.h>
 
 void testUrlCharacterSetEncoding(NSString* decodedString, NSString* encodedString, NSCharacterSet* allowedCharacterSet) {
     NSString* testString = [decodedString stringByAddingPercentEncodingWithAllowedCharacters:allowedCharacterSet];
@@ -193,6 +194,32 @@ TEST(NSString, InitWithFormat) {
     ASSERT_OBJCEQ(string, @"4B");
 }
 
+TEST(NSString, FormatFloatingPointUnderCommaLocale) {
+    // Formatting without a locale always uses '.', whatever decimal point the C runtime is set up for
+    char* previousLocale = _strdup(setlocale(LC_NUMERIC, NULL));
+    ASSERT_NE(nullptr, setlocale(LC_NUMERIC, "de-DE"));
+
+    const double values[] = { 0.0, 1.0, -1.5, 3.14159265358979, 123456.789, 0.000123, 1e-7, 9.9999, 1e20, 2.5e-300 };
+    const char* formats[] = { "%f", "%.0f", "%.3f", "%.20f", "%e", "%.10e", "%.17g" };
+    for (double value : values) {
+        for (const char* format : formats) {
+            char expected[512];
+            snprintf(expected, sizeof(expected), format, value);
+            for (char* c = expected; *c; c++) {
+                if (*c == ',') {
+                    *c = '.';
+                }
+            }
+
+            NSString* actual = [NSString stringWithFormat:[NSString stringWithUTF8String:format], value];
+            EXPECT_OBJCEQ([NSString stringWithUTF8String:expected], actual);
+        }
+    }
+
+    setlocale(LC_NUMERIC, previousLocale);
+    free(previousLocale);
+}
+
 TEST(NSString, LocalizedStandardCompare) {
     NSString* string = @"Abc3";
     ASSERT_EQ(NSOrderedAscending, [string localizedStandardCompare:@"ABC4"]);
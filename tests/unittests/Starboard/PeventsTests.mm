@@ -0,0 +1,160 @@
+//******************************************************************************
+//
+// Copyright (c) 2016 Microsoft Corporation. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+#include <TestFramework.h>
+#include "Starboard.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+TEST(EbrEvent, AutoResetSignalIsConsumedOnce) {
+    EbrEvent event;
+    EbrEventInit(&event);
+
+    ASSERT_FALSE(EbrEventTryWait(event));
+    EbrEventSignal(event);
+    ASSERT_TRUE(EbrEventTryWait(event));
+    ASSERT_FALSE(EbrEventTryWait(event));
+
+    EbrEventDestroy(event);
+}
+
+TEST(EbrEvent, MultipleWaitReturnsSignaledIndex) {
+    EbrEvent events[8];
+    for (auto& event : events) {
+        EbrEventInit(&event);
+    }
+
+    ASSERT_EQ(-1, EbrEventTimedMultipleWait(events, 8, 0, nullptr));
+    ASSERT_EQ(-1, EbrEventTimedMultipleWait(events, 8, 0.05, nullptr));
+
+    EbrEventSignal(events[5]);
+    ASSERT_EQ(5, EbrEventTimedMultipleWait(events, 8, 0, nullptr));
+    ASSERT_FALSE(EbrEventTryWait(events[5]));
+
+    std::thread signaler([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        EbrEventSignal(events[3]);
+    });
+    ASSERT_EQ(3, EbrEventTimedMultipleWait(events, 8, 10, nullptr));
+    signaler.join();
+
+    for (auto& event : events) {
+        ASSERT_FALSE(EbrEventTryWait(event));
+        EbrEventDestroy(event);
+    }
+}
+
+TEST(EbrEvent, AutoResetWakesExactlyOneWaiter) {
+    EbrEvent event;
+    EbrEventInit(&event);
+
+    std::atomic<int> woken(0);
+    std::vector<std::thread> waiters;
+    for (int i = 0; i < 4; i++) {
+        waiters.emplace_back([&]() {
+            if (EbrEventTimedMultipleWait(&event, 1, 1, nullptr) == 0) {
+                ++woken;
+            }
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EbrEventSignal(event);
+
+    for (auto& waiter : waiters) {
+        waiter.join();
+    }
+
+    ASSERT_EQ(1, woken);
+    EbrEventDestroy(event);
+}
+
+TEST(EbrEvent, ContendedSignalsAreNeitherLostNorDuplicated) {
+    const int c_numEvents = 16;
+    const int c_numWaiters = 8;
+    const int c_numSignals = 20000;
+
+    EbrEvent events[c_numEvents];
+    for (auto& event : events) {
+        EbrEventInit(&event);
+    }
+
+    // Waiters block for much longer than the test should take, so a lost wakeup stalls the handshake below
+    std::atomic<int> consumed(0);
+    std::atomic<int> running(c_numWaiters);
+    std::atomic<bool> stop(false);
+    std::vector<std::thread> waiters;
+    for (int i = 0; i < c_numWaiters; i++) {
+        waiters.emplace_back([&, i]() {
+            while (!stop) {
+                if (i == 0) {
+                    EbrEventWait(events[0]);
+                    ++consumed;
+                } else if (EbrEventTimedMultipleWait(events, c_numEvents, 60, nullptr) >= 0) {
+                    ++consumed;
+                }
+            }
+            --running;
+        });
+    }
+
+    // A signal that is not consumed within the deadline was lost; give up rather than hang the run
+    const auto c_deadline = std::chrono::seconds(10);
+    int stalledSignal = -1;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < c_numSignals && stalledSignal < 0; i++) {
+        int before = consumed;
+        EbrEventSignal(events[(i * 7) % c_numEvents]);
+        auto deadline = std::chrono::steady_clock::now() + c_deadline;
+        while (consumed == before) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                stalledSignal = i;
+                break;
+            }
+            std::this_thread::yield();
+        }
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    LOG_INFO("%d signals across %d events and %d waiters took %lld ms", c_numSignals, c_numEvents, c_numWaiters, (long long)elapsed.count());
+
+    int consumedBeforeStop = -1;
+    if (stalledSignal < 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        consumedBeforeStop = consumed;
+    }
+
+    // The waiters reference this frame, so they are stopped before any failure is reported
+    stop = true;
+    while (running > 0) {
+        EbrEventSignal(events[0]);
+        std::this_thread::yield();
+    }
+    for (auto& waiter : waiters) {
+        waiter.join();
+    }
+
+    for (auto& event : events) {
+        EbrEventDestroy(event);
+    }
+
+    if (stalledSignal >= 0) {
+        FAIL() << "Signal " << stalledSignal << " was not consumed within " << c_deadline.count() << " s";
+    }
+    ASSERT_EQ(c_numSignals, consumedBeforeStop);
+}
@@ -0,0 +1,102 @@
+//******************************************************************************
+//
+// Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+#ifndef _OPENSTEPPLIST_H_
+#define _OPENSTEPPLIST_H_
+
+#include <stdint.h>
+
+#include "types.h"
+#include "Plist.hpp"
+
+// Parser for old-style (OpenStep) property lists, the format of project.pbxproj.
+// The text is parsed where it lies and every string is a span into it, so parsing
+// allocates nothing per value. Values only get copied (and unescaped) when asked
+// for, and subtrees can be boxed into PlistCpp types one at a time.
+class OpenStepPlist {
+public:
+  enum NodeType {
+    StringNode,
+    ArrayNode,
+    DictionaryNode
+  };
+
+  typedef uint32_t NodeRef;
+  static const NodeRef npos = 0xFFFFFFFF;
+
+  OpenStepPlist() : m_text(NULL), m_length(0), m_posn(0), m_root(npos) {}
+  OpenStepPlist(OpenStepPlist&& other) = default;
+  OpenStepPlist& operator=(OpenStepPlist&& other) = default;
+
+  // Returns false if the file can't be read or doesn't look like an OpenStep plist.
+  // Throws std::runtime_error if it does, but is malformed.
+  bool readFile(const String& path);
+
+  // Parses text in place, so it has to outlive the plist
+  void parse(const char* text, size_t length);
+
+  NodeRef root() const { return m_root; }
+  NodeType getType(NodeRef node) const { return NodeType(m_nodes[node].type); }
+
+  // Number of elements in an array or entries in a dictionary
+  size_t getCount(NodeRef node) const { return m_nodes[node].type == StringNode ? 0 : m_nodes[node].length; }
+  NodeRef getElement(NodeRef array, size_t i) const { return m_children[m_nodes[array].begin + i]; }
+  NodeRef getKey(NodeRef dict, size_t i) const { return m_children[m_nodes[dict].begin + 2 * i]; }
+  NodeRef getValue(NodeRef dict, size_t i) const { return m_children[m_nodes[dict].begin + 2 * i + 1]; }
+  NodeRef findValue(NodeRef dict, const char* key) const;
+
+  // Sorts the entries of a dictionary by key, for the findValue below to binary search
+  void sortEntries(NodeRef dict, std::vector<uint32_t>& ret) const;
+  NodeRef findValue(NodeRef dict, const std::vector<uint32_t>& sortedEntries, const String& key) const;
+
+  String getString(NodeRef node) const;
+  bool stringEquals(NodeRef node, const char* str) const;
+
+  // Converts a subtree to the representation PlistCpp produces
+  void toAny(NodeRef node, boost::any& ret) const;
+  void toDictionary(NodeRef dict, Plist::dictionary_type& ret) const;
+
+private:
+  struct Node {
+    uint8_t type;
+    bool escaped;     // Quoted string containing backslash escapes
+    uint32_t begin;   // String: offset into m_text. Container: index into m_children.
+    uint32_t length;  // String: byte count. Container: element/entry count.
+  };
+
+  OpenStepPlist(const OpenStepPlist&) = delete;
+  OpenStepPlist& operator=(const OpenStepPlist&) = delete;
+
+  void parseText(const char* text, size_t length);
+  NodeRef parseValue();
+  NodeRef parseString();
+  NodeRef parseContainer(NodeType type, char close);
+  NodeRef addNode(NodeType type, bool escaped, size_t begin, size_t length);
+  void skipWhitespace();
+  void fail(const String& msg) const;
+  int compareString(NodeRef node, const char* str, size_t length) const;
+
+  std::vector<char> m_buffer;   // The file, when read by readFile; moving it keeps m_text valid
+  const char* m_text;
+  size_t m_length;
+  size_t m_posn;
+  std::vector<Node> m_nodes;
+  std::vector<NodeRef> m_children;
+  std::vector<NodeRef> m_pending;   // Children of the containers being parsed
+  NodeRef m_root;
+};
+
+#endif /* _OPENSTEPPLIST_H_ */
@@ -20,6 +20,7 @@
 #include "Plist.hpp"
 #include "types.h"
 #include "ErrorReporter.h"
+#include "OpenStepPlist.h"
 
 class PBXObject;
 class PBXProject;
@@ -35,22 +36,42 @@ public:
   String getName() const;
   
   static PBXDocument* createFromPlist(const Plist::dictionary_type& plist, const String& projectPath);
+  static PBXDocument* createFromPlist(const OpenStepPlist& plist, const String& projectPath);
   static PBXDocument* createFromFile(const String& projPath);
+
+  // Parses the project files at the given (absolute) project paths on up to jobs threads,
+  // ahead of createFromFile being called for each of them
+  static void prefetchFiles(const StringVec& projPaths, unsigned jobs);
   
 private:
   typedef std::map<String, PBXObject*> PBXObjectMap;
 
   PBXDocument(const String& projectPath);
   bool initFromPlist(const Plist::dictionary_type& plist);
+  bool initFromPlist(const OpenStepPlist& plist);
+  void initVersionsFromPlist(const Plist::dictionary_type& plist);
+  bool initRootFromPlist(const Plist::dictionary_type& plist);
   void resolvePointers();
   void constructObjects(const Plist::dictionary_type& objectsDict);
+  PBXObject* constructObject(const String& objectId, OpenStepPlist::NodeRef objectNode) const;
+  PBXObject* createObject(const String& objectId, const Plist::dictionary_type& objectDict) const;
   
 /* Start of serialized values */
   int m_archiveVersion;
   int m_objectVersion;
-  PBXObjectMap m_objects;
+  mutable PBXObjectMap m_objects;
   String m_rootObjectId;
 /* End of serialized values */
+
+  // Objects of an OpenStep plist are only constructed when findObjectWithId is first asked
+  // for them, while resolving pointers from the root object down. Until then, these point
+  // into the plist's objects dictionary.
+  const OpenStepPlist* m_plist;
+  OpenStepPlist::NodeRef m_plistObjects;
+  std::vector<uint32_t> m_plistObjectOrder;
+
+  // Objects whose pointers are yet to be resolved
+  mutable std::vector<PBXObject*> m_unresolved;
   
   // The parent directory and name of the project
   String m_path;
@@ -17,8 +17,10 @@
 #ifndef _SBLOG_H_
 #define _SBLOG_H_
 
+#include <deque>
 #include <iostream>
 #include <fstream>
+#include <sstream>
 
 #include "types.h"
 #include "SplitStream.h"
@@ -30,6 +32,17 @@ enum SBLogLevel {
   SB_ERROR = 3
 };
 
+// Log output held back by SBLog::beginCapture, to be replayed later by another thread
+class SBLogCapture {
+private:
+  friend class SBLog;
+  struct Record {
+    SBLogLevel severity;
+    std::ostringstream text;
+  };
+  std::deque<Record> m_records;
+};
+
 class SBLog {
 public:
   ~SBLog();
@@ -44,6 +57,12 @@ public:
   static SplitStream& debug() { return log(SB_DEBUG); }
   static const String& getLogPath() { return s_logger.m_logPath; }
 
+  // Functions for holding back the output of worker threads, so that the thread that started
+  // them can report it in a fixed order
+  static void beginCapture(SBLogCapture& capture);
+  static void endCapture();
+  static void replay(const SBLogCapture& capture);
+
   // Functions for file tracking
   static void registerWorkspace(const String& absPath);
   static void registerProject(const String& absPath);
@@ -27,7 +27,6 @@ public:
   using VariableCollection::insert;
   virtual void insert(const String& varName, const String& varValue);
   virtual void erase(const String& varName);
-  String& operator[](const String& varName);
   virtual bool getValue(const String& varName, String& ret) const;
   virtual void getVariableSet(StringSet& ret) const;
   virtual bool empty() const;
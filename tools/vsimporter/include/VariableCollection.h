@@ -27,6 +27,7 @@ public:
 
 class VariableCollection {
 public:
+  VariableCollection() : m_generation(0) {}
   virtual ~VariableCollection() {}
 
   void insert(const VariableCollection& vc);
@@ -41,6 +42,15 @@ public:
   virtual bool isSet(const String& varName) const;
   virtual void getVariableSet(StringSet& ret) const = 0;
   virtual void print(const VarPrintFunc& pf) const;
+
+  // Bumped whenever a variable is actually added, changed or removed, so cached expansions can tell they are stale
+  unsigned long getGeneration() const { return m_generation; }
+
+protected:
+  void touch() { m_generation++; }
+
+private:
+  unsigned long m_generation;
 };
 
 #endif /* _VARIABLECOLLECTION_H_ */
\ No newline at end of file
@@ -17,6 +17,7 @@
 #ifndef _VARIABLECOLLECTIONHIERARCHY_H_
 #define _VARIABLECOLLECTIONHIERARCHY_H_
 
+#include <mutex>
 #include "types.h"
 
 class VariableCollection;
@@ -24,6 +25,13 @@ class VarPrintFunc;
 
 class VariableCollectionHierarchy {
 public:
+  // A memoized XCVariableExpander result
+  struct Expansion {
+    bool found;
+    String value;
+    StringSet freeVars; // Variables looked up from outside the expansion; it is only valid while none of them is being expanded
+  };
+
   void push_back(const VariableCollection& vc);
   void pop_back();
 
@@ -39,8 +47,21 @@ public:
   void print(const VarPrintFunc& pf) const;
   size_t size() const;
 
+  // The expansion cache may be used from several threads at once, so these copy in and out under a lock
+  bool getCachedExpansion(const String& varName, size_t searchDepth, size_t maxSearchLevel, Expansion& ret) const;
+  void cacheExpansion(const String& varName, size_t searchDepth, size_t maxSearchLevel, const Expansion& expansion) const;
+
 private:
+  typedef std::pair<String, std::pair<size_t, size_t> > ExpansionKey;
+  typedef std::map<ExpansionKey, Expansion> ExpansionCache;
+
+  void validateExpansionCache() const;
+
   std::vector<const VariableCollection*> m_vcs;
+
+  mutable std::mutex m_expansionLock;
+  mutable ExpansionCache m_expansionCache;
+  mutable std::vector<unsigned long> m_expansionGenerations; // Of each level, when the cache was filled
 };
 
 #endif /* _VARIABLECOLLECTIONHIERARCHY_H_ */
\ No newline at end of file
@@ -32,14 +32,24 @@ private:
   typedef std::map<const String, size_t> VariableMarkerMap;
   typedef std::pair<const String, size_t> VariableMarkerPair;
 
+  // A variable whose expansion is in progress
+  struct ExpansionFrame {
+    String varName;
+    bool cacheable;
+    StringSet freeVars;
+  };
+
   XCVariableExpander(); // disallow
   size_t processPossibleVar(const String& str, size_t posn, String& ret);
   size_t processBracketedVar(const String& str, size_t posn, String& ret);
   size_t processSimpleVar(const String& str, size_t posn, String& ret);
   String getInheritedName(const String& varName);
+  bool isBeingExpanded(const StringSet& varNames) const;
+  void noteVariableUse(const String& varName);
 
   VariableMarkerMap m_varMarkers;
   String m_currentVar;
+  std::vector<ExpansionFrame> m_frames;
   const VariableCollectionHierarchy& m_vch;
   size_t m_maxSearchLevel;
 };
@@ -147,5 +147,12 @@ void getRelativePaths(const String& fromAbsPath, StringVec& toAbsPaths);
 
 void openOutputFileStream(OFStream& ofs, const String& outFilePath, OFStream::openmode mode = OFStream::out);
 
+/*
+ * Writes contents to a file, unless the file already holds exactly that content,
+ * in which case it is left untouched. Sets changed, when given, to whether the
+ * file was written. Returns false if the file could not be written.
+ */
+bool writeFileIfChanged(const String& outFilePath, const String& contents, OFStream::openmode mode = OFStream::out, bool* changed = NULL);
+
 #endif /* _FILEUTILS_H_ */
 
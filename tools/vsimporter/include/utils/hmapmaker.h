@@ -20,14 +20,38 @@
 #include <stdint.h>
 #include <string.h>
 #include <string>
+#include <vector>
+#include <unordered_map>
 #include <fstream>
 
 class IncludeMapMaker {
 public:
   IncludeMapMaker();
   ~IncludeMapMaker();
+
+  /// Adds a mapping from an include name to a header path. Include names are
+  /// case-insensitive; if a name is mapped more than once, the first mapping
+  /// wins, as it would with clang probing the table.
   void addMapping(const std::string &from, const std::string &to);
+
+  /// Looks up an include name the way clang does; returns false if unmapped.
+  bool lookup(const std::string &from, std::string &to);
+
+  /// Replaces the contents with an existing header map file, so that it can be
+  /// inspected with lookup() or extended and written back. Writing it back
+  /// unchanged reproduces the file.
+  bool readMap(const std::string &fileName);
+
+  /// Adds the mappings of other that are new, after the existing ones, so that
+  /// the strings and buckets already written stay where they are. Returns false
+  /// without changing anything if other maps an existing name differently or
+  /// not at all, as entries can't be removed in place.
+  bool update(const IncludeMapMaker &other);
+
   void writeMap(std::ofstream& outFile);
+
+  /// Writes the map to fileName. If the file already holds an identical map it
+  /// is left alone, so that its timestamp doesn't trigger needless rebuilds.
   bool writeMap(const std::string &fileName);
   
 private:
@@ -58,28 +82,24 @@ private:
   };
  
   struct MapEntry {
-    char *from;
-    char *toDirectory;  //  prefix
-    char *toFilename;   //  suffix
-
     uint32_t fromOffset, prefixOffset, suffixOffset;
   };
   
-  MapEntry *headerMaps;
-  int    mapCount, mapCountMax;
+  std::vector<MapEntry> headerMaps;
+  std::unordered_map<uint32_t, uint32_t> headerMapIndex;   // fromOffset -> index in headerMaps
  
-  char    **strings;
+  //  All strings live once in stringsBlock, which is written out as is. Offset
+  //  0 holds the empty string, so no key can collide with HMAP_EmptyBucketKey.
+  std::vector<char> stringsBlock;
+  std::vector<uint32_t> stringSlots;   // Open addressed set of string offsets, 0 = free
   int       numStrings;
-  char     *stringsBlock;
-  int       stringsBlockLen;
   int       maxStringLen;
  
-  HMapBucket *buckets;
-  int numBuckets, numAdded;
- 
-  static int compareStringPtrs(const char **a, const char **b) {
-    return strcmp(*a, *b);
-  }
+  std::vector<HMapBucket> buckets;
+  bool bucketsValid;
+
+  //  Keep the table at most 3/4 full, so lookups stay short
+  enum { HMAP_MaxLoadNumerator = 3, HMAP_MaxLoadDenominator = 4 };
   
   static uint32_t nextPow2(uint32_t v) {
     v--;
@@ -103,10 +123,15 @@ private:
       Result += *S * 13;
     return Result;
   }
+
+  static uint32_t hashString(const char *str, size_t len);
  
-  void buildStrings();
+  int64_t findString(const char *str, size_t len) const;
+  uint32_t internString(const char *str, size_t len);
+  void growStringSlots();
+  void addMapping(const char *from, size_t fromLen, const char *to, size_t toLen);
   void buildHash();
-  void createHashMapping(MapEntry *entry);
+  void serialize(std::string &out);
 };
 
 #endif /* _HMAPMAKER_H_ */
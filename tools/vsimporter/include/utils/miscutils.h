@@ -18,6 +18,7 @@
 #define _MISCUTILS_H_
 
 #include "types.h"
+#include <functional>
 
 String getTime();
 double getEpochTime();
@@ -29,4 +30,10 @@ void removeDupes(StringVec& in);
 bool checkTelemetryOptIn();
 bool isMSFTInternalMachine();
 std::string getMachineID();
+
+/*
+ * Calls func(i) for every i in [0, count) on up to maxThreads threads, or one
+ * per hardware thread if maxThreads is 0. Returns once every call has finished.
+ */
+void parallelFor(size_t count, unsigned maxThreads, const std::function<void(size_t)>& func);
 #endif /* _MISCUTILS_H_ */
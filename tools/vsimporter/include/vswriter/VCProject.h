@@ -76,9 +76,9 @@ protected:
   typedef void (VCProject::*LabelHandlerFn)(pugi::xml_node& node) const;
   typedef std::map<std::string, LabelHandlerFn> LabelHandlerFnMap;
 
-  bool writeTemplate(const std::string& filePath, const LabelHandlerFnMap& handlers) const;
-  virtual bool writeFilters() const;
-  virtual bool writeProject() const;
+  bool writeTemplate(const std::string& filePath, const StringMap& templateFiles, const LabelHandlerFnMap& handlers) const;
+  virtual bool writeFilters(const StringMap& templateFiles) const;
+  virtual bool writeProject(const StringMap& templateFiles) const;
 
   void writeProjectConfigSummary(pugi::xml_node& node) const;
   void writeGlobalProperties(pugi::xml_node& node) const;
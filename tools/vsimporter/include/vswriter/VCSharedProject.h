@@ -34,7 +34,7 @@ public:
   virtual void addBuildExtension(const std::string& extension);
 
 protected:
-  virtual bool writeProject() const;
+  virtual bool writeProject(const StringMap& templateFiles) const;
 
   std::string m_sharedId;
 };
\ No newline at end of file
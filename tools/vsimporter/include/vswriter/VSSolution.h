@@ -40,7 +40,8 @@ public:
   void addConfiguration(const std::string& name);
   void addPlatform(const std::string& name);
 
-  bool write() const;
+  // Writes the solution and its projects, using up to jobs threads (0 for one per hardware thread)
+  bool write(unsigned jobs = 0) const;
   void write(std::ostream& out) const;
 
 private:
@@ -56,6 +57,7 @@ private:
   void writeProjectConfigurationPlatforms(std::ostream& out) const;
   void writeSolutionProperties(std::ostream& out) const;
   void writeNestedProjects(std::ostream& out) const;
+  bool writeProjects(unsigned jobs) const;
 
   unsigned m_version;
   std::string m_absFilePath;
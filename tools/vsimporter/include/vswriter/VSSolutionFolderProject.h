@@ -41,7 +41,7 @@ public:
 private:
   typedef std::set<std::string> StringSet;
 
-  VSSolutionFolderProject(const std::string& name, VSSolution& parent);
+  VSSolutionFolderProject(const std::string& name, const VSSolutionFolderProject* parentFolder, VSSolution& parent);
   void writeFileDescriptions(std::ostream& out) const;
 
   std::string m_name;
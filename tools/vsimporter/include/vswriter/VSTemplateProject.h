@@ -39,7 +39,8 @@ public:
   ~VSTemplateProject();
 
   void expand(const std::string& srcDir, const std::string& destDir, const VSTemplateParameters& params);
-  void write(const StringSet& urlSchemes) const;
+  // Items whose output paths are in holdBack are expanded into heldBack instead of being written
+  void write(const StringSet& urlSchemes, const StringSet& holdBack, StringMap& heldBack) const;
 
   bool isShared() const;
   bool isDeployable() const;
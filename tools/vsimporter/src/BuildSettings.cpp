@@ -69,8 +69,8 @@ BuildSettings::BuildSettings(const PBXTarget* target, const String& configName)
   addLevel(&m_overrideSettings);
 
   // Insert a few extra variables into the build settings
-  m_overrideSettings["CONFIGURATION"] = configName;
-  m_overrideSettings["SDKROOT"] = "${WINOBJC_SDK_ROOT}";
+  m_overrideSettings.insert("CONFIGURATION", configName);
+  m_overrideSettings.insert("SDKROOT", "${WINOBJC_SDK_ROOT}");
 }
 
 void BuildSettings::addLevel(const VariableCollection* vc)
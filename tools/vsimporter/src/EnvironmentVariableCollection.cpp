@@ -27,20 +27,29 @@ EnvironmentVariableCollection EnvironmentVariableCollection::s_envVC;
 
 void EnvironmentVariableCollection::insert(const String& varName, const String& varValue)
 {
+  String oldValue;
+  if (getValue(varName, oldValue) && oldValue == varValue)
+    return;
+
 #if defined(_MSC_VER)
   _putenv_s(varName.c_str(), varValue.c_str());
 #else
   setenv(varName.c_str(), varValue.c_str(), 1);
 #endif
+  touch();
 }
 
 void EnvironmentVariableCollection::erase(const String& varName)
 {
+  if (!isSet(varName))
+    return;
+
 #if defined(_MSC_VER)
   _putenv_s(varName.c_str(), "");
 #else
   unsetenv(varName.c_str());
 #endif
+  touch();
 }
 
 bool EnvironmentVariableCollection::getValue(const String& varName, String& ret) const
@@ -0,0 +1,372 @@
+//******************************************************************************
+//
+// Copyright (c) 2015 Microsoft Corporation. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+#include <string.h>
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#include "OpenStepPlist.h"
+
+static bool isUnquotedChar(char c)
+{
+  return isalnum((unsigned char)c) || strchr("_$+/:.-", c) != NULL;
+}
+
+static int hexValue(char c)
+{
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+static void appendUTF8(unsigned code, String& ret)
+{
+  if (code < 0x80) {
+    ret += char(code);
+  } else if (code < 0x800) {
+    ret += char(0xC0 | (code >> 6));
+    ret += char(0x80 | (code & 0x3F));
+  } else {
+    ret += char(0xE0 | (code >> 12));
+    ret += char(0x80 | ((code >> 6) & 0x3F));
+    ret += char(0x80 | (code & 0x3F));
+  }
+}
+
+bool OpenStepPlist::readFile(const String& path)
+{
+  std::ifstream ifs(path.c_str(), std::ifstream::in | std::ifstream::binary);
+  if (!ifs.is_open())
+    return false;
+
+  std::vector<char> buffer((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+
+  // Skip a UTF-8 BOM, then sniff the first significant character
+  size_t start = buffer.size() >= 3 && memcmp(buffer.data(), "\xEF\xBB\xBF", 3) == 0 ? 3 : 0;
+  size_t first = start;
+  while (first < buffer.size() && (buffer[first] == ' ' || buffer[first] == '\t' || buffer[first] == '\r' || buffer[first] == '\n'))
+    first++;
+  if (first == buffer.size() || (buffer[first] != '/' && buffer[first] != '{' && buffer[first] != '('))
+    return false;
+
+  m_buffer.swap(buffer);
+  parseText(m_buffer.data() + start, m_buffer.size() - start);
+  return true;
+}
+
+void OpenStepPlist::parse(const char* text, size_t length)
+{
+  m_buffer.clear();
+  parseText(text, length);
+}
+
+void OpenStepPlist::parseText(const char* text, size_t length)
+{
+  m_text = text;
+  m_length = length;
+  m_posn = 0;
+  m_nodes.clear();
+  m_children.clear();
+  m_pending.clear();
+
+  m_root = parseValue();
+
+  skipWhitespace();
+  if (m_posn < m_length)
+    fail("Unexpected characters after the root object.");
+}
+
+void OpenStepPlist::fail(const String& msg) const
+{
+  size_t line = 1 + std::count(m_text, m_text + std::min(m_posn, m_length), '\n');
+  throw std::runtime_error("Malformed property list at line " + std::to_string(line) + ": " + msg);
+}
+
+void OpenStepPlist::skipWhitespace()
+{
+  while (m_posn < m_length) {
+    char c = m_text[m_posn];
+    if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+      m_posn++;
+    } else if (c == '/' && m_posn + 1 < m_length && m_text[m_posn + 1] == '/') {
+      const char* end = (const char*)memchr(m_text + m_posn, '\n', m_length - m_posn);
+      m_posn = end ? end - m_text : m_length;
+    } else if (c == '/' && m_posn + 1 < m_length && m_text[m_posn + 1] == '*') {
+      static const char close[] = "*/";
+      const char* end = std::search(m_text + m_posn + 2, m_text + m_length, close, close + 2);
+      if (end == m_text + m_length)
+        fail("Unterminated comment.");
+      m_posn = end - m_text + 2;
+    } else {
+      break;
+    }
+  }
+}
+
+OpenStepPlist::NodeRef OpenStepPlist::addNode(NodeType type, bool escaped, size_t begin, size_t length)
+{
+  Node node;
+  node.type = type;
+  node.escaped = escaped;
+  node.begin = begin;
+  node.length = length;
+  m_nodes.push_back(node);
+  return m_nodes.size() - 1;
+}
+
+OpenStepPlist::NodeRef OpenStepPlist::parseValue()
+{
+  skipWhitespace();
+  if (m_posn >= m_length)
+    fail("Unexpected end of file.");
+
+  switch (m_text[m_posn]) {
+  case '{':
+    m_posn++;
+    return parseContainer(DictionaryNode, '}');
+  case '(':
+    m_posn++;
+    return parseContainer(ArrayNode, ')');
+  default:
+    return parseString();
+  }
+}
+
+OpenStepPlist::NodeRef OpenStepPlist::parseString()
+{
+  char c = m_text[m_posn];
+
+  if (c == '"' || c == '\'') {
+    size_t begin = ++m_posn;
+    bool escaped = false;
+    for (; m_posn < m_length && m_text[m_posn] != c; m_posn++) {
+      if (m_text[m_posn] == '\\') {
+        escaped = true;
+        m_posn++;
+      }
+    }
+    if (m_posn >= m_length)
+      fail("Unterminated string.");
+    return addNode(StringNode, escaped, begin, m_posn++ - begin);
+  } else if (c == '<') {
+    // Data; pbxproj files don't really use it, so keep the hex digits as text
+    const char* close = (const char*)memchr(m_text + m_posn, '>', m_length - m_posn);
+    if (!close)
+      fail("Unterminated data.");
+    size_t end = close - m_text;
+    size_t begin = m_posn + 1;
+    m_posn = end + 1;
+    return addNode(StringNode, false, begin, end - begin);
+  } else {
+    size_t begin = m_posn;
+    while (m_posn < m_length && isUnquotedChar(m_text[m_posn]))
+      m_posn++;
+    if (m_posn == begin)
+      fail(String("Unexpected character '") + c + "'.");
+    return addNode(StringNode, false, begin, m_posn - begin);
+  }
+}
+
+OpenStepPlist::NodeRef OpenStepPlist::parseContainer(NodeType type, char close)
+{
+  size_t firstPending = m_pending.size();
+
+  for (;;) {
+    skipWhitespace();
+    if (m_posn >= m_length)
+      fail("Unexpected end of file.");
+    if (m_text[m_posn] == close) {
+      m_posn++;
+      break;
+    }
+
+    if (type == DictionaryNode) {
+      NodeRef key = parseValue();
+      if (m_nodes[key].type != StringNode)
+        fail("Dictionary key is not a string.");
+      m_pending.push_back(key);
+
+      skipWhitespace();
+      if (m_posn >= m_length || m_text[m_posn++] != '=')
+        fail("Expected '=' after dictionary key.");
+      m_pending.push_back(parseValue());
+
+      skipWhitespace();
+      if (m_posn >= m_length || m_text[m_posn++] != ';')
+        fail("Expected ';' after dictionary value.");
+    } else {
+      m_pending.push_back(parseValue());
+
+      skipWhitespace();
+      if (m_posn < m_length && m_text[m_posn] == ',')
+        m_posn++;
+      else if (m_posn >= m_length || m_text[m_posn] != close)
+        fail("Expected ',' between array elements.");
+    }
+  }
+
+  // Move this container's children into their final, contiguous spot
+  size_t begin = m_children.size();
+  size_t count = m_pending.size() - firstPending;
+  m_children.insert(m_children.end(), m_pending.begin() + firstPending, m_pending.end());
+  m_pending.resize(firstPending);
+
+  return addNode(type, false, begin, type == DictionaryNode ? count / 2 : count);
+}
+
+OpenStepPlist::NodeRef OpenStepPlist::findValue(NodeRef dict, const char* key) const
+{
+  if (m_nodes[dict].type != DictionaryNode)
+    return npos;
+
+  for (size_t i = 0; i < getCount(dict); i++) {
+    if (stringEquals(getKey(dict, i), key))
+      return getValue(dict, i);
+  }
+  return npos;
+}
+
+void OpenStepPlist::sortEntries(NodeRef dict, std::vector<uint32_t>& ret) const
+{
+  ret.resize(getCount(dict));
+  for (size_t i = 0; i < ret.size(); i++)
+    ret[i] = i;
+
+  std::sort(ret.begin(), ret.end(), [&](uint32_t a, uint32_t b) {
+    const Node& key = m_nodes[getKey(dict, b)];
+    if (key.escaped) {
+      String str = getString(getKey(dict, b));
+      return compareString(getKey(dict, a), str.data(), str.length()) < 0;
+    }
+    return compareString(getKey(dict, a), m_text + key.begin, key.length) < 0;
+  });
+}
+
+OpenStepPlist::NodeRef OpenStepPlist::findValue(NodeRef dict, const std::vector<uint32_t>& sortedEntries, const String& key) const
+{
+  std::vector<uint32_t>::const_iterator it = std::lower_bound(sortedEntries.begin(), sortedEntries.end(), key, [&](uint32_t entry, const String& str) {
+    return compareString(getKey(dict, entry), str.data(), str.length()) < 0;
+  });
+  if (it == sortedEntries.end() || compareString(getKey(dict, *it), key.data(), key.length()) != 0)
+    return npos;
+  return getValue(dict, *it);
+}
+
+int OpenStepPlist::compareString(NodeRef node, const char* str, size_t length) const
+{
+  const Node& n = m_nodes[node];
+  if (n.escaped)
+    return getString(node).compare(0, String::npos, str, length);
+
+  int ret = memcmp(m_text + n.begin, str, std::min<size_t>(n.length, length));
+  if (ret == 0 && n.length != length)
+    ret = n.length < length ? -1 : 1;
+  return ret;
+}
+
+bool OpenStepPlist::stringEquals(NodeRef node, const char* str) const
+{
+  const Node& n = m_nodes[node];
+  if (n.type != StringNode)
+    return false;
+  if (n.escaped)
+    return getString(node) == str;
+  return strlen(str) == n.length && memcmp(m_text + n.begin, str, n.length) == 0;
+}
+
+String OpenStepPlist::getString(NodeRef node) const
+{
+  const Node& n = m_nodes[node];
+  if (n.type != StringNode)
+    return String();
+  if (!n.escaped)
+    return String(m_text + n.begin, n.length);
+
+  String ret;
+  ret.reserve(n.length);
+
+  size_t end = n.begin + n.length;
+  for (size_t i = n.begin; i < end; i++) {
+    char c = m_text[i];
+    if (c != '\\' || i + 1 >= end) {
+      ret += c;
+      continue;
+    }
+
+    c = m_text[++i];
+    switch (c) {
+    case 'a': ret += '\a'; break;
+    case 'b': ret += '\b'; break;
+    case 'f': ret += '\f'; break;
+    case 'n': ret += '\n'; break;
+    case 'r': ret += '\r'; break;
+    case 't': ret += '\t'; break;
+    case 'v': ret += '\v'; break;
+    case 'U': {
+      unsigned code = 0;
+      int digits = 0;
+      for (; digits < 4 && i + 1 < end && hexValue(m_text[i + 1]) >= 0; digits++)
+        code = code * 16 + hexValue(m_text[++i]);
+      appendUTF8(code, ret);
+      break;
+    }
+    default:
+      if (c >= '0' && c <= '7') {
+        unsigned code = c - '0';
+        for (int digits = 1; digits < 3 && i + 1 < end && m_text[i + 1] >= '0' && m_text[i + 1] <= '7'; digits++)
+          code = code * 8 + (m_text[++i] - '0');
+        ret += char(code);
+      } else {
+        // \\, \", \' and anything unknown stand for themselves
+        ret += c;
+      }
+      break;
+    }
+  }
+
+  return ret;
+}
+
+void OpenStepPlist::toDictionary(NodeRef dict, Plist::dictionary_type& ret) const
+{
+  for (size_t i = 0; i < getCount(dict); i++) {
+    toAny(getValue(dict, i), ret[getString(getKey(dict, i))]);
+  }
+}
+
+void OpenStepPlist::toAny(NodeRef node, boost::any& ret) const
+{
+  switch (getType(node)) {
+  case StringNode:
+    ret = Plist::string_type(getString(node));
+    break;
+  case ArrayNode: {
+    // Fill the containers in place rather than copying them into ret
+    ret = Plist::array_type(getCount(node));
+    Plist::array_type& array = *boost::any_cast<Plist::array_type>(&ret);
+    for (size_t i = 0; i < array.size(); i++)
+      toAny(getElement(node, i), array[i]);
+    break;
+  }
+  case DictionaryNode:
+    ret = Plist::dictionary_type();
+    toDictionary(node, *boost::any_cast<Plist::dictionary_type>(&ret));
+    break;
+  }
+}
@@ -54,7 +54,9 @@ PBXDocument::~PBXDocument()
 PBXDocument::PBXDocument(const String& projectPath)
   : m_rootObjectPtr(NULL),
     m_path(platformPath(sanitizePath(projectPath))),
-    m_parseER(SB_DEBUG)
+    m_parseER(SB_DEBUG),
+    m_plist(NULL),
+    m_plistObjects(OpenStepPlist::npos)
 {
   // Set context for any parse errors that we might encounter
   m_parseER.setContext("Error parsing \"" + getName() + "\" project description. ");
@@ -75,7 +77,63 @@ PBXDocument* PBXDocument::createFromPlist(const Plist::dictionary_type& plist, c
   return ret;
 }
 
+PBXDocument* PBXDocument::createFromPlist(const OpenStepPlist& plist, const String& projectPath)
+{
+  PBXDocument* ret = new PBXDocument(projectPath);
+  if (!ret->initFromPlist(plist)) {
+    delete ret;
+    ret = NULL;
+  }
+
+  return ret;
+}
+
 bool PBXDocument::initFromPlist(const Plist::dictionary_type& plist)
+{
+  initVersionsFromPlist(plist);
+
+  // Get objects
+  const Plist::dictionary_type& objectsDict = getContainerForKey<Plist::dictionary_type>(plist, "objects", VALUE_REQUIRED, m_parseER);
+  constructObjects(objectsDict);
+  
+  return initRootFromPlist(plist);
+}
+
+bool PBXDocument::initFromPlist(const OpenStepPlist& plist)
+{
+  // Box everything except the objects, which are boxed one at a time as they are referred to
+  Plist::dictionary_type topLevel;
+  OpenStepPlist::NodeRef objectsDict = OpenStepPlist::npos;
+  OpenStepPlist::NodeRef root = plist.root();
+  for (size_t i = 0; i < plist.getCount(root); i++) {
+    OpenStepPlist::NodeRef value = plist.getValue(root, i);
+    if (plist.stringEquals(plist.getKey(root, i), "objects") && plist.getType(value) == OpenStepPlist::DictionaryNode)
+      objectsDict = value;
+    else
+      plist.toAny(value, topLevel[plist.getString(plist.getKey(root, i))]);
+  }
+
+  initVersionsFromPlist(topLevel);
+
+  // Get objects
+  if (objectsDict != OpenStepPlist::npos) {
+    m_plist = &plist;
+    m_plistObjects = objectsDict;
+    plist.sortEntries(objectsDict, m_plistObjectOrder);
+  } else {
+    constructObjects(getContainerForKey<Plist::dictionary_type>(topLevel, "objects", VALUE_REQUIRED, m_parseER));
+  }
+
+  bool ret = initRootFromPlist(topLevel);
+
+  // Objects nothing refers to are never constructed
+  m_plist = NULL;
+  m_plistObjectOrder.clear();
+
+  return ret;
+}
+
+void PBXDocument::initVersionsFromPlist(const Plist::dictionary_type& plist)
 {
   // Get archiveVersion
   m_archiveVersion = getIntForKey(plist, "archiveVersion", VALUE_REQUIRED, m_parseER);
@@ -83,11 +141,10 @@ bool PBXDocument::initFromPlist(const Plist::dictionary_type& plist)
   // Get objectVersion
   m_objectVersion = getIntForKey(plist, "objectVersion", VALUE_REQUIRED, m_parseER);
   TELEMETRY_EVENT_DATA(L"VSImporterObjectVersion", to_string(m_objectVersion).c_str());
+}
 
-  // Get objects
-  const Plist::dictionary_type& objectsDict = getContainerForKey<Plist::dictionary_type>(plist, "objects", VALUE_REQUIRED, m_parseER);
-  constructObjects(objectsDict);
-  
+bool PBXDocument::initRootFromPlist(const Plist::dictionary_type& plist)
+{
   // Get rootObject
   getStringForKey(plist, "rootObject", m_rootObjectId, VALUE_REQUIRED, m_parseER);
 
@@ -118,63 +175,87 @@ void PBXDocument::constructObjects(const Plist::dictionary_type& objectsDict)
 
     // Get object contents
     const Plist::dictionary_type& objectDict = castContainer<Plist::dictionary_type>(objsIt->second, VALUE_REQUIRED, m_parseER);
-    
-    // Get object type
-    String isa;
-    getStringForKey(objectDict, "isa", isa, VALUE_REQUIRED, m_parseER);
-    
-    PBXObject* object = NULL;
-    
-    if (isa == "PBXBuildFile") {
-      object = PBXBuildFile::createFromPlist(objectId, objectDict, this);
-    } else if (isa == "PBXFileReference") {
-      object = PBXFileReference::createFromPlist(objectId, objectDict, this);
-    } else if (isa == "PBXReferenceProxy") {
-      object = PBXReferenceProxy::createFromPlist(objectId, objectDict, this);
-    } else if (isa == "PBXGroup") {
-      object = PBXGroup::createFromPlist(objectId, objectDict, this);
-    } else if (isa == "PBXVariantGroup") {
-      object = PBXVariantGroup::createFromPlist(objectId, objectDict, this);
-    } else if (isa == "XCVersionGroup") {
-      object = XCVersionGroup::createFromPlist(objectId, objectDict, this);
-    } else if (isa == "PBXContainerItemProxy") {
-      object = PBXContainerItemProxy::createFromPlist(objectId, objectDict, this);
-    } else if (isa == "PBXTargetDependency") {
-      object = PBXTargetDependency::createFromPlist(objectId, objectDict, this);
-    } else if (isa == "XCConfigurationList") {
-      object = XCConfigurationList::createFromPlist(objectId, objectDict, this);
-    } else if (isa == "PBXLegacyTarget") {
-      object = PBXLegacyTarget::createFromPlist(objectId, objectDict, this);
-    } else if (isa == "PBXAggregateTarget") {
-      object = PBXAggregateTarget::createFromPlist(objectId, objectDict, this);
-    } else if (isa == "PBXNativeTarget") {
-      object = PBXNativeTarget::createFromPlist(objectId, objectDict, this);
-    } else if (isa == "PBXFrameworksBuildPhase") {
-      object = PBXFrameworksBuildPhase::createFromPlist(objectId, objectDict, this);
-    } else if (isa == "PBXSourcesBuildPhase") {
-      object = PBXSourcesBuildPhase::createFromPlist(objectId, objectDict, this);
-    } else if (isa == "PBXResourcesBuildPhase") {
-      object = PBXResourcesBuildPhase::createFromPlist(objectId, objectDict, this);
-    } else if (isa == "PBXHeadersBuildPhase") {
-      object = PBXHeadersBuildPhase::createFromPlist(objectId, objectDict, this);
-    } else if (isa == "PBXCopyFilesBuildPhase") {
-      object = PBXCopyFilesBuildPhase::createFromPlist(objectId, objectDict, this);
-    } else if (isa == "PBXShellScriptBuildPhase") {
-      object = PBXShellScriptBuildPhase::createFromPlist(objectId, objectDict, this);
-    } else if (isa == "PBXProject") {
-      object = PBXProject::createFromPlist(objectId, objectDict, this);
-    } else if (isa == "XCBuildConfiguration") {
-      object = XCBuildConfiguration::createFromPlist(objectId, objectDict, this);
-    } else if (isa == "PBXBuildRule") {
-      object = PBXBuildRule::createFromPlist(objectId, objectDict, this);
-    } else {
-      m_parseER.reportError("Object type is unsupported: " + isa);
-    }
 
     // Add object to the map
-    if (object)
+    PBXObject* object = createObject(objectId, objectDict);
+    if (object) {
       m_objects[objectId] = object;
+      m_unresolved.push_back(object);
+    }
+  }
+}
+
+PBXObject* PBXDocument::constructObject(const String& objectId, OpenStepPlist::NodeRef objectNode) const
+{
+  // Get object contents, boxed only for as long as it takes to construct the object
+  boost::any objectVal;
+  m_plist->toAny(objectNode, objectVal);
+  const Plist::dictionary_type& objectDict = castContainer<Plist::dictionary_type>(objectVal, VALUE_REQUIRED, m_parseER);
+
+  // Add object to the map, even if it failed, so that it is only attempted once
+  PBXObject* object = createObject(objectId, objectDict);
+  m_objects[objectId] = object;
+  if (object)
+    m_unresolved.push_back(object);
+
+  return object;
+}
+
+PBXObject* PBXDocument::createObject(const String& objectId, const Plist::dictionary_type& objectDict) const
+{
+  // Get object type
+  String isa;
+  getStringForKey(objectDict, "isa", isa, VALUE_REQUIRED, m_parseER);
+  
+  PBXObject* object = NULL;
+  
+  if (isa == "PBXBuildFile") {
+    object = PBXBuildFile::createFromPlist(objectId, objectDict, this);
+  } else if (isa == "PBXFileReference") {
+    object = PBXFileReference::createFromPlist(objectId, objectDict, this);
+  } else if (isa == "PBXReferenceProxy") {
+    object = PBXReferenceProxy::createFromPlist(objectId, objectDict, this);
+  } else if (isa == "PBXGroup") {
+    object = PBXGroup::createFromPlist(objectId, objectDict, this);
+  } else if (isa == "PBXVariantGroup") {
+    object = PBXVariantGroup::createFromPlist(objectId, objectDict, this);
+  } else if (isa == "XCVersionGroup") {
+    object = XCVersionGroup::createFromPlist(objectId, objectDict, this);
+  } else if (isa == "PBXContainerItemProxy") {
+    object = PBXContainerItemProxy::createFromPlist(objectId, objectDict, this);
+  } else if (isa == "PBXTargetDependency") {
+    object = PBXTargetDependency::createFromPlist(objectId, objectDict, this);
+  } else if (isa == "XCConfigurationList") {
+    object = XCConfigurationList::createFromPlist(objectId, objectDict, this);
+  } else if (isa == "PBXLegacyTarget") {
+    object = PBXLegacyTarget::createFromPlist(objectId, objectDict, this);
+  } else if (isa == "PBXAggregateTarget") {
+    object = PBXAggregateTarget::createFromPlist(objectId, objectDict, this);
+  } else if (isa == "PBXNativeTarget") {
+    object = PBXNativeTarget::createFromPlist(objectId, objectDict, this);
+  } else if (isa == "PBXFrameworksBuildPhase") {
+    object = PBXFrameworksBuildPhase::createFromPlist(objectId, objectDict, this);
+  } else if (isa == "PBXSourcesBuildPhase") {
+    object = PBXSourcesBuildPhase::createFromPlist(objectId, objectDict, this);
+  } else if (isa == "PBXResourcesBuildPhase") {
+    object = PBXResourcesBuildPhase::createFromPlist(objectId, objectDict, this);
+  } else if (isa == "PBXHeadersBuildPhase") {
+    object = PBXHeadersBuildPhase::createFromPlist(objectId, objectDict, this);
+  } else if (isa == "PBXCopyFilesBuildPhase") {
+    object = PBXCopyFilesBuildPhase::createFromPlist(objectId, objectDict, this);
+  } else if (isa == "PBXShellScriptBuildPhase") {
+    object = PBXShellScriptBuildPhase::createFromPlist(objectId, objectDict, this);
+  } else if (isa == "PBXProject") {
+    object = PBXProject::createFromPlist(objectId, objectDict, this);
+  } else if (isa == "XCBuildConfiguration") {
+    object = XCBuildConfiguration::createFromPlist(objectId, objectDict, this);
+  } else if (isa == "PBXBuildRule") {
+    object = PBXBuildRule::createFromPlist(objectId, objectDict, this);
+  } else {
+    m_parseER.reportError("Object type is unsupported: " + isa);
   }
+
+  return object;
 }
 
 void PBXDocument::resolvePointers()
@@ -182,13 +263,11 @@ void PBXDocument::resolvePointers()
   // Resolve pointer to the PBXProject
   m_rootObjectPtr = dynamic_cast<PBXProject*>(findObjectWithId(m_rootObjectId));
   
-  // Resolve pointers for all objects
-  PBXObjectMap::iterator objIt = m_objects.begin();
-  PBXObjectMap::iterator objEnd = m_objects.end();
-  for (; objIt != objEnd; objIt++) {
-    if (objIt->second)
-      objIt->second->resolvePointers();
-  }
+  // Resolve pointers for all objects. Objects of an OpenStep plist get constructed, and
+  // added to the list, as they are referred to.
+  for (size_t i = 0; i < m_unresolved.size(); i++)
+    m_unresolved[i]->resolvePointers();
+  m_unresolved.clear();
 }
 
 PBXObject* PBXDocument::findObjectWithId(const String& id) const
@@ -197,10 +276,15 @@ PBXObject* PBXDocument::findObjectWithId(const String& id) const
     return NULL;
   
   PBXObjectMap::const_iterator it = m_objects.find(id);
-  if (it != m_objects.end()) {
+  if (it != m_objects.end())
     return it->second;
-  } else {
-    m_parseER.reportError("Failed to find object with id:" + id);
-    return NULL;
+
+  if (m_plist) {
+    OpenStepPlist::NodeRef objectNode = m_plist->findValue(m_plistObjects, m_plistObjectOrder, id);
+    if (objectNode != OpenStepPlist::npos)
+      return constructObject(id, objectNode);
   }
+
+  m_parseER.reportError("Failed to find object with id:" + id);
+  return NULL;
 }
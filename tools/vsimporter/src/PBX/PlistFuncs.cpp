@@ -15,6 +15,7 @@
 //******************************************************************************
 
 #include <sstream>
+#include <vector>
 
 #include "PlistFuncs.h"
 #include "SimpleVariableCollection.h"
@@ -254,21 +255,62 @@ const T& getContainerForKey(const Plist::dictionary_type& dict, const String& ke
 template const Plist::dictionary_type& getContainerForKey<Plist::dictionary_type>(const Plist::dictionary_type&, const String&, GetterBehavior, const ErrorReporter&);
 template const Plist::array_type& getContainerForKey<Plist::array_type>(const Plist::dictionary_type&, const String&, GetterBehavior, const ErrorReporter&);
 
+// Project files that prefetchFiles has already parsed, by project path
+static std::map<String, OpenStepPlist> s_prefetchedPlists;
+
+void PBXDocument::prefetchFiles(const StringVec& projPaths, unsigned jobs)
+{
+  // Reading and parsing the files is most of the work of opening a project, and unlike
+  // constructing the objects, doesn't touch any shared state. Failures are left for
+  // createFromFile to run into again and report.
+  std::vector<OpenStepPlist> plists(projPaths.size());
+  std::vector<char> parsed(projPaths.size());
+  parallelFor(projPaths.size(), jobs, [&](size_t i) {
+    try {
+      parsed[i] = plists[i].readFile(joinPaths(projPaths[i], "project.pbxproj"));
+    } catch (const std::exception&) {
+      parsed[i] = false;
+    }
+  });
+
+  for (size_t i = 0; i < projPaths.size(); i++) {
+    if (parsed[i] && plists[i].getType(plists[i].root()) == OpenStepPlist::DictionaryNode)
+      s_prefetchedPlists[projPaths[i]] = std::move(plists[i]);
+  }
+}
+
 PBXDocument* PBXDocument::createFromFile(const String& projPath)
 {
+  auto prefetchedIt = s_prefetchedPlists.find(projPath);
+  if (prefetchedIt != s_prefetchedPlists.end()) {
+    OpenStepPlist openStep = std::move(prefetchedIt->second);
+    s_prefetchedPlists.erase(prefetchedIt);
+    return PBXDocument::createFromPlist(openStep, projPath);
+  }
+
   String projFilePath = joinPaths(projPath, "project.pbxproj");
   const Plist::dictionary_type* pDict = NULL;
   boost::any pDoc;
+  OpenStepPlist openStep;
+  bool isOpenStep = false;
 
   try {
-    Plist::readPlist(projFilePath.c_str(), pDoc);
-    pDict = dictionary_cast(pDoc);
+    // Most project files are OpenStep plists, which we can read without boxing
+    // every value. Leave XML and binary plists to PlistCpp.
+    isOpenStep = openStep.readFile(projFilePath);
+    if (!isOpenStep) {
+      Plist::readPlist(projFilePath.c_str(), pDoc);
+      pDict = dictionary_cast(pDoc);
+    }
   } catch (const std::exception& e) {
     SBLog::error() << e.what() << std::endl;
+    isOpenStep = false;
     pDict = NULL;
   }
 
-  if (pDict) {
+  if (isOpenStep && openStep.getType(openStep.root()) == OpenStepPlist::DictionaryNode) {
+    return PBXDocument::createFromPlist(openStep, projPath);
+  } else if (pDict) {
     return PBXDocument::createFromPlist(*pDict, projPath);
   } else {
     SBLog::error() << "Failed to read \"" << projFilePath << "\" project file." << std::endl;
@@ -22,6 +22,10 @@
 SBLog SBLog::s_logger;
 SplitStream SBLog::s_nullStream;
 
+// Where output from this thread goes while it is being captured
+static thread_local SBLogCapture* t_capture = NULL;
+static thread_local SplitStream t_captureStream;
+
 SBLog::SBLog()
   : m_verbosity(SB_DEBUG),
     m_errStream(std::cerr),
@@ -93,12 +97,38 @@ SplitStream& SBLog::getStreamForSeverity(SBLogLevel severity)
 SplitStream& SBLog::log(SBLogLevel severity)
 {
   // Figure out which output stream to return
-  SplitStream& out = s_logger.getStreamForSeverity(severity);
+  SplitStream* out = &s_logger.getStreamForSeverity(severity);
+
+  // Start a new record instead, if this thread's output is being captured
+  if (t_capture && out != &s_nullStream) {
+    t_capture->m_records.emplace_back();
+    t_capture->m_records.back().severity = severity;
+    t_captureStream.clear();
+    t_captureStream.addStream(t_capture->m_records.back().text);
+    out = &t_captureStream;
+  }
 
   // Write the severity prefix before returning
   static const char* const levelLabels[] = {"[D] ", "[I] ", "[W] ", "[E] "};
   assert(severity < sizeof(levelLabels) / sizeof(char*));
 
-  out << levelLabels[severity];
-  return out;
+  *out << levelLabels[severity];
+  return *out;
+}
+
+void SBLog::beginCapture(SBLogCapture& capture)
+{
+  t_capture = &capture;
+}
+
+void SBLog::endCapture()
+{
+  t_capture = NULL;
+  t_captureStream.clear();
+}
+
+void SBLog::replay(const SBLogCapture& capture)
+{
+  for (const auto& record : capture.m_records)
+    s_logger.getStreamForSeverity(record.severity) << record.text.str() << std::flush;
 }
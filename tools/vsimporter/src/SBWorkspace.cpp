@@ -15,6 +15,8 @@
 //******************************************************************************
 
 #include <string.h>
+#include <stdlib.h>
+#include <chrono>
 #include <iostream>
 #include <limits>
 #include <iterator>
@@ -26,6 +28,7 @@
 #include "XCScheme.h"
 #include "XCWorkspace.h"
 #include "PBXProject.h"
+#include "PBXDocument.h"
 #include "BuildSettings.h"
 #include "VariableCollectionManager.h"
 #include "SBWorkspace.h"
@@ -47,6 +50,13 @@ SBWorkspace* SBWorkspace::get()
   return s_workspace;
 }
 
+static unsigned getJobCount()
+{
+  // 0 means one job per hardware thread
+  BuildSettings bs(NULL);
+  return strtoul(bs.getValue("VSIMPORTER_JOBS").c_str(), NULL, 10);
+}
+
 SBWorkspace* SBWorkspace::createFromProject(const String &projectDir)
 {
   sbAssertWithTelemetry(!s_workspace, "Workspace already exists");
@@ -79,12 +89,24 @@ SBWorkspace* SBWorkspace::createFromWorkspace(const String &workspaceDir)
   VariableCollectionManager& settingsManager = VariableCollectionManager::get();
   settingsManager.setGlobalVar("WORKSPACE_FILE_PATH", workspaceDir);
 
-  // Open all projects referenced by the workspace
+  // Parse all projects referenced by the workspace in parallel, then open them in order
+  auto startTime = std::chrono::steady_clock::now();
   const StringVec& projPaths = s_workspace->m_workspace->getProjectPaths();
+  StringVec absProjPaths;
+  for (unsigned i = 0; i < projPaths.size(); i++) {
+    String absProjPath = sb_realpath(projPaths[i]);
+    if (!absProjPath.empty())
+      absProjPaths.push_back(absProjPath);
+  }
+  PBXDocument::prefetchFiles(absProjPaths, getJobCount());
+
   for (unsigned i = 0; i < projPaths.size(); i++) {
     s_workspace->openProject(projPaths[i]);
   }
 
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+  SBLog::info() << "Opened " << s_workspace->m_openProjects.size() << " projects in " << elapsed.count() << " seconds." << std::endl;
+
   s_workspace->findSchemes(workspaceDir);
 
   // A workspace MUST contain at least one scheme
@@ -542,5 +564,5 @@ void SBWorkspace::generateFiles(bool genProjectionsProj)
 
   // Write solution/projects to disk
   sbValidateWithTelemetry(!vcProjects.empty(), "No valid targets to import.");
-  sln->write();
+  sln->write(getJobCount());
 }
\ No newline at end of file
@@ -19,17 +19,19 @@
 
 void SimpleVariableCollection::insert(const String& varName, const String& varValue)
 {
-  m_vars[varName] = varValue;
+  std::pair<StringMap::iterator, bool> res = m_vars.insert(std::make_pair(varName, varValue));
+  if (res.second) {
+    touch();
+  } else if (res.first->second != varValue) {
+    res.first->second = varValue;
+    touch();
+  }
 }
 
 void SimpleVariableCollection::erase(const String& varName)
 {
-  m_vars.erase(varName);
-}
-
-String& SimpleVariableCollection::operator[](const String& varName)
-{
-  return m_vars[varName];
+  if (m_vars.erase(varName))
+    touch();
 }
 
 bool SimpleVariableCollection::getValue(const String& varName, String& ret) const
@@ -69,11 +69,15 @@ bool VariableCollectionHierarchy::getValue(const String& varName, size_t searchL
 void VariableCollectionHierarchy::push_back(const VariableCollection& vc)
 {
   m_vcs.push_back(&vc);
+  std::lock_guard<std::mutex> lock(m_expansionLock);
+  m_expansionCache.clear();
 }
 
 void VariableCollectionHierarchy::pop_back()
 {
   m_vcs.pop_back();
+  std::lock_guard<std::mutex> lock(m_expansionLock);
+  m_expansionCache.clear();
 }
 
 const VariableCollection& VariableCollectionHierarchy::operator[](size_t level) const
@@ -86,6 +90,42 @@ size_t VariableCollectionHierarchy::size() const
   return m_vcs.size();
 }
 
+void VariableCollectionHierarchy::validateExpansionCache() const
+{
+  // A change to any level may change any expansion. Called with m_expansionLock held.
+  bool stale = m_expansionGenerations.size() != m_vcs.size();
+  for (size_t i = 0; i < m_vcs.size() && !stale; i++)
+    stale = m_expansionGenerations[i] != m_vcs[i]->getGeneration();
+
+  if (stale) {
+    m_expansionCache.clear();
+    m_expansionGenerations.resize(m_vcs.size());
+    for (size_t i = 0; i < m_vcs.size(); i++)
+      m_expansionGenerations[i] = m_vcs[i]->getGeneration();
+  }
+}
+
+bool VariableCollectionHierarchy::getCachedExpansion(const String& varName, size_t searchDepth, size_t maxSearchLevel, Expansion& ret) const
+{
+  std::lock_guard<std::mutex> lock(m_expansionLock);
+  validateExpansionCache();
+
+  ExpansionCache::const_iterator it = m_expansionCache.find(ExpansionKey(varName, std::make_pair(searchDepth, maxSearchLevel)));
+  if (it == m_expansionCache.end())
+    return false;
+
+  ret = it->second;
+  return true;
+}
+
+void VariableCollectionHierarchy::cacheExpansion(const String& varName, size_t searchDepth, size_t maxSearchLevel, const Expansion& expansion) const
+{
+  std::lock_guard<std::mutex> lock(m_expansionLock);
+  validateExpansionCache();
+
+  m_expansionCache[ExpansionKey(varName, std::make_pair(searchDepth, maxSearchLevel))] = expansion;
+}
+
 void VariableCollectionHierarchy::getVariableSet(StringSet& ret) const
 {
   for (size_t i = 0; i < m_vcs.size(); i++)
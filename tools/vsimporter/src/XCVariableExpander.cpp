@@ -76,15 +76,12 @@ size_t XCVariableExpander::processBracketedVar(const String& str, size_t posn, S
 
 size_t XCVariableExpander::processSimpleVar(const String& str, size_t posn, String& ret)
 {
-  String varName;
-  varName += str[posn++];
-
+  size_t start = posn++;
   for (; posn < str.length(); posn++) {
-    if (isalnum(str[posn]) || str[posn] == '_')
-      varName += str[posn];
-    else
+    if (!isalnum(str[posn]) && str[posn] != '_')
       break;
   }
+  String varName(str, start, posn - start);
 
   String val;
   if (getExpandedValue(varName, val)) {
@@ -128,12 +125,41 @@ String XCVariableExpander::getInheritedName(const String& varName)
 
 void XCVariableExpander::expandString(const String& str, String& ret)
 {
+  // Copy everything up to the next $ in one go
   for (size_t posn = 0; posn < str.length(); posn++) {
-    if (str[posn] == '$') {
-      posn = processPossibleVar(str, posn, ret);
-    } else {
-      ret += str[posn];
+    size_t dollar = str.find('$', posn);
+    if (dollar == String::npos) {
+      ret.append(str, posn, String::npos);
+      break;
     }
+    ret.append(str, posn, dollar - posn);
+    posn = processPossibleVar(str, dollar, ret);
+  }
+}
+
+bool XCVariableExpander::isBeingExpanded(const StringSet& varNames) const
+{
+  for (size_t i = 0; i < m_frames.size(); i++) {
+    if (varNames.find(m_frames[i].varName) != varNames.end())
+      return true;
+  }
+  return false;
+}
+
+void XCVariableExpander::noteVariableUse(const String& varName)
+{
+  // Find the innermost expansion of this variable, if any
+  size_t i = m_frames.size();
+  while (i > 0 && m_frames[i - 1].varName != varName)
+    i--;
+
+  if (i > 0) {
+    // The expansions nested inside it see where its search stopped, which
+    // depends on how they were reached, so they can't be memoized
+    for (; i < m_frames.size(); i++)
+      m_frames[i].cacheable = false;
+  } else if (!m_frames.empty()) {
+    m_frames.back().freeVars.insert(varName);
   }
 }
 
@@ -147,26 +173,51 @@ bool XCVariableExpander::getExpandedValue(const String& varName, String& ret)
   // Get the hierarchy depth at which to start searching
   size_t& searchDepth = m_varMarkers.insert(make_pair(fixedVarName, m_maxSearchLevel)).first->second;
 
+  noteVariableUse(fixedVarName);
+
+  // Reuse an earlier expansion, unless it depended on a variable that is now being expanded
+  VariableCollectionHierarchy::Expansion cached;
+  if (m_vch.getCachedExpansion(fixedVarName, searchDepth, m_maxSearchLevel, cached) && !isBeingExpanded(cached.freeVars)) {
+    if (!m_frames.empty())
+      m_frames.back().freeVars.insert(cached.freeVars.begin(), cached.freeVars.end());
+    ret += cached.value;
+    return cached.found;
+  }
+
   // Save the current state
   size_t savedDepth = searchDepth;
   String savedVar = m_currentVar;
 
   // Set the current variable being expanded
   m_currentVar = fixedVarName;
+  m_frames.push_back(ExpansionFrame());
+  m_frames.back().varName = fixedVarName;
+  m_frames.back().cacheable = true;
 
   // Find a value for the variable
-  bool found = false;
+  VariableCollectionHierarchy::Expansion expansion;
+  expansion.found = false;
   String val;
-  for(; searchDepth > 0 && !found; searchDepth--) {
-    found = m_vch[searchDepth - 1].getValue(fixedVarName, val);
+  for(; searchDepth > 0 && !expansion.found; searchDepth--) {
+    expansion.found = m_vch[searchDepth - 1].getValue(fixedVarName, val);
   }
 
   // Expand the value
-  expandString(val, ret);
+  expandString(val, expansion.value);
+  ret += expansion.value;
 
   // Restore the original state
   searchDepth = savedDepth;
   m_currentVar = savedVar;
 
-  return found;
+  bool cacheable = m_frames.back().cacheable;
+  expansion.freeVars.swap(m_frames.back().freeVars);
+  m_frames.pop_back();
+  if (!m_frames.empty())
+    m_frames.back().freeVars.insert(expansion.freeVars.begin(), expansion.freeVars.end());
+
+  if (cacheable)
+    m_vch.cacheExpansion(fixedVarName, savedDepth, m_maxSearchLevel, expansion);
+
+  return expansion.found;
 }
\ No newline at end of file
@@ -44,9 +44,6 @@ void writeHMap(const String& outputFile, const StringVec& inVec)
 {
   IncludeMapMaker hmap;
 
-  std::ofstream outFile(outputFile.c_str(), std::ofstream::out | std::ofstream::binary);
-  sbValidate(outFile.is_open(), "Failed to open \"" + outputFile + "\" output file for writing.");
-
   StringVec::const_iterator it = inVec.begin();
   for (; it != inVec.end(); ++it) {
     // Tokenize line using tabs
@@ -64,8 +61,12 @@ void writeHMap(const String& outputFile, const StringVec& inVec)
     }
   }
 
-  hmap.writeMap(outFile);
-  outFile.close();
+  // When headers have only been added, extend the existing map rather than
+  // starting over, so that what it already holds stays where it is. An
+  // unchanged map is not rewritten, so dependent builds stay up to date.
+  IncludeMapMaker existing;
+  IncludeMapMaker& result = existing.readMap(outputFile) && existing.update(hmap) ? existing : hmap;
+  sbValidate(result.writeMap(outputFile), "Failed to open \"" + outputFile + "\" output file for writing.");
 }
 
 int main(int argc, const char* argv[])
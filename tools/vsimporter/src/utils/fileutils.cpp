@@ -19,6 +19,7 @@
 #include <string.h>
 #include <errno.h>
 #include <algorithm>
+#include <iterator>
 #include <unistd.h>
 #if defined(_MSC_VER)
 #include <direct.h> // getcwd
@@ -391,3 +392,28 @@ void openOutputFileStream(OFStream& ofs, const String& outFilePath, OFStream::op
     return;
   }
 }
+
+bool writeFileIfChanged(const String& outFilePath, const String& contents, OFStream::openmode mode, bool* changed)
+{
+  if (changed)
+    *changed = false;
+
+  // Read the file back the same way it would be written, so that line endings compare equal
+  std::ifstream ifs(outFilePath.c_str(), std::ifstream::in | (mode & std::ifstream::binary));
+  if (ifs.is_open()) {
+    String existing((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    if (existing == contents)
+      return true;
+    ifs.close();
+  }
+
+  OFStream ofs;
+  openOutputFileStream(ofs, outFilePath, mode);
+  if (!ofs.is_open())
+    return false;
+
+  ofs << contents;
+  if (changed)
+    *changed = true;
+  return ofs.good();
+}
@@ -18,236 +18,345 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <ctype.h>
+#include <iterator>
 
 #include "hmapmaker.h"
 
-#if !defined(_MSC_VER)
-void strlwr(char *str)
+uint32_t IncludeMapMaker::hashString(const char *str, size_t len)
 {
-  for (int i = 0; str[i]; i++) {
-      str[i] = tolower(str[i]);
+  //  FNV-1a; only used for interning, never written out
+  uint32_t hash = 2166136261u;
+  for ( size_t i = 0; i < len; i ++ ) {
+    hash = (hash ^ (unsigned char) str[i]) * 16777619u;
   }
+  return hash;
 }
-#endif
 
-void IncludeMapMaker::buildStrings()
+void IncludeMapMaker::growStringSlots()
 {
-  if ( strings ) free(strings);
-  if ( stringsBlock ) free(stringsBlock);
-
-  strings = (char **) malloc((mapCount * 3 + 16) * sizeof(char *));
-  numStrings = 0;
+  std::vector<uint32_t> oldSlots;
+  oldSlots.swap(stringSlots);
+  stringSlots.assign(oldSlots.empty() ? 1024 : oldSlots.size() * 2, 0);
+
+  uint32_t mask = stringSlots.size() - 1;
+  for ( size_t i = 0; i < oldSlots.size(); i ++ ) {
+    if ( !oldSlots[i] ) continue;
+    const char *str = &stringsBlock[oldSlots[i]];
+    uint32_t idx = hashString(str, strlen(str)) & mask;
+    while ( stringSlots[idx] ) idx = (idx + 1) & mask;
+    stringSlots[idx] = oldSlots[i];
+  }
+}
 
-  //  Empty string first
-  strings[numStrings ++] = "";
+int64_t IncludeMapMaker::findString(const char *str, size_t len) const
+{
+  if ( len == 0 ) return 0;
+  if ( stringSlots.empty() ) return -1;
 
-  //  Grab all strings
-  int i;
-  for ( i = 0; i < mapCount; i ++ ) {
-    if ( headerMaps[i].from ) strings[numStrings ++] = headerMaps[i].from;
-    if ( headerMaps[i].toDirectory ) strings[numStrings ++] = headerMaps[i].toDirectory;
-    if ( headerMaps[i].toFilename ) strings[numStrings ++] = headerMaps[i].toFilename;
+  uint32_t mask = stringSlots.size() - 1;
+  for ( uint32_t idx = hashString(str, len) & mask; stringSlots[idx]; idx = (idx + 1) & mask ) {
+    const char *existing = &stringsBlock[stringSlots[idx]];
+    if ( strncmp(existing, str, len) == 0 && existing[len] == 0 ) return stringSlots[idx];
   }
 
-  //  Sort them
-  qsort(strings, numStrings, sizeof(char *), (int (*)(const void *, const void *)) compareStringPtrs);
+  return -1;
+}
 
-  //  Remove duplicate strings
-  int count = numStrings;
-  numStrings = 0;
-  char *lastString = NULL;
+uint32_t IncludeMapMaker::internString(const char *str, size_t len)
+{
+  if ( len == 0 ) return 0;
 
-  for ( i = 0; i < count; i ++ ) {
-    if ( lastString && strcmp(lastString, strings[i]) == 0 ) {
-      continue;
-    }
-    strings[numStrings ++] = strings[i];
-    lastString = strings[i];
-  }
+  //  Keep the intern table at most half full
+  if ( (size_t) numStrings * 2 >= stringSlots.size() ) growStringSlots();
 
-  //  Build string block and remap strings array to point to it
-  stringsBlock = NULL;
-  stringsBlockLen = 0;
+  uint32_t mask = stringSlots.size() - 1;
+  uint32_t idx = hashString(str, len) & mask;
+  for ( ; stringSlots[idx]; idx = (idx + 1) & mask ) {
+    const char *existing = &stringsBlock[stringSlots[idx]];
+    if ( strncmp(existing, str, len) == 0 && existing[len] == 0 ) return stringSlots[idx];
+  }
 
-  int totalSize = 0;
+  uint32_t offset = stringsBlock.size();
+  stringsBlock.insert(stringsBlock.end(), str, str + len);
+  stringsBlock.push_back(0);
+  stringSlots[idx] = offset;
+  numStrings ++;
+  if ( (int) len > maxStringLen ) maxStringLen = len;
 
-  for ( i = 0; i < numStrings; i ++ ) {
-    totalSize += strlen(strings[i]) + 1;
+  return offset;
+}
+ 
+void IncludeMapMaker::buildHash()
+{
+  uint32_t numBuckets = nextPow2(headerMaps.size() * HMAP_MaxLoadDenominator / HMAP_MaxLoadNumerator + 1);
+  uint32_t mask = numBuckets - 1;
+  buckets.assign(numBuckets, HMapBucket());
+
+  //  The format's hash only spans a narrow range, so large projects end up with
+  //  a few very long clusters. Rather than walking a cluster on every insert,
+  //  follow (and compress) links to the next possibly free bucket; this lands
+  //  on the same bucket plain linear probing would.
+  std::vector<uint32_t> nextFree(numBuckets);
+  for ( uint32_t i = 0; i < numBuckets; i ++ ) nextFree[i] = i;
+
+  for ( size_t i = 0; i < headerMaps.size(); i ++ ) {
+    HMapBucket newItem;
+    newItem.Key = headerMaps[i].fromOffset;
+    newItem.Prefix = headerMaps[i].prefixOffset;
+    newItem.Suffix = headerMaps[i].suffixOffset;
+
+    uint32_t curIdx = HashHMapKey(&stringsBlock[newItem.Key]) & mask;
+
+    //  Find an empty spot
+    while ( nextFree[curIdx] != curIdx ) {
+      nextFree[curIdx] = nextFree[nextFree[curIdx]];
+      curIdx = nextFree[curIdx];
+    }
+    buckets[curIdx] = newItem;
+    nextFree[curIdx] = (curIdx + 1) & mask;
   }
 
-  stringsBlock = (char *) malloc(totalSize);
+  bucketsValid = true;
+}
+
+IncludeMapMaker::IncludeMapMaker()
+{
+  numStrings = 0;
   maxStringLen = 0;
+  bucketsValid = false;
 
-  for ( i = 0; i < numStrings; i ++ ) {
-    int strLen = strlen(strings[i]);
+  //  Empty string first
+  stringsBlock.push_back(0);
+  numStrings ++;
+}
+ 
+IncludeMapMaker::~IncludeMapMaker()
+{
+}
 
-    strcpy(&stringsBlock[stringsBlockLen], strings[i]);
-    strings[i] = &stringsBlock[stringsBlockLen];
-    stringsBlockLen += strLen + 1;
-    if ( strLen > maxStringLen ) maxStringLen = strLen;
+void IncludeMapMaker::addMapping(const char *from, size_t fromLen, const char *to, size_t toLen)
+{
+  std::string lowerFrom(from, fromLen);
+  for ( size_t i = 0; i < fromLen; i ++ ) {
+    lowerFrom[i] = tolower(lowerFrom[i]);
   }
 
-  //  Calculate string offsets for header maps
-  for ( i = 0; i < mapCount; i ++ ) {
-    char **stringPos = (char **) bsearch(&headerMaps[i].from, strings, numStrings, sizeof(char *), (int (*)(const void *, const void *)) compareStringPtrs);
-    assert(stringPos != NULL);
+  MapEntry entry;
+  entry.fromOffset = internString(lowerFrom.data(), fromLen);
+  if ( entry.fromOffset == HMAP_EmptyBucketKey ) return;
 
-    headerMaps[i].fromOffset = *stringPos - stringsBlock;
+  //  Clang would only ever find the first mapping for a name
+  if ( headerMapIndex.find(entry.fromOffset) != headerMapIndex.end() ) return;
 
-    if ( headerMaps[i].toDirectory ) {
-      char **stringPos = (char **) bsearch(&headerMaps[i].toDirectory, strings, numStrings, sizeof(char *), (int (*)(const void *, const void *)) compareStringPtrs);
-      assert(stringPos != NULL);
-
-      headerMaps[i].prefixOffset = *stringPos - stringsBlock;
-    } else {
-      headerMaps[i].prefixOffset = 0;
-    }
-    
-    if ( headerMaps[i].toFilename ) {
-      char **stringPos = (char **) bsearch(&headerMaps[i].toFilename, strings, numStrings, sizeof(char *), (int (*)(const void *, const void *)) compareStringPtrs);
-      assert(stringPos != NULL);
-
-      headerMaps[i].suffixOffset = *stringPos - stringsBlock;
-    } else {
-      headerMaps[i].suffixOffset = 0;
+  const char *lastSlash = NULL;
+  for ( size_t i = toLen; i > 0; i -- ) {
+    if ( to[i - 1] == '/' ) {
+      lastSlash = &to[i - 1];
+      break;
     }
   }
+  if ( lastSlash ) {
+    lastSlash++;
+    entry.prefixOffset = internString(to, lastSlash - to);
+    entry.suffixOffset = internString(lastSlash, to + toLen - lastSlash);
+  } else {
+    entry.prefixOffset = 0;
+    entry.suffixOffset = internString(to, toLen);
+  }
+
+  headerMapIndex[entry.fromOffset] = headerMaps.size();
+  headerMaps.push_back(entry);
+  bucketsValid = false;
 }
  
-void IncludeMapMaker::buildHash()
+void IncludeMapMaker::addMapping(const std::string &fromStr, const std::string &toStr)
 {
-  if ( buckets ) free(buckets);
-  numBuckets = nextPow2(mapCount + 1);
-  buckets = (HMapBucket *) calloc(numBuckets, sizeof(HMapBucket));
-  numAdded = 0;
-
-  int i;
-  for ( i = 0; i < mapCount; i ++ ) {
-    createHashMapping(&headerMaps[i]);
-  }
+  addMapping(fromStr.c_str(), fromStr.size(), toStr.c_str(), toStr.size());
 }
- 
-void IncludeMapMaker::createHashMapping(MapEntry *entry)
+
+bool IncludeMapMaker::lookup(const std::string &fromStr, std::string &toStr)
 {
-  HMapBucket newItem;
-  newItem.Key = entry->fromOffset;
-  newItem.Prefix = entry->prefixOffset;
-  newItem.Suffix = entry->suffixOffset;
-
-  char *fromName = stringsBlock + newItem.Key;
-  uint32_t hashKey = HashHMapKey(fromName);
-  int curIdx = hashKey & (numBuckets - 1);
-
-  //  Find an empty spot
-  for ( ;; ) {
-    if ( buckets[curIdx].Key == HMAP_EmptyBucketKey ) {
-      buckets[curIdx] = newItem;
-      break;
-    }
+  if ( headerMaps.empty() ) return false;
+  if ( !bucketsValid ) buildHash();
+
+  std::string from(fromStr);
+  for ( size_t i = 0; i < from.size(); i ++ ) {
+    from[i] = tolower(from[i]);
+  }
 
-    curIdx = (curIdx + 1) & (numBuckets - 1);
+  uint32_t mask = buckets.size() - 1;
+  for ( uint32_t curIdx = HashHMapKey(from.c_str()) & mask; buckets[curIdx].Key != HMAP_EmptyBucketKey; curIdx = (curIdx + 1) & mask ) {
+    if ( from == &stringsBlock[buckets[curIdx].Key] ) {
+      toStr = &stringsBlock[buckets[curIdx].Prefix];
+      toStr += &stringsBlock[buckets[curIdx].Suffix];
+      return true;
+    }
   }
 
-  numAdded ++;
+  return false;
 }
 
-IncludeMapMaker::IncludeMapMaker()
+bool IncludeMapMaker::readMap(const std::string &fileName)
 {
-  headerMaps = NULL;
-  mapCount = 0;
-  mapCountMax = 0;
+  std::ifstream ifs(fileName.c_str(), std::ifstream::in | std::ifstream::binary);
+  if ( !ifs.is_open() ) return false;
 
-  strings = NULL;
-  stringsBlock = NULL;
+  std::string data((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
 
-  buckets = NULL;
-}
- 
-IncludeMapMaker::~IncludeMapMaker()
-{
-  int i;
+  HMapHeader header;
+  if ( data.size() < sizeof(HMapHeader) ) return false;
+  memcpy(&header, data.data(), sizeof(HMapHeader));
+
+  if ( header.Magic != HMAP_HeaderMagicNumber || header.Version != HMAP_HeaderVersion ) return false;
+  if ( header.NumBuckets == 0 || (header.NumBuckets & (header.NumBuckets - 1)) != 0 ) return false;
+
+  //  The buckets lie between the header and the strings, which end the file
+  if ( header.StringsOffset < sizeof(HMapHeader) || header.StringsOffset > data.size() ) return false;
+  if ( sizeof(HMapHeader) + (uint64_t) header.NumBuckets * sizeof(HMapBucket) > header.StringsOffset ) return false;
+
+  //  Ensure every string offset in the file ends at a NUL inside the file
+  const char *strs = data.data() + header.StringsOffset;
+  size_t strsLen = data.size() - header.StringsOffset;
+  if ( strsLen == 0 || strs[0] != 0 || strs[strsLen - 1] != 0 ) return false;
+
+  std::vector<HMapBucket> fileBuckets(header.NumBuckets);
+  memcpy(fileBuckets.data(), data.data() + sizeof(HMapHeader), header.NumBuckets * sizeof(HMapBucket));
+  for ( size_t i = 0; i < fileBuckets.size(); i ++ ) {
+    const HMapBucket &bucket = fileBuckets[i];
+    if ( bucket.Key >= strsLen || bucket.Prefix >= strsLen || bucket.Suffix >= strsLen ) return false;
+  }
+
+  //  Find an empty bucket to start from, so that no cluster wraps around the start
+  uint32_t mask = header.NumBuckets - 1;
+  uint32_t start = 0;
+  while ( start < header.NumBuckets && fileBuckets[start].Key != HMAP_EmptyBucketKey ) start ++;
+  if ( start == header.NumBuckets ) return false;
+
+  //  Take the string table over as is, so that the offsets in the buckets stay valid
+  stringsBlock.assign(strs, strs + strsLen);
+  stringSlots.clear();
+  numStrings = 1;
+  maxStringLen = 0;
+  headerMaps.clear();
+  headerMapIndex.clear();
+  for ( size_t offset = 1; offset < strsLen; ) {
+    size_t len = strlen(&stringsBlock[offset]);
+    if ( (size_t) numStrings * 2 >= stringSlots.size() ) growStringSlots();
+
+    uint32_t idx = hashString(&stringsBlock[offset], len) & (stringSlots.size() - 1);
+    while ( stringSlots[idx] && strcmp(&stringsBlock[stringSlots[idx]], &stringsBlock[offset]) != 0 ) {
+      idx = (idx + 1) & (stringSlots.size() - 1);
+    }
+    if ( !stringSlots[idx] ) {
+      stringSlots[idx] = offset;
+      numStrings ++;
+      if ( (int) len > maxStringLen ) maxStringLen = len;
+    }
+    offset += len + 1;
+  }
 
-  for ( i = 0; i < mapCount; i ++ ) {
-    if ( headerMaps[i].from ) free(headerMaps[i].from);
-    if ( headerMaps[i].toDirectory ) free(headerMaps[i].toDirectory);
-    if ( headerMaps[i].toFilename ) free(headerMaps[i].toFilename);
+  //  Taking each cluster in bucket order puts every entry back where it was, so writing
+  //  the map out again reproduces the file
+  for ( uint32_t n = 1; n <= header.NumBuckets; n ++ ) {
+    const HMapBucket &bucket = fileBuckets[(start + n) & mask];
+    if ( bucket.Key == HMAP_EmptyBucketKey ) continue;
+    if ( headerMapIndex.find(bucket.Key) != headerMapIndex.end() ) continue;
+
+    MapEntry entry;
+    entry.fromOffset = bucket.Key;
+    entry.prefixOffset = bucket.Prefix;
+    entry.suffixOffset = bucket.Suffix;
+    headerMapIndex[entry.fromOffset] = headerMaps.size();
+    headerMaps.push_back(entry);
   }
-  
-  if ( headerMaps ) free(headerMaps);
-  if ( strings ) free(strings);
-  if ( stringsBlock ) free(stringsBlock);
 
-  if ( buckets ) free(buckets);
+  bucketsValid = false;
+  return true;
 }
- 
-void IncludeMapMaker::addMapping(const std::string &fromStr, const std::string &toStr)
+
+bool IncludeMapMaker::update(const IncludeMapMaker &other)
 {
-  const char *from = fromStr.c_str();
-  const char *to = toStr.c_str();
-  
-  if ( mapCount + 1 >= mapCountMax ) {
-    mapCountMax += 4096;
-    headerMaps = (MapEntry *) realloc(headerMaps, mapCountMax * sizeof(MapEntry));
-  }
-
-  MapEntry *out = (MapEntry *) &headerMaps[mapCount];
-  mapCount ++;
-  memset(out, 0, sizeof(MapEntry));
-  out->from = (char *) malloc(strlen(from) + 1);
-  strcpy(out->from, from);
-  strlwr(out->from);
-
-  const char *lastSlash = strrchr(to, '/');
-  if ( lastSlash ) {
-    lastSlash++;
-    out->toDirectory = (char *) malloc(lastSlash - to + 1);
-    strncpy(out->toDirectory, to, lastSlash - to);
-    out->toDirectory[lastSlash - to] = 0;
+  //  Entries can't be taken back out of the table, so all of ours have to be wanted still
+  std::string to, otherTo;
+  for ( size_t i = 0; i < headerMaps.size(); i ++ ) {
+    const MapEntry &entry = headerMaps[i];
+    const char *from = &stringsBlock[entry.fromOffset];
+    int64_t otherFrom = other.findString(from, strlen(from));
+    if ( otherFrom < 0 ) return false;
+
+    auto otherIt = other.headerMapIndex.find((uint32_t) otherFrom);
+    if ( otherIt == other.headerMapIndex.end() ) return false;
+
+    const MapEntry &otherEntry = other.headerMaps[otherIt->second];
+    to = &stringsBlock[entry.prefixOffset];
+    to += &stringsBlock[entry.suffixOffset];
+    otherTo = &other.stringsBlock[otherEntry.prefixOffset];
+    otherTo += &other.stringsBlock[otherEntry.suffixOffset];
+    if ( to != otherTo ) return false;
+  }
 
-    out->toFilename = (char *) malloc(strlen(lastSlash) + 1);
-    strcpy(out->toFilename, lastSlash);
-  } else {
-    out->toDirectory = NULL;
-    out->toFilename = (char *) malloc(strlen(to) + 1);
-    strcpy(out->toFilename, to);
+  for ( size_t i = 0; i < other.headerMaps.size(); i ++ ) {
+    const MapEntry &entry = other.headerMaps[i];
+    const char *from = &other.stringsBlock[entry.fromOffset];
+    to = &other.stringsBlock[entry.prefixOffset];
+    to += &other.stringsBlock[entry.suffixOffset];
+    addMapping(from, strlen(from), to.c_str(), to.size());
   }
+
+  return true;
 }
- 
-void IncludeMapMaker::writeMap(std::ofstream& outFile)
-{
-  //  Build the string table
-  buildStrings();
 
+void IncludeMapMaker::serialize(std::string &out)
+{
   //  Build the hash table
-  buildHash();
+  if ( !bucketsValid ) buildHash();
 
   //  Setup header
   HMapHeader header;
   header.Magic = HMAP_HeaderMagicNumber;
   header.Version = HMAP_HeaderVersion;
   header.Reserved = 0;
-  header.StringsOffset = sizeof(HMapHeader) + numBuckets * sizeof(HMapBucket);
+  header.StringsOffset = sizeof(HMapHeader) + buckets.size() * sizeof(HMapBucket);
   header.NumEntries = numStrings;
-  header.NumBuckets = numBuckets;
+  header.NumBuckets = buckets.size();
   header.MaxValueLength = maxStringLen;
 
-  //  Write header
-  outFile.write((char*)&header, sizeof(HMapHeader));
-
-  //  Write buckets
-  outFile.write((char*)buckets, sizeof(HMapBucket) * numBuckets);
+  out.clear();
+  out.reserve(header.StringsOffset + stringsBlock.size());
 
-  //  Write string table
-  outFile.write((char*)stringsBlock, stringsBlockLen);
+  //  Header, buckets, then the string table
+  out.append((const char*)&header, sizeof(HMapHeader));
+  out.append((const char*)buckets.data(), sizeof(HMapBucket) * buckets.size());
+  out.append(stringsBlock.data(), stringsBlock.size());
+}
+ 
+void IncludeMapMaker::writeMap(std::ofstream& outFile)
+{
+  std::string out;
+  serialize(out);
+  outFile.write(out.data(), out.size());
 }
 
 bool IncludeMapMaker::writeMap(const std::string &fileName)
 {
+  std::string out;
+  serialize(out);
+
+  //  Leave an up to date map untouched
+  std::ifstream ifs(fileName.c_str(), std::ifstream::in | std::ifstream::binary);
+  if (ifs.is_open()) {
+    std::string existing((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    ifs.close();
+    if (existing == out) {
+      return true;
+    }
+  }
+
   std::ofstream ofs;
   ofs.open(fileName.c_str(), std::ofstream::out|std::ofstream::binary);
 
   if (ofs.is_open()) {
-    writeMap(ofs);
+    ofs.write(out.data(), out.size());
     return true;
   } else {
     return false;
@@ -18,6 +18,8 @@
 #include <time.h>
 #include <Windows.h>
 #include <string>
+#include <atomic>
+#include <thread>
 
 String getTime()
 {
@@ -159,3 +161,26 @@ std::string getMachineID() {
     }
     return std::string("");
 }
+
+void parallelFor(size_t count, unsigned maxThreads, const std::function<void(size_t)>& func)
+{
+  unsigned threadCount = maxThreads ? maxThreads : std::thread::hardware_concurrency();
+  if (threadCount == 0)
+    threadCount = 1;
+  if (threadCount > count)
+    threadCount = (unsigned)count;
+
+  // Each thread, including this one, claims the next unclaimed index until there are none left
+  std::atomic<size_t> next(0);
+  auto worker = [&]() {
+    for (size_t i = next++; i < count; i = next++)
+      func(i);
+  };
+
+  std::vector<std::thread> threads;
+  for (unsigned i = 1; i < threadCount; i++)
+    threads.emplace_back(worker);
+  worker();
+  for (auto& thread : threads)
+    thread.join();
+}
@@ -75,6 +75,7 @@ void printUsage(const char *execName, bool full)
     std::cout << "    -help" << "\t\t    print full usage message" << std::endl;
     std::cout << "    -genprojections" << "\t    generate WinRT projections project" << std::endl;
     std::cout << "    -interactive" << "\t    enable interactive mode" << std::endl;
+    std::cout << "    -jobs N" << "\t\t    parse and write projects on N threads (by default one per hardware thread)" << std::endl;
     std::cout << "    -loglevel LEVEL" << "\t    debug | info | warning | error" << std::endl;
     std::cout << "    -list" << "\t\t    list the targets and configurations in the project" << std::endl;
     std::cout << "    -sdk SDKROOT" << "\t    specify path to WinObjC SDK root (by default calculated from binary's location)" << std::endl;
@@ -96,6 +97,7 @@ int main(int argc, char* argv[])
   StringSet targets, configurations, schemes;
   String sdkRoot, projectPath, xcconfigPath, workspacePath;
   String logVerbosity("warning");
+  String jobs("0");
   int projectSet = 0;
   int workspaceSet = 0;
   int interactiveFlag = 0;
@@ -123,6 +125,7 @@ int main(int argc, char* argv[])
     {"allschemes", required_argument, &allSchemes, 1},
     {"relativepath", no_argument, &relativeSdkFlag, 1},
     { "genprojections", no_argument, &genProjectionsFlag, 1 },
+    {"jobs", required_argument, 0, 0},
     {0, 0, 0, 0}
   };
 
@@ -176,6 +179,9 @@ int main(int argc, char* argv[])
     case 13:
       schemes.insert(optarg);
       break;
+    case 17:
+      jobs = optarg;
+      break;
     default:
       // Do nothing
       break;
@@ -285,6 +291,7 @@ int main(int argc, char* argv[])
   settingsManager.setGlobalVar("VSIMPORTER_BINARY_DIR", binaryDir);
   settingsManager.setGlobalVar("VSIMPORTER_INTERACTIVE", interactiveFlag ? "YES" : "NO");
   settingsManager.setGlobalVar("VSIMPORTER_RELATIVE_SDK_PATH", relativeSdkFlag ? "YES" : "NO");
+  settingsManager.setGlobalVar("VSIMPORTER_JOBS", jobs);
   if (!sdkRoot.empty()) {
     sdkRoot = joinPaths(getcwd(), sdkRoot);
   } else {
@@ -19,7 +19,6 @@
 #include "VCProjectItem.h"
 #include "VSTemplateProject.h"
 #include "vshelpers.h"
-#include "sole/sole.hpp"
 #include "pugixml.hpp"
 #include "utils.h"
 #include "sbassert.h"
@@ -27,6 +26,8 @@
 #include "..\WBITelemetry\WBITelemetry.h"
 
 #include <fstream>
+#include <sstream>
+#include <stdexcept>
 
 typedef std::set<std::string> StringSet;
 
@@ -43,7 +44,7 @@ VCProject::VCProject(VSTemplateProject* projTemplate, const std::string& id)
   if (!id.empty())
     m_id = id;
   else
-    m_id = sole::uuid4().str();
+    m_id = makeStableUUID(projTemplate->getPath());
 
   string guid = formatVSGUID(m_id);
   if (m_subType == VCShared)
@@ -206,10 +207,12 @@ void VCProject::setUrlSchemes(const StringSet& schemes)
 
 bool VCProject::write() const
 {
-  // Write the template
-  m_template->write(m_urlSchemes);
+  // Write the template, keeping back the project and filters files to be filled in below
+  StringSet holdBack = { getPath(), getPath() + ".filters" };
+  StringMap templateFiles;
+  m_template->write(m_urlSchemes, holdBack, templateFiles);
 
-  return writeProject() && writeFilters();
+  return writeProject(templateFiles) && writeFilters(templateFiles);
 }
   
 void VCProject::writeProjectConfigSummary(pugi::xml_node& node) const
@@ -326,12 +329,17 @@ void VCProject::writeProjectReferences(pugi::xml_node& node) const
 }
 
 #define callMemberFunction(objectPtr, ptrToMember) ((objectPtr)->*(ptrToMember))
-bool VCProject::writeTemplate(const std::string& filePath, const LabelHandlerFnMap& handlers) const
+bool VCProject::writeTemplate(const std::string& filePath, const StringMap& templateFiles, const LabelHandlerFnMap& handlers) const
 {
   // Open the template
   pugi::xml_document projDoc;
-  pugi::xml_parse_result result = projDoc.load_file(filePath.c_str());
-  sbValidateWithTelemetry(result, "Failed to open template file: " + filePath);
+  auto templateIt = templateFiles.find(filePath);
+  pugi::xml_parse_result result;
+  if (templateIt != templateFiles.end())
+    result = projDoc.load_buffer(templateIt->second.data(), templateIt->second.size());
+  // Projects are written on worker threads, so leave it to the caller to stop the import
+  if (!result)
+    throw std::runtime_error("Failed to open template file: " + filePath);
   pugi::xml_node projRoot = projDoc.first_child();
 
   for (pugi::xml_node child = projRoot.first_child(); child; child = child.next_sibling()) {
@@ -355,11 +363,13 @@ bool VCProject::writeTemplate(const std::string& filePath, const LabelHandlerFnM
     }
   }
 
-  // Output tree
-  return projDoc.save_file(filePath.c_str(), "  ");
+  // Output tree, unless an earlier import already wrote the same thing
+  std::ostringstream out;
+  projDoc.save(out, "  ");
+  return writeFileIfChanged(filePath, out.str(), std::ios::binary);
 }
 
-bool VCProject::writeProject() const
+bool VCProject::writeProject(const StringMap& templateFiles) const
 {
   LabelHandlerFnMap nodeHandlers;
   nodeHandlers["ProjectConfigSummary"] = &VCProject::writeProjectConfigSummary;
@@ -374,7 +384,7 @@ bool VCProject::writeProject() const
   nodeHandlers["ProjectItems"] = &VCProject::writeProjectItems;
   nodeHandlers["ProjectReferences"] = &VCProject::writeProjectReferences;
 
-  return writeTemplate(getPath(), nodeHandlers);
+  return writeTemplate(getPath(), templateFiles, nodeHandlers);
 }
 
 static void recordFilterPath(const std::string& filterPath, StringSet& filterSet)
@@ -409,8 +419,8 @@ void VCProject::writeFilterDescriptions(pugi::xml_node& node) const
 
   pugi::xml_node tempNode = node.parent().append_child("Temp");
   for (auto filter : filters) {
-    // Generate a unique id
-    std::string id = sole::uuid4().str();
+    // Generate a unique id that stays the same from one import to the next
+    std::string id = makeStableUUID(getPath() + "|" + filter);
 
     // Fix up the filter path to be Windows-style
     std::string winFilterPath = winPath(filter);
@@ -423,7 +433,7 @@ void VCProject::writeFilterDescriptions(pugi::xml_node& node) const
   mergeNodes(node, tempNode);
 }
 
-bool VCProject::writeFilters() const
+bool VCProject::writeFilters(const StringMap& templateFiles) const
 {
   std::string filtersFilePath = getPath() + ".filters";
   LabelHandlerFnMap nodeHandlers;
@@ -431,8 +441,8 @@ bool VCProject::writeFilters() const
   nodeHandlers["FilterDescriptions"] = &VCProject::writeFilterDescriptions;
 
   // In cases where the VS template doesn't contain a filters file, write nothing
-  if (fileExists(filtersFilePath)) {
-    return writeTemplate(filtersFilePath, nodeHandlers);
+  if (templateFiles.find(filtersFilePath) != templateFiles.end()) {
+    return writeTemplate(filtersFilePath, templateFiles, nodeHandlers);
   } else {
     return true;
   }
@@ -16,7 +16,6 @@
 
 #include "VCSharedProject.h"
 #include "VCProjectItem.h"
-#include "sole/sole.hpp"
 #include "sbassert.h"
 #include "SBLog.h"
 #include "fileutils.h"
@@ -27,7 +26,7 @@ VCSharedProject::~VCSharedProject() {}
 VCSharedProject::VCSharedProject(VSTemplateProject* projTemplate)
 : VCProject(projTemplate)
 {
-  m_sharedId = sole::uuid4().str();
+  m_sharedId = makeStableUUID(getPath() + "|SharedGUID");
 
   m_globalProps.clear();
   addGlobalProperty("ItemsProjectGuid", formatVSGUID(m_id));
@@ -59,11 +58,11 @@ VCProjectItem* VCSharedProject::addItem(const std::string& itemName, const std::
   return VCProject::addItem(itemName, fixedIncludePath, filterPath);
 }
 
-bool VCSharedProject::writeProject() const
+bool VCSharedProject::writeProject(const StringMap& templateFiles) const
 {
   LabelHandlerFnMap nodeHandlers;
   nodeHandlers["GlobalProperties"] = &VCSharedProject::writeGlobalProperties;
   nodeHandlers["ProjectItems"] = &VCSharedProject::writeProjectItems;
 
-  return writeTemplate(getPath(), nodeHandlers);
+  return writeTemplate(getPath(), templateFiles, nodeHandlers);
 }
\ No newline at end of file
@@ -14,10 +14,16 @@
 //
 //******************************************************************************
 
+#include <chrono>
 #include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
 
 #include "sbassert.h"
 #include "utils.h"
+#include "SBLog.h"
 #include "VSSolution.h"
 #include "VCProject.h"
 #include "VSBuildableSolutionProject.h"
@@ -112,7 +118,7 @@ VSSolutionFolderProject* VSSolution::addFolder(const std::string& name, VSSoluti
     return dynamic_cast<VSSolutionFolderProject*>(otherProject);
 
   // Create the project
-  VSSolutionFolderProject* folder = new VSSolutionFolderProject(name, *this);
+  VSSolutionFolderProject* folder = new VSSolutionFolderProject(name, parent, *this);
   m_nestingMap.insert(std::make_pair(parent, folder));
   return folder;
 }
@@ -128,14 +134,55 @@ void VSSolution::addPlatform(const std::string& name)
     m_platforms.insert(name);
 }
 
-bool VSSolution::write() const
+bool VSSolution::write(unsigned jobs) const
 {
-  // Open solution file for writing
-  std::ofstream ofs;
-  openOutputFileStream(ofs, m_absFilePath);
-  write(ofs);
+  // Write project files
+  bool projectsWritten = writeProjects(jobs);
+
+  // Write the solution, unless an earlier import already wrote the same thing
+  std::ostringstream out;
+  write(out);
+  bool solutionWritten = writeFileIfChanged(m_absFilePath, out.str());
+  std::cout << "Generated " << m_absFilePath << std::endl;
+
+  return projectsWritten && solutionWritten;
+}
+
+bool VSSolution::writeProjects(unsigned jobs) const
+{
+  std::vector<const VCProject*> projects;
+  for (auto project : m_buildableProjects) {
+    projects.push_back(project.second->getProject());
+  }
 
-  return ofs.is_open();
+  // Projects are complete by now, so each one can be written out independently. What the
+  // workers log is reported here in project order, and a fatal error only stops the import
+  // once all of them are done writing.
+  auto startTime = std::chrono::steady_clock::now();
+  std::vector<char> written(projects.size());
+  std::vector<SBLogCapture> logs(projects.size());
+  std::vector<String> failures(projects.size());
+  parallelFor(projects.size(), jobs, [&](size_t i) {
+    SBLog::beginCapture(logs[i]);
+    try {
+      written[i] = projects[i]->write();
+    } catch (const std::exception& e) {
+      failures[i] = e.what();
+    }
+    SBLog::endCapture();
+  });
+
+  bool ret = true;
+  for (size_t i = 0; i < projects.size(); i++) {
+    SBLog::replay(logs[i]);
+    sbValidateWithTelemetry(failures[i].empty(), failures[i]);
+    std::cout << "Generated " << projects[i]->getPath() << std::endl;
+    ret = ret && written[i];
+  }
+
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+  SBLog::info() << "Wrote " << projects.size() << " projects in " << elapsed.count() << " seconds." << std::endl;
+  return ret;
 }
 
 void VSSolution::writeProjectDescriptions(std::ostream& out) const
@@ -253,12 +300,4 @@ void VSSolution::write(std::ostream& out) const
   writeSolutionProperties(out);
   writeNestedProjects(out);
   out << "EndGlobal" << std::endl;
-
-  // Write project files
-  for (auto project : m_buildableProjects) {
-    project.second->getProject()->write();
-    std::cout << "Generated " << project.second->getProject()->getPath() << std::endl;
-  }
-
-  std::cout << "Generated " << m_absFilePath << std::endl;
 }
\ No newline at end of file
@@ -17,14 +17,14 @@
 #include "VSSolutionFolderProject.h"
 #include "VSSolution.h"
 #include "vshelpers.h"
-#include "sole/sole.hpp"
 #include "..\WBITelemetry\WBITelemetry.h"
 
 
-VSSolutionFolderProject::VSSolutionFolderProject(const std::string& name, VSSolution& parent)
+VSSolutionFolderProject::VSSolutionFolderProject(const std::string& name, const VSSolutionFolderProject* parentFolder, VSSolution& parent)
 : VSSolutionProject(parent), m_name(name)
 {
-  m_id = sole::uuid4().str();
+  // Keep the id stable from one import to the next
+  m_id = makeStableUUID(parent.getPath() + "|" + (parentFolder ? parentFolder->getId() : "") + "|" + name);
   std::string guid = formatVSGUID(m_id);
   TELEMETRY_EVENT_GUID(L"VSImporterSolutionFolderGuid", guid);
 }
@@ -21,6 +21,9 @@
 #include "SBLog.h"
 #include "utils.h"
 #include "tokenizer.h"
+#include "vshelpers.h"
+#include <iterator>
+#include <sstream>
 
 struct ProjectItem {
   ProjectItem(const std::string& input, const std::string& output, bool replace)
@@ -154,7 +157,7 @@ static bool isAppxManifestFileName(const String& fileName)
     return 0 == fileName.compare(fileName.length() - extension.length(), String::npos, extension);
 }
 
-static void insertUrlSchemes(const String& file, const StringSet& schemes)
+static bool insertUrlSchemes(const String& file, String& contents, const StringSet& schemes)
 {
     //
     // Inject registered URL schemes into the AppX manifest file, in this format:
@@ -174,15 +177,15 @@ static void insertUrlSchemes(const String& file, const StringSet& schemes)
     //
 
     pugi::xml_document doc;
-    if (!doc.load_file(file.c_str())) {
+    if (!doc.load_buffer(contents.data(), contents.size())) {
         SBLog::error() << "Failed to parse AppX manifest file " << file << std::endl;
-        return;
+        return false;
     }
 
     pugi::xpath_node app = doc.select_single_node(PUGIXML_TEXT("/Package/Applications/Application"));
     if (!app) {
         SBLog::error() << "Failed to find Application element in AppX manifest file " << file << std::endl;
-        return;
+        return false;
     }
 
     pugi::xml_node extensions = app.node().append_child(PUGIXML_TEXT("Extensions"));
@@ -201,10 +204,13 @@ static void insertUrlSchemes(const String& file, const StringSet& schemes)
         protocol.append_attribute(PUGIXML_TEXT("Name")).set_value(schemeValue.c_str());
     }
 
-    doc.save_file(file.c_str());
+    std::ostringstream out;
+    doc.save(out);
+    contents = out.str();
+    return true;
 }
 
-static void writeProjectItem(const ProjectItem* item, const StringMap& params, const StringSet& urlSchemes)
+static void writeProjectItem(const ProjectItem* item, const StringMap& params, const StringSet& urlSchemes, const StringSet& holdBack, StringMap& heldBack)
 {
   if (!item)
     return;
@@ -217,27 +223,35 @@ static void writeProjectItem(const ProjectItem* item, const StringMap& params, c
     return;
   }
 
-  // Open output file
-  ofstream ofs;
-  auto outMode = item->replaceParams ? ios::out : ios::binary;
-  openOutputFileStream(ofs, item->outFile, outMode);
-
+  std::string contents;
   if (item->replaceParams) {
-    // Expand input line by line and write it out
+    // Expand input line by line
+    std::ostringstream out;
     std::string line;
     while (std::getline(ifs, line)) {
       expandString(line, params);
-      ofs << line << std::endl;
+      out << line << std::endl;
     }
+    contents = out.str();
   } else {
     // Copy the file contents
-    ofs << ifs.rdbuf();
+    contents.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
   }
 
-  if (!urlSchemes.empty() && isAppxManifestFileName(item->inFile)) {
-      ofs.close();
-      insertUrlSchemes(item->outFile, urlSchemes);
+  // Hand back the files that the caller finishes itself
+  if (holdBack.find(item->outFile) != holdBack.end()) {
+    heldBack[item->outFile] = contents;
+    return;
   }
+
+  auto outMode = item->replaceParams ? ios::out : ios::binary;
+  if (!urlSchemes.empty() && isAppxManifestFileName(item->inFile) && insertUrlSchemes(item->outFile, contents, urlSchemes)) {
+    // pugixml output is written as is
+    outMode = ios::binary;
+  }
+
+  // Leave files from an earlier import alone if they haven't changed, so that VS doesn't reload them
+  writeFileIfChanged(item->outFile, contents, outMode);
 }
 
 void VSTemplateProject::expand(const std::string& srcDir, const std::string& destDir, const VSTemplateParameters& params)
@@ -249,6 +263,12 @@ void VSTemplateProject::expand(const std::string& srcDir, const std::string& des
   expandString(m_outputDir, m_params);
   std::string updatedDestDir = joinPaths(destDir, m_outputDir);
 
+  // Derive the template GUIDs from where the project goes, so that they stay the same from one import to the next
+  for (auto& paramKV : m_params) {
+    if (paramKV.first.compare(0, 5, "$guid") == 0)
+      paramKV.second = makeStableUUID(updatedDestDir + "/" + paramKV.first);
+  }
+
   // Handle the project items
   for (auto item : m_items) {
     expandProjectItem(srcDir, updatedDestDir, m_params, item);;
@@ -256,9 +276,9 @@ void VSTemplateProject::expand(const std::string& srcDir, const std::string& des
 
 }
 
-void VSTemplateProject::write(const StringSet& urlSchemes) const
+void VSTemplateProject::write(const StringSet& urlSchemes, const StringSet& holdBack, StringMap& heldBack) const
 {
   for (auto item : m_items) {
-    writeProjectItem(item, m_params, urlSchemes);
+    writeProjectItem(item, m_params, urlSchemes, holdBack, heldBack);
   }
 }
\ No newline at end of file
@@ -38,6 +38,37 @@ String formatVSGUID(const String& guid)
   return String("{") + strToUpper(guid) + "}";
 }
 
+// Derives a UUID from a name, such as the path of the file it identifies, so that
+// importing the same project again produces the same files
+String makeStableUUID(const String& name)
+{
+  // Two FNV-1a hashes with different offsets make up the 128 bits
+  unsigned long long halves[2] = { 0xcbf29ce484222325ULL, 0x84222325cbf29ce4ULL };
+  for (auto& half : halves) {
+    for (unsigned char c : name) {
+      half ^= c;
+      half *= 0x100000001b3ULL;
+    }
+  }
+
+  unsigned char bytes[16];
+  for (int i = 0; i < 16; i++) {
+    bytes[i] = (unsigned char)(halves[i / 8] >> (8 * (i % 8)));
+  }
+  bytes[6] = (bytes[6] & 0x0F) | 0x80; // Version 8, custom
+  bytes[8] = (bytes[8] & 0x3F) | 0x80; // RFC 4122 variant
+
+  static const char hexDigits[] = "0123456789abcdef";
+  String ret;
+  for (int i = 0; i < 16; i++) {
+    if (i == 4 || i == 6 || i == 8 || i == 10)
+      ret += '-';
+    ret += hexDigits[bytes[i] >> 4];
+    ret += hexDigits[bytes[i] & 0xF];
+  }
+  return ret;
+}
+
 pugi::xml_node appendNodeWithText(pugi::xml_node& parent, const String& nodeName, const String& nodeText, const String& nodeCond)
 {
   pugi::xml_node node = parent.append_child(nodeName.c_str());
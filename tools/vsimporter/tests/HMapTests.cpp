@@ -0,0 +1,101 @@
+//******************************************************************************
+//
+// Copyright (c) 2016 Microsoft Corporation. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <iterator>
+#include "hmapmaker.h"
+
+// Header field offsets, per HMapHeader
+enum { StringsOffsetField = 8, NumBucketsField = 16, HeaderSize = 24 };
+
+static const char* const testMapName = "hmaptests.hmap";
+
+static std::string writeTestMap()
+{
+  IncludeMapMaker hmap;
+  hmap.addMapping("Foo/Foo.h", "C:/src/Foo/Foo.h");
+  hmap.addMapping("Bar.h", "C:/src/Bar/Bar.h");
+  hmap.writeMap(testMapName);
+
+  std::ifstream ifs(testMapName, std::ifstream::in | std::ifstream::binary);
+  return std::string((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+}
+
+static void rewriteTestMap(const std::string& data)
+{
+  std::ofstream ofs(testMapName, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+  ofs.write(data.data(), data.size());
+}
+
+static std::string withField(std::string data, size_t offset, uint32_t value)
+{
+  memcpy(&data[offset], &value, sizeof(value));
+  return data;
+}
+
+TEST(HMap, ReadsWrittenMap)
+{
+  writeTestMap();
+
+  IncludeMapMaker hmap;
+  ASSERT_TRUE(hmap.readMap(testMapName));
+
+  std::string to;
+  EXPECT_TRUE(hmap.lookup("foo/foo.h", to));
+  EXPECT_EQ("C:/src/Foo/Foo.h", to);
+  EXPECT_TRUE(hmap.lookup("Bar.h", to));
+  EXPECT_EQ("C:/src/Bar/Bar.h", to);
+  EXPECT_FALSE(hmap.lookup("Baz.h", to));
+
+  remove(testMapName);
+}
+
+TEST(HMap, RejectsMalformedHeaders)
+{
+  std::string data = writeTestMap();
+  ASSERT_GT(data.size(), (size_t)HeaderSize);
+
+  uint32_t stringsOffset, numBuckets;
+  memcpy(&stringsOffset, &data[StringsOffsetField], sizeof(stringsOffset));
+  memcpy(&numBuckets, &data[NumBucketsField], sizeof(numBuckets));
+
+  IncludeMapMaker hmap;
+  hmap.addMapping("Kept.h", "C:/src/Kept.h");
+
+  std::vector<std::string> malformed;
+  malformed.push_back(data.substr(0, HeaderSize - 1));                                  // Truncated header
+  malformed.push_back(withField(data, StringsOffsetField, 0));                          // Strings inside the header
+  malformed.push_back(withField(data, StringsOffsetField, 5));                          // Strings inside the header, at a NUL
+  malformed.push_back(withField(data, StringsOffsetField, HeaderSize));                 // Strings overlap the buckets
+  malformed.push_back(withField(data, StringsOffsetField, stringsOffset - 1));          // Strings overlap the last bucket
+  malformed.push_back(withField(data, StringsOffsetField, (uint32_t)data.size() + 1));  // Strings past the end
+  malformed.push_back(withField(data, NumBucketsField, numBuckets * 2));                // Buckets run into the strings
+  malformed.push_back(withField(data, NumBucketsField, 0x80000000));                    // Bucket array size overflows
+  malformed.push_back(withField(data, NumBucketsField, numBuckets - 1));                // Not a power of two
+
+  for (size_t i = 0; i < malformed.size(); i++) {
+    rewriteTestMap(malformed[i]);
+    EXPECT_FALSE(hmap.readMap(testMapName)) << "malformed map " << i;
+  }
+
+  // A rejected map leaves the contents alone
+  std::string to;
+  EXPECT_TRUE(hmap.lookup("Kept.h", to));
+  EXPECT_EQ("C:/src/Kept.h", to);
+
+  remove(testMapName);
+}
@@ -0,0 +1,89 @@
+//******************************************************************************
+//
+// Copyright (c) 2016 Microsoft Corporation. All rights reserved.
+//
+// This code is licensed under the MIT License (MIT).
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//******************************************************************************
+
+#include <gtest/gtest.h>
+#include "SimpleVariableCollection.h"
+#include "VariableCollectionHierarchy.h"
+
+static bool isCached(const VariableCollectionHierarchy& vch, const String& varName, String& value)
+{
+  // Top level lookups start and end their search at the last level
+  VariableCollectionHierarchy::Expansion expansion;
+  if (!vch.getCachedExpansion(varName, vch.size(), vch.size(), expansion))
+    return false;
+  value = expansion.value;
+  return true;
+}
+
+TEST(VariableCollectionHierarchy, SecondExpansionIsCached)
+{
+  SimpleVariableCollection defaults, project;
+  defaults.insert("PRODUCT_NAME", "App");
+  defaults.insert("OTHER_CFLAGS", "-DDEFAULT");
+  project.insert("OTHER_CFLAGS", "$(inherited) -D$(PRODUCT_NAME:upper)");
+
+  VariableCollectionHierarchy vch;
+  vch.push_back(defaults);
+  vch.push_back(project);
+
+  String value;
+  EXPECT_FALSE(isCached(vch, "OTHER_CFLAGS", value));
+  EXPECT_EQ("-DDEFAULT -DAPP", vch.getValue("OTHER_CFLAGS"));
+  ASSERT_TRUE(isCached(vch, "OTHER_CFLAGS", value));
+  EXPECT_EQ("-DDEFAULT -DAPP", value);
+
+  // Reading the collections, rewriting a value unchanged, and changing collections outside the hierarchy keep the cache
+  EXPECT_TRUE(defaults.getValue("PRODUCT_NAME", value));
+  EXPECT_FALSE(project.isSet("PRODUCT_NAME"));
+  defaults.insert("PRODUCT_NAME", "App");
+  project.erase("MISSING");
+  SimpleVariableCollection unrelated;
+  unrelated.insert("PRODUCT_NAME", "Other");
+
+  EXPECT_TRUE(isCached(vch, "OTHER_CFLAGS", value));
+  EXPECT_EQ("-DDEFAULT -DAPP", vch.getValue("OTHER_CFLAGS"));
+}
+
+TEST(VariableCollectionHierarchy, ChangesInvalidateCache)
+{
+  SimpleVariableCollection defaults, project;
+  defaults.insert("PRODUCT_NAME", "App");
+  project.insert("OTHER_CFLAGS", "-D$(PRODUCT_NAME)");
+
+  VariableCollectionHierarchy vch;
+  vch.push_back(defaults);
+  vch.push_back(project);
+
+  String value;
+  EXPECT_EQ("-DApp", vch.getValue("OTHER_CFLAGS"));
+
+  // A change to a lower level than the variable's own is seen
+  defaults.insert("PRODUCT_NAME", "Renamed");
+  EXPECT_FALSE(isCached(vch, "OTHER_CFLAGS", value));
+  EXPECT_EQ("-DRenamed", vch.getValue("OTHER_CFLAGS"));
+
+  defaults.erase("PRODUCT_NAME");
+  EXPECT_FALSE(isCached(vch, "OTHER_CFLAGS", value));
+  EXPECT_EQ("-D", vch.getValue("OTHER_CFLAGS"));
+
+  // As is another level
+  SimpleVariableCollection overrides;
+  overrides.insert("PRODUCT_NAME", "Override");
+  vch.push_back(overrides);
+  EXPECT_EQ("-DOverride", vch.getValue("OTHER_CFLAGS"));
+  vch.pop_back();
+  EXPECT_EQ("-D", vch.getValue("OTHER_CFLAGS"));
+}
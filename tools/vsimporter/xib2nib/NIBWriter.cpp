@@ -24,7 +24,7 @@
 #include "UIViewController.h"
 #include "..\WBITelemetry\WBITelemetry.h"
 
-int curPlaceholder = 1;
+thread_local int curPlaceholder = 1;
 
 void NIBWriter::WriteInt(int val, int minlen)
 {
@@ -70,10 +70,8 @@ XIBObject* NIBWriter::AddOutputObject(XIBObject *pObj)
             pObj = GetProxyFor(pObj);
         }
     }
-    for ( size_t i = 0; i < _outputObjects.size(); i ++ ) {
-        if ( _outputObjects[i] == pObj ) {
-            return pObj;
-        }
+    if ( !_outputObjectSet.insert(pObj).second ) {
+        return pObj;
     }
 
     _outputObjects.push_back(pObj);
@@ -94,39 +92,22 @@ typedef struct
     int _classNamesOffset;  //  9
 } NIBHeader;
 
+//  Assigns each distinct string an index, in order of first appearance. The strings
+//  aren't copied; they belong to the objects being written and outlive the combiner.
 class StringCombiner
 {
 public:
-    char **_stringTable;
-    int    _numStrings, _maxStrings;
-
-    StringCombiner()
-    {
-        _numStrings = 0;
-        _maxStrings = 32;
-        _stringTable = (char **) malloc(sizeof(char *) * _maxStrings);
-    }
+    std::vector<const char *> _stringTable;
+    std::unordered_map<const char *, int, CStringHash, CStringEqual> _stringIndex;
 
     int AddString(const char *str)
     {
-        for ( int i = 0; i < _numStrings; i ++ ) {
-            if ( strcmp(_stringTable[i], str) == 0 ) {
-                return i;
-            }
-        }
-
-        if ( _numStrings + 1 > _maxStrings ) {
-            _maxStrings += 64;
-            _stringTable = (char **) realloc(_stringTable, sizeof(char *) * _maxStrings);
+        auto found = _stringIndex.insert(std::make_pair(str, (int) _stringTable.size()));
+        if ( found.second ) {
+            _stringTable.push_back(str);
         }
 
-        _stringTable[_numStrings] = (char *) malloc(strlen(str) + 1);
-        strcpy(_stringTable[_numStrings], str);
-
-        int ret = _numStrings;
-        _numStrings ++;
-
-        return ret;
+        return found.first->second;
     }
 };
 
@@ -138,6 +119,7 @@ NIBWriter::NIBWriter(FILE *out)
     _connections = NULL;
     _visibleWindows = NULL;
     fpOut = out;
+    _failed = false;
 }
 
 NIBWriter::NIBWriter(FILE *out, XIBDictionary *externalReferences, XIBObject *base)
@@ -148,6 +130,7 @@ NIBWriter::NIBWriter(FILE *out, XIBDictionary *externalReferences, XIBObject *ba
     _connections = NULL;
     _visibleWindows = NULL;
     fpOut = out;
+    _failed = false;
 
     curPlaceholder = 1;
     _baseObject = base;
@@ -165,7 +148,7 @@ void NIBWriter::ExportObject(XIBObject *obj)
     _allUIObjects->AddMember(NULL, obj);
 }
 
-void NIBWriter::WriteObjects()
+bool NIBWriter::WriteObjects()
 {
     XIBObject *nibRoot = new XIBArray();
 
@@ -227,7 +210,7 @@ void NIBWriter::WriteObjects()
         if ( !didSwap ) break;
     }
 
-    WriteData();
+    return WriteData();
 }
 
 void NIBWriter::AddOutletConnection(XIBObject *src, XIBObject *dst, char *propName)
@@ -272,12 +255,9 @@ XIBObject *NIBWriter::FindProxy(char *propName)
 XIBObject *NIBWriter::GetProxyFor(XIBObject *obj)
 {
     //  Go through current proxies
-    for ( proxyList::iterator cur = _proxies.begin(); cur != _proxies.end(); cur ++ ) {
-        ProxiedObject *curObj = *cur;
-
-        if ( curObj->_obj == obj ) {
-            return curObj->_proxyObj;
-        }
+    auto existing = _proxyForObject.find(obj);
+    if ( existing != _proxyForObject.end() ) {
+        return existing->second;
     }
 
     UIProxyObject *newProxy = new UIProxyObject();
@@ -294,6 +274,7 @@ XIBObject *NIBWriter::GetProxyFor(XIBObject *obj)
     newProxiedObj->_proxyObj = newProxy;
     newProxiedObj->_name = newProxy->_identifier;
     _proxies.push_back(newProxiedObj);
+    _proxyForObject[obj] = newProxy;
 
     XIBObjectString *key = new XIBObjectString(strdup(szName));
     _externalReferencesDictionary->AddObjectForKey(key, obj);
@@ -301,16 +282,20 @@ XIBObject *NIBWriter::GetProxyFor(XIBObject *obj)
     return newProxy;
 }
 
-std::map<std::string, std::string> _g_exportedControllers;
+thread_local std::map<std::string, std::string> _g_exportedControllers;
 
-void NIBWriter::ExportAllControllers()
+bool NIBWriter::ExportAllControllers()
 {
     for (const char* cur : UIViewController::_viewControllerNames) {
-        ExportController(cur);
+        if (!ExportController(cur)) {
+            return false;
+        }
     }
+
+    return true;
 }
 
-void NIBWriter::ExportController(const char *controllerId)
+bool NIBWriter::ExportController(const char *controllerId)
 {
     char szFilename[255];
 
@@ -319,7 +304,7 @@ void NIBWriter::ExportController(const char *controllerId)
     if (!uiViewController) {
         //object isn't really a controller
         printf("Object %s is not a controller\n", controller->stringValue());
-        return;
+        return true;
     }
 
     const char* controllerIdentifier = uiViewController->_storyboardIdentifier;
@@ -330,7 +315,7 @@ void NIBWriter::ExportController(const char *controllerId)
 
     //  Check if we've already written out the controller
     if (_g_exportedControllers.find(controllerId) != _g_exportedControllers.end()) {
-        return;
+        return true;
     }
 
     sprintf(szFilename, "%s.nib", controllerIdentifier);
@@ -360,13 +345,32 @@ void NIBWriter::ExportController(const char *controllerId)
         }
     }
 
-    writer->WriteObjects();
+    bool written = writer->WriteObjects();
 
     fclose(fpOut);
+    if (!written) {
+        remove(GetOutputFilename(szFilename).c_str());
+    }
+
+    return written;
 }
 
-void NIBWriter::WriteData()
+bool NIBWriter::WriteData()
 {
+    if ( _failed ) {
+        return false;
+    }
+
+    //  Every object needs a class to be written as, so check them all before writing anything
+    for ( int i = 0; i < _outputObjects.size(); i ++ ) {
+        XIBObject *pObject = _outputObjects[i];
+        if (pObject->_outputClassName == NULL) {
+            printf("Unable to find class mapping for required object <%s>\n", pObject->_node.name());
+            TELEMETRY_EVENT_DATA(L"MissingClassMapping", pObject->_node.name());
+            return false;
+        }
+    }
+
     fwrite("NIBArchive", 10, 1, fpOut);
     int headerPos = ftell(fpOut);
 
@@ -380,19 +384,12 @@ void NIBWriter::WriteData()
 
     for ( int i = 0; i < _outputObjects.size(); i ++ ) {
         XIBObject *pObject = _outputObjects[i];
-        if (pObject->_outputClassName == NULL) {
-            printf("Unable to find class mapping for required object <%s>\n", pObject->_node.name());
-            TELEMETRY_EVENT_DATA(L"MissingClassMapping", pObject->_node.name());
-            TELEMETRY_FLUSH();
-
-            exit(-1);
-        }
         pObject->_outputClassNameIdx = classNames.AddString(pObject->_outputClassName);
         pObject->_outputObjectIdx = i;
     }
 
-    for ( int i = 0; i < classNames._numStrings; i ++ ) {
-        char *pName = classNames._stringTable[i];
+    for ( size_t i = 0; i < classNames._stringTable.size(); i ++ ) {
+        const char *pName = classNames._stringTable[i];
         int len = strlen(pName) + 1;
         WriteInt(len, 2);
         if ( len == 0x1b ) {
@@ -415,8 +412,8 @@ void NIBWriter::WriteData()
         }
     }
 
-    for ( int i = 0; i < keyNames._numStrings; i ++ ) {
-        char *pName = keyNames._stringTable[i];
+    for ( size_t i = 0; i < keyNames._stringTable.size(); i ++ ) {
+        const char *pName = keyNames._stringTable[i];
         int len = strlen(pName) + 1;
         WriteInt(len, 1);
         fwrite(pName, 1, len, fpOut);
@@ -468,5 +465,6 @@ void NIBWriter::WriteData()
 
     fseek(fpOut, headerPos, SEEK_SET);
     fwrite(&header, sizeof(header), 1, fpOut);
+    return true;
 }
 
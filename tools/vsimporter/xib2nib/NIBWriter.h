@@ -18,6 +18,8 @@
 #define __NIBWRITER_H
 
 #include <stdio.h>
+#include <unordered_map>
+#include <unordered_set>
 #include "XIBObject.h"
 
 #define NIBOBJ_INT8     0x00
@@ -46,8 +48,11 @@ class NIBWriter
 {
 private:
     xibList _outputObjects; 
+    std::unordered_set<XIBObject *> _outputObjectSet;
     proxyList _proxies;
+    std::unordered_map<XIBObject *, XIBObject *> _proxyForObject;
     FILE *fpOut;
+    bool _failed;
 
 public:
     XIBObject *_allUIObjects;
@@ -62,12 +67,15 @@ public:
     NIBWriter(FILE *out);
     NIBWriter(FILE *out, XIBDictionary *externalRefsDict, XIBObject *base);
 
-    static void ExportController(const char *controllerId);
-    static void ExportAllControllers();
+    static bool ExportController(const char *controllerId);
+    static bool ExportAllControllers();
     void ExportObject(XIBObject *obj);
-    void WriteObjects();
+    bool WriteObjects();
     XIBObject *AddOutputObject(XIBObject *pObj);
-    void WriteData();
+    bool WriteData();
+
+    //  Marks a nib written while emitting this one as failed, which fails this one too
+    void SetFailed() { _failed = true; }
 
     void WriteInt(int val, int minlen);
     void WriteByte(int byte);
@@ -25,7 +25,7 @@ static PropertyMapper propertyMappings[] = {
 };
 
 static const int numPropertyMappings = sizeof(propertyMappings) / sizeof(PropertyMapper);
-viewControllerList UIViewController::_viewControllerNames;
+thread_local viewControllerList UIViewController::_viewControllerNames;
 
 UIViewController::UIViewController() {
     _childViewControllers = new XIBArray();
@@ -155,8 +155,12 @@ void UIViewController::ConvertStaticMappings(NIBWriter* writer, XIBObject* obj)
                 //  Add view connection
                 viewWriter->AddOutletConnection(ownerProxy, _view, "view");
 
-                viewWriter->WriteObjects();
+                bool written = viewWriter->WriteObjects();
                 fclose(fpOut);
+                if (!written) {
+                    remove(GetOutputFilename(szOutputName).c_str());
+                    writer->SetFailed();
+                }
 
                 if (externalObjects->_members.size() > 1) {
                     AddOutputMember(writer, "UIExternalObjectsTableForViewLoading", externalObjects);
@@ -182,7 +186,9 @@ void UIViewController::ConvertStaticMappings(NIBWriter* writer, XIBObject* obj)
             for (int i = 0; i < segueTemplates->count(); i++) {
                 UIStoryboardSegue* curSegue = (UIStoryboardSegue*)segueTemplates->objectAtIndex(i);
 
-                NIBWriter::ExportController(curSegue->getAttrib("destination"));
+                if (!NIBWriter::ExportController(curSegue->getAttrib("destination"))) {
+                    writer->SetFailed();
+                }
             }
         }
     }
@@ -35,7 +35,7 @@ public:
     XIBArray *_segueTemplates;
     bool _resizesToFullSize;
     const char *_storyboardIdentifier;
-    static viewControllerList _viewControllerNames;
+    static thread_local viewControllerList _viewControllerNames;
 
     UIViewController();
     virtual void InitFromXIB(XIBObject *obj);
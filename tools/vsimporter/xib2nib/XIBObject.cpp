@@ -66,7 +66,18 @@ XIBMember::XIBMember() {
     _obj = NULL;
 }
 
-xibList XIBObject::_allObjs;
+thread_local xibList XIBObject::_allObjs;
+thread_local xibIdMap XIBObject::_objsById;
+thread_local size_t XIBObject::_numObjsIndexed = 0;
+
+size_t CStringHash::operator()(const char* str) const {
+    // FNV-1a
+    size_t hash = 2166136261U;
+    for (; *str; str++) {
+        hash = (hash ^ (unsigned char)*str) * 16777619U;
+    }
+    return hash;
+}
 
 void XIBObject::AddOutputMember(NIBWriter* writer, const char* keyName, XIBObject* obj) {
     XIBMember* pNewMember = new XIBMember();
@@ -531,16 +542,17 @@ void XIBObject::ResolveReferences() {
 }
 
 XIBObject* XIBObject::findReference(const char* id) {
-    xibList::iterator cur = _allObjs.begin();
-
-    for (; cur != _allObjs.end(); cur++) {
-        if ((*cur)->_id == NULL)
-            continue;
-        if (strcmp((*cur)->_id, id) == 0)
-            return (*cur);
+    // Index any objects scanned since the last lookup. Ids are assigned as objects are scanned, so
+    // by the time anything is looked up they're final. The first object with a given id wins.
+    for (; _numObjsIndexed < _allObjs.size(); _numObjsIndexed++) {
+        XIBObject* obj = _allObjs[_numObjsIndexed];
+        if (obj->_id != NULL) {
+            _objsById.insert(xibIdMap::value_type(obj->_id, obj));
+        }
     }
 
-    return NULL;
+    xibIdMap::iterator found = _objsById.find(id);
+    return found != _objsById.end() ? found->second : NULL;
 }
 
 void XIBObject::ParseAllXIBMembers() {
@@ -583,6 +595,15 @@ void XIBObject::ParseAllStoryMembers() {
     }
 }
 
+void XIBObject::ResetAllObjects() {
+    // Forget the previous document's objects. They (and the nodes they point into) are leaked
+    // along with everything else xib2nib allocates, but must no longer be found by id.
+    _allObjs.clear();
+    _objsById.clear();
+    _numObjsIndexed = 0;
+    _handledNodes.clear();
+}
+
 void XIBObject::EmitObject(NIBWriter* writer) {
     if (!_needsConversion)
         return;
@@ -600,7 +621,7 @@ void XIBObject::ConvertStaticMappings(NIBWriter* writer, XIBObject* obj) {
 void XIBObject::Awaken() {
 }
 
-std::unordered_set<size_t> XIBObject::_handledNodes;
+thread_local std::unordered_set<size_t> XIBObject::_handledNodes;
 
 void XIBObject::setNodeHandled(pugi::xml_node node) {
     _handledNodes.insert(node.hash_value());
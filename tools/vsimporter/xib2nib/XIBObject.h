@@ -21,6 +21,7 @@
 #include <pugixml.hpp>
 #include <string.h>
 #include <unordered_set>
+#include <unordered_map>
 
 class XIBObject;
 
@@ -38,6 +39,17 @@ public:
 typedef std::vector<XIBObject*> xibList;
 typedef std::vector<XIBMember*> memberList;
 
+// Hashing and equality for tables keyed on the C strings used for ids and names
+struct CStringHash {
+    size_t operator()(const char* str) const;
+};
+struct CStringEqual {
+    bool operator()(const char* a, const char* b) const {
+        return strcmp(a, b) == 0;
+    }
+};
+typedef std::unordered_map<const char*, XIBObject*, CStringHash, CStringEqual> xibIdMap;
+
 class XIBObjectInt;
 class XIBObjectString;
 class NIBWriter;
@@ -73,7 +85,10 @@ public:
     XIBObject* _parent;
     xibList _variations;
 
-    static xibList _allObjs;
+    // Per-document state is thread-local so that batch mode can convert documents concurrently
+    static thread_local xibList _allObjs;
+    static thread_local xibIdMap _objsById;
+    static thread_local size_t _numObjsIndexed;
     bool _ignoreUIObject;
 
 public:
@@ -115,6 +130,7 @@ public:
     static XIBObject* findReference(const char* id);
     static void ParseAllXIBMembers();
     static void ParseAllStoryMembers();
+    static void ResetAllObjects();
 
     virtual void EmitObject(NIBWriter* writer);
     virtual void WriteData(NIBWriter* writer);
@@ -131,7 +147,7 @@ public:
     void AddInt(NIBWriter* writer, char* pPropName, int val);
     void AddBool(NIBWriter* writer, char* pPropName, bool val);
 
-    static std::unordered_set<size_t> _handledNodes;
+    static thread_local std::unordered_set<size_t> _handledNodes;
     static void setNodeHandled(pugi::xml_node node);
     static void setAttrHandled(pugi::xml_attribute attr);
     static void setMemberHandled(XIBObject* member);
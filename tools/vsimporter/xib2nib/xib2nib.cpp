@@ -22,12 +22,19 @@
 #include <direct.h>
 #include <assert.h>
 #include <map>
+#include <algorithm>
 #include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <atomic>
+#include <chrono>
 
 #include "XIBObject.h"
 #include "XIBObjectTypes.h"
 #include "XIBDocument.h"
 #include "NIBWriter.h"
+#include "UIViewController.h"
 #include "Plist.hpp"
 #include "miscutils.h"
 #include "versionutils.h"
@@ -36,8 +43,9 @@
 
 // These globals should only be employed when dealing with storyboard files (.storyboard)
 // They are only set once when we determine that the input format is a storyboard
-bool g_isStoryboard = false;
-static char g_outputDirectory[4096];
+// They're per thread, as batch mode converts several documents at once
+thread_local bool g_isStoryboard = false;
+static thread_local char g_outputDirectory[4096];
 
 bool IsStoryboardConversion() {
     return g_isStoryboard;
@@ -49,9 +57,19 @@ std::string GetOutputFilename(const char* filename) {
     return ret;
 }
 
-extern std::map<std::string, std::string> _g_exportedControllers;
+extern thread_local std::map<std::string, std::string> _g_exportedControllers;
+extern thread_local int curPlaceholder;
 
-void ConvertStoryboard(pugi::xml_document& doc) {
+static void ResetConversionState() {
+    XIBObject::ResetAllObjects();
+    UIViewController::_viewControllerNames.clear();
+    _g_exportedControllers.clear();
+    curPlaceholder = 1;
+    g_isStoryboard = false;
+    g_outputDirectory[0] = 0;
+}
+
+bool ConvertStoryboard(pugi::xml_document& doc) {
     pugi::xml_node curNode = doc.first_child();
 
     //  Storyboard XIB file - get topmost controller, then export it
@@ -69,7 +87,9 @@ void ConvertStoryboard(pugi::xml_document& doc) {
     // Print which XML nodes we did not handle during the parse for diagnostic purpose.
     XIBObject::getDocumentCoverage(doc);
 
-    NIBWriter::ExportAllControllers();
+    if (!NIBWriter::ExportAllControllers()) {
+        return false;
+    }
 
     Plist::dictionary_type viewControllerInfo;
     viewControllerInfo[std::string("UIStoryboardDesignatedEntryPointIdentifier")] = std::string(initialController);
@@ -83,9 +103,10 @@ void ConvertStoryboard(pugi::xml_document& doc) {
 
     printf("Writing %s\n", GetOutputFilename("Info.plist").c_str());
     Plist::writePlistBinary(GetOutputFilename("Info.plist").c_str(), viewControllerInfo);
+    return true;
 }
 
-void ConvertXIB3ToNib(FILE* fpOut, pugi::xml_document& doc) {
+bool ConvertXIB3ToNib(FILE* fpOut, pugi::xml_document& doc) {
     pugi::xml_node curNode = doc.first_child();
 
     //  XIB3 file
@@ -104,10 +125,13 @@ void ConvertXIB3ToNib(FILE* fpOut, pugi::xml_document& doc) {
             writer->ExportObject(curObj);
         }
 
-        writer->WriteObjects();
+        return writer->WriteObjects();
     }
+
+    return true;
 }
-void ConvertXIBToNib(FILE* fpOut, pugi::xml_document& doc) {
+
+bool ConvertXIBToNib(FILE* fpOut, pugi::xml_document& doc) {
     pugi::xml_node dataNode = doc.first_element_by_path("/archive/data");
 
     XIBObject* root = new XIBObject();
@@ -235,87 +259,266 @@ void ConvertXIBToNib(FILE* fpOut, pugi::xml_document& doc) {
     writer->_allUIObjects = allObjects;
     writer->_visibleWindows = visibleWindows;
     writer->AddOutputObject(nibRoot);
-    writer->WriteData();
+    return writer->WriteData();
 }
 
-int main(int argc, char* argv[]) {
-    TELEMETRY_INIT(L"AIF-47606e3a-4264-4368-8f7f-ed6ec3366dca");
-
-    if (checkTelemetryOptIn()) {
-        TELEMETRY_ENABLE();
-    } else {
-        TELEMETRY_DISABLE();
-    }
-
-    TELEMETRY_SET_INTERNAL(isMSFTInternalMachine());
-    string machineID = getMachineID();
-    if (!machineID.empty()) {
-        TELEMETRY_SET_MACHINEID(machineID.c_str());
-    }
-
-    TELEMETRY_EVENT_DATA(L"Xib2NibStart", getProductVersion().c_str());
+// Converts a single XIB or storyboard. Returns the process exit code for the failure, if any.
+static int ConvertDocument(const char* inputFile, const char* output) {
+    ResetConversionState();
 
     pugi::xml_document doc;
-    pugi::xml_parse_result result = doc.load_file(argv[1]);
+    pugi::xml_parse_result result = doc.load_file(inputFile);
     if (!result) {
-        printf("Error opening %s\n", argv[1]);
-        TELEMETRY_FLUSH();
-        exit(2);
-        return -1;
+        printf("Error opening %s\n", inputFile);
+        return 2;
     }
 
     pugi::xml_node rootNode = doc.first_child();
     const char* type = getNodeAttrib(rootNode, "type");
     if (!type) {
         printf("Unable to find input type\n");
-        TELEMETRY_FLUSH();
-        exit(3);
-        return -1;
+        return 3;
     }
     if (strcmp(rootNode.name(), "document") == 0 && strcmp(type, "com.apple.InterfaceBuilder3.CocoaTouch.Storyboard.XIB") == 0) {
-        if (argc < 3) {
+        if (!output) {
             printf("Usage: xib2nib input.storyboard <outputdir>\n");
-            TELEMETRY_FLUSH();
-            exit(1);
-            return -1;
+            return 1;
         }
 
         struct stat st = { 0 };
-        stat(argv[2], &st);
-        if (!(((st.st_mode) & S_IFMT) == S_IFDIR) && _mkdir(argv[2]) != 0) {
-            printf("Unable to create directory %s err=%d\n", argv[2], errno);
+        stat(output, &st);
+        if (!(((st.st_mode) & S_IFMT) == S_IFDIR) && _mkdir(output) != 0) {
+            printf("Unable to create directory %s err=%d\n", output, errno);
             return -1;
         }
 
         g_isStoryboard = true;
-        strcpy_s(g_outputDirectory, arraySize(g_outputDirectory), argv[2]);
-        ConvertStoryboard(doc);
+        strcpy_s(g_outputDirectory, arraySize(g_outputDirectory), output);
+        if (!ConvertStoryboard(doc)) {
+            return -1;
+        }
     } else if (strstr(type, ".XIB") != NULL) {
-        if (argc < 3) {
+        if (!output) {
             printf("Usage: xib2nib input.xib output.nib\n");
-            TELEMETRY_FLUSH();
-            exit(1);
-            return -1;
+            return 1;
         }
 
-        FILE* fpOut = fopen(argv[2], "wb");
+        FILE* fpOut = fopen(output, "wb");
         if (!fpOut) {
-            printf("Error opening %s\n", argv[2]);
-            TELEMETRY_FLUSH();
-            exit(3);
-            return -1;
+            printf("Error opening %s\n", output);
+            return 3;
         }
 
+        bool converted;
         if (strcmp(rootNode.name(), "document") == 0) {
-            ConvertXIB3ToNib(fpOut, doc);
+            converted = ConvertXIB3ToNib(fpOut, doc);
         } else {
-            ConvertXIBToNib(fpOut, doc);
+            converted = ConvertXIBToNib(fpOut, doc);
         }
         fclose(fpOut);
+
+        // Don't leave a partial nib behind for a later build to pick up
+        if (!converted) {
+            remove(output);
+            return -1;
+        }
     } else {
         printf("Unable to determine input type type=\"%s\"\n", type);
+        return 4;
+    }
+
+    return 0;
+}
+
+struct BatchJob {
+    std::string input, output;
+    int result;
+    bool upToDate;
+};
+
+// Stamp recording which input (and which xib2nib) produced an output, so unchanged inputs can be skipped
+static std::string GetInputStamp(const std::string& inputFile) {
+    std::ifstream in(inputFile, std::ios::binary);
+    if (!in.is_open()) {
+        return std::string();
+    }
+
+    // FNV-1a
+    unsigned long long hash = 14695981039346656037ULL;
+    char buf[65536];
+    while (in.read(buf, sizeof(buf)) || in.gcount() > 0) {
+        for (std::streamsize i = 0; i < in.gcount(); i++) {
+            hash = (hash ^ (unsigned char)buf[i]) * 1099511628211ULL;
+        }
+    }
+
+    char szHash[32];
+    sprintf(szHash, "%016llx", hash);
+    return std::string(szHash) + " " + getProductVersion();
+}
+
+static std::string GetStampFilename(const std::string& output) {
+    return output + ".xib2nib-stamp";
+}
+
+static bool IsUpToDate(const BatchJob& job, const std::string& stamp) {
+    struct stat st = { 0 };
+    if (stamp.empty() || stat(job.output.c_str(), &st) != 0) {
+        return false;
+    }
+
+    std::ifstream in(GetStampFilename(job.output));
+    std::string oldStamp;
+    std::getline(in, oldStamp);
+    return oldStamp == stamp;
+}
+
+// Manifest lines are "<input>\t<output>"; blank lines and lines starting with '#' are ignored
+static bool ReadBatchManifest(const char* manifestFile, std::vector<BatchJob>& jobs) {
+    std::ifstream in(manifestFile);
+    if (!in.is_open()) {
+        printf("Error opening %s\n", manifestFile);
+        return false;
+    }
+
+    std::string line;
+    for (int lineNum = 1; std::getline(in, line); lineNum++) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        size_t tab = line.find('\t');
+        if (tab == std::string::npos || tab == 0 || tab + 1 == line.length()) {
+            printf("%s(%d): expected <input>\\t<output>\n", manifestFile, lineNum);
+            return false;
+        }
+
+        BatchJob job;
+        job.input = line.substr(0, tab);
+        job.output = line.substr(tab + 1);
+        job.result = 0;
+        job.upToDate = false;
+        jobs.push_back(job);
+    }
+
+    return true;
+}
+
+static int ConvertBatch(const char* manifestFile, unsigned numThreads) {
+    std::vector<BatchJob> jobs;
+    if (!ReadBatchManifest(manifestFile, jobs)) {
+        return 2;
+    }
+
+    if (numThreads == 0) {
+        numThreads = std::max(1U, std::thread::hardware_concurrency());
+    }
+    numThreads = std::min<unsigned>(numThreads, std::max<size_t>(1, jobs.size()));
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    // Each worker takes the next unclaimed document; all per-document state is thread-local
+    std::atomic<size_t> nextJob(0);
+    auto worker = [&]() {
+        for (size_t i = nextJob++; i < jobs.size(); i = nextJob++) {
+            BatchJob& job = jobs[i];
+            std::string stamp = GetInputStamp(job.input);
+            if (IsUpToDate(job, stamp)) {
+                job.upToDate = true;
+                continue;
+            }
+
+            job.result = ConvertDocument(job.input.c_str(), job.output.c_str());
+            if (job.result != 0) {
+                remove(GetStampFilename(job.output).c_str());
+            } else if (!stamp.empty()) {
+                std::ofstream(GetStampFilename(job.output)) << stamp << std::endl;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned i = 1; i < numThreads; i++) {
+        threads.push_back(std::thread(worker));
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count();
+
+    int ret = 0;
+    size_t numUpToDate = 0, numFailed = 0;
+    for (const BatchJob& job : jobs) {
+        if (job.upToDate) {
+            numUpToDate++;
+        } else if (job.result != 0) {
+            printf("Failed to convert %s (error %d)\n", job.input.c_str(), job.result);
+            numFailed++;
+            if (ret == 0) {
+                ret = job.result;
+            }
+        }
+    }
+
+    printf("Converted %d of %d documents (%d up to date, %d failed) on %u threads in %lld ms\n",
+           (int)(jobs.size() - numUpToDate - numFailed),
+           (int)jobs.size(),
+           (int)numUpToDate,
+           (int)numFailed,
+           numThreads,
+           (long long)elapsedMs);
+
+    return ret;
+}
+
+int main(int argc, char* argv[]) {
+    TELEMETRY_INIT(L"AIF-47606e3a-4264-4368-8f7f-ed6ec3366dca");
+
+    if (checkTelemetryOptIn()) {
+        TELEMETRY_ENABLE();
+    } else {
+        TELEMETRY_DISABLE();
+    }
+
+    TELEMETRY_SET_INTERNAL(isMSFTInternalMachine());
+    string machineID = getMachineID();
+    if (!machineID.empty()) {
+        TELEMETRY_SET_MACHINEID(machineID.c_str());
+    }
+
+    TELEMETRY_EVENT_DATA(L"Xib2NibStart", getProductVersion().c_str());
+
+    if (argc < 2) {
+        printf("Usage: xib2nib input.xib output.nib\n"
+               "       xib2nib input.storyboard <outputdir>\n"
+               "       xib2nib --batch manifest.txt [threads]\n");
+        TELEMETRY_FLUSH();
+        exit(1);
+        return -1;
+    }
+
+    int ret;
+    if (strcmp(argv[1], "--batch") == 0) {
+        if (argc < 3) {
+            printf("Usage: xib2nib --batch manifest.txt [threads]\n");
+            TELEMETRY_FLUSH();
+            exit(1);
+            return -1;
+        }
+
+        ret = ConvertBatch(argv[2], argc > 3 ? atoi(argv[3]) : 0);
+    } else {
+        ret = ConvertDocument(argv[1], argc > 2 ? argv[2] : NULL);
+    }
+
+    if (ret != 0) {
         TELEMETRY_FLUSH();
-        exit(4);
+        exit(ret);
         return -1;
     }
 